@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+"""
+ASR stand-in -- local test server for client-side upload formats.
+
+Speaks the subset of the local-ai-server transcription API the clients use
+(POST /v1/audio/transcriptions, verbose_json and streaming_verbose_json) but
+runs no model. It decodes whatever was uploaded -- WAV, an LMEL log-mel
+feature block (input_format=log_mel, see shared/mel_frontend.h), or a PBLK
+block list (input_format=pcm_blocks, see shared/block_upload.h) resolved
+against its block cache -- and answers with a transcript that describes
+what it decoded, one "word" per second of audio. That exercises the whole
+client path (upload, SSE, timestamps, cache misses) and reports upload bytes.
+
+Usage:
+    python asr_standin.py                 # listens on 8091
+    python asr_standin.py --port 8090 -v
+    python asr_standin.py --cache-blocks 0    # every block reference misses
+
+Point a client at it with --asr-port=8091 (GUI) or --port 8091 (headless).
+"""
+
+import argparse
+import json
+import math
+import struct
+import sys
+import threading
+import time
+from collections import OrderedDict
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+LMEL_HEADER = struct.Struct('<4sHHIHHIBBHffH2x')
+LMEL_CENTERED = 1
+QUANT_NAMES = {1: 'int8', 2: 'int16'}
+PBLK_HEADER = struct.Struct('<4sHHII')
+PBLK_ENTRY = struct.Struct('<B3xIIIQ')
+BLK_REF, BLK_DATA, BLK_TAIL = 1, 2, 3
+
+
+class BlockMiss(Exception):
+    pass
+
+
+class BlockCache:
+    """Content-addressed PCM blocks, least recently used evicted."""
+
+    def __init__(self, capacity):
+        self.capacity = capacity
+        self.blocks = OrderedDict()
+        self.lock = threading.Lock()
+
+    def get(self, h):
+        with self.lock:
+            data = self.blocks.get(h)
+            if data is not None:
+                self.blocks.move_to_end(h)
+            return data
+
+    def put(self, h, data):
+        if self.capacity <= 0:
+            return
+        with self.lock:
+            self.blocks[h] = data
+            self.blocks.move_to_end(h)
+            while len(self.blocks) > self.capacity:
+                self.blocks.popitem(last=False)
+
+
+def fnv1a64(data):
+    h = 0xcbf29ce484222325
+    for b in data:
+        h = ((h ^ b) * 0x100000001b3) & 0xFFFFFFFFFFFFFFFF
+    return h
+
+
+def parse_multipart(body, content_type):
+    """Split a multipart/form-data body. Returns {name: bytes}."""
+    boundary = None
+    for part in content_type.split(';'):
+        part = part.strip()
+        if part.startswith('boundary='):
+            boundary = part[9:].strip('"')
+    if not boundary:
+        raise ValueError("no multipart boundary")
+
+    fields = {}
+    delim = b'--' + boundary.encode()
+    for chunk in body.split(delim)[1:]:
+        if chunk.startswith(b'--'):
+            break
+        head, _, data = chunk.partition(b'\r\n\r\n')
+        if data.endswith(b'\r\n'):
+            data = data[:-2]
+        name = None
+        for line in head.decode('latin-1').split('\r\n'):
+            if line.lower().startswith('content-disposition'):
+                for attr in line.split(';'):
+                    attr = attr.strip()
+                    if attr.startswith('name='):
+                        name = attr[5:].strip('"')
+        if name:
+            fields[name] = data
+    return fields
+
+
+def decode_wav(data):
+    """Returns (sample_rate, n_samples) of a 16-bit PCM WAV."""
+    if data[:4] != b'RIFF' or data[8:12] != b'WAVE':
+        raise ValueError("not a WAV file")
+    sample_rate = struct.unpack('<I', data[24:28])[0]
+    pos = 12
+    while pos + 8 <= len(data):
+        cid, size = struct.unpack('<4sI', data[pos:pos + 8])
+        if cid == b'data':
+            size = min(size, len(data) - pos - 8)
+            return sample_rate, size // 2
+        pos += 8 + size
+    raise ValueError("WAV has no data chunk")
+
+
+def decode_lmel(data):
+    """Dequantize an LMEL block and normalize it as the server front-end
+    does (clamp to max - 8, then (x + 4) / 4). Returns (info, frames)."""
+    if len(data) < LMEL_HEADER.size:
+        raise ValueError("LMEL block too short")
+    (magic, version, n_mels, n_frames, hop, win, sample_rate, quant, flags,
+     n_fft, scale, offset, n_bins) = LMEL_HEADER.unpack_from(data)
+    if magic != b'LMEL' or version != 2:
+        raise ValueError("bad LMEL header")
+    if n_bins != n_fft // 2 + 1:
+        raise ValueError(f"LMEL bins {n_bins} do not match n_fft {n_fft}")
+    if quant not in QUANT_NAMES:
+        raise ValueError(f"unknown quantization {quant}")
+
+    fmt = 'b' if quant == 1 else 'h'
+    count = n_frames * n_mels
+    need = LMEL_HEADER.size + count * struct.calcsize(fmt)
+    if len(data) < need:
+        raise ValueError(f"LMEL block truncated ({len(data)} < {need} bytes)")
+    values = struct.unpack_from(f'<{count}{fmt}', data, LMEL_HEADER.size)
+
+    logmel = [q * scale + offset for q in values]
+    peak = max(logmel) if logmel else 0.0
+    floor = peak - 8.0
+    norm = [(max(v, floor) + 4.0) / 4.0 for v in logmel]
+    frames = [norm[i * n_mels:(i + 1) * n_mels] for i in range(n_frames)]
+
+    info = {
+        'frames': n_frames, 'mels': n_mels, 'hop': hop, 'win': win,
+        'n_fft': n_fft, 'centered': bool(flags & LMEL_CENTERED),
+        'sample_rate': sample_rate, 'quant': QUANT_NAMES[quant],
+        'peak_log10': round(peak, 3),
+    }
+    return info, frames
+
+
+def decode_pblk(data, cache):
+    """Assemble the window of a PBLK block list. Data blocks are checked
+    against their hash and cached; a reference to an unknown block raises
+    BlockMiss. Returns (sample_rate, pcm bytes, sent samples, referenced)."""
+    if len(data) < PBLK_HEADER.size:
+        raise ValueError("PBLK body too short")
+    magic, version, n_entries, sample_rate, total = PBLK_HEADER.unpack_from(data)
+    if magic != b'PBLK' or version != 1:
+        raise ValueError("bad PBLK header")
+    pos = PBLK_HEADER.size
+    pcm = bytearray()
+    sent = refs = 0
+    for _ in range(n_entries):
+        if pos + PBLK_ENTRY.size > len(data):
+            raise ValueError("PBLK entry truncated")
+        kind, offset, length, block_samples, h = PBLK_ENTRY.unpack_from(data, pos)
+        pos += PBLK_ENTRY.size
+        if kind == BLK_REF:
+            block = cache.get(h)
+            if block is None:
+                raise BlockMiss(f"{h:016x}")
+            refs += 1
+        elif kind in (BLK_DATA, BLK_TAIL):
+            block = bytes(data[pos:pos + block_samples * 2])
+            if len(block) != block_samples * 2:
+                raise ValueError("PBLK block truncated")
+            pos += block_samples * 2
+            sent += block_samples
+            if kind == BLK_DATA:
+                if fnv1a64(block) != h:
+                    raise ValueError(f"PBLK block hash mismatch {h:016x}")
+                cache.put(h, block)
+        else:
+            raise ValueError(f"unknown PBLK entry kind {kind}")
+        if offset + length > len(block) // 2:
+            raise ValueError("PBLK slice outside its block")
+        pcm += block[offset * 2:(offset + length) * 2]
+    if len(pcm) != total * 2:
+        raise ValueError(f"PBLK window is {len(pcm) // 2} samples, header says {total}")
+    return sample_rate, bytes(pcm), sent, refs
+
+
+def describe(kind, seconds, extra):
+    """Deterministic stand-in transcript: one word per started second."""
+    words = []
+    text = ''
+    n_words = max(1, math.ceil(seconds))
+    for i in range(n_words):
+        piece = (' ' if i else '') + f'{kind}{i}'
+        words.append({'word': piece.strip(), 'byte_offset': len(text),
+                      'audio_ms': int(min(i + 0.5, seconds) * 1000)})
+        text += piece
+    if extra:
+        text += f' [{extra}]'
+    return text, words
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    verbose = False
+    cache = BlockCache(0)
+    totals = {'requests': 0, 'bytes': 0}
+
+    def log_message(self, fmt, *args):
+        if self.verbose:
+            sys.stderr.write('[standin] ' + fmt % args + '\n')
+
+    def send_json(self, code, obj):
+        body = json.dumps(obj).encode()
+        self.send_response(code)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_POST(self):
+        if self.path != '/v1/audio/transcriptions':
+            self.send_json(404, {'error': 'not found'})
+            return
+        t0 = time.perf_counter()
+        length = int(self.headers.get('Content-Length', 0))
+        body = self.rfile.read(length)
+        try:
+            fields = parse_multipart(body, self.headers.get('Content-Type', ''))
+            if 'file' not in fields:
+                raise ValueError("missing file field")
+            fmt = fields.get('response_format', b'json').decode()
+            input_format = fields.get('input_format', b'wav').decode()
+            if input_format == 'log_mel':
+                info, _ = decode_lmel(fields['file'])
+                seconds = info['frames'] * info['hop'] / info['sample_rate']
+                text, words = describe('mel', seconds,
+                                       f"{info['frames']}x{info['mels']} {info['quant']} "
+                                       f"n_fft {info['n_fft']}")
+            elif input_format == 'pcm_blocks':
+                sample_rate, pcm, sent, refs = decode_pblk(fields['file'], self.cache)
+                seconds = len(pcm) / 2 / sample_rate
+                text, words = describe('pcm', seconds,
+                                       f"{sent / sample_rate:.2f}s sent, {refs} refs")
+            else:
+                sample_rate, n = decode_wav(fields['file'])
+                seconds = n / sample_rate
+                text, words = describe('pcm', seconds, '')
+        except BlockMiss as e:
+            sys.stderr.write(f"[standin] block miss {e}\n")
+            self.send_json(409, {'error': 'block_miss', 'missing': str(e)})
+            return
+        except ValueError as e:
+            self.send_json(400, {'error': str(e)})
+            return
+
+        Handler.totals['requests'] += 1
+        Handler.totals['bytes'] += length
+        sys.stderr.write(f"[standin] {input_format}: {length} bytes, {seconds:.2f}s "
+                         f"(total {Handler.totals['requests']} requests, "
+                         f"{Handler.totals['bytes']} bytes)\n")
+
+        elapsed = (time.perf_counter() - t0) * 1000.0
+        done = {'text': text, 'duration': seconds, 'words': words,
+                'perf_total_ms': elapsed, 'perf_encode_ms': elapsed,
+                'perf_decode_ms': 0.0, 'upload_bytes': length}
+
+        if fmt != 'streaming_verbose_json':
+            self.send_json(200, done)
+            return
+
+        events = []
+        for w in words:
+            piece = (' ' if w['byte_offset'] else '') + w['word']
+            events.append({'token': piece, 'audio_ms': w['audio_ms'],
+                           'byte_offset': w['byte_offset']})
+        done['done'] = True
+        events.append(done)
+        payload = ''.join(f'data: {json.dumps(e)}\n\n' for e in events).encode()
+        self.send_response(200)
+        self.send_header('Content-Type', 'text/event-stream')
+        self.send_header('Content-Length', str(len(payload)))
+        self.end_headers()
+        self.wfile.write(payload)
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Local ASR stand-in server')
+    ap.add_argument('--port', type=int, default=8091)
+    ap.add_argument('--cache-blocks', type=int, default=1024,
+                    help='PCM blocks kept for pcm_blocks references (default 1024)')
+    ap.add_argument('-v', '--verbose', action='store_true')
+    args = ap.parse_args()
+
+    Handler.verbose = args.verbose
+    Handler.cache = BlockCache(args.cache_blocks)
+    server = ThreadingHTTPServer(('127.0.0.1', args.port), Handler)
+    print(f"ASR stand-in on http://localhost:{args.port}", file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
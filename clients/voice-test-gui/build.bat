@@ -45,6 +45,198 @@ if %ERRORLEVEL% NEQ 0 (
     exit /b 1
 )
 
+REM Compile shared recording store
+echo Compiling rec_store...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\rec_store.c" /Fo:"%BUILD_DIR%\rec_store.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo rec_store compilation failed.
+    exit /b 1
+)
+
+REM Compile shared capture ring
+echo Compiling capture_ring...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\capture_ring.c" /Fo:"%BUILD_DIR%\capture_ring.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo capture_ring compilation failed.
+    exit /b 1
+)
+
+REM Compile shared audio blocks
+echo Compiling audio_buf...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\audio_buf.c" /Fo:"%BUILD_DIR%\audio_buf.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo audio_buf compilation failed.
+    exit /b 1
+)
+
+REM Compile shared streaming WAV writer
+echo Compiling wav_writer...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\wav_writer.c" /Fo:"%BUILD_DIR%\wav_writer.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo wav_writer compilation failed.
+    exit /b 1
+)
+
+REM Compile shared waveform level pyramid
+echo Compiling level_pyramid...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\level_pyramid.c" /Fo:"%BUILD_DIR%\level_pyramid.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo level_pyramid compilation failed.
+    exit /b 1
+)
+
+REM Compile shared task executor
+echo Compiling executor...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\executor.c" /Fo:"%BUILD_DIR%\executor.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo executor compilation failed.
+    exit /b 1
+)
+
+REM Compile shared silence trimming
+echo Compiling silence_trim...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\silence_trim.c" /Fo:"%BUILD_DIR%\silence_trim.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo silence_trim compilation failed.
+    exit /b 1
+)
+
+REM Compile shared lossless audio codec
+echo Compiling lac...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\lac.c" /Fo:"%BUILD_DIR%\lac.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo lac compilation failed.
+    exit /b 1
+)
+
+REM Compile shared session archive
+echo Compiling session_log...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\session_log.c" /Fo:"%BUILD_DIR%\session_log.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo session_log compilation failed.
+    exit /b 1
+)
+
+REM Compile shared real FFT
+echo Compiling fft...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\fft.c" /Fo:"%BUILD_DIR%\fft.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo fft compilation failed.
+    exit /b 1
+)
+
+REM Compile shared spectral VAD
+echo Compiling vad...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\vad.c" /Fo:"%BUILD_DIR%\vad.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo vad compilation failed.
+    exit /b 1
+)
+
+REM Compile shared log-mel front-end
+echo Compiling mel_frontend...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\mel_frontend.c" /Fo:"%BUILD_DIR%\mel_frontend.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo mel_frontend compilation failed.
+    exit /b 1
+)
+
+REM Compile shared block upload
+echo Compiling block_upload...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\block_upload.c" /Fo:"%BUILD_DIR%\block_upload.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo block_upload compilation failed.
+    exit /b 1
+)
+
+REM Compile shared TTS clip cache
+echo Compiling tts_cache...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_cache.c" /Fo:"%BUILD_DIR%\tts_cache.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo tts_cache compilation failed.
+    exit /b 1
+)
+
+REM Compile shared TTS disk cache
+echo Compiling tts_store...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_store.c" /Fo:"%BUILD_DIR%\tts_store.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo tts_store compilation failed.
+    exit /b 1
+)
+
+REM Compile shared prefetch priority queue
+echo Compiling prefetch_queue...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\prefetch_queue.c" /Fo:"%BUILD_DIR%\prefetch_queue.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo prefetch_queue compilation failed.
+    exit /b 1
+)
+
+REM Compile shared grouping index
+echo Compiling grouping_index...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\grouping_index.c" /Fo:"%BUILD_DIR%\grouping_index.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo grouping_index compilation failed.
+    exit /b 1
+)
+
+REM Compile shared audio sink
+echo Compiling audio_sink...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\audio_sink.c" /Fo:"%BUILD_DIR%\audio_sink.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo audio_sink compilation failed.
+    exit /b 1
+)
+
+REM Compile shared TTS stream parser
+echo Compiling tts_stream...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_stream.c" /Fo:"%BUILD_DIR%\tts_stream.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo tts_stream compilation failed.
+    exit /b 1
+)
+
+REM Compile shared base64 decoder
+echo Compiling base64...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\base64.c" /Fo:"%BUILD_DIR%\base64.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo base64 compilation failed.
+    exit /b 1
+)
+
+REM Compile shared 2x upsampler
+echo Compiling upsample2...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\upsample2.c" /Fo:"%BUILD_DIR%\upsample2.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo upsample2 compilation failed.
+    exit /b 1
+)
+
+REM Compile shared time-stretch
+echo Compiling wsola...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\wsola.c" /Fo:"%BUILD_DIR%\wsola.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo wsola compilation failed.
+    exit /b 1
+)
+
+REM Compile shared TTS request queue
+echo Compiling tts_queue...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_queue.c" /Fo:"%BUILD_DIR%\tts_queue.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo tts_queue compilation failed.
+    exit /b 1
+)
+
+REM Compile shared TTS voice presets
+echo Compiling tts_request...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_request.c" /Fo:"%BUILD_DIR%\tts_request.obj"
+if %ERRORLEVEL% NEQ 0 (
+    echo tts_request compilation failed.
+    exit /b 1
+)
+
 REM Compile GUI
 echo Compiling GUI (debug)...
 cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c src\main.c /Fo:"%BUILD_DIR%\main.obj"
@@ -55,7 +247,7 @@ if %ERRORLEVEL% NEQ 0 (
 
 REM Link
 echo Linking...
-link /nologo /DEBUG /MAP:"%BIN_DIR%\voice-test-gui.map" /SUBSYSTEM:WINDOWS /OUT:"%BIN_DIR%\voice-test-gui.exe" "%BUILD_DIR%\main.obj" "%BUILD_DIR%\asr_client.obj" mfplat.lib mf.lib mfreadwrite.lib mfuuid.lib ole32.lib comctl32.lib user32.lib gdi32.lib winmm.lib winhttp.lib psapi.lib advapi32.lib dbghelp.lib
+link /nologo /DEBUG /MAP:"%BIN_DIR%\voice-test-gui.map" /SUBSYSTEM:WINDOWS /OUT:"%BIN_DIR%\voice-test-gui.exe" "%BUILD_DIR%\main.obj" "%BUILD_DIR%\asr_client.obj" "%BUILD_DIR%\rec_store.obj" "%BUILD_DIR%\capture_ring.obj" "%BUILD_DIR%\audio_buf.obj" "%BUILD_DIR%\wav_writer.obj" "%BUILD_DIR%\level_pyramid.obj" "%BUILD_DIR%\executor.obj" "%BUILD_DIR%\silence_trim.obj" "%BUILD_DIR%\lac.obj" "%BUILD_DIR%\session_log.obj" "%BUILD_DIR%\fft.obj" "%BUILD_DIR%\vad.obj" "%BUILD_DIR%\mel_frontend.obj" "%BUILD_DIR%\block_upload.obj" "%BUILD_DIR%\tts_cache.obj" "%BUILD_DIR%\tts_store.obj" "%BUILD_DIR%\prefetch_queue.obj" "%BUILD_DIR%\grouping_index.obj" "%BUILD_DIR%\audio_sink.obj" "%BUILD_DIR%\tts_stream.obj" "%BUILD_DIR%\base64.obj" "%BUILD_DIR%\upsample2.obj" "%BUILD_DIR%\wsola.obj" "%BUILD_DIR%\tts_queue.obj" "%BUILD_DIR%\tts_request.obj" mfplat.lib mf.lib mfreadwrite.lib mfuuid.lib ole32.lib comctl32.lib user32.lib gdi32.lib winmm.lib winhttp.lib psapi.lib advapi32.lib dbghelp.lib
 
 if %ERRORLEVEL% EQU 0 (
     echo.
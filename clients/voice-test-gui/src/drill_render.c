@@ -66,6 +66,43 @@ static int s_group_of[DRILL_MAX_TEXT];
 static int s_grp_start_ms[DRILL_MAX_TEXT], s_grp_end_ms[DRILL_MAX_TEXT];
 static int s_cell_w, s_num_target, s_n_groups;
 
+/* Back buffer kept across paints and rebuilt on resize, so the 50 ms
+ * playback repaints don't create a window-sized bitmap each time */
+static HDC     s_back_dc = NULL;
+static HBITMAP s_back_bmp = NULL, s_back_old_bmp = NULL;
+static int     s_back_w = 0, s_back_h = 0;
+
+static void drill_back_free(void)
+{
+    if (!s_back_dc) return;
+    SelectObject(s_back_dc, s_back_old_bmp);
+    DeleteObject(s_back_bmp);
+    DeleteDC(s_back_dc);
+    s_back_dc = NULL;
+    s_back_bmp = s_back_old_bmp = NULL;
+    s_back_w = s_back_h = 0;
+}
+
+/* w x h back buffer compatible with hdc_screen, or NULL */
+static HDC drill_back_dc(HDC hdc_screen, int w, int h)
+{
+    if (s_back_dc && s_back_w == w && s_back_h == h) return s_back_dc;
+    drill_back_free();
+    s_back_dc = CreateCompatibleDC(hdc_screen);
+    s_back_bmp = CreateCompatibleBitmap(hdc_screen, w, h);
+    if (!s_back_dc || !s_back_bmp) {
+        if (s_back_bmp) DeleteObject(s_back_bmp);
+        if (s_back_dc) DeleteDC(s_back_dc);
+        s_back_dc = NULL;
+        s_back_bmp = NULL;
+        return NULL;
+    }
+    s_back_old_bmp = (HBITMAP)SelectObject(s_back_dc, s_back_bmp);
+    s_back_w = w;
+    s_back_h = h;
+    return s_back_dc;
+}
+
 /* Copy UTF-8 string to clipboard as Unicode */
 static void drill_copy_to_clipboard(HWND hwnd, const char *utf8)
 {
@@ -324,9 +361,11 @@ static LRESULT CALLBACK DrillWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
         int h = rc.bottom - rc.top;
 
         /* Double buffering */
-        HDC hdc = CreateCompatibleDC(hdc_screen);
-        HBITMAP bmp = CreateCompatibleBitmap(hdc_screen, w, h);
-        HBITMAP old_bmp = (HBITMAP)SelectObject(hdc, bmp);
+        HDC hdc = drill_back_dc(hdc_screen, w, h);
+        if (!hdc) {
+            EndPaint(hwnd, &ps);
+            return 0;
+        }
 
         /* Background */
         HBRUSH bg_brush = CreateSolidBrush(DRILL_COLOR_BG);
@@ -386,27 +425,15 @@ static LRESULT CALLBACK DrillWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
         int cell_w = char_size.cx + 6;
         int cell_h = char_size.cy + 4;
 
-        /* Snapshot word timestamps under lock */
-        EnterCriticalSection(&g_tts_current_ts_lock);
-        TtsTimestamps ts_snap = {0};
-        if (g_tts_current_ts.count > 0 && g_tts_current_ts.words) {
-            ts_snap.count = g_tts_current_ts.count;
-            ts_snap.words = (TtsWordTimestamp *)malloc(
-                ts_snap.count * sizeof(TtsWordTimestamp));
-            if (ts_snap.words)
-                memcpy(ts_snap.words, g_tts_current_ts.words,
-                       ts_snap.count * sizeof(TtsWordTimestamp));
-            else
-                ts_snap.count = 0;
-        }
-        LeaveCriticalSection(&g_tts_current_ts_lock);
+        /* Word timestamps: borrowed, valid for this paint (no lock, no copy) */
+        const TtsTimestamps *ts_view = tts_current_words();
 
         /* Word group mapping from TTS timestamps */
         int group_of[DRILL_MAX_TEXT] = {0};
         int grp_start[DRILL_MAX_TEXT] = {0};
         int grp_end[DRILL_MAX_TEXT] = {0};
         int n_groups = map_chars_to_word_groups(target_cps, num_target,
-                                                 &ts_snap, group_of,
+                                                 ts_view, group_of,
                                                  grp_start, grp_end);
 
         /* Split pinyin into syllables + measure per-group widths for layout */
@@ -569,7 +596,7 @@ static LRESULT CALLBACK DrillWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
             phase = 3;
         } else if (g_is_recording) {
             phase = 1;
-        } else if (g_transcribe_thread != NULL) {
+        } else if (g_transcribe_task != NULL) {
             phase = 2;
         } else {
             phase = 0;
@@ -754,7 +781,7 @@ static LRESULT CALLBACK DrillWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
                 RECT fb_rc = { margin, status_y, w / 3, status_y + 24 };
                 char tts_msg[64];
                 snprintf(tts_msg, sizeof(tts_msg), "Generating [%s]...",
-                         g_tts_voices[g_tts_voice_idx]);
+                         tts_voices[g_tts_voice_idx]);
                 DrawTextA(hdc, tts_msg, -1, &fb_rc,
                           DT_LEFT | DT_SINGLELINE | DT_VCENTER);
             } else if (g_tts_state == 2) {
@@ -762,7 +789,7 @@ static LRESULT CALLBACK DrillWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
                 RECT fb_rc = { margin, status_y, w / 3, status_y + 24 };
                 char play_msg[64];
                 snprintf(play_msg, sizeof(play_msg), ">> %s  L:stop",
-                         g_tts_voices[g_tts_voice_idx]);
+                         tts_voices[g_tts_voice_idx]);
                 DrawTextA(hdc, play_msg, -1, &fb_rc,
                           DT_LEFT | DT_SINGLELINE | DT_VCENTER);
             } else if (g_tts_state == 3) {
@@ -822,14 +849,9 @@ static LRESULT CALLBACK DrillWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
             }
         }
 
-        free(ts_snap.words);
-
 paint_done:
         /* Blit to screen */
         BitBlt(hdc_screen, 0, 0, w, h, hdc, 0, 0, SRCCOPY);
-        SelectObject(hdc, old_bmp);
-        DeleteObject(bmp);
-        DeleteDC(hdc);
 
         EndPaint(hwnd, &ps);
         return 0;
@@ -904,6 +926,10 @@ paint_done:
         return 0;
     }
 
+    case WM_DESTROY:
+        drill_back_free();
+        return 0;
+
     default:
         return DefWindowProc(hwnd, msg, wParam, lParam);
     }
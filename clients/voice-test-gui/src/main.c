@@ -36,6 +36,28 @@
 #include <time.h>
 
 #include "asr_client.h"
+#include "rec_store.h"
+#include "capture_ring.h"
+#include "wav_writer.h"
+#include "level_pyramid.h"
+#include "executor.h"
+#include "silence_trim.h"
+#include "lac.h"
+#include "session_log.h"
+#include "vad.h"
+#include "mel_frontend.h"
+#include "block_upload.h"
+#include "tts_cache.h"
+#include "tts_store.h"
+#include "prefetch_queue.h"
+#include "grouping_index.h"
+#include "audio_sink.h"
+#include "tts_stream.h"
+#include "base64.h"
+#include "upsample2.h"
+#include "wsola.h"
+#include "tts_queue.h"
+#include "tts_request.h"
 #include "drill.h"
 
 /* GUIDs */
@@ -66,8 +88,8 @@ DEFINE_GUID(IID_ISpVoice, 0x6C44DF74, 0x72B9, 0x4992,
 /* Configuration */
 #define WHISPER_SAMPLE_RATE 16000
 #define CHUNK_MS           2000
-#define MAX_AUDIO_SECONDS  120
-#define MAX_AUDIO_SAMPLES  (WHISPER_SAMPLE_RATE * MAX_AUDIO_SECONDS)
+#define REC_MEM_BUDGET     (16 * 1024 * 1024)  /* ~8.7 min resident, rest spills to disk */
+#define CAPTURE_RING_SAMPLES (1 << 17)         /* ~8 s of slack between capture and UI */
 #define WAVEFORM_BARS      60
 #define WAVEFORM_UPDATE_MS 50
 #define STABILITY_COUNT    2
@@ -75,7 +97,6 @@ DEFINE_GUID(IID_ISpVoice, 0x6C44DF74, 0x72B9, 0x4992,
 #define SILENCE_CHUNKS     4
 
 /* Timeline scrubbing - store energy for entire recording */
-#define MAX_STORED_BARS    (MAX_AUDIO_SECONDS * 1000 / WAVEFORM_UPDATE_MS)  /* 2400 bars max */
 #define SAMPLES_PER_BAR    (WHISPER_SAMPLE_RATE * WAVEFORM_UPDATE_MS / 1000) /* 800 samples */
 
 /* Colors */
@@ -184,73 +205,151 @@ static int g_tts_enabled = 1;
 
 /* Server-based TTS (local-ai-server /v1/audio/speech) */
 #define TTS_SERVER_PORT 8090
-#define TTS_RESPONSE_BUF (4 * 1024 * 1024)  /* 4 MB for WAV data */
-static HWAVEOUT g_waveout = NULL;
-static HANDLE g_waveout_done_event = NULL;
+#define TTS_SINK_START_MS 200   /* audio queued before a stream starts playing */
+static int g_tts_stream = 1;    /* play while downloading; --no-tts-stream */
 static volatile LONG g_tts_playback_ms = -1;    /* -1 = not playing, >=0 = position ms */
+static volatile LONG g_tts_speed_pct = 100;     /* playback speed, 50..150 (+/- in drill mode) */
 static volatile LONG g_tts_interrupt = 0;
 static volatile HINTERNET g_tts_worker_hrequest = NULL;  /* in-flight HTTP for cancellation */
-static char *g_tts_pending_text = NULL;
-static int g_tts_pending_voice_idx = 0;
-static int g_tts_pending_sentence_idx = -1;
-static int g_tts_pending_seed = -1;  /* -1=use locked, -2=force random (tuning), >=0=explicit */
-static CRITICAL_SECTION g_tts_lock;
+static int g_tts_server_replies = 0;   /* --tts-replies: LLM/pipe replies in the server voice */
 static HANDLE g_tts_request_event = NULL;
 static HANDLE g_tts_shutdown_event = NULL;
 static HANDLE g_tts_thread = NULL;
 static volatile int g_tts_state = 0;  /* 0=idle, 1=generating, 2=speaking, 3=error */
 
-/* Server TTS voice presets (Qwen3-TTS) */
-static const char *g_tts_voices[] = {
-    "Vivian", "Serena", "Uncle_Fu", "Dylan", "Eric",
-    "Ryan", "Aiden", "Ono_Anna", "Sohee"
-};
-#define TTS_NUM_VOICES (sizeof(g_tts_voices) / sizeof(g_tts_voices[0]))
+/* Server TTS voice presets: tts_voices (tts_request.h) */
 static int g_tts_voice_idx = 0;  /* Vivian default */
 static int g_tts_voice_seeds[TTS_NUM_VOICES];    /* -1 = unlocked, >=0 = locked seed */
 static volatile LONG g_tts_last_seed = -1;       /* seed from last auditioned TTS */
 
 /* TTS word timestamps (from ASR on generated audio) */
-typedef struct {
-    char word[64];    /* UTF-8 word text */
-    int  start_ms;
-    int  end_ms;
-} TtsWordTimestamp;
+typedef tts_word_t TtsWordTimestamp;
 
 typedef struct {
     TtsWordTimestamp *words;  /* malloc'd, NULL if none */
     int              count;
 } TtsTimestamps;
 
-/* Last-WAV cache: single-entry cache keyed by sentence_idx + voice_idx.
- * Stores both the WAV data and the timestamps from that specific fetch,
- * so replay karaoke timing matches the cached audio (not a different voice). */
-static char            *g_tts_last_wav = NULL;
-static int              g_tts_last_wav_len = 0;
-static int              g_tts_last_wav_sentence = -1;
-static int              g_tts_last_wav_voice = -1;
-static TtsWordTimestamp *g_tts_last_wav_words = NULL;
-static int              g_tts_last_wav_word_count = 0;
-static CRITICAL_SECTION g_tts_last_wav_lock;
-
-/* Per-sentence word groupings (voice-independent, never purged) */
-static TtsTimestamps   *g_tts_groupings       = NULL;  /* malloc'd [num_sentences] */
+/* Word timestamps shared between threads: immutable once published and
+ * swapped in whole with InterlockedExchangePointer, so readers borrow the
+ * view without a lock or a copy. A replaced block is retired, not freed,
+ * until no reader can still hold it. */
+typedef struct TtsWordsBlock {
+    struct TtsWordsBlock *next_retired;
+    int                   table;    /* owned by the groupings table */
+    TtsTimestamps         view;     /* words follow the header */
+} TtsWordsBlock;
+
+/* Decoded TTS clips keyed by (text, voice, seed). Each clip holds the PCM
+ * at the device rate and the timestamps from that specific fetch, so replay
+ * karaoke timing matches the cached audio; replay and word slices take a
+ * reference instead of refetching or converting. Seed -1 is the unlocked
+ * voice's most recent random take. */
+#define TTS_CACHE_BYTES (96u * 1024 * 1024)
+static tts_cache_t     *g_tts_cache = NULL;
+
+/* Disk tier under tts_cache\audio for takes with a known seed, at the
+ * server's rate. Keyed by model too (--tts-model=<id>) so a server model
+ * change doesn't replay old audio. Writes and trims run on the prefetch
+ * lane; a memory miss reads through it before asking the server. Capped at
+ * TTS_STORE_BYTES. */
+static tts_store_t     *g_tts_store = NULL;
+static char             g_tts_model_id[64] = "qwen3-tts";
+
+/* Every sentence's groupings in one packed file, tts_cache\groupings.idx.
+ * Replaces the old per-sentence tts_cache\groupings\<hash>.ts files, which
+ * are still read (and imported) on an index miss. */
+static gidx_t          *g_grouping_index = NULL;
+
+/* Per-sentence word groupings (voice-independent, never purged). Replaced
+ * blocks are kept on the retired list until tts_groupings_destroy, so a
+ * published block stays valid for the whole session. */
+static TtsWordsBlock * volatile *g_tts_groupings = NULL;  /* malloc'd [num_sentences] */
 static int              g_tts_groupings_count  = 0;
-static CRITICAL_SECTION g_tts_groupings_lock;
-
-/* Current word timestamps (set by worker thread, read by drill renderer for playback timing) */
-static TtsTimestamps    g_tts_current_ts = {0};
-static CRITICAL_SECTION g_tts_current_ts_lock;
-
-/* TTS pre-fetch thread (fetches word groupings only) */
-static HANDLE           g_tts_prefetch_event     = NULL;  /* auto-reset */
-static HANDLE           g_tts_prefetch_shutdown   = NULL;  /* manual-reset */
-static HANDLE           g_tts_prefetch_thread     = NULL;
-static volatile HINTERNET g_tts_prefetch_hrequest = NULL;  /* in-flight HTTP for cancellation */
-static volatile LONG    g_tts_prefetch_priority   = -1;    /* sentence to fetch next */
+static TtsWordsBlock * volatile g_tts_groupings_retired = NULL;
+
+/* Current word timestamps (set by worker and UI threads, read only by the
+ * drill renderer on the UI thread). Retired blocks are freed on the UI
+ * thread between paints by tts_current_words_reclaim. */
+static TtsWordsBlock * volatile g_tts_current_words = NULL;
+static TtsWordsBlock * volatile g_tts_current_retired = NULL;
+
+/* Shared worker pool for transient background work (ASR passes, live
+ * session start/stop, word-slice playback, prefetch steps) */
+#define EXECUTOR_WORKERS 4
+static executor_t      *g_executor = NULL;
+
+/* TTS pre-fetch (fetches word groupings only). Sentences wait in a
+ * priority queue: the sweep at priority 0, explicit requests above it,
+ * newest first. Up to g_tts_prefetch_jobs one-sentence steps run at once
+ * on the executor's prefetch lane, each in its own slot; a failed sentence
+ * is retried with exponential backoff. */
+#define TTS_PREFETCH_MAX_JOBS    8
+#define TTS_PREFETCH_BACKOFF_MS  2000
+#define TTS_PREFETCH_BACKOFF_MAX 120000
+static int              g_tts_prefetch_jobs       = 3;     /* --prefetch-jobs=N */
+static pfq_t           *g_tts_prefetch_queue      = NULL;
+static exec_cancel_t   *g_tts_prefetch_cancel     = NULL;
+static volatile LONG    g_tts_prefetch_slot_busy[TTS_PREFETCH_MAX_JOBS];   /* step queued/running */
+static volatile HINTERNET g_tts_prefetch_hrequest[TTS_PREFETCH_MAX_JOBS];  /* per-slot HTTP for cancellation */
+static volatile LONG    g_tts_prefetch_waiter     = 0;     /* slot + 1 of the step delayed over backoffs */
+static volatile LONG    g_tts_prefetch_pri        = 0;     /* last explicit priority handed out */
 static volatile LONG    g_tts_prefetch_done       = 0;     /* completed count for progress UI */
 static volatile LONG    g_tts_prefetch_total      = 0;     /* total sentences for progress UI */
 
+/* Speech requests, in a tts_queue. Seeds there are request seeds: -1 =
+ * voice's locked seed (or random), -2 = force random (tuning), >= 0 =
+ * explicit. The worker plays the playback classes one after another:
+ * interactive requests (L key, auditions) stop what is playing and drop the
+ * playback queued behind it; queued ones (replies, sentence by sentence)
+ * wait their turn. One synthesis step at a time on the executor makes the
+ * best waiting request ahead into the clip cache, never while the worker is
+ * fetching: the next queued sentence while one plays, so sentences play
+ * back to back, then the likely next drill sentences after each advance
+ * (drill_peek_next; the top g_tts_predict_count, the first as speculation
+ * and the rest as prefetch). A new advance drops the guesses that haven't
+ * started; the worker joins a synthesis in flight for what it wants
+ * instead of requesting it again. */
+#define TTS_PREDICT_MAX 4
+static ttsq_t          *g_tts_queue               = NULL;
+static int              g_tts_predict_count       = 2;     /* --predict=K, 0 = off */
+static exec_cancel_t   *g_tts_synth_cancel        = NULL;
+static volatile HINTERNET g_tts_synth_hrequest    = NULL;
+static HANDLE           g_tts_synth_done_event    = NULL;  /* auto-reset, set as one ends */
+static volatile LONG    g_tts_synth_busy          = 0;     /* step queued or running */
+static volatile LONG    g_tts_synth_kicks         = 0;     /* kicks so far, see tts_synth_step */
+static volatile LONG    g_tts_worker_fetching     = 0;     /* worker is on the server */
+
+/* Audition batch (Ctrl+Shift+> in drill mode): the current sentence in
+ * every voice with g_tts_audition_count fresh seeds each, synthesized up to
+ * g_tts_audition_jobs at a time on the prefetch lane and filed in the clip
+ * cache (and on disk) under the seeds the server reports. [ and ] flip
+ * through the finished takes straight from the cache; Shift+< locks the one
+ * playing. Steps requeue per take like prefetch steps and the pool has a
+ * worker for each job, so playback never waits behind a batch. */
+#define TTS_AUDITION_MAX      8     /* seeds per voice */
+#define TTS_AUDITION_MAX_JOBS 8
+typedef struct {
+    int voice_idx;
+    volatile LONG seed;             /* -1 until the take is cached */
+} TtsAuditionTake;
+typedef struct {
+    volatile LONG refs;             /* g_tts_audition + one per job */
+    char *text;
+    int sentence_idx;
+    int count;
+    TtsAuditionTake takes[TTS_NUM_VOICES * TTS_AUDITION_MAX];
+    volatile LONG next;             /* next take to synthesize */
+    volatile LONG ready;
+    exec_cancel_t *cancel;
+    volatile HINTERNET hrequest[TTS_AUDITION_MAX_JOBS];
+} TtsAudition;
+static int              g_tts_audition_count      = 2;     /* --audition=N */
+static int              g_tts_audition_jobs       = 3;     /* --audition-jobs=N */
+static TtsAudition     *g_tts_audition            = NULL;  /* UI thread */
+static int              g_tts_audition_cursor     = -1;    /* take playing, UI thread */
+static volatile LONG    g_tts_audition_busy       = 0;     /* steps queued or running */
+
 /* System/hardware info (queried once at startup) */
 static char g_os_version[64] = "";
 static char g_cpu_name[128] = "";
@@ -319,14 +418,29 @@ static const char *g_tutor_system_prompt =
     "- If the student's Mandarin is correct, say so briefly then give the next prompt\n"
     "- Always include all five sections";
 
-static float g_audio_buffer[MAX_AUDIO_SAMPLES];
-static int g_audio_write_pos = 0;
-static int g_audio_samples = 0;
-static CRITICAL_SECTION g_audio_lock;
-
-/* Full recording buffer for WAV saving (never cleared during recording) */
-static float g_recording_buffer[MAX_AUDIO_SAMPLES];
-static int g_recording_samples = 0;
+/* Capture thread -> UI thread handoff (lock-free SPSC) */
+static capture_ring_t *g_capture_ring = NULL;
+static int64_t g_energy_prev_pos = 0;
+static int64_t g_energy_prev_sum = 0;
+static int64_t g_capture_overruns_logged = 0;
+/* Samples drained from the ring that the store could not take yet; retried
+ * before reading more, so the ring (and its overrun count) absorbs a stall */
+static int16_t g_capture_held[4096];
+static int g_capture_held_n = 0;
+
+/* Full recording (int16 segments, never cleared during recording).
+ * Written only by the UI thread as it drains the capture ring. */
+static rec_store_t *g_rec_store = NULL;
+
+/* Start of the current VAD speech block within the recording */
+static int g_vad_block_start = 0;
+
+/* Recording WAV, written in the background as audio is drained */
+static wav_writer_t *g_wav_writer = NULL;
+static int g_wav_queued = 0;            /* samples handed to the writer */
+static char g_wav_path[MAX_PATH];
+static char g_rec_stamp[32];              /* YYYYMMDD_HHMMSS of the current recording */
+static sess_writer_t *g_session = NULL;  /* session archive, open until the next recording */
 
 /* No model context needed -- transcription via HTTP to local-ai-server */
 
@@ -336,12 +450,28 @@ static HANDLE g_capture_thread = NULL;
 static int g_is_recording = 0;
 
 /* Waveform data */
-static float g_waveform_levels[WAVEFORM_BARS];
 static float g_current_energy = 0.0f;
 
-/* Stored waveform for entire recording (for scrubbing after stop) */
-static float g_stored_levels[MAX_STORED_BARS];
+/* min/max/RMS pyramid over the whole recording, fed from the drained
+ * samples. Both the live view and scrubbing after stop draw from it. */
+static level_pyr_t *g_level_pyr = NULL;
+
+/* Spectral VAD over the drained samples; speech frames are counted until
+ * the next VAD check so a short burst between checks is not lost */
+static vad_t *g_vad = NULL;
+static int g_vad_speech_frames = 0;
+
+/* --mel-upload[=int8|int16] (--mel-bins=N, default 128): log-mel frames
+ * are computed here as audio is drained and retranscribe passes upload
+ * them instead of PCM */
+static mel_fe_t *g_mel = NULL;
+
+/* --block-upload: retranscribe passes reference audio blocks the server
+ * already holds and only send new ones */
+static blk_uploader_t *g_blk = NULL;
+static volatile LONG g_blk_rejected = 0;    /* server refused blocks (not a cache miss) */
 static int g_stored_bar_count = 0;
+static int g_bar_samples = SAMPLES_PER_BAR;  /* zoom: samples per bar (stopped) */
 
 /* Timeline scrubbing state */
 static int g_scroll_offset = 0;          /* Which bar is at left edge of view */
@@ -368,12 +498,13 @@ static float g_audio_seconds = 0.0f;
 static int g_committed_samples = 0;  /* audio offset past stable sentences */
 static int g_window_samples = 0;     /* samples in last transcription window */
 static volatile int g_transcribing = 0;
-static HANDLE g_transcribe_thread = NULL;  /* saved for join before context mutation */
+static exec_task_t *g_transcribe_task = NULL;  /* saved for join before context mutation */
 
 /* Resource monitoring stats (second stats row) */
 static int    g_pass_count = 0;           /* retranscription passes so far */
 static double g_last_transcribe_ms = 0;   /* wall-clock time of last pass */
 static double g_last_audio_window_sec = 0;/* audio duration transcribed */
+static double g_trim_saved_sec = 0;       /* silence trimmed before upload */
 static double g_last_rtf = 0;            /* realtime factor (< 1.0 = good) */
 static double g_last_encode_ms = 0;      /* encoder time */
 static double g_last_decode_ms = 0;      /* decoder time */
@@ -495,173 +626,186 @@ static void log_event(const char *event, const char *detail) {
 }
 
 
-/* Forward declaration (defined later with LLM code) */
-static int json_escape(const char *src, char *dst, int dst_size);
+/* ---- TTS playback (audio_sink, int16 PCM at the device rate) ---- */
 
-/* ---- waveOut playback (int16 PCM from server WAV) ---- */
+/* Device rate for TTS audio at sample_rate. 24kHz is interpolated to 48kHz
+ * (upsample2) to avoid inconsistent Windows mixer resampling (24kHz is
+ * non-standard, 48kHz is native). */
+static int tts_device_rate(int sample_rate) {
+    return (sample_rate == 24000) ? 48000 : sample_rate;
+}
 
-static int g_waveout_base_sr = 0;  /* base rate before speed (always 48000 for 24kHz source) */
+/* Convert a decoded TTS block to tts_device_rate(*sr). Takes over the
+ * caller's reference on src and returns the block to use (src itself when
+ * no conversion is needed), updating *sr. Returns NULL on failure. */
+static audio_block_t *tts_to_device_rate(audio_block_t *src, int *sr) {
+    if (tts_device_rate(*sr) == *sr) return src;
+    audio_block_t *out = audio_block_new(src->n_samples * 2);
+    if (!out) { audio_block_release(src); return NULL; }
+    up2_block(src->samples, src->n_samples, out->samples);
+    audio_block_release(src);
+    *sr = tts_device_rate(*sr);
+    return out;
+}
 
-/* Open waveOut device at given sample rate, mono 16-bit PCM. Returns 1 on success.
- * 24kHz is upsampled to 48kHz to avoid inconsistent Windows mixer resampling. */
-static int waveout_open(int sample_rate) {
-    g_waveout_done_event = CreateEventA(NULL, FALSE, FALSE, NULL);
-    if (!g_waveout_done_event) return 0;
+/* Worker thread: time-stretch for the open take, NULL at 1x. Set by
+ * tts_sink_start_take from g_tts_speed_pct, so a speed change applies from
+ * the next take on without re-synthesis. */
+static wsola_t *g_tts_stretch = NULL;
+static long long g_tts_take_base = 0;   /* sink samples queued before the take */
+
+/* Start a take on sink: a fresh stretch at the current speed, positions
+ * counted from what is queued so far */
+static void tts_sink_start_take(audio_sink_t *sink) {
+    wsola_destroy(g_tts_stretch);
+    g_tts_stretch = NULL;
+    LONG pct = InterlockedCompareExchange(&g_tts_speed_pct, 0, 0);
+    if (pct != 100) {
+        g_tts_stretch = wsola_create(audio_sink_rate(sink), pct / 100.0);
+        if (!g_tts_stretch) log_event("TTS_SRV", "Time-stretch unavailable, playing at 1x");
+    }
+    g_tts_take_base = audio_sink_played(sink) + audio_sink_pending(sink);
+}
 
-    /* Open at 48kHz for 24kHz source — waveout_play_pcm does the 2x upsample */
-    int base_rate = (sample_rate == 24000) ? 48000 : sample_rate;
-    int device_rate = base_rate;
-    g_waveout_base_sr = base_rate;
+static audio_sink_t *tts_sink_open(int sample_rate, int start_ms) {
+    audio_sink_t *sink = audio_sink_open_waveout(sample_rate, start_ms);
+    if (sink) tts_sink_start_take(sink);
+    return sink;
+}
 
-    WAVEFORMATEX wfx = {0};
-    wfx.wFormatTag = WAVE_FORMAT_PCM;
-    wfx.nChannels = 1;
-    wfx.nSamplesPerSec = (DWORD)device_rate;
-    wfx.wBitsPerSample = 16;
-    wfx.nBlockAlign = wfx.nChannels * wfx.wBitsPerSample / 8;
-    wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
-
-    MMRESULT mr = waveOutOpen(&g_waveout, WAVE_MAPPER, &wfx,
-                              (DWORD_PTR)g_waveout_done_event,
-                              0, CALLBACK_EVENT);
-    if (mr != MMSYSERR_NOERROR) {
-        CloseHandle(g_waveout_done_event);
-        g_waveout_done_event = NULL;
-        g_waveout = NULL;
-        log_event("WAVEOUT", "waveOutOpen failed");
-        return 0;
-    }
+static void tts_sink_close(audio_sink_t *sink) {
+    audio_sink_close(sink);
+    wsola_destroy(g_tts_stretch);
+    g_tts_stretch = NULL;
+}
 
-    log_event("WAVEOUT", "Opened successfully");
-    return 1;
+/* Karaoke position: ms of the take played so far, in original (unstretched)
+ * time so word highlighting follows at any speed */
+static void tts_sink_publish_position(audio_sink_t *sink) {
+    int sr = audio_sink_rate(sink);
+    long long played = audio_sink_played(sink) - g_tts_take_base;
+    if (played < 0) played = 0;     /* the take before is still playing out */
+    if (g_tts_stretch) played = wsola_source_pos(g_tts_stretch, played);
+    if (sr > 0)
+        InterlockedExchange(&g_tts_playback_ms, (LONG)(played * 1000 / sr));
 }
 
-static void waveout_close(void) {
-    if (g_waveout) {
-        waveOutReset(g_waveout);
-        waveOutClose(g_waveout);
-        g_waveout = NULL;
+/* Queue samples as played, waiting for room. Returns 0, 1 if interrupted,
+ * -1 on a device error. */
+static int tts_sink_write(audio_sink_t *sink, const int16_t *samples, int n) {
+    while (n > 0) {
+        int k = audio_sink_write(sink, samples, n);
+        if (k < 0) return -1;
+        samples += k;
+        n -= k;
+        if (n > 0) {
+            if (InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) return 1;
+            audio_sink_wait(sink, 50);
+        }
+        tts_sink_publish_position(sink);
     }
-    if (g_waveout_done_event) {
-        CloseHandle(g_waveout_done_event);
-        g_waveout_done_event = NULL;
+    return 0;
+}
+
+/* Play out what the stretch has ready */
+static int tts_sink_drain_stretch(audio_sink_t *sink) {
+    int16_t tmp[2048];
+    int k;
+    while ((k = wsola_read(g_tts_stretch, tmp, 2048)) > 0) {
+        int rc = tts_sink_write(sink, tmp, k);
+        if (rc != 0) return rc;
     }
+    return 0;
 }
 
-/* Play int16 PCM samples through waveOut. Returns 0 = played fully, 1 = interrupted. */
-static int waveout_play_pcm(const int16_t *samples, int n_samples) {
-    if (!g_waveout || n_samples <= 0) return 0;
+/* Queue device-rate samples of the take, through the stretch when the
+ * speed isn't 1x. Returns as tts_sink_write. */
+static int tts_sink_push(audio_sink_t *sink, const int16_t *samples, int n) {
+    if (!g_tts_stretch) return tts_sink_write(sink, samples, n);
+    while (n > 0) {
+        int k = n < 4096 ? n : 4096;
+        if (wsola_write(g_tts_stretch, samples, k) != 0) return -1;
+        int rc = tts_sink_drain_stretch(sink);
+        if (rc != 0) return rc;
+        samples += k;
+        n -= k;
+    }
+    return 0;
+}
 
-    /* Upsample to 48kHz if source is 24kHz to avoid inconsistent Windows
-     * audio mixer resampling (24kHz is non-standard, 48kHz is native). */
-    int16_t *upsampled = NULL;
-    if (g_waveout_base_sr == 48000) {
-        upsampled = (int16_t *)malloc((size_t)n_samples * 2 * sizeof(int16_t));
-        if (upsampled) {
-            for (int i = 0; i < n_samples; i++) {
-                upsampled[i * 2]     = samples[i];
-                upsampled[i * 2 + 1] = samples[i];
-            }
-            samples = upsampled;
-            n_samples *= 2;
-        }
+/* tts_sink_push for samples at the server rate sr, converted in pieces.
+ * up carries the interpolator between pieces of one take; the output
+ * matches tts_to_device_rate once tts_sink_push_tail has run. */
+static int tts_sink_push_at(audio_sink_t *sink, up2_state_t *up,
+                            const int16_t *samples, int n, int sr) {
+    if (tts_device_rate(sr) == sr) return tts_sink_push(sink, samples, n);
+    int16_t tmp[2048];
+    while (n > 0) {
+        int k = n < 1024 ? n : 1024;
+        int rc = tts_sink_push(sink, tmp, up2_process(up, samples, k, tmp));
+        if (rc != 0) return rc;
+        samples += k;
+        n -= k;
     }
+    return 0;
+}
 
-    /* Submit entire buffer as one WAVEHDR */
-    int interrupted = 0;
-    WAVEHDR hdr = {0};
-    hdr.lpData = (LPSTR)samples;
-    hdr.dwBufferLength = (DWORD)(n_samples * sizeof(int16_t));
+/* End of a take pushed with tts_sink_push_at: the interpolator's tail */
+static int tts_sink_push_tail(audio_sink_t *sink, up2_state_t *up, int sr) {
+    if (tts_device_rate(sr) == sr) return 0;
+    int16_t tail[UP2_DELAY * 2];
+    return tts_sink_push(sink, tail, up2_flush(up, tail));
+}
 
-    MMRESULT mr = waveOutPrepareHeader(g_waveout, &hdr, sizeof(hdr));
-    if (mr != MMSYSERR_NOERROR) return 0;
+/* End the take without waiting for it to play: the stretch's tail is
+ * queued and flushed, and the sink can go straight on with the next take.
+ * Returns 0, or 1 if interrupted. */
+static int tts_sink_end_take(audio_sink_t *sink) {
+    int interrupted = 0;
+    if (g_tts_stretch) {
+        wsola_end(g_tts_stretch);
+        interrupted = tts_sink_drain_stretch(sink) == 1;
+        wsola_destroy(g_tts_stretch);
+        g_tts_stretch = NULL;
+    }
+    audio_sink_flush(sink);
+    return interrupted;
+}
 
-    ResetEvent(g_waveout_done_event);
-    InterlockedExchange(&g_tts_playback_ms, 0);
-    mr = waveOutWrite(g_waveout, &hdr, sizeof(hdr));
-    if (mr != MMSYSERR_NOERROR) {
+/* Play out what is queued. Returns 0 = played fully, 1 = interrupted. */
+static int tts_sink_finish(audio_sink_t *sink) {
+    int interrupted = 0;
+    if (tts_sink_end_take(sink)) {
         InterlockedExchange(&g_tts_playback_ms, -1);
-        waveOutUnprepareHeader(g_waveout, &hdr, sizeof(hdr));
-        return 0;
+        return 1;
     }
-
-    /* Poll for completion or interrupt */
-    while (!(hdr.dwFlags & WHDR_DONE)) {
-        DWORD ret = WaitForSingleObject(g_waveout_done_event, 50);
-        if (ret == WAIT_TIMEOUT || ret == WAIT_OBJECT_0) {
-            if (InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) {
-                waveOutReset(g_waveout);
-                interrupted = 1;
-                break;
-            }
-            /* Update playback position for karaoke highlight.
-             * Use base rate (48000) not device rate (48000*speed) so
-             * position maps to original audio ms regardless of speed. */
-            if (g_waveout_base_sr > 0) {
-                MMTIME mmt = {0};
-                mmt.wType = TIME_SAMPLES;
-                if (waveOutGetPosition(g_waveout, &mmt, sizeof(mmt)) == MMSYSERR_NOERROR
-                    && mmt.wType == TIME_SAMPLES) {
-                    InterlockedExchange(&g_tts_playback_ms,
-                        (LONG)((double)mmt.u.sample * 1000.0 / g_waveout_base_sr));
-                }
-            }
+    while (audio_sink_pending(sink) > 0) {
+        if (InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) {
+            interrupted = 1;
+            break;
         }
+        audio_sink_wait(sink, 50);
+        tts_sink_publish_position(sink);
     }
-
     InterlockedExchange(&g_tts_playback_ms, -1);
-    waveOutUnprepareHeader(g_waveout, &hdr, sizeof(hdr));
-    free(upsampled);
     return interrupted;
 }
 
-/* ---- Base64 decoder (for TTS timestamp responses) ---- */
-
-static const int b64_decode_table[256] = {
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
-    52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-1,-1,-1,
-    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
-    15,16,17,18,19,20,21,22,23,24,25,-1,-1,-1,-1,-1,
-    -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
-    41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
-};
-
-static char *base64_decode(const char *b64, int b64_len, int *out_len) {
-    *out_len = 0;
-    int pad = 0;
-    if (b64_len >= 1 && b64[b64_len - 1] == '=') pad++;
-    if (b64_len >= 2 && b64[b64_len - 2] == '=') pad++;
-    int out_size = (b64_len / 4) * 3 - pad;
-    if (out_size <= 0) return NULL;
-    char *out = (char *)malloc(out_size);
-    if (!out) return NULL;
-
-    int j = 0;
-    for (int i = 0; i + 3 < b64_len; i += 4) {
-        int a = b64_decode_table[(unsigned char)b64[i]];
-        int b = b64_decode_table[(unsigned char)b64[i+1]];
-        int c = b64_decode_table[(unsigned char)b64[i+2]];
-        int d = b64_decode_table[(unsigned char)b64[i+3]];
-        if (a < 0 || b < 0) { free(out); return NULL; }
-        int v = (a << 18) | (b << 12);
-        if (c >= 0) v |= (c << 6);
-        if (d >= 0) v |= d;
-        if (j < out_size) out[j++] = (char)((v >> 16) & 0xFF);
-        if (j < out_size && c >= 0) out[j++] = (char)((v >> 8) & 0xFF);
-        if (j < out_size && d >= 0) out[j++] = (char)(v & 0xFF);
-    }
-    *out_len = j;
-    return out;
+/* Sink for a take at sample_rate. The sink *carry left open by the take
+ * before is reused at the same rate, so back-to-back takes play without a
+ * reopen or a start gap; otherwise it plays out and closes first. */
+static audio_sink_t *tts_sink_next(audio_sink_t **carry, int sample_rate, int start_ms) {
+    audio_sink_t *sink = *carry;
+    *carry = NULL;
+    if (sink && audio_sink_rate(sink) == sample_rate) {
+        tts_sink_start_take(sink);
+        return sink;
+    }
+    if (sink) {
+        tts_sink_finish(sink);
+        tts_sink_close(sink);
+    }
+    return tts_sink_open(sample_rate, start_ms);
 }
 
 /* ---- TTS timestamp JSON parser ---- */
@@ -714,34 +858,17 @@ static double json_find_double(const char *json, int json_len,
     return atof(tmp);
 }
 
-/* Parse TTS timestamp JSON response.
- * Returns 0 on success, -1 on error. Caller must free *wav_out. */
-static int tts_parse_timestamp_response(const char *json, int json_len,
-                                         char **wav_out, int *wav_len_out,
-                                         TtsTimestamps *ts_out) {
-    *wav_out = NULL;
-    *wav_len_out = 0;
+/* Parse the "words":[...] array of a TTS JSON response into ts_out (left
+ * empty if there is none). */
+static void tts_parse_words(const char *json, int json_len, TtsTimestamps *ts_out) {
     ts_out->words = NULL;
     ts_out->count = 0;
 
-    /* Extract "audio":"<base64>" */
-    int audio_b64_len = 0;
-    const char *audio_b64 = json_find_string(json, json_len, "audio", &audio_b64_len);
-    if (!audio_b64 || audio_b64_len <= 0) return -1;
-
-    int wav_len = 0;
-    char *wav = base64_decode(audio_b64, audio_b64_len, &wav_len);
-    if (!wav || wav_len <= 0) return -1;
-
-    *wav_out = wav;
-    *wav_len_out = wav_len;
-
-    /* Parse "words":[...] array */
     const char *words_key = strnstr_safe(json, "\"words\":", json_len);
-    if (!words_key) return 0; /* no words array is OK */
+    if (!words_key) return;
 
     const char *arr_start = strchr(words_key, '[');
-    if (!arr_start) return 0;
+    if (!arr_start) return;
     arr_start++;
 
     /* Count objects to allocate */
@@ -754,10 +881,10 @@ static int tts_parse_timestamp_response(const char *json, int json_len,
             scan++;
         }
     }
-    if (count <= 0) return 0;
+    if (count <= 0) return;
 
     TtsWordTimestamp *words = (TtsWordTimestamp *)calloc(count, sizeof(TtsWordTimestamp));
-    if (!words) return 0;
+    if (!words) return;
 
     /* Parse each word object */
     const char *p = arr_start;
@@ -793,27 +920,38 @@ static int tts_parse_timestamp_response(const char *json, int json_len,
 
     ts_out->words = words;
     ts_out->count = count;
-    return 0;
 }
 
 /* ---- TTS HTTP client (local-ai-server /v1/audio/speech) ---- */
 
-/* POST to TTS server, receive WAV bytes. Returns 0 on success, -1 on failure.
- * Caller must free *wav_out.
- * ts_out (optional): when non-NULL, sends "timestamps":true, parses JSON response
- * to extract WAV + word timestamps. When NULL, receives raw WAV bytes.
- * cancel_handle (optional): published for external cancellation via
- * WinHttpCloseHandle from another thread. InterlockedExchangePointer ensures
- * exactly one side (caller or canceller) closes the request handle. */
-static int tts_request(const char *text, const char *voice, int seed,
-                       char **wav_out, int *wav_len,
-                       TtsTimestamps *ts_out, int *seed_out,
-                       volatile HINTERNET *cancel_handle) {
-    *wav_out = NULL;
-    *wav_len = 0;
-    if (ts_out) { ts_out->words = NULL; ts_out->count = 0; }
-    if (seed_out) *seed_out = -1;
+/* A request slot after tts_http_cancel: requests published there later
+ * stop at once. Whoever starts the slot's owner again resets it to NULL. */
+#define TTS_HTTP_CANCELLED ((HINTERNET)(INT_PTR)-1)
+
+/* Abort the request published in *slot (if any) and any published later */
+static void tts_http_cancel(volatile HINTERNET *slot) {
+    HINTERNET h = InterlockedExchangePointer((volatile PVOID *)slot, TTS_HTTP_CANCELLED);
+    if (h && h != TTS_HTTP_CANCELLED) WinHttpCloseHandle(h);
+}
 
+/* Abort only the request published in *slot now; the slot stays usable */
+static void tts_http_abort(volatile HINTERNET *slot) {
+    HINTERNET h = *slot;
+    if (!h || h == TTS_HTTP_CANCELLED) return;
+    if (InterlockedCompareExchangePointer((volatile PVOID *)slot, NULL, h) == h)
+        WinHttpCloseHandle(h);
+}
+
+/* POST body to the TTS server and hand the response to on_data as it
+ * arrives (return nonzero from on_data to stop). Returns 0 when the whole
+ * response was read, 1 if on_data stopped it, -1 on failure (including a
+ * cancel).
+ * cancel_handle (optional): published for external cancellation with
+ * tts_http_cancel from another thread. The slot is swapped atomically, so
+ * exactly one side (caller or canceller) closes the request handle, and a
+ * cancel that came before the publish is seen. */
+static int tts_http_post(const char *body, volatile HINTERNET *cancel_handle,
+                         int (*on_data)(void *ctx, const char *data, int len), void *ctx) {
     HINTERNET hSession = WinHttpOpen(L"VoiceNoteGUI/1.0",
                                       WINHTTP_ACCESS_TYPE_NO_PROXY,
                                       WINHTTP_NO_PROXY_NAME,
@@ -837,46 +975,25 @@ static int tts_request(const char *text, const char *voice, int seed,
         return -1;
     }
 
-    /* Publish handle so another thread can close it to abort blocking I/O */
-    if (cancel_handle)
-        InterlockedExchangePointer((volatile PVOID *)cancel_handle, hRequest);
+    /* Publish handle so another thread can close it to abort blocking I/O,
+     * unless it was cancelled before we got here */
+    if (cancel_handle
+        && InterlockedCompareExchangePointer((volatile PVOID *)cancel_handle,
+                                             hRequest, NULL) != NULL) {
+        WinHttpCloseHandle(hRequest);
+        WinHttpCloseHandle(hConnect);
+        WinHttpCloseHandle(hSession);
+        return -1;
+    }
 
     /* 5s connect, 60s receive (TTS generation can be slow) */
     WinHttpSetTimeouts(hRequest, 5000, 5000, 60000, 60000);
 
-    /* Build JSON body */
-    char escaped[4096];
-    json_escape(text, escaped, sizeof(escaped));
-    char body[8192];
-    if (ts_out) {
-        if (seed >= 0) {
-            snprintf(body, sizeof(body),
-                     "{\"input\":\"%s\",\"voice\":\"%s\",\"response_format\":\"wav\","
-                     "\"timestamps\":true,\"language\":\"Chinese\",\"seed\":%d}",
-                     escaped, voice, seed);
-        } else {
-            snprintf(body, sizeof(body),
-                     "{\"input\":\"%s\",\"voice\":\"%s\",\"response_format\":\"wav\","
-                     "\"timestamps\":true,\"language\":\"Chinese\"}",
-                     escaped, voice);
-        }
-    } else {
-        if (seed >= 0) {
-            snprintf(body, sizeof(body),
-                     "{\"input\":\"%s\",\"voice\":\"%s\",\"response_format\":\"wav\",\"seed\":%d}",
-                     escaped, voice, seed);
-        } else {
-            snprintf(body, sizeof(body),
-                     "{\"input\":\"%s\",\"voice\":\"%s\",\"response_format\":\"wav\"}",
-                     escaped, voice);
-        }
-    }
-
     DWORD body_len = (DWORD)strlen(body);
     BOOL ok = WinHttpSendRequest(hRequest,
                                   L"Content-Type: application/json\r\n",
                                   (DWORD)-1L,
-                                  body, body_len, body_len, 0);
+                                  (LPVOID)body, body_len, body_len, 0);
 
     if (ok) ok = WinHttpReceiveResponse(hRequest, NULL);
 
@@ -892,196 +1009,314 @@ static int tts_request(const char *text, const char *voice, int seed,
             snprintf(errmsg, sizeof(errmsg), "TTS server returned HTTP %lu", status_code);
             log_event("TTS_SRV", errmsg);
         } else {
-            /* Read response data */
-            char *buf = (char *)malloc(TTS_RESPONSE_BUF);
-            if (buf) {
-                DWORD total = 0, bytes_read = 0;
-                while (WinHttpReadData(hRequest, buf + total,
-                                        TTS_RESPONSE_BUF - total, &bytes_read)) {
-                    if (bytes_read == 0) break;
-                    total += bytes_read;
-                    if (total >= (DWORD)TTS_RESPONSE_BUF) break;
+            /* Read response data in socket-sized pieces */
+            char chunk[16384];
+            DWORD bytes_read = 0;
+            while (WinHttpReadData(hRequest, chunk, sizeof(chunk), &bytes_read)) {
+                if (bytes_read == 0) {
+                    result = 0;
+                    break;
                 }
-                if (total > 0) {
-                    if (ts_out) {
-                        /* JSON response: parse base64 audio + word timestamps */
-                        if (seed_out) {
-                            *seed_out = (int)json_find_double(buf, (int)total, "seed", -1.0);
-                        }
-                        int rc = tts_parse_timestamp_response(buf, (int)total,
-                                                               wav_out, wav_len, ts_out);
-                        free(buf);
-                        if (rc == 0 && *wav_out) result = 0;
-                    } else {
-                        /* Raw WAV response */
-                        *wav_out = buf;
-                        *wav_len = (int)total;
-                        result = 0;
-                    }
-                } else {
-                    free(buf);
+                if (on_data(ctx, chunk, (int)bytes_read)) {
+                    result = 1;
+                    break;
                 }
             }
         }
     }
 
     /* Reclaim handle: if external cancel already closed it, skip our close.
-     * Both sides race to swap the slot to NULL; the winner closes. */
-    if (cancel_handle) {
-        if (!InterlockedExchangePointer((volatile PVOID *)cancel_handle, NULL))
-            hRequest = NULL;
-    }
+     * Both sides race to swap the slot away from it; the winner closes. */
+    if (cancel_handle
+        && InterlockedCompareExchangePointer((volatile PVOID *)cancel_handle,
+                                             NULL, hRequest) != hRequest)
+        hRequest = NULL;
     if (hRequest) WinHttpCloseHandle(hRequest);
     WinHttpCloseHandle(hConnect);
     WinHttpCloseHandle(hSession);
     return result;
 }
 
-/* Parse WAV header to find PCM data. Returns 0 on success.
- * Sets *pcm_out to point into wav_data (not a new allocation),
- * *n_samples to sample count, *sample_rate to Hz. */
-static int wav_parse_header(const char *wav_data, int wav_len,
-                            const int16_t **pcm_out, int *n_samples, int *sample_rate) {
-    if (wav_len < 44) return -1;
-    if (memcmp(wav_data, "RIFF", 4) != 0) return -1;
-    if (memcmp(wav_data + 8, "WAVE", 4) != 0) return -1;
-
-    /* Walk chunks to find "fmt " and "data" */
-    int fmt_found = 0;
-    int sr = 0, bits = 0, channels = 0;
-    int pos = 12;
-    while (pos + 8 <= wav_len) {
-        const char *chunk_id = wav_data + pos;
-        int chunk_size = *(const int32_t *)(wav_data + pos + 4);
-        if (chunk_size < 0 || pos + 8 + chunk_size > wav_len) break;
-
-        if (memcmp(chunk_id, "fmt ", 4) == 0 && chunk_size >= 16) {
-            int16_t format = *(const int16_t *)(wav_data + pos + 8);
-            if (format != 1) return -1;  /* not PCM */
-            channels = *(const int16_t *)(wav_data + pos + 10);
-            sr = *(const int32_t *)(wav_data + pos + 12);
-            bits = *(const int16_t *)(wav_data + pos + 22);
-            fmt_found = 1;
-        } else if (memcmp(chunk_id, "data", 4) == 0 && fmt_found) {
-            if (bits != 16 || channels != 1) return -1;  /* only mono 16-bit */
-            *pcm_out = (const int16_t *)(wav_data + pos + 8);
-            *n_samples = chunk_size / sizeof(int16_t);
-            *sample_rate = sr;
-            return 0;
-        }
+/* A take's PCM at the server rate, gathered as it is decoded */
+typedef struct {
+    int      sr;
+    int16_t *pcm;
+    int      n, cap;
+} TtsPcmBuf;
+
+/* Destroy callback for blocks wrapping malloc'd samples (ctx = the samples) */
+static void malloc_block_destroy(audio_block_t *b) {
+    free(b->ctx);
+}
+
+/* Returns 0, or -1 if out of memory or the rate changed mid-take. */
+static int tts_pcm_append(TtsPcmBuf *b, const int16_t *samples, int n, int sr) {
+    if (b->n == 0) {
+        b->sr = sr;
+    } else if (sr != b->sr) {
+        log_event("TTS_SRV", "Stream changed sample rate");
+        return -1;
+    }
+    if (b->n + n > b->cap) {
+        int cap = b->cap ? b->cap * 2 : sr * 4;
+        while (cap < b->n + n) cap *= 2;
+        int16_t *p = (int16_t *)realloc(b->pcm, cap * sizeof(int16_t));
+        if (!p) return -1;
+        b->pcm = p;
+        b->cap = cap;
+    }
+    memcpy(b->pcm + b->n, samples, n * sizeof(int16_t));
+    b->n += n;
+    return 0;
+}
+
+/* Hand the gathered samples to a block (b is left empty). Returns NULL if
+ * there were none or out of memory. */
+static audio_block_t *tts_pcm_take(TtsPcmBuf *b) {
+    audio_block_t *block = NULL;
+    if (b->n > 0)
+        block = audio_block_wrap(b->pcm, b->n, malloc_block_destroy, b->pcm);
+    if (!block) free(b->pcm);
+    b->pcm = NULL;
+    b->n = b->cap = 0;
+    return block;
+}
 
-        pos += 8 + chunk_size;
-        if (chunk_size & 1) pos++;  /* chunks are 2-byte aligned */
+static int tts_pcm_collect(void *ctx, const int16_t *samples, int n, int sr) {
+    return tts_pcm_append((TtsPcmBuf *)ctx, samples, n, sr) != 0;
+}
+
+static int tts_pcm_discard(void *ctx, const int16_t *samples, int n, int sr) {
+    (void)ctx; (void)samples; (void)n; (void)sr;
+    return 0;
+}
+
+typedef struct {
+    tts_stream_t *st;
+    int rc;             /* last tts_stream_feed result */
+} TtsStreamFeed;
+
+static int tts_stream_feed_cb(void *ctx, const char *data, int len) {
+    TtsStreamFeed *f = (TtsStreamFeed *)ctx;
+    f->rc = tts_stream_feed(f->st, data, len);
+    return f->rc != 0;
+}
+
+/* POST body and decode the response as it arrives: PCM goes to on_pcm,
+ * words and seed (if asked for) come from the metadata JSON. Returns 0 on
+ * success, 1 if on_pcm stopped the stream, -1 on failure. */
+static int tts_fetch(const char *body, TtsTimestamps *ts_out, int *seed_out,
+                     tts_stream_pcm_fn on_pcm, void *ctx,
+                     volatile HINTERNET *cancel_handle) {
+    if (ts_out) { ts_out->words = NULL; ts_out->count = 0; }
+    if (seed_out) *seed_out = -1;
+
+    TtsStreamFeed feed = { tts_stream_new(on_pcm, ctx), 0 };
+    if (!feed.st) return -1;
+    int rc = tts_http_post(body, cancel_handle, tts_stream_feed_cb, &feed);
+    if (rc == 0)
+        rc = tts_stream_finish(feed.st);
+    else if (rc == 1)
+        rc = feed.rc == 1 ? 1 : -1;     /* on_pcm stopped it, or malformed */
+    int json_len = 0;
+    const char *json = tts_stream_json(feed.st, &json_len);
+    if (rc == 0 && json) {
+        if (seed_out) *seed_out = (int)json_find_double(json, json_len, "seed", -1.0);
+        if (ts_out) tts_parse_words(json, json_len, ts_out);
+    }
+    tts_stream_free(feed.st);
+    return rc;
+}
+
+/* POST to TTS server for a whole take (WAV, or with ts_out the timestamp
+ * JSON whose base64 WAV is decoded as it arrives). Returns 0 on success,
+ * -1 on failure.
+ * pcm_out (optional): the take at the server rate *sr_out; caller releases.
+ * ts_out (optional): sends "timestamps":true and fills word timestamps.
+ * cancel_handle (optional): see tts_http_post. */
+static int tts_request(const char *text, const char *voice, int seed,
+                       audio_block_t **pcm_out, int *sr_out,
+                       TtsTimestamps *ts_out, int *seed_out,
+                       volatile HINTERNET *cancel_handle) {
+    if (pcm_out) *pcm_out = NULL;
+
+    char body[8192];
+    if (tts_build_body(text, voice, seed, ts_out != NULL, 0, body, sizeof(body)) != 0) {
+        log_event("TTS_SRV", "Text too long for a request");
+        return -1;
+    }
+
+    TtsPcmBuf take = {0};
+    int rc = tts_fetch(body, ts_out, seed_out,
+                       pcm_out ? tts_pcm_collect : tts_pcm_discard, &take, cancel_handle);
+    if (rc == 0 && pcm_out) {
+        *sr_out = take.sr;
+        *pcm_out = tts_pcm_take(&take);
+        if (!*pcm_out) rc = -1;
+    }
+    free(take.pcm);
+    if (rc != 0 && ts_out) {
+        free(ts_out->words);
+        ts_out->words = NULL;
+        ts_out->count = 0;
+    }
+    return rc == 0 ? 0 : -1;
+}
+
+/* Streaming variant of tts_request: decoded PCM goes to on_pcm while the
+ * response is still arriving. Words and seed (if asked for) are filled
+ * from the final event. Returns 0 on success, 1 if on_pcm stopped the
+ * stream, -1 on failure. */
+static int tts_request_stream(const char *text, const char *voice, int seed,
+                              TtsTimestamps *ts_out, int *seed_out,
+                              tts_stream_pcm_fn on_pcm, void *ctx,
+                              volatile HINTERNET *cancel_handle) {
+    char body[8192];
+    if (tts_build_body(text, voice, seed, ts_out != NULL, 1, body, sizeof(body)) != 0) {
+        log_event("TTS_SRV", "Text too long for a request");
+        return -1;
     }
-    return -1;
+    return tts_fetch(body, ts_out, seed_out, on_pcm, ctx, cancel_handle);
+}
+
+/* ---- Published word timestamps ---- */
+
+/* Immutable copy of count words. Returns NULL if count is 0 or out of memory. */
+static TtsWordsBlock *tts_words_new(const TtsWordTimestamp *words, int count) {
+    if (!words || count <= 0) return NULL;
+    TtsWordsBlock *b = (TtsWordsBlock *)malloc(sizeof(TtsWordsBlock)
+                                               + count * sizeof(TtsWordTimestamp));
+    if (!b) return NULL;
+    b->next_retired = NULL;
+    b->table = 0;
+    b->view.words = (TtsWordTimestamp *)(b + 1);
+    b->view.count = count;
+    memcpy(b->view.words, words, count * sizeof(TtsWordTimestamp));
+    return b;
+}
+
+/* Push b onto a retired list (any thread) */
+static void tts_words_retire(TtsWordsBlock * volatile *list, TtsWordsBlock *b) {
+    if (!b) return;
+    TtsWordsBlock *head;
+    do {
+        head = *list;
+        b->next_retired = head;
+    } while (InterlockedCompareExchangePointer((PVOID volatile *)list, b, head) != head);
+}
+
+/* Free a retired list once no reader can hold its blocks */
+static void tts_words_free_retired(TtsWordsBlock * volatile *list) {
+    TtsWordsBlock *b = (TtsWordsBlock *)InterlockedExchangePointer((PVOID volatile *)list, NULL);
+    while (b) {
+        TtsWordsBlock *next = b->next_retired;
+        free(b);
+        b = next;
+    }
+}
+
+/* Same words in the same order (timings aside) */
+static int tts_words_same(const TtsTimestamps *a, const TtsTimestamps *b) {
+    if (a->count != b->count) return 0;
+    for (int i = 0; i < a->count; i++)
+        if (strcmp(a->words[i].word, b->words[i].word) != 0) return 0;
+    return 1;
+}
+
+/* Publish b (owned, may be NULL) as the current timestamps. Any thread. */
+static void tts_current_words_set(TtsWordsBlock *b) {
+    TtsWordsBlock *old = (TtsWordsBlock *)InterlockedExchangePointer(
+        (PVOID volatile *)&g_tts_current_words, b);
+    if (old && !old->table) tts_words_retire(&g_tts_current_retired, old);
+}
+
+/* Borrowed view of the current timestamps, or NULL. UI thread only; valid
+ * until the next tts_current_words_reclaim. */
+static const TtsTimestamps *tts_current_words(void) {
+    TtsWordsBlock *b = g_tts_current_words;
+    return b ? &b->view : NULL;
+}
+
+/* Free replaced current timestamps. UI thread only, outside WM_PAINT. */
+static void tts_current_words_reclaim(void) {
+    tts_words_free_retired(&g_tts_current_retired);
 }
 
 /* ---- Per-sentence word grouping cache (voice-independent, permanent) ---- */
 
 static void tts_groupings_init(int n) {
-    InitializeCriticalSection(&g_tts_groupings_lock);
-    g_tts_groupings = (TtsTimestamps *)calloc(n, sizeof(TtsTimestamps));
-    g_tts_groupings_count = n;
+    g_tts_groupings = (TtsWordsBlock * volatile *)calloc(n, sizeof(TtsWordsBlock *));
+    g_tts_groupings_count = g_tts_groupings ? n : 0;
 }
 
+/* Shutdown, after every thread that reads groupings has stopped */
 static void tts_groupings_destroy(void) {
     if (!g_tts_groupings) return;
+    tts_current_words_set(NULL);
+    tts_current_words_reclaim();
     for (int i = 0; i < g_tts_groupings_count; i++)
-        free(g_tts_groupings[i].words);
-    free(g_tts_groupings);
+        free(g_tts_groupings[i]);
+    free((void *)g_tts_groupings);
     g_tts_groupings = NULL;
     g_tts_groupings_count = 0;
-    DeleteCriticalSection(&g_tts_groupings_lock);
+    tts_words_free_retired(&g_tts_groupings_retired);
 }
 
 static int tts_groupings_has(int idx) {
     if (idx < 0 || idx >= g_tts_groupings_count) return 0;
-    int found;
-    EnterCriticalSection(&g_tts_groupings_lock);
-    found = (g_tts_groupings[idx].count > 0) ? 1 : 0;
-    LeaveCriticalSection(&g_tts_groupings_lock);
-    return found;
-}
-
-/* Copy grouping timestamps for sentence idx. Returns 1 on hit. Caller frees ts->words. */
-static int tts_groupings_copy(int idx, TtsTimestamps *ts) {
-    if (idx < 0 || idx >= g_tts_groupings_count || !ts) return 0;
-    int found = 0;
-    EnterCriticalSection(&g_tts_groupings_lock);
-    TtsTimestamps *e = &g_tts_groupings[idx];
-    if (e->count > 0 && e->words) {
-        ts->count = e->count;
-        ts->words = (TtsWordTimestamp *)malloc(e->count * sizeof(TtsWordTimestamp));
-        if (ts->words) {
-            memcpy(ts->words, e->words, e->count * sizeof(TtsWordTimestamp));
-            found = 1;
-        } else {
-            ts->count = 0;
-        }
-    } else {
-        ts->words = NULL;
-        ts->count = 0;
-    }
-    LeaveCriticalSection(&g_tts_groupings_lock);
-    return found;
+    return g_tts_groupings[idx] != NULL;
 }
 
-/* Store grouping (copies timestamps). */
+/* Store grouping (copies timestamps). A refetch with the same words keeps
+ * the published block, so replacements (and retired blocks) stay rare. */
 static void tts_groupings_put(int idx, const TtsTimestamps *ts) {
     if (idx < 0 || idx >= g_tts_groupings_count) return;
     if (!ts || ts->count <= 0 || !ts->words) return;
-    EnterCriticalSection(&g_tts_groupings_lock);
-    TtsTimestamps *e = &g_tts_groupings[idx];
-    free(e->words);
-    e->count = ts->count;
-    e->words = (TtsWordTimestamp *)malloc(ts->count * sizeof(TtsWordTimestamp));
-    if (e->words)
-        memcpy(e->words, ts->words, ts->count * sizeof(TtsWordTimestamp));
-    else
-        e->count = 0;
-    LeaveCriticalSection(&g_tts_groupings_lock);
+    TtsWordsBlock *cur = g_tts_groupings[idx];
+    if (cur && tts_words_same(&cur->view, ts)) return;
+    TtsWordsBlock *b = tts_words_new(ts->words, ts->count);
+    if (!b) return;
+    b->table = 1;
+    TtsWordsBlock *old = (TtsWordsBlock *)InterlockedExchangePointer(
+        (PVOID volatile *)&g_tts_groupings[idx], b);
+    tts_words_retire(&g_tts_groupings_retired, old);
 }
 
 /* ---- Grouping disk persistence (voice-independent, permanent) ---- */
 
+static void tts_grouping_index_open(void) {
+    char path[MAX_PATH];
+    if (resolve_exe_relative("..\\tts_cache", path, sizeof(path)) != 0) return;
+    CreateDirectoryA(path, NULL);
+    strncat(path, "\\groupings.idx", sizeof(path) - strlen(path) - 1);
+    g_grouping_index = gidx_open(path);
+    if (!g_grouping_index) {
+        log_event("TTS_DISK", "Failed to open grouping index");
+        return;
+    }
+    char msg[80];
+    snprintf(msg, sizeof(msg), "Grouping index: %d sentences", gidx_count(g_grouping_index));
+    log_event("TTS_DISK", msg);
+}
+
 static uint32_t fnv1a(const char *s) {
     uint32_t h = 2166136261u;
     for (; *s; s++) { h ^= (unsigned char)*s; h *= 16777619u; }
     return h;
 }
 
-/* Build grouping disk path: <exe_dir>\..\tts_cache\groupings\<hash>.ts
- * Creates directories if missing. Returns 0 on success. */
-static int tts_grouping_disk_path(const char *chinese, char *out, int out_size) {
+/* Legacy grouping path: <exe_dir>\..\tts_cache\groupings\<hash>.ts */
+static int tts_grouping_legacy_path(const char *chinese, char *out, int out_size) {
     char base[MAX_PATH];
     if (resolve_exe_relative("..\\tts_cache", base, sizeof(base)) != 0) return -1;
-    CreateDirectoryA(base, NULL);
-    char grp_dir[MAX_PATH];
-    snprintf(grp_dir, sizeof(grp_dir), "%s\\groupings", base);
-    CreateDirectoryA(grp_dir, NULL);
-    uint32_t hash = fnv1a(chinese);
-    snprintf(out, out_size, "%s\\%08x.ts", grp_dir, hash);
+    snprintf(out, out_size, "%s\\groupings\\%08x.ts", base, fnv1a(chinese));
     return 0;
 }
 
-static void tts_grouping_disk_save(const char *chinese, const TtsTimestamps *ts) {
-    if (!ts || ts->count <= 0 || !ts->words) return;
-    char path[MAX_PATH];
-    if (tts_grouping_disk_path(chinese, path, sizeof(path)) != 0) return;
-    FILE *f = fopen(path, "w");
-    if (!f) return;
-    for (int i = 0; i < ts->count; i++)
-        fprintf(f, "%s\t%d\t%d\n", ts->words[i].word,
-                ts->words[i].start_ms, ts->words[i].end_ms);
-    fclose(f);
-}
-
-/* Returns 1 on hit. Caller owns ts->words. */
-static int tts_grouping_disk_load(const char *chinese, TtsTimestamps *ts) {
-    ts->words = NULL;
-    ts->count = 0;
+/* Read a legacy per-sentence file. Returns 1 on hit. Caller owns ts->words. */
+static int tts_grouping_legacy_load(const char *chinese, TtsTimestamps *ts) {
     char path[MAX_PATH];
-    if (tts_grouping_disk_path(chinese, path, sizeof(path)) != 0) return 0;
+    if (tts_grouping_legacy_path(chinese, path, sizeof(path)) != 0) return 0;
     FILE *f = fopen(path, "r");
     if (!f) return 0;
     int nlines = 0;
@@ -1109,6 +1344,28 @@ static int tts_grouping_disk_load(const char *chinese, TtsTimestamps *ts) {
     return 1;
 }
 
+static void tts_grouping_disk_save(const char *chinese, const TtsTimestamps *ts) {
+    if (!g_grouping_index || !ts || ts->count <= 0 || !ts->words) return;
+    if (gidx_put(g_grouping_index, chinese, ts->words, ts->count) != 0)
+        log_event("TTS_DISK", "Failed to save grouping");
+}
+
+/* Returns 1 on hit. Caller owns ts->words. A sentence found only in a
+ * legacy file is copied into the index. */
+static int tts_grouping_disk_load(const char *chinese, TtsTimestamps *ts) {
+    ts->words = NULL;
+    ts->count = 0;
+    if (gidx_get(g_grouping_index, chinese, &ts->words, &ts->count)) {
+        if (ts->count > 0) return 1;
+        free(ts->words);
+        ts->words = NULL;
+        ts->count = 0;
+    }
+    if (!tts_grouping_legacy_load(chinese, ts)) return 0;
+    if (g_grouping_index) gidx_put(g_grouping_index, chinese, ts->words, ts->count);
+    return 1;
+}
+
 /* ---- Per-voice seed persistence (tts_cache/seeds.txt) ---- */
 
 static void tts_seeds_save(void) {
@@ -1121,7 +1378,7 @@ static void tts_seeds_save(void) {
     if (!f) return;
     for (int i = 0; i < (int)TTS_NUM_VOICES; i++) {
         if (g_tts_voice_seeds[i] >= 0) {
-            fprintf(f, "%s\t%d\n", g_tts_voices[i], g_tts_voice_seeds[i]);
+            fprintf(f, "%s\t%d\n", tts_voices[i], g_tts_voice_seeds[i]);
         }
     }
     fclose(f);
@@ -1142,7 +1399,7 @@ static void tts_seeds_load(void) {
         int seed_val = -1;
         if (sscanf(line, "%63[^\t]\t%d", name, &seed_val) == 2) {
             for (int i = 0; i < (int)TTS_NUM_VOICES; i++) {
-                if (_stricmp(g_tts_voices[i], name) == 0) {
+                if (_stricmp(tts_voices[i], name) == 0) {
                     g_tts_voice_seeds[i] = seed_val;
                     break;
                 }
@@ -1154,40 +1411,301 @@ static void tts_seeds_load(void) {
 
 /* ---- TTS worker thread (server-based) ---- */
 
-static void tts_last_wav_clear(void) {
-    EnterCriticalSection(&g_tts_last_wav_lock);
-    free(g_tts_last_wav);
-    g_tts_last_wav = NULL;
-    g_tts_last_wav_len = 0;
-    g_tts_last_wav_sentence = -1;
-    g_tts_last_wav_voice = -1;
-    free(g_tts_last_wav_words);
-    g_tts_last_wav_words = NULL;
-    g_tts_last_wav_word_count = 0;
-    LeaveCriticalSection(&g_tts_last_wav_lock);
+/* ---- TTS disk tier ---- */
+
+typedef struct {
+    char *text;
+    int voice_idx;
+    int seed;
+    audio_block_t *pcm;     /* server-rate samples, reference held */
+    int sr;
+    TtsTimestamps ts;       /* copy */
+} TtsPersistArgs;
+
+/* Trim the disk tier if it may be over its cap (first call sizes it) */
+static void tts_store_trim_task(void *param, exec_cancel_t *cancel) {
+    (void)param;
+    if (exec_cancelled(cancel)) return;
+    int deleted = tts_store_trim(g_tts_store);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Disk cache %.1f MB, evicted %d takes",
+             tts_store_bytes(g_tts_store) / (1024.0 * 1024.0), deleted);
+    log_event("TTS_DISK", msg);
+}
+
+static void tts_persist_task(void *param, exec_cancel_t *cancel) {
+    TtsPersistArgs *a = (TtsPersistArgs *)param;
+    if (!exec_cancelled(cancel)) {
+        if (tts_store_put(g_tts_store, a->text, tts_voices[a->voice_idx], a->seed,
+                          g_tts_model_id, a->pcm->samples, a->pcm->n_samples, a->sr,
+                          a->ts.words, a->ts.count) != 0)
+            log_event("TTS_DISK", "Failed to write take");
+        else if (tts_store_needs_trim(g_tts_store))
+            tts_store_trim_task(NULL, cancel);
+    }
+    audio_block_release(a->pcm);
+    free(a->ts.words);
+    free(a->text);
+    free(a);
 }
 
+/* Queue a write of a freshly fetched take (pcm at the server rate) */
+static void tts_store_save(const char *text, int voice_idx, int seed,
+                           audio_block_t *pcm, int sr, const TtsTimestamps *ts) {
+    if (!g_tts_store || !g_executor) return;
+    TtsPersistArgs *a = (TtsPersistArgs *)calloc(1, sizeof(TtsPersistArgs));
+    if (!a) return;
+    a->text = _strdup(text);
+    if (ts->words && ts->count > 0) {
+        a->ts.words = (TtsWordTimestamp *)malloc(ts->count * sizeof(TtsWordTimestamp));
+        if (a->ts.words) {
+            memcpy(a->ts.words, ts->words, ts->count * sizeof(TtsWordTimestamp));
+            a->ts.count = ts->count;
+        }
+    }
+    a->voice_idx = voice_idx;
+    a->seed = seed;
+    a->sr = sr;
+    a->pcm = pcm;
+    audio_block_retain(pcm);
+    if (!a->text
+        || executor_submit(g_executor, EXEC_LANE_PREFETCH, tts_persist_task, a,
+                           NULL, NULL) != 0) {
+        audio_block_release(pcm);
+        free(a->ts.words);
+        free(a->text);
+        free(a);
+    }
+}
+
+/* Read a take from disk into a device-rate clip. Returns NULL on miss. */
+static tts_clip_t *tts_store_load(const char *text, int voice_idx, int seed) {
+    tts_clip_t *disk = tts_store_get(g_tts_store, text, tts_voices[voice_idx],
+                                     seed, g_tts_model_id);
+    if (!disk) return NULL;
+    int sr = disk->sample_rate;
+    audio_block_t *pcm = disk->pcm;
+    audio_block_retain(pcm);
+    pcm = tts_to_device_rate(pcm, &sr);
+    tts_clip_t *clip = pcm ? tts_clip_new(pcm, sr, disk->words, disk->word_count, seed)
+                           : NULL;
+    tts_clip_release(disk);
+    if (clip) tts_cache_put(g_tts_cache, text, tts_voices[voice_idx], seed, clip);
+    return clip;
+}
+
+/* Cache key seed for a request: the voice's locked seed, or -1 (unlocked) */
+static int tts_cache_seed(int voice_idx) {
+    return g_tts_voice_seeds[voice_idx] >= 0 ? g_tts_voice_seeds[voice_idx] : -1;
+}
+
+/* After locking seed for a voice, file the unlocked take under the locked
+ * key too (memory and disk) if that take is what the seed came from. */
+static void tts_cache_adopt_seed(const char *text, int voice_idx, int seed) {
+    tts_clip_t *clip = tts_cache_get(g_tts_cache, text, tts_voices[voice_idx], -1);
+    if (clip && clip->seed == seed) {
+        tts_cache_put(g_tts_cache, text, tts_voices[voice_idx], seed, clip);
+        /* The store keeps takes at the server rate, not the device rate */
+        TtsTimestamps ts = { clip->words, clip->word_count };
+        if (clip->source)
+            tts_store_save(text, voice_idx, seed, clip->source, clip->source_rate, &ts);
+        else
+            tts_store_save(text, voice_idx, seed, clip->pcm, clip->sample_rate, &ts);
+    }
+    tts_clip_release(clip);
+}
+
+/* Turn a fetched take at the server rate sr into a device-rate clip,
+ * queueing it for disk when cache_seed is a real seed. A take with a seed
+ * but not stored keeps its server-rate samples too, for
+ * tts_cache_adopt_seed. Takes over the caller's reference on pcm_block.
+ * Returns NULL on failure. */
+static tts_clip_t *tts_clip_from_pcm(audio_block_t *pcm_block, int sr, const char *text,
+                                     int voice_idx, int cache_seed,
+                                     const TtsTimestamps *ts, int seed) {
+    audio_block_t *source = NULL;
+    int source_rate = sr;
+    if (cache_seed >= 0)
+        tts_store_save(text, voice_idx, cache_seed, pcm_block, sr, ts);
+    else if (seed >= 0 && tts_device_rate(sr) != sr) {
+        audio_block_retain(pcm_block);
+        source = pcm_block;
+    }
+
+    /* Convert once; the clip keeps device-rate samples */
+    pcm_block = tts_to_device_rate(pcm_block, &sr);
+    tts_clip_t *clip = pcm_block ? tts_clip_new(pcm_block, sr, ts->words, ts->count, seed)
+                                 : NULL;
+    if (clip) {
+        clip->source = source;
+        clip->source_rate = source_rate;
+    } else {
+        audio_block_release(source);
+    }
+    return clip;
+}
+
+/* If a request equal to this one is being synthesized ahead, wait for it
+ * to land. Returns its clip from the cache, or NULL. */
+static tts_clip_t *tts_synth_join(const char *text, int voice_idx, int seed, int cache_seed) {
+    if (!g_tts_synth_done_event || !ttsq_in_synth(g_tts_queue, text, voice_idx, seed))
+        return NULL;
+    log_event("TTS_SRV", "Waiting for take in synthesis");
+    HANDLE events[2] = { g_tts_synth_done_event, g_tts_shutdown_event };
+    while (ttsq_in_synth(g_tts_queue, text, voice_idx, seed)
+           && !InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) {
+        DWORD which = WaitForMultipleObjects(2, events, FALSE, 250);
+        if (which == WAIT_OBJECT_0 + 1) return NULL;  /* shutdown */
+    }
+    return tts_cache_get(g_tts_cache, text, tts_voices[voice_idx], cache_seed);
+}
+
+/* A streamed take. tts_stream_fetch_task downloads it on the executor and
+ * only gathers the PCM into take, so the download ends when the server is
+ * done sending rather than when playback catches up; the worker plays take
+ * as it grows (tts_stream_play) and keeps it whole for the caches. */
+typedef struct {
+    const char *text, *voice;
+    int      seed;
+    TtsTimestamps *ts;
+    int     *seed_out;
+    CRITICAL_SECTION lock;
+    TtsPcmBuf take;         /* lock */
+    HANDLE   event;         /* auto-reset: more PCM, or the download ended */
+    volatile LONG done;
+    volatile LONG stop;     /* the player gave up on the take */
+    int      rc;            /* download result, once done */
+    /* Worker thread */
+    audio_sink_t *sink;
+    int      no_device;
+    int      fed;           /* samples of take queued to sink */
+    up2_state_t up;         /* server rate to device rate */
+} TtsStreamPlay;
+
+static int tts_stream_gather_pcm(void *ctx, const int16_t *samples, int n, int sr) {
+    TtsStreamPlay *sp = (TtsStreamPlay *)ctx;
+    if (InterlockedCompareExchange(&sp->stop, 0, 0)
+        || InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) return 1;
+    EnterCriticalSection(&sp->lock);
+    int rc = tts_pcm_append(&sp->take, samples, n, sr);
+    LeaveCriticalSection(&sp->lock);
+    SetEvent(sp->event);
+    return rc != 0;
+}
+
+static void tts_stream_fetch_task(void *arg, exec_cancel_t *cancel) {
+    TtsStreamPlay *sp = (TtsStreamPlay *)arg;
+    (void)cancel;   /* tts_worker_stop aborts the request instead */
+    sp->rc = tts_request_stream(sp->text, sp->voice, sp->seed, sp->ts, sp->seed_out,
+                                tts_stream_gather_pcm, sp, &g_tts_worker_hrequest);
+    /* The server is free for synthesis ahead while the rest plays */
+    if (sp->rc == 0) InterlockedExchange(&g_tts_worker_fetching, 0);
+    InterlockedExchange(&sp->done, 1);
+    SetEvent(sp->event);
+}
+
+/* Download sp's take and play it as it arrives, into a sink from
+ * tts_sink_next(carry). Returns 0 once all of it is queued, 1 if playback
+ * was interrupted (or the device failed), -1 if the download failed or
+ * could not start. */
+static int tts_stream_play(TtsStreamPlay *sp, audio_sink_t **carry) {
+    InitializeCriticalSection(&sp->lock);
+    sp->event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    exec_task_t *task = NULL;
+    if (!sp->event || executor_submit(g_executor, EXEC_LANE_PLAYBACK, tts_stream_fetch_task,
+                                      sp, NULL, &task) != 0) {
+        if (sp->event) CloseHandle(sp->event);
+        sp->event = NULL;
+        DeleteCriticalSection(&sp->lock);
+        return -1;
+    }
+
+    int stopped = 0;
+    int16_t piece[1024];
+    while (!stopped) {
+        LONG done = InterlockedCompareExchange(&sp->done, 0, 0);
+        EnterCriticalSection(&sp->lock);
+        int sr = sp->take.sr;
+        int k = sp->take.n - sp->fed;
+        if (k > 1024) k = 1024;
+        if (k > 0) memcpy(piece, sp->take.pcm + sp->fed, k * sizeof(int16_t));
+        LeaveCriticalSection(&sp->lock);
+        if (k == 0) {
+            if (done) break;
+            if (InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) stopped = 1;
+            else WaitForSingleObject(sp->event, 50);
+            continue;
+        }
+        sp->fed += k;
+        if (!sp->sink && !sp->no_device) {
+            sp->sink = tts_sink_next(carry, tts_device_rate(sr), TTS_SINK_START_MS);
+            if (!sp->sink) {
+                sp->no_device = 1;
+                log_event("TTS_SRV", "Failed to open audio output");
+            } else {
+                up2_init(&sp->up);
+                PostMessageA(g_hwnd_main, WM_TTS_STATUS, 2, 0); /* speaking */
+            }
+        }
+        if (sp->sink && tts_sink_push_at(sp->sink, &sp->up, piece, k, sr) != 0) stopped = 1;
+    }
+
+    if (stopped) {
+        InterlockedExchange(&sp->stop, 1);
+        tts_http_abort(&g_tts_worker_hrequest);
+    }
+    exec_task_wait(task, INFINITE);
+    exec_task_release(task);
+    CloseHandle(sp->event);
+    sp->event = NULL;
+    DeleteCriticalSection(&sp->lock);
+    if (stopped) return 1;
+    if (sp->rc == 0 && sp->sink) tts_sink_push_tail(sp->sink, &sp->up, sp->take.sr);
+    return sp->rc;
+}
+
+static void tts_synth_kick(void);
+
 static DWORD WINAPI tts_worker_proc(LPVOID param) {
     (void)param;
     HANDLE events[2] = { g_tts_request_event, g_tts_shutdown_event };
+    audio_sink_t *carry = NULL;     /* left open by a take with another queued */
 
     while (1) {
-        DWORD which = WaitForMultipleObjects(2, events, FALSE, INFINITE);
-        if (which != WAIT_OBJECT_0) break; /* shutdown */
-
-        /* Grab pending text, voice, sentence index, and seed */
-        EnterCriticalSection(&g_tts_lock);
-        char *text = g_tts_pending_text;
-        g_tts_pending_text = NULL;
-        int voice_idx = g_tts_pending_voice_idx;
-        int sentence_idx = g_tts_pending_sentence_idx;
-        int pending_seed = g_tts_pending_seed;
-        LeaveCriticalSection(&g_tts_lock);
-
-        if (!text) continue;
-
-        /* Clear interrupt flag before request */
-        InterlockedExchange(&g_tts_interrupt, 0);
+        if (WaitForSingleObject(g_tts_shutdown_event, 0) == WAIT_OBJECT_0) break;
+
+        /* Next playback request: text, voice, sentence index, and seed */
+        ttsq_item_t *item = ttsq_take_play(g_tts_queue);
+        if (!item) {
+            if (carry) {
+                /* The take queued after it was dropped: play out the tail */
+                if (tts_sink_finish(carry)) log_event("TTS_SRV", "Playback interrupted");
+                tts_sink_close(carry);
+                carry = NULL;
+                PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0); /* idle */
+                continue;
+            }
+            DWORD which = WaitForMultipleObjects(2, events, FALSE, INFINITE);
+            if (which != WAIT_OBJECT_0) break; /* shutdown */
+            continue;
+        }
+        char *text = item->text;
+        item->text = NULL;
+        int voice_idx = item->voice;
+        int sentence_idx = item->tag;
+        int pending_seed = item->seed;
+        ttsq_item_free(item);
+
+        /* The player is busy now, so the request after this one can be
+         * synthesized while this one plays */
+        tts_synth_kick();
+
+        /* Clear interrupt flag before request. An interrupt also cuts the
+         * take still playing out of a carried sink. */
+        if (InterlockedExchange(&g_tts_interrupt, 0) && carry) {
+            tts_sink_close(carry);
+            carry = NULL;
+        }
 
         /* Compute effective seed:
          * pending_seed == -2: tuning mode (force random)
@@ -1206,63 +1724,94 @@ static DWORD WINAPI tts_worker_proc(LPVOID param) {
             char seed_msg[120];
             snprintf(seed_msg, sizeof(seed_msg),
                      "voice=%s pending_seed=%d effective_seed=%d voice_seeds[%d]=%d",
-                     g_tts_voices[voice_idx], pending_seed, effective_seed,
+                     tts_voices[voice_idx], pending_seed, effective_seed,
                      voice_idx, g_tts_voice_seeds[voice_idx]);
             log_event("TTS_SEED", seed_msg);
         }
 
         int want_ts = g_drill_mode;
         TtsTimestamps worker_ts = {0};
-        char *wav_data = NULL;
-        int wav_len = 0;
+        tts_clip_t *clip = NULL;
         int from_cache = 0;
 
-        /* Check last-WAV cache (skip for tuning: pending_seed == -2) */
-        if (pending_seed != -2 && sentence_idx >= 0) {
-            EnterCriticalSection(&g_tts_last_wav_lock);
-            if (g_tts_last_wav && g_tts_last_wav_len > 0
-                && g_tts_last_wav_sentence == sentence_idx
-                && g_tts_last_wav_voice == voice_idx) {
-                wav_data = (char *)malloc(g_tts_last_wav_len);
-                if (wav_data) {
-                    memcpy(wav_data, g_tts_last_wav, g_tts_last_wav_len);
-                    wav_len = g_tts_last_wav_len;
-                    /* Copy timestamps that match this exact WAV */
-                    if (g_tts_last_wav_words && g_tts_last_wav_word_count > 0) {
-                        size_t tsz = g_tts_last_wav_word_count * sizeof(TtsWordTimestamp);
-                        worker_ts.words = (TtsWordTimestamp *)malloc(tsz);
-                        if (worker_ts.words) {
-                            memcpy(worker_ts.words, g_tts_last_wav_words, tsz);
-                            worker_ts.count = g_tts_last_wav_word_count;
-                        }
-                    }
-                    from_cache = 1;
-                }
-            }
-            LeaveCriticalSection(&g_tts_last_wav_lock);
-            if (from_cache) {
+        /* Tuning takes are filed under the seed the server reports when
+         * the voice is locked, so they don't displace the locked take */
+        const char *voice = tts_voices[voice_idx];
+        int cache_seed = effective_seed;
+
+        /* Check clip cache, then disk (skip for tuning: pending_seed == -2) */
+        if (pending_seed != -2) {
+            clip = tts_cache_get(g_tts_cache, text, voice, cache_seed);
+            if (clip) {
+                from_cache = 1;
                 log_event("TTS_SRV", "Replay from cache");
-                free(text);
+            } else if (cache_seed >= 0 && (clip = tts_store_load(text, voice_idx, cache_seed))) {
+                from_cache = 1;
+                log_event("TTS_SRV", "Replay from disk cache");
+            } else if ((clip = tts_synth_join(text, voice_idx, pending_seed, cache_seed))) {
+                from_cache = 1;
+                log_event("TTS_SRV", "Replay take synthesized ahead");
             }
         }
 
-        /* Fetch from server if not cached */
+        /* Fetch from server if not cached. A streamed take starts playing
+         * through sink while it downloads; if the stream yields nothing
+         * (e.g. the server can't stream), fall back to a buffered request. */
+        audio_sink_t *sink = NULL;
         if (!from_cache) {
             log_event("TTS_SRV", "Requesting speech...");
             PostMessageA(g_hwnd_main, WM_TTS_STATUS, 1, 0); /* generating */
 
+            audio_block_t *pcm_block = NULL;
+            int pcm_sr = 0;
             int seed_out = -1;
-            int rc = tts_request(text, g_tts_voices[voice_idx], effective_seed,
-                                 &wav_data, &wav_len,
+            int rc = -1;
+            int streamed = 0;
+            TtsStreamPlay sp = {0};
+            InterlockedExchange(&g_tts_worker_fetching, 1);
+            if (g_tts_stream) {
+                sp.text = text;
+                sp.voice = voice;
+                sp.seed = effective_seed;
+                sp.ts = want_ts ? &worker_ts : NULL;
+                sp.seed_out = want_ts ? &seed_out : NULL;
+                rc = tts_stream_play(&sp, &carry);
+                streamed = rc == 1 || sp.take.n > 0;
+                if (!streamed) {
+                    log_event("TTS_SRV", "Stream failed, retrying buffered");
+                    tts_sink_close(sp.sink);
+                    sp.sink = NULL;
+                    free(worker_ts.words);
+                    worker_ts.words = NULL;
+                    worker_ts.count = 0;
+                }
+            }
+            if (!streamed)
+                rc = tts_request(text, voice, effective_seed,
+                                 &pcm_block, &pcm_sr,
                                  want_ts ? &worker_ts : NULL,
                                  want_ts ? &seed_out : NULL,
                                  &g_tts_worker_hrequest);
+            InterlockedExchange(&g_tts_worker_fetching, 0);
+            sink = sp.sink;
+            if (streamed && rc == 0) {
+                pcm_sr = sp.take.sr;
+                pcm_block = tts_pcm_take(&sp.take);
+            }
 
-            if (rc != 0 || !wav_data) {
-                log_event("TTS_SRV", "Request failed");
-                PostMessageA(g_hwnd_main, WM_TTS_STATUS, 3, 0); /* error */
+            if (rc != 0 || !pcm_block) {
+                if (rc == 1) {
+                    log_event("TTS_SRV", "Interrupted during download");
+                    PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0);
+                } else {
+                    log_event("TTS_SRV", "Request failed");
+                    PostMessageA(g_hwnd_main, WM_TTS_STATUS, 3, 0); /* error */
+                }
+                tts_sink_close(sink);
+                InterlockedExchange(&g_tts_playback_ms, -1);
                 free(text);
-                free(wav_data);
+                free(sp.take.pcm);
+                audio_block_release(pcm_block);
                 free(worker_ts.words);
                 continue;
             }
@@ -1271,12 +1820,17 @@ static DWORD WINAPI tts_worker_proc(LPVOID param) {
             if (seed_out >= 0) {
                 InterlockedExchange(&g_tts_last_seed, (LONG)seed_out);
             }
+            if (pending_seed == -2 && g_tts_voice_seeds[voice_idx] >= 0)
+                cache_seed = seed_out >= 0 ? seed_out : -2;  /* -2: don't cache */
 
             /* Check interrupt after network request */
             if (InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) {
                 log_event("TTS_SRV", "Interrupted after download");
+                tts_sink_close(sink);
+                InterlockedExchange(&g_tts_playback_ms, -1);
                 free(text);
-                free(wav_data);
+                free(sp.take.pcm);
+                audio_block_release(pcm_block);
                 free(worker_ts.words);
                 PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0);
                 continue;
@@ -1287,92 +1841,109 @@ static DWORD WINAPI tts_worker_proc(LPVOID param) {
                 tts_groupings_put(sentence_idx, &worker_ts);
                 tts_grouping_disk_save(text, &worker_ts);
             }
-            free(text);
-
-            /* Store in last-WAV cache (audio + timestamps from this fetch) */
-            if (sentence_idx >= 0 && wav_data && wav_len > 0) {
-                EnterCriticalSection(&g_tts_last_wav_lock);
-                free(g_tts_last_wav);
-                free(g_tts_last_wav_words);
-                g_tts_last_wav = (char *)malloc(wav_len);
-                if (g_tts_last_wav) {
-                    memcpy(g_tts_last_wav, wav_data, wav_len);
-                    g_tts_last_wav_len = wav_len;
-                    g_tts_last_wav_sentence = sentence_idx;
-                    g_tts_last_wav_voice = voice_idx;
-                    /* Store timestamps alongside WAV */
-                    if (worker_ts.words && worker_ts.count > 0) {
-                        size_t tsz = worker_ts.count * sizeof(TtsWordTimestamp);
-                        g_tts_last_wav_words = (TtsWordTimestamp *)malloc(tsz);
-                        if (g_tts_last_wav_words) {
-                            memcpy(g_tts_last_wav_words, worker_ts.words, tsz);
-                            g_tts_last_wav_word_count = worker_ts.count;
-                        } else {
-                            g_tts_last_wav_word_count = 0;
-                        }
-                    } else {
-                        g_tts_last_wav_words = NULL;
-                        g_tts_last_wav_word_count = 0;
-                    }
-                } else {
-                    g_tts_last_wav_len = 0;
-                    g_tts_last_wav_sentence = -1;
-                    g_tts_last_wav_voice = -1;
-                    g_tts_last_wav_words = NULL;
-                    g_tts_last_wav_word_count = 0;
-                }
-                LeaveCriticalSection(&g_tts_last_wav_lock);
+
+            clip = tts_clip_from_pcm(pcm_block, pcm_sr, text, voice_idx, cache_seed,
+                                     &worker_ts, seed_out);
+            if (!clip) {
+                tts_sink_close(sink);
+                InterlockedExchange(&g_tts_playback_ms, -1);
+                free(text);
+                free(worker_ts.words);
+                PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0);
+                continue;
             }
-        }
 
-        /* Publish word timestamps for drill renderer */
-        EnterCriticalSection(&g_tts_current_ts_lock);
-        free(g_tts_current_ts.words);
-        g_tts_current_ts = worker_ts;
-        LeaveCriticalSection(&g_tts_current_ts_lock);
-
-        /* Parse WAV header */
-        const int16_t *pcm = NULL;
-        int n_samples = 0, sr = 0;
-        if (wav_parse_header(wav_data, wav_len, &pcm, &n_samples, &sr) != 0) {
-            log_event("TTS_SRV", "Failed to parse WAV header");
-            free(wav_data);
-            PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0);
-            continue;
+            /* Cache audio + timestamps from this fetch */
+            if (cache_seed >= -1)
+                tts_cache_put(g_tts_cache, text, voice, cache_seed, clip);
         }
-
-        char msg[80];
-        snprintf(msg, sizeof(msg), "%s %d samples at %d Hz (%.1fs)",
-                 from_cache ? "Cached" : "Received",
-                 n_samples, sr, (double)n_samples / sr);
+        free(text);
+        free(worker_ts.words);
+
+        /* Publish this clip's word timestamps for drill renderer */
+        tts_current_words_set(tts_words_new(clip->words, clip->word_count));
+
+        const int16_t *pcm = clip->pcm->samples;
+        int n_samples = clip->pcm->n_samples;
+        int sr = clip->sample_rate;
+
+        tts_cache_stats_t cst;
+        tts_cache_stats(g_tts_cache, &cst);
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%s %d samples at %d Hz (%.1fs), cache %d clips %.1f MB",
+                 from_cache ? "Cached" : sink ? "Streamed" : "Received",
+                 n_samples, sr, (double)n_samples / sr,
+                 cst.entries, cst.bytes / (1024.0 * 1024.0));
         log_event("TTS_SRV", msg);
 
-        /* Open waveOut at the WAV sample rate, play, close */
-        if (waveout_open(sr)) {
+        /* Play out the rest of a stream, or the whole clip from the start.
+         * With another take queued the sink stays open for it, so takes at
+         * one rate play back to back on one device stream. */
+        int was_interrupted = 0;
+        if (!sink && (sink = tts_sink_next(&carry, sr, 0)) != NULL) {
             PostMessageA(g_hwnd_main, WM_TTS_STATUS, 2, 0); /* speaking */
-            int was_interrupted = waveout_play_pcm(pcm, n_samples);
-            waveout_close();
+            was_interrupted = tts_sink_push(sink, pcm, n_samples) == 1;
+        } else if (!sink) {
+            log_event("TTS_SRV", "Failed to open audio output");
+        }
+        if (sink) {
+            if (!was_interrupted && ttsq_count(g_tts_queue, TTSQ_PLAY) > 0) {
+                was_interrupted = tts_sink_end_take(sink);
+                if (!was_interrupted) {
+                    carry = sink;
+                    sink = NULL;
+                }
+            } else if (!was_interrupted) {
+                was_interrupted = tts_sink_finish(sink);
+            }
+            if (sink) {
+                InterlockedExchange(&g_tts_playback_ms, -1);
+                tts_sink_close(sink);
+            }
             if (was_interrupted) {
                 log_event("TTS_SRV", "Playback interrupted");
             }
-        } else {
-            log_event("TTS_SRV", "waveout_open failed");
         }
 
-        free(wav_data);
-        PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0); /* idle */
+        tts_clip_release(clip);
+        if (ttsq_count(g_tts_queue, TTSQ_PLAY) == 0)
+            PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0); /* idle */
     }
 
+    if (carry) {
+        InterlockedExchange(&g_tts_playback_ms, -1);
+        tts_sink_close(carry);
+    }
     return 0;
 }
 
 static int tts_worker_start(void) {
-    InitializeCriticalSection(&g_tts_lock);
-    InitializeCriticalSection(&g_tts_current_ts_lock);
-    InitializeCriticalSection(&g_tts_last_wav_lock);
+    g_tts_worker_hrequest = NULL;
+    g_tts_synth_hrequest = NULL;
+    g_tts_cache = tts_cache_create(TTS_CACHE_BYTES);
+    g_tts_queue = ttsq_create();
+    g_tts_synth_cancel = exec_cancel_new();
+    if (!g_tts_queue || !g_tts_synth_cancel) {
+        log_event("TTS_SRV", "Failed to create request queue");
+        return 0;
+    }
+    {
+        char dir[MAX_PATH];
+        if (resolve_exe_relative("..\\tts_cache", dir, sizeof(dir)) == 0) {
+            CreateDirectoryA(dir, NULL);
+            strncat(dir, "\\audio", sizeof(dir) - strlen(dir) - 1);
+            g_tts_store = tts_store_open(dir, TTS_STORE_BYTES);
+        }
+        if (!g_tts_store)
+            log_event("TTS_DISK", "Failed to open disk cache");
+        else if (executor_submit(g_executor, EXEC_LANE_PREFETCH, tts_store_trim_task,
+                                 NULL, NULL, NULL) != 0)
+            log_event("TTS_DISK", "Failed to queue disk cache scan");
+    }
     g_tts_request_event = CreateEventA(NULL, FALSE, FALSE, NULL);   /* auto-reset */
     g_tts_shutdown_event = CreateEventA(NULL, TRUE, FALSE, NULL);   /* manual-reset */
-    if (!g_tts_request_event || !g_tts_shutdown_event) {
+    g_tts_synth_done_event = CreateEventA(NULL, FALSE, FALSE, NULL);  /* auto-reset */
+    if (!g_tts_request_event || !g_tts_shutdown_event || !g_tts_synth_done_event) {
         log_event("TTS_SRV", "Failed to create worker events");
         return 0;
     }
@@ -1391,20 +1962,16 @@ static void tts_worker_stop(void) {
     /* Signal interrupt + shutdown */
     InterlockedExchange(&g_tts_interrupt, 1);
     /* Cancel any in-flight HTTP request so thread unblocks immediately */
-    {
-        HINTERNET h = InterlockedExchangePointer(
-            (volatile PVOID *)&g_tts_worker_hrequest, NULL);
-        if (h) WinHttpCloseHandle(h);
-    }
+    tts_http_cancel(&g_tts_worker_hrequest);
     if (g_tts_shutdown_event) {
         SetEvent(g_tts_shutdown_event);
     }
+    /* No time limit: the queue and the clip cache go away below */
     if (g_tts_thread) {
-        WaitForSingleObject(g_tts_thread, 5000);
+        WaitForSingleObject(g_tts_thread, INFINITE);
         CloseHandle(g_tts_thread);
         g_tts_thread = NULL;
     }
-    waveout_close();
     if (g_tts_request_event) {
         CloseHandle(g_tts_request_event);
         g_tts_request_event = NULL;
@@ -1413,36 +1980,29 @@ static void tts_worker_stop(void) {
         CloseHandle(g_tts_shutdown_event);
         g_tts_shutdown_event = NULL;
     }
-    EnterCriticalSection(&g_tts_lock);
-    free(g_tts_pending_text);
-    g_tts_pending_text = NULL;
-    LeaveCriticalSection(&g_tts_lock);
-    DeleteCriticalSection(&g_tts_lock);
-    EnterCriticalSection(&g_tts_current_ts_lock);
-    free(g_tts_current_ts.words);
-    g_tts_current_ts.words = NULL;
-    g_tts_current_ts.count = 0;
-    LeaveCriticalSection(&g_tts_current_ts_lock);
-    DeleteCriticalSection(&g_tts_current_ts_lock);
-    EnterCriticalSection(&g_tts_last_wav_lock);
-    free(g_tts_last_wav);
-    g_tts_last_wav = NULL;
-    g_tts_last_wav_len = 0;
-    free(g_tts_last_wav_words);
-    g_tts_last_wav_words = NULL;
-    g_tts_last_wav_word_count = 0;
-    LeaveCriticalSection(&g_tts_last_wav_lock);
-    DeleteCriticalSection(&g_tts_last_wav_lock);
-}
-
-/* ---- TTS pre-fetch thread (word groupings only, voice-independent) ---- */
+    if (g_tts_synth_done_event) {
+        CloseHandle(g_tts_synth_done_event);
+        g_tts_synth_done_event = NULL;
+    }
+    ttsq_destroy(g_tts_queue);
+    g_tts_queue = NULL;
+    exec_cancel_release(g_tts_synth_cancel);
+    g_tts_synth_cancel = NULL;
+    tts_current_words_set(NULL);
+    tts_current_words_reclaim();
+    tts_cache_destroy(g_tts_cache);
+    g_tts_cache = NULL;
+}
+
+/* ---- TTS pre-fetch (word groupings only, voice-independent) ---- */
 
 /* Fetch word groupings for one sentence. Checks disk cache first, then server.
- * Discards audio — only keeps timestamps. Returns 1 on success. */
-static int tts_prefetch_fetch_one(int idx) {
+ * Discards audio — only keeps timestamps. slot picks the cancel handle.
+ * Returns 1 on success. */
+static int tts_prefetch_fetch_one(int idx, int slot) {
     if (idx < 0 || idx >= g_drill_state.num_sentences) return 0;
     const char *text = g_drill_state.sentences[idx].chinese;
-    if (!text[0]) return 0;
+    if (!text[0]) return 1;  /* nothing to fetch */
 
     TtsTimestamps ts = {0};
 
@@ -1462,12 +2022,9 @@ static int tts_prefetch_fetch_one(int idx) {
     }
 
     /* Fetch from server — use first voice, no seed (groupings are voice-independent) */
-    char *wav_data = NULL;
-    int wav_len = 0;
-    int rc = tts_request(text, g_tts_voices[0], -1,
-                         &wav_data, &wav_len,
-                         &ts, NULL, &g_tts_prefetch_hrequest);
-    free(wav_data);  /* discard audio — we only want groupings */
+    /* Audio is decoded and dropped — we only want groupings */
+    int rc = tts_request(text, tts_voices[0], -1, NULL, NULL,
+                         &ts, NULL, &g_tts_prefetch_hrequest[slot]);
     if (rc != 0 || ts.count <= 0) {
         free(ts.words);
         return 0;
@@ -1486,148 +2043,499 @@ static int tts_prefetch_fetch_one(int idx) {
     log_event("TTS_PRE", pmsg);
     PostMessageA(g_hwnd_main, WM_TTS_CACHED, (WPARAM)idx, 0);
     return 1;
-}
-
-static DWORD WINAPI tts_prefetch_proc(LPVOID param) {
-    (void)param;
-    HANDLE events[2] = { g_tts_prefetch_event, g_tts_prefetch_shutdown };
-
-    while (1) {
-        DWORD which = WaitForMultipleObjects(2, events, FALSE, INFINITE);
-        if (which != WAIT_OBJECT_0) break; /* shutdown */
+}
 
-        int n = g_tts_groupings_count;
+static void tts_prefetch_kick(void);
+
+/* One prefetch step in a slot: the best ready sentence from the queue.
+ * Requeues itself while there is work, so interactive tasks on the
+ * executor are never stuck behind a whole sweep. When only backoffs are
+ * left, one step is requeued with a delay to wait them out (holding no
+ * worker) and the others retire. */
+static void tts_prefetch_step(void *param, exec_cancel_t *cancel) {
+    int slot = (int)(INT_PTR)param;
+    InterlockedCompareExchange(&g_tts_prefetch_waiter, 0, slot + 1);
+    if (exec_cancelled(cancel)) {
+        InterlockedExchange(&g_tts_prefetch_slot_busy[slot], 0);
+        return;
+    }
 
-        /* Count already-cached entries to init done counter */
-        LONG already = 0;
-        for (int i = 0; i < n; i++) {
-            if (tts_groupings_has(i)) already++;
+    long wait_ms = -1;
+    unsigned long delay_ms = 0;
+    int idx = pfq_pop(g_tts_prefetch_queue, GetTickCount(), &wait_ms);
+    if (idx >= 0) {
+        int ok = tts_groupings_has(idx) || tts_prefetch_fetch_one(idx, slot);
+        if (!ok && !exec_cancelled(cancel)) {
+            char pmsg[64];
+            snprintf(pmsg, sizeof(pmsg), "Grouping fetch failed: sentence %d, will retry", idx);
+            log_event("TTS_PRE", pmsg);
         }
-        InterlockedExchange(&g_tts_prefetch_done, already);
-        InterlockedExchange(&g_tts_prefetch_total, (LONG)n);
-
-        /* Sequential sweep 0..N with priority interrupts */
-        for (int i = 0; i < n; i++) {
-            if (WaitForSingleObject(g_tts_prefetch_shutdown, 0) == WAIT_OBJECT_0)
-                goto done;
-
-            /* Check priority: service it first, then resume */
-            LONG pri = InterlockedExchange(&g_tts_prefetch_priority, -1);
-            if (pri >= 0 && pri < n && !tts_groupings_has((int)pri)) {
-                if (!tts_prefetch_fetch_one((int)pri)) {
-                    if (WaitForSingleObject(g_tts_prefetch_shutdown, 2000) == WAIT_OBJECT_0)
-                        goto done;
-                }
-            }
+        pfq_finish(g_tts_prefetch_queue, idx, ok, GetTickCount());
+    } else if (wait_ms < 0
+               || InterlockedCompareExchange(&g_tts_prefetch_waiter, slot + 1, 0) != 0) {
+        /* Drained (or another step is waiting). A push after our pop must
+         * not be lost, so re-kick once the slot is free. */
+        InterlockedExchange(&g_tts_prefetch_slot_busy[slot], 0);
+        if (pfq_waiting(g_tts_prefetch_queue) > 0 && wait_ms < 0)
+            tts_prefetch_kick();
+        return;
+    } else {
+        /* Look again within a second, so a priority push still reaches a
+         * lone slot soon */
+        delay_ms = wait_ms < 1 ? 1 : wait_ms < 1000 ? (unsigned long)wait_ms : 1000;
+    }
 
-            /* Skip already-cached */
-            if (tts_groupings_has(i)) continue;
+    if (executor_submit_delayed(g_executor, EXEC_LANE_PREFETCH, delay_ms, tts_prefetch_step,
+                                param, cancel, NULL) != 0) {
+        InterlockedCompareExchange(&g_tts_prefetch_waiter, 0, slot + 1);
+        InterlockedExchange(&g_tts_prefetch_slot_busy[slot], 0);
+    } else if (idx >= 0) {
+        tts_prefetch_kick();  /* retries that became ready may want more slots */
+    }
+}
 
-            /* Fetch this sentence's groupings */
-            if (!tts_prefetch_fetch_one(i)) {
-                if (WaitForSingleObject(g_tts_prefetch_shutdown, 2000) == WAIT_OBJECT_0)
-                    goto done;
-                i--;  /* retry */
-                continue;
-            }
+/* Start steps in free slots, up to one per waiting sentence */
+static void tts_prefetch_kick(void) {
+    if (!g_tts_prefetch_cancel || exec_cancelled(g_tts_prefetch_cancel)) return;
+    int want = pfq_waiting(g_tts_prefetch_queue);
+    for (int slot = 0; slot < g_tts_prefetch_jobs && want > 0; slot++) {
+        if (InterlockedCompareExchange(&g_tts_prefetch_slot_busy[slot], 1, 0) != 0)
+            continue;
+        if (executor_submit(g_executor, EXEC_LANE_PREFETCH, tts_prefetch_step,
+                            (void *)(INT_PTR)slot, g_tts_prefetch_cancel, NULL) != 0) {
+            InterlockedExchange(&g_tts_prefetch_slot_busy[slot], 0);
+            log_event("TTS_PRE", "Failed to queue prefetch step");
+            return;
         }
-        /* Sweep complete — wait for next event */
+        want--;
     }
-
-done:
-    return 0;
 }
 
 static void tts_prefetch_start(void) {
-    InterlockedExchange(&g_tts_prefetch_priority, -1);
-
-    g_tts_prefetch_event = CreateEventA(NULL, FALSE, FALSE, NULL);     /* auto-reset */
-    g_tts_prefetch_shutdown = CreateEventA(NULL, TRUE, FALSE, NULL);   /* manual-reset */
-    if (!g_tts_prefetch_event || !g_tts_prefetch_shutdown) {
-        log_event("TTS_PRE", "Failed to create prefetch events");
+    int n = g_tts_groupings_count;
+    for (int slot = 0; slot < TTS_PREFETCH_MAX_JOBS; slot++)
+        g_tts_prefetch_hrequest[slot] = NULL;
+    g_tts_prefetch_queue = pfq_create(n, TTS_PREFETCH_BACKOFF_MS, TTS_PREFETCH_BACKOFF_MAX);
+    g_tts_prefetch_cancel = exec_cancel_new();
+    if (!g_tts_prefetch_queue || !g_tts_prefetch_cancel) {
+        log_event("TTS_PRE", "Failed to create prefetch queue");
+        pfq_destroy(g_tts_prefetch_queue);
+        g_tts_prefetch_queue = NULL;
+        exec_cancel_release(g_tts_prefetch_cancel);
+        g_tts_prefetch_cancel = NULL;
         return;
     }
 
-    g_tts_prefetch_thread = CreateThread(NULL, 0, tts_prefetch_proc, NULL, 0, NULL);
-    if (!g_tts_prefetch_thread) {
-        log_event("TTS_PRE", "Failed to create prefetch thread");
-        return;
+    /* Queue the sweep: every uncached sentence, in bank order */
+    LONG already = 0;
+    for (int i = 0; i < n; i++) {
+        if (tts_groupings_has(i)) already++;
+        else pfq_push(g_tts_prefetch_queue, i, 0);
     }
+    InterlockedExchange(&g_tts_prefetch_done, already);
+    InterlockedExchange(&g_tts_prefetch_total, (LONG)n);
 
-    /* Kick off initial sweep */
-    InterlockedExchange(&g_tts_prefetch_total, (LONG)g_tts_groupings_count);
-    InterlockedExchange(&g_tts_prefetch_done, 0);
-    SetEvent(g_tts_prefetch_event);
-
-    log_event("TTS_PRE", "Prefetch thread started");
+    tts_prefetch_kick();
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Prefetch started (%d jobs, %ld/%d cached)",
+             g_tts_prefetch_jobs, already, n);
+    log_event("TTS_PRE", msg);
 }
 
 static void tts_prefetch_stop(void) {
-    {
-        HINTERNET h = InterlockedExchangePointer(
-            (volatile PVOID *)&g_tts_prefetch_hrequest, NULL);
-        if (h) WinHttpCloseHandle(h);
+    if (!g_tts_prefetch_cancel) return;
+    /* Also starts a step delayed over backoffs, so it sees the cancel now */
+    executor_cancel(g_executor, g_tts_prefetch_cancel);
+    for (int slot = 0; slot < TTS_PREFETCH_MAX_JOBS; slot++)
+        tts_http_cancel(&g_tts_prefetch_hrequest[slot]);
+    /* Let in-flight steps notice the cancel before groupings go away */
+    for (int i = 0; i < 100; i++) {
+        int busy = 0;
+        for (int slot = 0; slot < TTS_PREFETCH_MAX_JOBS; slot++)
+            busy |= InterlockedCompareExchange(&g_tts_prefetch_slot_busy[slot], 0, 0);
+        if (!busy) break;
+        Sleep(50);
+    }
+    exec_cancel_release(g_tts_prefetch_cancel);
+    g_tts_prefetch_cancel = NULL;
+}
+
+/* Fetch sentence idx ahead of the sweep and of earlier requests. */
+static void tts_prefetch_prioritize(int idx) {
+    if (!g_tts_prefetch_queue || tts_groupings_has(idx)) return;
+    pfq_push(g_tts_prefetch_queue, idx, (int)InterlockedIncrement(&g_tts_prefetch_pri));
+    tts_prefetch_kick();
+}
+
+/* ---- Synthesis ahead (queued playback, likely next sentences) ---- */
+
+/* Make one request's take into the clip cache (and disk) unless it is
+ * there already. Tuning requests are skipped: the worker never replays
+ * them. */
+static void tts_synth_one(const ttsq_item_t *it, exec_cancel_t *cancel) {
+    if (it->seed == -2) return;
+    int seed = it->seed == -1 ? tts_cache_seed(it->voice) : it->seed;
+    const char *voice = tts_voices[it->voice];
+    tts_clip_t *clip = tts_cache_get(g_tts_cache, it->text, voice, seed);
+    if (!clip && seed >= 0) clip = tts_store_load(it->text, it->voice, seed);
+    if (clip) goto done;
+
+    /* Leave the server to the worker while it is fetching. It may have
+     * fetched this very take meanwhile. */
+    if (InterlockedCompareExchange(&g_tts_worker_fetching, 0, 0)) {
+        while (InterlockedCompareExchange(&g_tts_worker_fetching, 0, 0))
+            if (exec_cancel_wait(cancel, 100)) return;
+        clip = tts_cache_get(g_tts_cache, it->text, voice, seed);
+        if (clip) goto done;
+    }
+
+    audio_block_t *pcm_block = NULL;
+    int pcm_sr = 0;
+    int seed_out = -1;
+    TtsTimestamps ts = {0};
+    int rc = tts_request(it->text, voice, seed, &pcm_block, &pcm_sr,
+                         &ts, &seed_out, &g_tts_synth_hrequest);
+    if (rc == 0) {
+        if (it->tag >= 0 && ts.count > 0) {
+            tts_groupings_put(it->tag, &ts);
+            tts_grouping_disk_save(it->text, &ts);
+        }
+        clip = tts_clip_from_pcm(pcm_block, pcm_sr, it->text, it->voice, seed,
+                                 &ts, seed_out);
+        if (clip) {
+            tts_cache_put(g_tts_cache, it->text, voice, seed, clip);
+            char pmsg[80];
+            snprintf(pmsg, sizeof(pmsg), "%s take ready: sentence %d (%s)",
+                     it->cls >= TTSQ_PLAY ? "Queued" : "Predicted", it->tag, voice);
+            log_event("TTS_PRE", pmsg);
+        }
+    } else if (rc != 1) {
+        log_event("TTS_PRE", "Synthesis ahead failed");
+    }
+    free(ts.words);
+
+done:
+    tts_clip_release(clip);
+}
+
+static void tts_synth_step(void *param, exec_cancel_t *cancel);
+
+/* Queue the step on the lane for what is waiting: playback for queued
+ * sentences, idle for guesses. The caller holds g_tts_synth_busy. */
+static int tts_synth_submit(exec_cancel_t *cancel) {
+    exec_lane_t lane = ttsq_count(g_tts_queue, TTSQ_PLAY) > 0 ? EXEC_LANE_PLAYBACK
+                                                              : EXEC_LANE_IDLE;
+    return executor_submit(g_executor, lane, tts_synth_step, NULL, cancel, NULL);
+}
+
+/* One request per step, then requeue, so the lane follows what is waiting
+ * and word slices wait for one take at most. g_tts_synth_busy stays set
+ * from the first submit until a step finds nothing to do or is cancelled,
+ * and once it drops a step touches nothing but its own token: when
+ * tts_synth_stop sees it clear, the queue and the cache can go. */
+static void tts_synth_step(void *param, exec_cancel_t *cancel) {
+    (void)param;
+    LONG kicks = InterlockedCompareExchange(&g_tts_synth_kicks, 0, 0);
+    ttsq_item_t *it = exec_cancelled(cancel) ? NULL : ttsq_take_synth(g_tts_queue);
+    if (it) {
+        tts_synth_one(it, cancel);
+        ttsq_synth_done(g_tts_queue, it);
+        SetEvent(g_tts_synth_done_event);
+    } else if (!exec_cancelled(cancel)) {
+        /* Nothing to take. A kick since our take must not be lost: take
+         * the step back unless that kick already restarted it. A stop
+         * that saw busy clear meanwhile has set the token checked below. */
+        InterlockedExchange(&g_tts_synth_busy, 0);
+        if (InterlockedCompareExchange(&g_tts_synth_kicks, 0, 0) == kicks
+            || InterlockedCompareExchange(&g_tts_synth_busy, 1, 0) != 0)
+            return;
     }
-    if (g_tts_prefetch_shutdown)
-        SetEvent(g_tts_prefetch_shutdown);
-    if (g_tts_prefetch_thread) {
-        WaitForSingleObject(g_tts_prefetch_thread, 5000);
-        CloseHandle(g_tts_prefetch_thread);
-        g_tts_prefetch_thread = NULL;
+    if (!exec_cancelled(cancel)) {
+        if (tts_synth_submit(cancel) == 0) return;
+        log_event("TTS_PRE", "Failed to queue synthesis step");
     }
-    if (g_tts_prefetch_event) {
-        CloseHandle(g_tts_prefetch_event);
-        g_tts_prefetch_event = NULL;
+    InterlockedExchange(&g_tts_synth_busy, 0);
+}
+
+/* Start the step if it isn't queued or running */
+static void tts_synth_kick(void) {
+    InterlockedIncrement(&g_tts_synth_kicks);
+    if (!g_tts_synth_cancel || exec_cancelled(g_tts_synth_cancel) || !g_executor) return;
+    if (InterlockedCompareExchange(&g_tts_synth_busy, 1, 0) != 0) return;
+    if (tts_synth_submit(g_tts_synth_cancel) != 0) {
+        InterlockedExchange(&g_tts_synth_busy, 0);
+        log_event("TTS_PRE", "Failed to queue synthesis step");
     }
-    if (g_tts_prefetch_shutdown) {
-        CloseHandle(g_tts_prefetch_shutdown);
-        g_tts_prefetch_shutdown = NULL;
+}
+
+/* Queue synthesis of the likely next sentences after the current one,
+ * most likely first, replacing the guesses that haven't started yet. */
+static void tts_predict_schedule(void) {
+    if (g_tts_predict_count <= 0 || !g_drill_mode || !g_tts_queue) return;
+    ttsq_drop_class(g_tts_queue, TTSQ_SPECULATIVE);
+    ttsq_drop_class(g_tts_queue, TTSQ_PREFETCH);
+
+    int next[TTS_PREDICT_MAX];
+    int n = drill_peek_next(&g_drill_state, g_drill_state.current_idx, next,
+                            g_tts_predict_count);
+    for (int i = 0; i < n; i++) {
+        const char *text = g_drill_state.sentences[next[i]].chinese;
+        if (!text[0]) continue;
+        if (ttsq_push(g_tts_queue, text, g_tts_voice_idx, g_tts_voice_seeds[g_tts_voice_idx],
+                      next[i], i == 0 ? TTSQ_SPECULATIVE : TTSQ_PREFETCH) != 0) {
+            log_event("TTS_PRE", "Failed to queue predicted take");
+            break;
+        }
     }
+    tts_synth_kick();
 }
 
-/* Set priority sentence and wake prefetch thread. */
-static void tts_prefetch_prioritize(int idx) {
-    InterlockedExchange(&g_tts_prefetch_priority, (LONG)idx);
-    if (g_tts_prefetch_event)
-        SetEvent(g_tts_prefetch_event);
+static void tts_synth_stop(void) {
+    if (g_tts_synth_cancel) exec_cancel_set(g_tts_synth_cancel);
+    tts_http_cancel(&g_tts_synth_hrequest);
+    /* A step still uses the queue and the clip cache the worker frees
+     * next. Its request was aborted above and a queued step sees the
+     * cancel at once, so this ends as soon as the step in flight unwinds. */
+    while (InterlockedCompareExchange(&g_tts_synth_busy, 0, 0))
+        Sleep(10);
 }
 
-/* Publish grouping timestamps to g_tts_current_ts for drill renderer. */
+/* Publish sentence idx's groupings as the current timestamps for the drill
+ * renderer (the table's own block, no copy). UI thread. */
 static void tts_publish_cached_timestamps(int idx) {
-    TtsTimestamps ts = {0};
-    int have = tts_groupings_copy(idx, &ts);
-    EnterCriticalSection(&g_tts_current_ts_lock);
-    free(g_tts_current_ts.words);
-    if (have) {
-        g_tts_current_ts = ts;
-    } else {
-        g_tts_current_ts.words = NULL;
-        g_tts_current_ts.count = 0;
-    }
-    LeaveCriticalSection(&g_tts_current_ts_lock);
+    TtsWordsBlock *b = g_tts_groupings && idx >= 0 && idx < g_tts_groupings_count
+                     ? g_tts_groupings[idx] : NULL;
+    tts_current_words_set(b);
+    tts_current_words_reclaim();
 }
 
-/* Queue text for server TTS playback (non-blocking).
+/* Play text with server TTS now (non-blocking): interrupts what is playing
+ * and drops the playback queued behind it.
  * sentence_idx >= 0 stores word groupings on success; -1 skips.
  * seed: -1=use voice's locked seed (or random), -2=force random (tuning), >=0=explicit */
 static void tts_speak_server(const char *text, int sentence_idx, int seed) {
-    if (!text || !text[0]) return;
+    if (!text || !text[0] || !g_tts_queue) return;
 
-    /* Interrupt any in-progress playback */
+    ttsq_drop_playback(g_tts_queue);
     InterlockedExchange(&g_tts_interrupt, 1);
+    if (ttsq_push(g_tts_queue, text, g_tts_voice_idx, seed, sentence_idx,
+                  TTSQ_INTERACTIVE) != 0) {
+        log_event("TTS_SRV", "Failed to queue request");
+        return;
+    }
+    SetEvent(g_tts_request_event);
+}
 
-    char *copy = _strdup(text);
-    if (!copy) return;
+/* Play text after the playback already queued, without interrupting.
+ * Same arguments as tts_speak_server. */
+static void tts_speak_server_queued(const char *text, int sentence_idx, int seed) {
+    if (!text || !text[0] || !g_tts_queue) return;
+    if (ttsq_push(g_tts_queue, text, g_tts_voice_idx, seed, sentence_idx, TTSQ_PLAY) != 0) {
+        log_event("TTS_SRV", "Failed to queue request");
+        return;
+    }
+    SetEvent(g_tts_request_event);
+    tts_synth_kick();
+}
 
-    EnterCriticalSection(&g_tts_lock);
-    free(g_tts_pending_text);
-    g_tts_pending_text = copy;
-    g_tts_pending_voice_idx = g_tts_voice_idx;
-    g_tts_pending_sentence_idx = sentence_idx;
-    g_tts_pending_seed = seed;
-    LeaveCriticalSection(&g_tts_lock);
+/* Speak a reply sentence by sentence (ends at . ! ? newline and the CJK
+ * full stop, exclamation and question marks), replacing anything playing
+ * or queued. Later sentences are synthesized while earlier ones play. */
+static void tts_speak_server_reply(const char *text) {
+    if (!text || !g_tts_queue) return;
+    ttsq_drop_playback(g_tts_queue);
+    InterlockedExchange(&g_tts_interrupt, 1);
 
-    SetEvent(g_tts_request_event);
+    char *buf = (char *)malloc(strlen(text) + 1);
+    if (!buf) return;
+    const unsigned char *p = (const unsigned char *)text;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        int len = 0;
+        while (*p) {
+            int end = 0, k = 1;
+            if (*p == '.' || *p == '!' || *p == '?' || *p == '\n') {
+                end = 1;
+            } else if ((p[0] == 0xE3 && p[1] == 0x80 && p[2] == 0x82)         /* 。 */
+                       || (p[0] == 0xEF && p[1] == 0xBC
+                           && (p[2] == 0x81 || p[2] == 0x9F))) {             /* ！ ？ */
+                end = 1;
+                k = 3;
+            }
+            memcpy(buf + len, p, k);
+            len += k;
+            p += k;
+            if (!end) continue;
+            /* "?!", "...", closing quotes stay with the sentence */
+            while (*p == '.' || *p == '!' || *p == '?' || *p == '"' || *p == '\'' || *p == ')')
+                buf[len++] = (char)*p++;
+            break;
+        }
+        while (len > 0 && (buf[len - 1] == ' ' || buf[len - 1] == '\t'
+                           || buf[len - 1] == '\r' || buf[len - 1] == '\n')) len--;
+        buf[len] = '\0';
+        if (len > 0) tts_speak_server_queued(buf, -1, -1);
+    }
+    free(buf);
+}
+
+/* ---- Audition batch (seed tuning) ---- */
+
+typedef struct {
+    TtsAudition *batch;
+    int slot;               /* picks the cancel handle */
+} TtsAuditionJob;
+
+static void tts_audition_release(TtsAudition *a) {
+    if (InterlockedDecrement(&a->refs) != 0) return;
+    exec_cancel_release(a->cancel);
+    free(a->text);
+    free(a);
+}
+
+/* One take of the batch, then requeue while takes remain */
+static void tts_audition_step(void *param, exec_cancel_t *cancel) {
+    TtsAuditionJob *job = (TtsAuditionJob *)param;
+    TtsAudition *a = job->batch;
+    LONG i = exec_cancelled(cancel) ? a->count : InterlockedIncrement(&a->next) - 1;
+    if (i < a->count) {
+        TtsAuditionTake *t = &a->takes[i];
+        const char *voice = tts_voices[t->voice_idx];
+        audio_block_t *pcm_block = NULL;
+        int pcm_sr = 0;
+        int seed_out = -1;
+        TtsTimestamps ts = {0};
+        int rc = tts_request(a->text, voice, -1, &pcm_block, &pcm_sr,
+                             &ts, &seed_out, &a->hrequest[job->slot]);
+        tts_clip_t *clip = NULL;
+        if (rc == 0 && seed_out >= 0) {
+            if (!tts_groupings_has(a->sentence_idx)) tts_groupings_put(a->sentence_idx, &ts);
+            clip = tts_clip_from_pcm(pcm_block, pcm_sr, a->text, t->voice_idx, seed_out,
+                                     &ts, seed_out);
+        } else {
+            audio_block_release(pcm_block);
+        }
+        char msg[96];
+        if (clip) {
+            tts_cache_put(g_tts_cache, a->text, voice, seed_out, clip);
+            tts_clip_release(clip);
+            InterlockedExchange(&t->seed, (LONG)seed_out);
+            snprintf(msg, sizeof(msg), "Audition %ld/%d ready: %s #%d",
+                     InterlockedIncrement(&a->ready), a->count, voice, seed_out);
+            log_event("TTS_AUD", msg);
+        } else if (!exec_cancelled(cancel)) {
+            snprintf(msg, sizeof(msg), "Audition take failed: %s%s", voice,
+                     rc == 0 ? " (server sent no seed)" : "");
+            log_event("TTS_AUD", msg);
+        }
+        free(ts.words);
+    }
+
+    if (i + 1 < a->count && !exec_cancelled(cancel)
+        && executor_submit(g_executor, EXEC_LANE_PREFETCH, tts_audition_step, job,
+                           cancel, NULL) == 0)
+        return;
+    tts_audition_release(a);
+    free(job);
+    InterlockedDecrement(&g_tts_audition_busy);
+}
+
+/* Stop the batch's remaining takes; its cached takes stay */
+static void tts_audition_cancel(void) {
+    TtsAudition *a = g_tts_audition;
+    if (!a) return;
+    g_tts_audition = NULL;
+    g_tts_audition_cursor = -1;
+    exec_cancel_set(a->cancel);
+    for (int slot = 0; slot < TTS_AUDITION_MAX_JOBS; slot++)
+        tts_http_cancel(&a->hrequest[slot]);
+    tts_audition_release(a);
+}
+
+/* Start a batch for sentence idx, replacing any running one */
+static void tts_audition_start(int sentence_idx) {
+    const char *text = g_drill_state.sentences[sentence_idx].chinese;
+    if (!text[0] || !g_executor) return;
+    tts_audition_cancel();
+
+    TtsAudition *a = (TtsAudition *)calloc(1, sizeof(TtsAudition));
+    if (!a) return;
+    a->text = _strdup(text);
+    a->cancel = exec_cancel_new();
+    if (!a->text || !a->cancel) {
+        exec_cancel_release(a->cancel);
+        free(a->text);
+        free(a);
+        return;
+    }
+    a->sentence_idx = sentence_idx;
+    /* First seeds of every voice before second seeds */
+    for (int c = 0; c < g_tts_audition_count; c++)
+        for (int v = 0; v < (int)TTS_NUM_VOICES; v++) {
+            a->takes[a->count].voice_idx = v;
+            a->takes[a->count].seed = -1;
+            a->count++;
+        }
+    a->refs = 1;
+    g_tts_audition = a;
+
+    int jobs = g_tts_audition_jobs < a->count ? g_tts_audition_jobs : a->count;
+    for (int slot = 0; slot < jobs; slot++) {
+        TtsAuditionJob *job = (TtsAuditionJob *)malloc(sizeof(TtsAuditionJob));
+        if (!job) break;
+        job->batch = a;
+        job->slot = slot;
+        InterlockedIncrement(&a->refs);
+        InterlockedIncrement(&g_tts_audition_busy);
+        if (executor_submit(g_executor, EXEC_LANE_PREFETCH, tts_audition_step, job,
+                            a->cancel, NULL) != 0) {
+            InterlockedDecrement(&g_tts_audition_busy);
+            InterlockedDecrement(&a->refs);
+            free(job);
+            log_event("TTS_AUD", "Failed to queue audition step");
+            break;
+        }
+    }
+    char msg[96];
+    snprintf(msg, sizeof(msg), "Audition batch: %d voices x %d seeds, %d at a time",
+             (int)TTS_NUM_VOICES, g_tts_audition_count, jobs);
+    log_event("TTS_AUD", msg);
+}
+
+/* Play the next (dir > 0) or previous finished take of the batch from the
+ * cache, switching to its voice. UI thread. */
+static void tts_audition_flip(int dir) {
+    TtsAudition *a = g_tts_audition;
+    if (!a) return;
+    if (a->sentence_idx != g_drill_state.current_idx) {
+        log_event("TTS_AUD", "Audition batch is for another sentence");
+        return;
+    }
+    int from = g_tts_audition_cursor >= 0 ? g_tts_audition_cursor : dir > 0 ? -1 : a->count;
+    for (int k = 1; k <= a->count; k++) {
+        int i = ((from + dir * k) % a->count + a->count) % a->count;
+        LONG seed = InterlockedCompareExchange(&a->takes[i].seed, 0, 0);
+        if (seed < 0) continue;
+        g_tts_audition_cursor = i;
+        g_tts_voice_idx = a->takes[i].voice_idx;
+        InterlockedExchange(&g_tts_last_seed, seed);
+        tts_speak_server(a->text, a->sentence_idx, (int)seed);
+        char msg[96];
+        snprintf(msg, sizeof(msg), "Audition %d/%d: %s #%ld",
+                 i + 1, a->count, tts_voices[a->takes[i].voice_idx], seed);
+        log_event("TTS_AUD", msg);
+        return;
+    }
+    log_event("TTS_AUD", "No audition takes ready yet");
+}
+
+static void tts_audition_stop(void) {
+    tts_audition_cancel();
+    /* A running step still uses the clip cache the worker frees next. Its
+     * request was cancelled above and queued steps see the cancel at once,
+     * so this ends as soon as the step in flight unwinds. */
+    while (InterlockedCompareExchange(&g_tts_audition_busy, 0, 0))
+        Sleep(10);
 }
 
 /* ---- Local LLM (llama-server HTTP) ---- */
@@ -1650,7 +2558,7 @@ static void llm_history_append(const char *role, const char *content) {
     m->content[sizeof(m->content) - 1] = '\0';
 }
 
-/* Escape a string for JSON: handle ", \, \n, \r, \t */
+/* Escape a string for JSON: handle ", \, \n, \r, \t and other control characters */
 static int json_escape(const char *src, char *dst, int dst_size) {
     int j = 0;
     for (int i = 0; src[i] && j < dst_size - 2; i++) {
@@ -1667,6 +2575,9 @@ static int json_escape(const char *src, char *dst, int dst_size) {
         } else if (c == '\t') {
             if (j + 2 >= dst_size) break;
             dst[j++] = '\\'; dst[j++] = 't';
+        } else if ((unsigned char)c < 0x20) {
+            if (j + 6 >= dst_size) break;
+            j += snprintf(dst + j, dst_size - j, "\\u%04x", (unsigned char)c);
         } else {
             dst[j++] = c;
         }
@@ -2085,6 +2996,12 @@ static void tts_speak(const char *text) {
         }
     }
 
+    if (g_tts_server_replies) {
+        tts_speak_server_reply(speak_text);
+        free(stripped);
+        return;
+    }
+
     /* SAPI TTS */
     if (!g_tts_voice) { free(stripped); return; }
 
@@ -2274,129 +3191,304 @@ static void pipe_send(const char *text) {
 }
 
 /* Audio buffer functions */
+/* Capture thread: hand samples to the UI thread without locking */
 static void add_audio_samples(const int16_t *pcm16, int sample_count) {
-    EnterCriticalSection(&g_audio_lock);
-
     if (!g_capture_ready && sample_count > 0)
         g_capture_ready = 1;
+    capture_ring_write(g_capture_ring, pcm16, sample_count);
+}
+
+/* ---- Session archive ---- */
+
+static void session_fail(void) {
+    log_event("SESS_ERR", "Session archive write failed, archive closed");
+    sess_writer_close(g_session);
+    g_session = NULL;
+}
+
+/* Close the previous session (writing its index) */
+static void session_end(void) {
+    if (!g_session) return;
+    if (sess_writer_close(g_session) != 0)
+        log_event("SESS_ERR", "Session archive close failed");
+    g_session = NULL;
+}
+
+/* Open recordings\session_<stamp>.vses alongside the recording */
+static void session_begin(const char *mode) {
+    session_end();
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "recordings\\session_%s.vses", g_rec_stamp);
+    g_session = sess_writer_open(path, WHISPER_SAMPLE_RATE);
+    if (!g_session) {
+        log_event("SESS_ERR", "Failed to create session archive");
+        return;
+    }
+    sess_write_event(g_session, "START", mode);
+}
+
+static void session_event(const char *tag, const char *detail) {
+    if (g_session && sess_write_event(g_session, tag, detail) != 0)
+        session_fail();
+}
+
+static void session_commit(long long from, long long to, const char *text) {
+    if (g_session && sess_write_commit(g_session, from, to, text) != 0)
+        session_fail();
+}
+
+/* Feed samples just stored at first to everything that follows the store */
+static void capture_pass_on(const int16_t *pcm, int first, int n) {
+    level_pyr_append(g_level_pyr, pcm, n);
+    vad_feed_s16(g_vad, pcm, n, &g_vad_speech_frames);
+    if (g_mel && !g_live_mode && mel_fe_push_s16(g_mel, pcm, n) < 0) {
+        log_event("MEL_ERR", "Feature front-end out of memory, uploading PCM");
+        mel_fe_destroy(g_mel);
+        g_mel = NULL;
+    }
+    if (g_session && sess_write_audio(g_session, first, pcm, n) != 0)
+        session_fail();
+}
 
-    float energy = 0.0f;
-    for (int i = 0; i < sample_count && g_audio_samples < MAX_AUDIO_SAMPLES; i++) {
-        float sample = pcm16[i] / 32768.0f;
-        g_audio_buffer[g_audio_write_pos] = sample;
-        g_audio_write_pos = (g_audio_write_pos + 1) % MAX_AUDIO_SAMPLES;
-        if (g_audio_samples < MAX_AUDIO_SAMPLES) {
-            g_audio_samples++;
+/* UI thread: move captured samples into the recording store. Whatever the
+ * store takes is passed on to the levels, VAD, features and session; if it
+ * cannot take the rest, that is held and the ring left alone until it can,
+ * so nothing downstream sees a gap the store does not have. */
+static void capture_drain(void) {
+    int16_t *chunk = g_capture_held;
+    for (;;) {
+        int n = g_capture_held_n ? g_capture_held_n
+                                 : capture_ring_read(g_capture_ring, chunk, 4096);
+        if (n <= 0) break;
+        int first = rec_store_count(g_rec_store);
+        int rc = rec_store_append(g_rec_store, chunk, n);
+        int stored = rec_store_count(g_rec_store) - first;
+        if (stored > 0)
+            capture_pass_on(chunk, first, stored);
+        if (rc == 0) {
+            g_capture_held_n = 0;
+            continue;
         }
-        /* Also save to full recording buffer (never cleared during recording) */
-        if (g_recording_samples < MAX_AUDIO_SAMPLES) {
-            g_recording_buffer[g_recording_samples++] = sample;
+        if (g_capture_held_n == 0) {
+            char buf[128];
+            snprintf(buf, sizeof(buf), "Recording store append failed, holding %d samples"
+                     " (the ring counts what it drops meanwhile)", n - stored);
+            log_event("AUDIO_ERR", buf);
+        }
+        g_capture_held_n = n - stored;
+        memmove(chunk, chunk + stored, g_capture_held_n * sizeof(int16_t));
+        break;
+    }
+    /* Queue new samples for the WAV writer (by reference, no copy) */
+    int total = rec_store_count(g_rec_store);
+    if (g_wav_writer && total > g_wav_queued) {
+        audio_view_t v = {0};
+        int got = rec_store_view(g_rec_store, g_wav_queued, total - g_wav_queued, &v);
+        if (got > 0 && wav_writer_append(g_wav_writer, &v) == 0) {
+            g_wav_queued += got;
+        } else {
+            log_event("WAV_ERR", "WAV writer failed, recording no longer saved");
+            wav_writer_close(g_wav_writer);
+            g_wav_writer = NULL;
         }
-        energy += fabsf(sample);
+        audio_view_release(&v);
     }
-
-    if (sample_count > 0) {
-        g_current_energy = energy / sample_count;
+    int64_t overruns = capture_ring_overruns(g_capture_ring);
+    if (overruns != g_capture_overruns_logged) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "Capture ring overrun: %lld samples dropped",
+                 (long long)(overruns - g_capture_overruns_logged));
+        log_event("AUDIO_ERR", buf);
+        g_capture_overruns_logged = overruns;
     }
+}
 
-    LeaveCriticalSection(&g_audio_lock);
+/* UI thread: mean |sample| since the previous call, from the ring's
+ * running total (no sample walk needed) */
+static float capture_energy_since_last(void) {
+    int64_t pos, sum;
+    capture_ring_energy(g_capture_ring, &pos, &sum);
+    int64_t n = pos - g_energy_prev_pos;
+    if (n <= 0) return g_current_energy;
+    float energy = (float)(sum - g_energy_prev_sum) / (float)n / 32768.0f;
+    g_energy_prev_pos = pos;
+    g_energy_prev_sum = sum;
+    return energy;
 }
 
-static int get_audio_samples(float *dest, int max_samples) {
-    EnterCriticalSection(&g_audio_lock);
-    int count = g_audio_samples < max_samples ? g_audio_samples : max_samples;
-    int start = (g_audio_write_pos - count + MAX_AUDIO_SAMPLES) % MAX_AUDIO_SAMPLES;
-    for (int i = 0; i < count; i++) {
-        dest[i] = g_audio_buffer[(start + i) % MAX_AUDIO_SAMPLES];
-    }
-    LeaveCriticalSection(&g_audio_lock);
-    return count;
+/* Samples in the current VAD block (since the last clear) */
+static int get_block_samples(void) {
+    return rec_store_count(g_rec_store) - g_vad_block_start;
 }
 
+/* Start a new VAD block at the current end of the recording */
 static void clear_audio_buffer(void) {
-    EnterCriticalSection(&g_audio_lock);
-    g_audio_write_pos = 0;
-    g_audio_samples = 0;
+    g_vad_block_start = rec_store_count(g_rec_store);
     g_current_energy = 0.0f;
-    LeaveCriticalSection(&g_audio_lock);
 }
 
 /* Forward declarations */
 static void update_scrollbar(void);
 
-/* Write audio buffer as WAV file for offline testing */
-static void write_wav(const float *samples, int n_samples) {
+/* Start streaming the recording to a timestamped WAV for offline testing */
+static void wav_recording_begin(void) {
     /* Create recordings directory next to executable */
     CreateDirectoryA("recordings", NULL);
 
     /* Generate filename with timestamp */
     time_t now = time(NULL);
     struct tm *tm_info = localtime(&now);
-    char filename[MAX_PATH];
-    snprintf(filename, sizeof(filename), "recordings\\recording_%04d%02d%02d_%02d%02d%02d.wav",
+    snprintf(g_rec_stamp, sizeof(g_rec_stamp), "%04d%02d%02d_%02d%02d%02d",
              tm_info->tm_year + 1900, tm_info->tm_mon + 1, tm_info->tm_mday,
              tm_info->tm_hour, tm_info->tm_min, tm_info->tm_sec);
+    snprintf(g_wav_path, sizeof(g_wav_path), "recordings\\recording_%s.wav", g_rec_stamp);
 
-    FILE *f = fopen(filename, "wb");
-    if (!f) {
+    g_wav_queued = 0;
+    g_wav_writer = wav_writer_open(g_wav_path, WHISPER_SAMPLE_RATE);
+    if (!g_wav_writer)
         log_event("WAV_ERR", "Failed to open WAV file for writing");
+}
+
+/* ---- Recording archive (WAV -> LAC) ---- */
+
+typedef struct {
+    char wav_path[MAX_PATH];
+} ArchiveArgs;
+
+/* Compress a finished recording to .lac next to it and delete the WAV once
+ * every block has been verified. Cancellation or any error keeps the WAV. */
+static void archive_recording_task(void *param, exec_cancel_t *cancel) {
+    ArchiveArgs *args = (ArchiveArgs *)param;
+    char lac_path[MAX_PATH];
+    strncpy(lac_path, args->wav_path, sizeof(lac_path) - 1);
+    lac_path[sizeof(lac_path) - 1] = '\0';
+    char *ext = strrchr(lac_path, '.');
+    if (ext) strcpy(ext, ".lac");
+
+    FILE *f = exec_cancelled(cancel) ? NULL : fopen(args->wav_path, "rb");
+    if (!f) {
+        free(args);
         return;
     }
+    /* wav_writer output: 44-byte header, 16-bit mono PCM */
+    unsigned char hdr[44];
+    int rate = 0;
+    if (fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr) && memcmp(hdr, "RIFF", 4) == 0
+        && *(uint16_t *)(hdr + 22) == 1 && *(uint16_t *)(hdr + 34) == 16)
+        rate = (int)*(uint32_t *)(hdr + 24);
+
+    lac_writer_t *w = rate > 0 ? lac_writer_open(lac_path, rate) : NULL;
+    long long wav_bytes = sizeof(hdr);
+    int ok = w != NULL;
+    int16_t buf[16384];
+    size_t got;
+    while (ok && (got = fread(buf, sizeof(int16_t), 16384, f)) > 0) {
+        wav_bytes += got * sizeof(int16_t);
+        if (exec_cancelled(cancel) || lac_writer_write(w, buf, (int)got) != 0)
+            ok = 0;
+    }
+    fclose(f);
+    long long lac_bytes = lac_writer_bytes(w);
+    if (w && lac_writer_close(w) < 0) ok = 0;
 
-    /* WAV header - 16-bit PCM, 16kHz, mono */
-    int32_t data_size = n_samples * 2;  /* 16-bit = 2 bytes per sample */
-    int32_t file_size = 36 + data_size;
-    int16_t audio_format = 1;       /* PCM */
-    int16_t num_channels = 1;       /* mono */
-    int32_t sample_rate = WHISPER_SAMPLE_RATE;
-    int32_t byte_rate = sample_rate * 2;
-    int16_t block_align = 2;
-    int16_t bits_per_sample = 16;
-
-    /* RIFF header */
-    fwrite("RIFF", 1, 4, f);
-    fwrite(&file_size, 4, 1, f);
-    fwrite("WAVE", 1, 4, f);
-
-    /* fmt chunk */
-    fwrite("fmt ", 1, 4, f);
-    int32_t fmt_size = 16;
-    fwrite(&fmt_size, 4, 1, f);
-    fwrite(&audio_format, 2, 1, f);
-    fwrite(&num_channels, 2, 1, f);
-    fwrite(&sample_rate, 4, 1, f);
-    fwrite(&byte_rate, 4, 1, f);
-    fwrite(&block_align, 2, 1, f);
-    fwrite(&bits_per_sample, 2, 1, f);
-
-    /* data chunk */
-    fwrite("data", 1, 4, f);
-    fwrite(&data_size, 4, 1, f);
-
-    /* Convert float samples to int16 and write */
-    for (int i = 0; i < n_samples; i++) {
-        float s = samples[i];
-        if (s > 1.0f) s = 1.0f;
-        if (s < -1.0f) s = -1.0f;
-        int16_t pcm = (int16_t)(s * 32767.0f);
-        fwrite(&pcm, 2, 1, f);
+    char msg[MAX_PATH + 96];
+    if (ok) {
+        DeleteFileA(args->wav_path);
+        snprintf(msg, sizeof(msg), "%s (%.1f MB -> %.1f MB, %.0f%%)", lac_path,
+                 wav_bytes / 1048576.0, lac_bytes / 1048576.0,
+                 wav_bytes > 0 ? lac_bytes * 100.0 / wav_bytes : 0.0);
+        log_event("ARCHIVE", msg);
+    } else {
+        if (w) DeleteFileA(lac_path);
+        snprintf(msg, sizeof(msg), "Kept %s (compression %s)", args->wav_path,
+                 exec_cancelled(cancel) ? "cancelled" : "failed");
+        log_event("ARCHIVE", msg);
     }
+    free(args);
+}
 
-    fclose(f);
+/* Flush the tail queued by the last drain and finalize the header.
+ * archive=1 queues background compression of the saved file. */
+static void wav_recording_end(int archive) {
+    if (!g_wav_writer) return;
+    long long n = wav_writer_close(g_wav_writer);
+    g_wav_writer = NULL;
+    if (n < 0) {
+        log_event("WAV_ERR", "WAV write failed, file may be truncated");
+    } else if (n == 0) {
+        DeleteFileA(g_wav_path);  /* nothing was recorded */
+    } else {
+        char msg[MAX_PATH + 32];
+        snprintf(msg, sizeof(msg), "Saved %s (%lld samples, %.1fs)", g_wav_path, n,
+                 (float)n / WHISPER_SAMPLE_RATE);
+        log_event("WAV_SAVE", msg);
 
-    char msg[MAX_PATH + 32];
-    snprintf(msg, sizeof(msg), "Saved %s (%d samples, %.1fs)", filename, n_samples,
-             (float)n_samples / WHISPER_SAMPLE_RATE);
-    log_event("WAV_SAVE", msg);
+        ArchiveArgs *args = archive ? (ArchiveArgs *)calloc(1, sizeof(ArchiveArgs)) : NULL;
+        if (args) {
+            strncpy(args->wav_path, g_wav_path, sizeof(args->wav_path) - 1);
+            if (executor_submit(g_executor, EXEC_LANE_PREFETCH, archive_recording_task,
+                                args, NULL, NULL) != 0)
+                free(args);
+        }
+    }
 }
 
-/* Helper: convert bar index to time and vice versa */
+/* Helper: convert bar index to time and vice versa (at the current zoom) */
 static float bar_to_time(int bar) {
-    return (float)bar * WAVEFORM_UPDATE_MS / 1000.0f;
+    return (float)bar * g_bar_samples / WHISPER_SAMPLE_RATE;
 }
 
 static int time_to_bar(float time_sec) {
-    return (int)(time_sec * 1000.0f / WAVEFORM_UPDATE_MS);
+    return (int)(time_sec * WHISPER_SAMPLE_RATE / g_bar_samples);
+}
+
+/* Bars needed to show the whole recording at the current zoom */
+static void update_bar_count(void) {
+    int64_t n = level_pyr_count(g_level_pyr);
+    g_stored_bar_count = (int)((n + g_bar_samples - 1) / g_bar_samples);
+}
+
+/* Bar levels for bars [first, first+WAVEFORM_BARS) from the pyramid.
+ * Bars before the start of the recording are left at zero. */
+static void query_bar_levels(int first, float *levels) {
+    level_px_t px[WAVEFORM_BARS];
+    int lead = first < 0 ? -first : 0;
+    if (lead > WAVEFORM_BARS) lead = WAVEFORM_BARS;
+    memset(px, 0, sizeof(px));
+    if (lead < WAVEFORM_BARS) {
+        int64_t start = (int64_t)(first + lead) * g_bar_samples;
+        int64_t end = (int64_t)(first + WAVEFORM_BARS) * g_bar_samples;
+        level_pyr_query(g_level_pyr, start, end, WAVEFORM_BARS - lead, px + lead);
+    }
+    for (int i = 0; i < WAVEFORM_BARS; i++) {
+        /* Same scale as the old mean-abs bars (RMS ~ 1.25x mean |x|) */
+        float level = px[i].rms * 12.0f;
+        levels[i] = level > 1.0f ? 1.0f : level;
+    }
+}
+
+/* Ctrl+wheel: halve/double samples per bar, keeping the view centre fixed */
+static void zoom_waveform(int zoom_in) {
+    int new_samples = zoom_in ? g_bar_samples / 2 : g_bar_samples * 2;
+    if (new_samples < LEVEL_PYR_BASE) new_samples = LEVEL_PYR_BASE;
+    if (new_samples > SAMPLES_PER_BAR * 1024) new_samples = SAMPLES_PER_BAR * 1024;
+    if (new_samples == g_bar_samples) return;
+
+    int64_t centre = ((int64_t)g_scroll_offset + WAVEFORM_BARS / 2) * g_bar_samples;
+    g_bar_samples = new_samples;
+    update_bar_count();
+
+    int max_offset = g_stored_bar_count - WAVEFORM_BARS;
+    if (max_offset < 0) max_offset = 0;
+    int offset = (int)(centre / g_bar_samples) - WAVEFORM_BARS / 2;
+    if (offset < 0) offset = 0;
+    if (offset > max_offset) offset = max_offset;
+    g_scroll_offset = offset;
+    if (g_marker_time >= 0) g_marker_bar = time_to_bar(g_marker_time);
+
+    update_scrollbar();
+    InvalidateRect(g_hwnd_waveform, NULL, FALSE);
+    InvalidateRect(g_hwnd_stats, NULL, FALSE);
 }
 
 /* Helper: convert x position to bar index (in stopped mode) */
@@ -2435,21 +3527,13 @@ static LRESULT CALLBACK WaveformWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
             int bar_gap = 2;
             int max_bar_height = height - 16;
 
-            /* Draw all bars - use stored data when stopped, live data when recording */
+            /* Draw all bars - the newest bars while recording, the scrolled
+             * window when stopped */
+            float levels[WAVEFORM_BARS];
+            query_bar_levels(g_is_recording ? g_stored_bar_count - WAVEFORM_BARS
+                                            : g_scroll_offset, levels);
             for (int i = 0; i < WAVEFORM_BARS; i++) {
-                float level;
-                if (!g_is_recording && g_stored_bar_count > 0) {
-                    /* Stopped mode: show stored waveform at scroll offset */
-                    int stored_idx = g_scroll_offset + i;
-                    if (stored_idx >= 0 && stored_idx < g_stored_bar_count) {
-                        level = g_stored_levels[stored_idx];
-                    } else {
-                        level = 0.0f;
-                    }
-                } else {
-                    /* Recording mode: show live data */
-                    level = g_waveform_levels[i];
-                }
+                float level = levels[i];
 
                 int bar_height;
                 if (g_is_recording && !g_capture_ready) {
@@ -2594,7 +3678,10 @@ static LRESULT CALLBACK WaveformWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
             return 0;
 
         case WM_MOUSEWHEEL:
-            if (!g_is_recording && g_stored_bar_count > WAVEFORM_BARS) {
+            if (!g_is_recording && g_stored_bar_count > 0
+                && (GET_KEYSTATE_WPARAM(wParam) & MK_CONTROL)) {
+                zoom_waveform(GET_WHEEL_DELTA_WPARAM(wParam) > 0);
+            } else if (!g_is_recording && g_stored_bar_count > WAVEFORM_BARS) {
                 int delta = GET_WHEEL_DELTA_WPARAM(wParam);
                 int scroll_amount = (delta > 0) ? -5 : 5;  /* Scroll 5 bars at a time */
                 int new_offset = g_scroll_offset + scroll_amount;
@@ -2821,7 +3908,7 @@ static LRESULT CALLBACK StatsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
                 SelectObject(hdc, g_font_normal);
                 DrawTextA(hdc, "STATUS", -1, &r2, DT_CENTER);
 
-                int is_speaking = g_current_energy >= SILENCE_THRESHOLD;
+                int is_speaking = vad_active(g_vad);
                 RECT r2v = { col_width, value_top, col_width * 2, h - 2 };
                 SetTextColor(hdc, is_speaking ? COLOR_WAVE_LOW : COLOR_SILENCE);
                 SelectObject(hdc, g_font_medium);
@@ -2845,7 +3932,7 @@ static LRESULT CALLBACK StatsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
                 SelectObject(hdc, g_font_normal);
                 DrawTextA(hdc, "TOTAL", -1, &r1, DT_CENTER);
 
-                float total_time = bar_to_time(g_stored_bar_count);
+                float total_time = (float)level_pyr_count(g_level_pyr) / WHISPER_SAMPLE_RATE;
                 snprintf(buf, sizeof(buf), "%.1fs", total_time);
                 RECT r1v = { 0, value_top, col_width, h - 2 };
                 SetTextColor(hdc, COLOR_ACCENT);
@@ -2988,24 +4075,31 @@ static LRESULT CALLBACK StatsWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
             {
                 int locked_seed = g_tts_voice_seeds[g_tts_voice_idx];
                 LONG last_seed = InterlockedCompareExchange(&g_tts_last_seed, 0, 0);
+                LONG speed_pct = InterlockedCompareExchange(&g_tts_speed_pct, 0, 0);
+                char speed_buf[16] = "";
+                if (speed_pct != 100)
+                    snprintf(speed_buf, sizeof(speed_buf), " %.1fx", speed_pct / 100.0);
                 if (locked_seed >= 0) {
                     /* Locked seed: green */
                     char voice_buf[48];
-                    snprintf(voice_buf, sizeof(voice_buf), "%s #%d",
-                             g_tts_voices[g_tts_voice_idx], locked_seed);
+                    snprintf(voice_buf, sizeof(voice_buf), "%s #%d%s",
+                             tts_voices[g_tts_voice_idx], locked_seed, speed_buf);
                     SetTextColor(hdc, COLOR_WAVE_LOW);
                     DrawTextA(hdc, voice_buf, -1, &r8v, DT_CENTER);
                 } else if (g_drill_mode && last_seed >= 0) {
                     /* Auditioning: yellow */
                     char voice_buf[48];
-                    snprintf(voice_buf, sizeof(voice_buf), "%s ?%ld",
-                             g_tts_voices[g_tts_voice_idx], last_seed);
+                    snprintf(voice_buf, sizeof(voice_buf), "%s ?%ld%s",
+                             tts_voices[g_tts_voice_idx], last_seed, speed_buf);
                     SetTextColor(hdc, COLOR_WAVE_MED);
                     DrawTextA(hdc, voice_buf, -1, &r8v, DT_CENTER);
                 } else {
                     /* No seed: blue */
+                    char voice_buf[48];
+                    snprintf(voice_buf, sizeof(voice_buf), "%s%s",
+                             tts_voices[g_tts_voice_idx], speed_buf);
                     SetTextColor(hdc, COLOR_ACCENT);
-                    DrawTextA(hdc, g_tts_voices[g_tts_voice_idx], -1, &r8v, DT_CENTER);
+                    DrawTextA(hdc, voice_buf, -1, &r8v, DT_CENTER);
                 }
             }
 
@@ -3246,24 +4340,11 @@ static LRESULT CALLBACK SysInfoWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARA
 
 /* Update waveform visualization */
 static void update_waveform(void) {
-    /* Shift live bars left */
-    for (int i = 0; i < WAVEFORM_BARS - 1; i++) {
-        g_waveform_levels[i] = g_waveform_levels[i + 1];
-    }
-
-    EnterCriticalSection(&g_audio_lock);
-    float energy = g_current_energy;
-    LeaveCriticalSection(&g_audio_lock);
-
-    /* Scale energy (log-ish for better visualization) */
-    float level = energy * 15.0f;
-    if (level > 1.0f) level = 1.0f;
-    g_waveform_levels[WAVEFORM_BARS - 1] = level;
-
-    /* Store this level in the full recording buffer */
-    if (g_stored_bar_count < MAX_STORED_BARS) {
-        g_stored_levels[g_stored_bar_count++] = level;
-    }
+    /* Bars come from the samples themselves, so timer jitter no longer
+     * affects them; the drain just extends the pyramid */
+    capture_drain();
+    g_current_energy = capture_energy_since_last();
+    update_bar_count();
 
     /* Redraw waveform and processing visualizer */
     InvalidateRect(g_hwnd_waveform, NULL, FALSE);
@@ -3430,10 +4511,19 @@ static int g_vad_silence_chunks = 0;    /* Consecutive silence chunks after spee
 #define VAD_SILENCE_TO_TRANSCRIBE 2     /* Silence chunks needed to trigger transcription */
 #define VAD_MIN_SPEECH_SAMPLES (WHISPER_SAMPLE_RATE * 1)  /* Minimum 1 second of audio */
 
+/* Pre-upload silence trimming. Guard keeps word onsets/offsets intact;
+ * long pauses keep enough silence for the model to place a sentence break. */
+#define TRIM_GUARD_MS      300
+#define TRIM_MAX_PAUSE_MS  800
+static const trim_opts_t g_trim_opts = { SILENCE_THRESHOLD, TRIM_GUARD_MS, TRIM_MAX_PAUSE_MS };
+
 /* Work item for transcription thread */
 typedef struct {
-    float *samples;   /* heap copy, worker frees */
-    int n_samples;
+    audio_view_t view;  /* refs into the recording store, worker releases */
+    unsigned char *feat;  /* LMEL block instead of view (--mel-upload), worker frees */
+    size_t feat_size;
+    unsigned char *blocks;  /* PBLK body (--block-upload), view kept for fallback */
+    size_t blocks_size;
     int is_final;     /* 1 = recording stopped, 0 = periodic update */
 } asr_work_t;
 
@@ -3449,10 +4539,12 @@ static char g_token_buf[16384];
 static int g_token_buf_len = 0;
 static int g_token_chat_anchor = -1;  /* chat_len before first token */
 
-/* Token callback: runs on worker thread, posts to UI thread */
+/* Token callback: runs on worker thread, posts to UI thread.
+ * userdata is the pass's trim map (audio_ms is relative to trimmed audio). */
 static void asr_stream_token_cb(const char *piece, int audio_ms,
                                  int byte_offset, void *userdata) {
-    (void)userdata;
+    const trim_map_t *map = (const trim_map_t *)userdata;
+    if (map) audio_ms = trim_map_ms(map, audio_ms, WHISPER_SAMPLE_RATE);
     AsrTokenMsg *msg = (AsrTokenMsg *)malloc(sizeof(AsrTokenMsg));
     if (!msg) return;
     strncpy(msg->text, piece, sizeof(msg->text) - 1);
@@ -3462,22 +4554,109 @@ static void asr_stream_token_cb(const char *piece, int audio_ms,
     PostMessageA(g_hwnd_main, WM_ASR_TOKEN, 0, (LPARAM)msg);
 }
 
-static DWORD WINAPI asr_transcribe_thread(LPVOID param) {
+static void asr_transcribe_task(void *param, exec_cancel_t *cancel) {
     asr_work_t *work = (asr_work_t *)param;
     int is_final = work->is_final;
+    if (exec_cancelled(cancel)) {
+        if (work->blocks) blk_finish(g_blk, 0);
+        audio_view_release(&work->view);
+        free(work->feat);
+        free(work->blocks);
+        free(work);
+        return;
+    }
+
+    /* Features were computed as audio arrived and are sent as they are;
+     * trimming only applies to PCM uploads */
+    if (work->feat) {
+        AsrResult *result = asr_transcribe_stream_mel(work->feat, work->feat_size,
+                                                      g_asr_port, g_asr_language,
+                                                      g_asr_prompt, is_final,
+                                                      asr_stream_token_cb, NULL);
+        free(work->feat);
+        free(work);
+        if (!result)
+            log_event("ASR", "HTTP request failed (server not running?)");
+        PostMessageA(g_hwnd_main, WM_TRANSCRIBE_DONE, (WPARAM)is_final, (LPARAM)result);
+        return;
+    }
+
+    /* Blocks go untrimmed (trimming would change their content). A 409
+     * means the server dropped its cache, so resend everything from here;
+     * any other rejection means it takes no blocks, so stop sending them */
+    if (work->blocks) {
+        int rejected = 0;
+        AsrResult *result = asr_transcribe_stream_blocks(work->blocks, work->blocks_size,
+                                                         g_asr_port, g_asr_language,
+                                                         g_asr_prompt, is_final,
+                                                         asr_stream_token_cb, NULL, &rejected);
+        blk_finish(g_blk, result != NULL);
+        free(work->blocks);
+        work->blocks = NULL;
+        if (result || !rejected) {
+            audio_view_release(&work->view);
+            free(work);
+            if (!result)
+                log_event("ASR", "HTTP request failed (server not running?)");
+            PostMessageA(g_hwnd_main, WM_TRANSCRIBE_DONE, (WPARAM)is_final, (LPARAM)result);
+            return;
+        }
+        if (rejected == 409) {
+            log_event("BLOCKS", "Server block cache miss, uploading the full window");
+        } else if (InterlockedExchange(&g_blk_rejected, 1) == 0) {
+            char buf[96];
+            snprintf(buf, sizeof(buf),
+                     "Server rejected block upload (HTTP %d), sending full windows", rejected);
+            log_event("BLOCKS", buf);
+        }
+        blk_uploader_reset(g_blk);
+    }
+
+    /* Cut silence beyond the guard so the server encodes less audio */
+    trim_map_t map;
+    audio_view_t upload = {0};
+    const audio_view_t *send = &work->view;
+    if (trim_plan_view(&work->view, WHISPER_SAMPLE_RATE, &g_trim_opts, &map) == 0) {
+        if (map.n_dst < map.n_src && map.n_dst > 0
+            && trim_apply_view(&work->view, &map, &upload) == map.n_dst) {
+            send = &upload;
+            double saved = (double)(map.n_src - map.n_dst) / WHISPER_SAMPLE_RATE;
+            g_trim_saved_sec += saved;
+            char buf[128];
+            snprintf(buf, sizeof(buf), "kept %.1fs of %.1fs (%d segs, saved %.1fs, total %.1fs)",
+                     (double)map.n_dst / WHISPER_SAMPLE_RATE,
+                     (double)map.n_src / WHISPER_SAMPLE_RATE,
+                     map.n_segs, saved, g_trim_saved_sec);
+            log_event("TRIM", buf);
+        } else {
+            trim_map_free(&map);
+        }
+    } else {
+        memset(&map, 0, sizeof(map));
+    }
 
-    AsrResult *result = asr_transcribe_stream(work->samples, work->n_samples,
-                                               g_asr_port, g_asr_language,
-                                               g_asr_prompt, is_final,
-                                               asr_stream_token_cb, NULL);
-    free(work->samples);
+    AsrResult *result = asr_transcribe_stream_view(send,
+                                                    g_asr_port, g_asr_language,
+                                                    g_asr_prompt, is_final,
+                                                    asr_stream_token_cb,
+                                                    map.n_segs ? &map : NULL);
+    audio_view_release(&upload);
+    audio_view_release(&work->view);
     free(work);
 
+    /* Timestamps drive window advancement, so put them back on the
+     * untrimmed timeline */
+    if (result && map.n_segs) {
+        for (int t = 0; t < result->ts_count; t++)
+            result->timestamps[t].audio_ms = trim_map_ms(&map,
+                result->timestamps[t].audio_ms, WHISPER_SAMPLE_RATE);
+    }
+    trim_map_free(&map);
+
     if (!result)
         log_event("ASR", "HTTP request failed (server not running?)");
 
     PostMessageA(g_hwnd_main, WM_TRANSCRIBE_DONE, (WPARAM)is_final, (LPARAM)result);
-    return 0;
 }
 
 /* Async retranscription for ASR server with sentence stability + sliding window. */
@@ -3491,6 +4670,12 @@ static int g_prev_result_len = 0;
 static int g_stable_len = 0;
 static int g_common0_unconfirmed = 0;
 
+/* Request side of the pass in flight, for the session archive */
+static sess_pass_t g_pass_req;
+static char g_pass_prompt[sizeof(g_asr_prompt)];
+static ULONGLONG g_pass_kick_tick = 0;
+static int g_pass_pending = 0;
+
 #define RETRANSCRIBE_INTERVAL_SAMPLES (WHISPER_SAMPLE_RATE * 3)
 #define RETRANSCRIBE_MIN_SAMPLES      (WHISPER_SAMPLE_RATE * 1)
 
@@ -3503,7 +4688,8 @@ static void asr_kick_retranscribe(int is_final) {
     }
     g_want_final = 0;
 
-    int total = g_recording_samples;
+    capture_drain();
+    int total = rec_store_count(g_rec_store);
     int start = g_committed_samples;
     int n_samples = total - start;
     if (n_samples < RETRANSCRIBE_MIN_SAMPLES) {
@@ -3521,40 +4707,79 @@ static void asr_kick_retranscribe(int is_final) {
         return;
     }
 
-    float *copy = (float *)malloc(n_samples * sizeof(float));
-    if (!copy) return;
-    memcpy(copy, g_recording_buffer + start, n_samples * sizeof(float));
-
-    asr_work_t *work = (asr_work_t *)malloc(sizeof(asr_work_t));
-    if (!work) { free(copy); return; }
-    work->samples = copy;
-    work->n_samples = n_samples;
+    asr_work_t *work = (asr_work_t *)calloc(1, sizeof(asr_work_t));
+    if (!work) return;
+    if (g_mel) {
+        /* Window start rounds up to the next frame (at most 10 ms) */
+        int first = mel_frame_at(start);
+        mel_fe_discard_before(g_mel, first);
+        work->feat = mel_fe_serialize(g_mel, first, mel_fe_frames(g_mel) - first,
+                                      &work->feat_size);
+        if (work->feat) {
+            char buf[128];
+            snprintf(buf, sizeof(buf), "%d frames, %.1f KB (PCM %.1f KB)",
+                     mel_fe_frames(g_mel) - first, work->feat_size / 1024.0,
+                     (44.0 + 2.0 * n_samples) / 1024.0);
+            log_event("MEL", buf);
+        }
+    }
+    if (!work->feat) {
+        n_samples = rec_store_view(g_rec_store, start, n_samples, &work->view);
+        if (n_samples <= 0) { free(work); return; }
+    }
+    if (!work->feat && g_blk && !g_blk_rejected) {
+        /* Blocks align to the recording start, so the view begins at the
+         * block holding the window start */
+        int base = (int)blk_align_down(start);
+        audio_view_t bv = {0};
+        int carried = 0;
+        if (rec_store_view(g_rec_store, base, start + n_samples - base, &bv) > 0)
+            work->blocks = blk_build(g_blk, &bv, start, n_samples,
+                                     &work->blocks_size, &carried);
+        audio_view_release(&bv);
+        if (work->blocks) {
+            char buf[128];
+            snprintf(buf, sizeof(buf), "sending %.2fs of %.2fs window, %.1f KB",
+                     (double)carried / WHISPER_SAMPLE_RATE,
+                     (double)n_samples / WHISPER_SAMPLE_RATE, work->blocks_size / 1024.0);
+            log_event("BLOCKS", buf);
+        }
+    }
     work->is_final = is_final;
 
     g_window_samples = n_samples;
     g_last_transcribe_samples = total;
     g_transcribing = 1;
-    if (g_transcribe_thread) {
-        CloseHandle(g_transcribe_thread);
-        g_transcribe_thread = NULL;
-    }
-    HANDLE ht = CreateThread(NULL, 0, asr_transcribe_thread, work, 0, NULL);
-    if (ht) {
-        g_transcribe_thread = ht;
-    } else {
-        free(work->samples);
+    if (g_transcribe_task) {
+        exec_task_release(g_transcribe_task);
+        g_transcribe_task = NULL;
+    }
+    if (executor_submit(g_executor, EXEC_LANE_INTERACTIVE, asr_transcribe_task,
+                        work, NULL, &g_transcribe_task) != 0) {
+        if (work->blocks) blk_finish(g_blk, 0);
+        audio_view_release(&work->view);
+        free(work->feat);
+        free(work->blocks);
         free(work);
         g_transcribing = 0;
+        return;
     }
+    memset(&g_pass_req, 0, sizeof(g_pass_req));
+    g_pass_req.window_start = start;
+    g_pass_req.window_samples = n_samples;
+    g_pass_req.is_final = is_final;
+    g_pass_req.pass_no = g_pass_count + 1;
+    strncpy(g_pass_prompt, g_asr_prompt, sizeof(g_pass_prompt) - 1);
+    g_pass_req.prompt = g_pass_prompt;
+    g_pass_kick_tick = GetTickCount64();
+    g_pass_pending = 1;
 }
 
 /* (qwen-asr direct path removed -- transcription via HTTP to local-ai-server) */
 
 /* Transcribe the current audio block (called when VAD detects end of speech) */
 static void transcribe_block(void) {
-    static float pcmf32[MAX_AUDIO_SAMPLES];
-
-    int n_samples = get_audio_samples(pcmf32, MAX_AUDIO_SAMPLES);
+    int n_samples = get_block_samples();
     if (n_samples < VAD_MIN_SPEECH_SAMPLES) {
         log_event("SKIP", "Block too short, skipping transcription");
         return;
@@ -3606,15 +4831,15 @@ static void handle_transcribe_result(char *text) {
 
 /* Check VAD state and trigger transcription when speech ends */
 static void check_vad_and_transcribe(void) {
-    EnterCriticalSection(&g_audio_lock);
+    capture_drain();
     float energy = g_current_energy;
-    int n_samples = g_audio_samples;
-    LeaveCriticalSection(&g_audio_lock);
+    int n_samples = get_block_samples();
 
     g_audio_seconds = (float)n_samples / WHISPER_SAMPLE_RATE;
 
     char buf[128];
-    int is_speech = energy >= SILENCE_THRESHOLD;
+    int is_speech = vad_active(g_vad) || g_vad_speech_frames > 0;
+    g_vad_speech_frames = 0;
 
     if (is_speech) {
         /* Speech detected */
@@ -3627,9 +4852,11 @@ static void check_vad_and_transcribe(void) {
     } else {
         /* Silence detected */
         if (g_vad_speech_started) {
+            vad_info_t vi;
+            vad_info(g_vad, &vi);
             g_vad_silence_chunks++;
-            snprintf(buf, sizeof(buf), "Silence %d/%d (energy=%.3f, samples=%d)",
-                     g_vad_silence_chunks, VAD_SILENCE_TO_TRANSCRIBE, energy, n_samples);
+            snprintf(buf, sizeof(buf), "Silence %d/%d (energy=%.3f, snr=%.1fdB, samples=%d)",
+                     g_vad_silence_chunks, VAD_SILENCE_TO_TRANSCRIBE, energy, vi.snr_db, n_samples);
             log_event("VAD", buf);
 
             /* Enough silence after speech - transcribe this block */
@@ -3661,7 +4888,7 @@ static void check_vad_and_transcribe(void) {
     InvalidateRect(g_hwnd_stats, NULL, FALSE);
 }
 
-/* Background thread for live session start — posts result via WM_LIVE_STARTED */
+/* Background task for live session start — posts result via WM_LIVE_STARTED */
 typedef struct {
     int port;
     char language[64];
@@ -3669,33 +4896,34 @@ typedef struct {
     void *userdata;
 } LiveStartArgs;
 
-static DWORD WINAPI live_start_thread(LPVOID param) {
+static void live_start_task(void *param, exec_cancel_t *cancel) {
     LiveStartArgs *args = (LiveStartArgs *)param;
-    asr_live_session_t *session = asr_live_start(args->port, args->language,
-                                                  args->token_cb, args->userdata);
+    asr_live_session_t *session = NULL;
+    if (!exec_cancelled(cancel))
+        session = asr_live_start(args->port, args->language,
+                                 args->token_cb, args->userdata);
     free(args);
     PostMessageA(g_hwnd_main, WM_LIVE_STARTED, 0, (LPARAM)session);
-    return 0;
 }
 
-/* Background thread for live stop — flushes remaining audio, then stops */
+/* Background task for live stop — flushes remaining audio, then stops.
+ * Always runs to completion so the session is closed even at shutdown. */
 typedef struct {
     asr_live_session_t *session;
-    float *flush_buf;
-    int flush_samples;
+    audio_view_t flush;  /* unsent tail, released after sending */
 } LiveStopArgs;
 
-static DWORD WINAPI live_stop_thread(LPVOID param) {
+static void live_stop_task(void *param, exec_cancel_t *cancel) {
     LiveStopArgs *args = (LiveStopArgs *)param;
+    (void)cancel;
     /* Send any remaining audio */
-    if (args->flush_buf && args->flush_samples > 0) {
-        asr_live_send_audio(args->session, args->flush_buf, args->flush_samples);
-        free(args->flush_buf);
+    if (args->flush.n_samples > 0) {
+        asr_live_send_view(args->session, &args->flush);
+        audio_view_release(&args->flush);
     }
     AsrResult *result = asr_live_stop(args->session);
     free(args);
     PostMessageA(g_hwnd_main, WM_TRANSCRIBE_DONE, (WPARAM)1, (LPARAM)result);
-    return 0;
 }
 
 /* Start/stop recording */
@@ -3715,9 +4943,13 @@ static void start_recording(void) {
     g_had_speech = 0;
     g_pending_stop = 0;
     g_audio_seconds = 0.0f;
-    memset(g_waveform_levels, 0, sizeof(g_waveform_levels));
-
     /* Reset stored data for new recording */
+    level_pyr_reset(g_level_pyr);
+    vad_reset(g_vad);
+    g_vad_speech_frames = 0;
+    mel_fe_reset(g_mel);
+    blk_uploader_reset(g_blk);
+    g_bar_samples = SAMPLES_PER_BAR;
     g_stored_bar_count = 0;
     g_scroll_offset = 0;
     g_marker_time = -1.0f;
@@ -3731,14 +4963,13 @@ static void start_recording(void) {
     g_committed_samples = 0;
     g_window_samples = 0;
     g_want_final = 0;
-    /* Wait for any in-flight transcription thread to finish */
-    if (g_transcribe_thread) {
-        log_event("START", "Waiting for transcribe thread...");
-        DWORD wr = WaitForSingleObject(g_transcribe_thread, 3000);
-        if (wr == WAIT_TIMEOUT)
-            log_event("START", "WARNING: transcribe thread timed out (3s)");
-        CloseHandle(g_transcribe_thread);
-        g_transcribe_thread = NULL;
+    /* Wait for any in-flight transcription pass to finish */
+    if (g_transcribe_task) {
+        log_event("START", "Waiting for transcribe pass...");
+        if (exec_task_wait(g_transcribe_task, 3000) != 0)
+            log_event("START", "WARNING: transcribe pass timed out (3s)");
+        exec_task_release(g_transcribe_task);
+        g_transcribe_task = NULL;
     }
     /* Drain any pending WM_ASR_TOKEN and WM_TRANSCRIBE_DONE */
     {
@@ -3766,6 +4997,7 @@ static void start_recording(void) {
     g_pass_count = 0;
     g_last_transcribe_ms = 0;
     g_last_audio_window_sec = 0;
+    g_trim_saved_sec = 0;
     g_last_rtf = 0;
     g_last_encode_ms = 0;
     g_last_decode_ms = 0;
@@ -3776,7 +5008,13 @@ static void start_recording(void) {
     g_cpu_prev_kernel = 0;
     g_cpu_prev_user = 0;
     g_cpu_prev_time = 0;
-    g_recording_samples = 0;  /* Clear full recording buffer */
+    rec_store_reset(g_rec_store);  /* Clear full recording */
+    capture_ring_reset(g_capture_ring);
+    g_vad_block_start = 0;
+    g_energy_prev_pos = 0;
+    g_energy_prev_sum = 0;
+    g_capture_overruns_logged = 0;
+    g_capture_held_n = 0;
     g_capture_ready = 0;      /* Will be set once first audio samples arrive */
     g_vad_speech_started = 0;
     g_vad_silence_chunks = 0;
@@ -3798,6 +5036,8 @@ static void start_recording(void) {
 
     if (g_capture_thread) {
         g_is_recording = 1;
+        wav_recording_begin();
+        session_begin(g_drill_mode ? "drill" : g_live_mode ? "live" : "retranscribe");
         SetWindowTextA(g_hwnd_btn, "Stop");
         SetWindowTextA(g_hwnd_lbl_audio, g_live_mode ? "Audio Input (LIVE):" : "Audio Input:");
         chat_append("---", g_live_mode ? "Live streaming ASR [G to toggle]"
@@ -3822,14 +5062,13 @@ static void start_recording(void) {
                 if (g_asr_language && g_asr_language[0])
                     strncpy(args->language, g_asr_language, sizeof(args->language) - 1);
                 args->token_cb = asr_stream_token_cb;
-                log_event("START", "Spawning live_start_thread...");
-                HANDLE ht = CreateThread(NULL, 0, live_start_thread, args, 0, NULL);
-                if (ht) {
-                    CloseHandle(ht);
+                log_event("START", "Queueing live_start_task...");
+                if (executor_submit(g_executor, EXEC_LANE_INTERACTIVE, live_start_task,
+                                    args, NULL, NULL) == 0) {
                     log_event("LIVE", "Starting session (async)...");
                 } else {
                     free(args);
-                    log_event("LIVE", "Failed to spawn start thread");
+                    log_event("LIVE", "Failed to queue start task");
                 }
             }
         }
@@ -3866,30 +5105,31 @@ static void stop_recording(void) {
         CloseHandle(g_capture_thread);
         g_capture_thread = NULL;
     }
+    capture_drain();
 
     if (g_live_mode && g_live_session) {
         /* Flush remaining audio + stop — all on background thread */
-        int delta = g_recording_samples - g_live_last_sent;
+        int total = rec_store_count(g_rec_store);
+        int delta = total - g_live_last_sent;
         {
             char lb[128];
             snprintf(lb, sizeof(lb), "Flush: %d remaining samples (total %d, sent %d)",
-                     delta, g_recording_samples, g_live_last_sent);
+                     delta, total, g_live_last_sent);
             log_event("LIVE", lb);
         }
         LiveStopArgs *args = (LiveStopArgs *)calloc(1, sizeof(LiveStopArgs));
         if (args) {
             args->session = g_live_session;
             if (delta > 0) {
-                args->flush_buf = (float *)malloc(delta * sizeof(float));
-                if (args->flush_buf) {
-                    memcpy(args->flush_buf, g_recording_buffer + g_live_last_sent,
-                           delta * sizeof(float));
-                    args->flush_samples = delta;
-                }
+                rec_store_view(g_rec_store, g_live_last_sent, delta, &args->flush);
             }
             log_event("LIVE", "Stopping session (async)...");
-            HANDLE ht = CreateThread(NULL, 0, live_stop_thread, args, 0, NULL);
-            if (ht) CloseHandle(ht);
+            if (executor_submit(g_executor, EXEC_LANE_INTERACTIVE, live_stop_task,
+                                args, NULL, NULL) != 0) {
+                log_event("LIVE", "Failed to queue stop task");
+                audio_view_release(&args->flush);
+                free(args);
+            }
         }
         g_live_session = NULL;
     } else if (g_live_mode && !g_live_session) {
@@ -3898,15 +5138,15 @@ static void stop_recording(void) {
         log_event("LIVE", "Stop before session connected — will clean up on arrival");
     }
     /* Final retranscription of all recorded audio (retranscribe mode only) */
-    else if (g_recording_samples >= RETRANSCRIBE_MIN_SAMPLES) {
+    else if (rec_store_count(g_rec_store) >= RETRANSCRIBE_MIN_SAMPLES) {
         log_event("STOP", "Final retranscription of all audio");
         asr_kick_retranscribe(1);
     }
 
-    /* Save full recording as WAV for offline testing */
-    if (g_recording_samples > 0) {
-        write_wav(g_recording_buffer, g_recording_samples);
-    }
+    /* The WAV has been written during recording; just finalize it */
+    wav_recording_end(1);
+    /* The session stays open for the final pass; the next recording closes it */
+    session_event("STOP", NULL);
 
     /* Signal end of recording session to pipe client (not needed in LLM mode) */
     if (g_llm_mode == LLM_MODE_CLAUDE) {
@@ -3915,7 +5155,7 @@ static void stop_recording(void) {
 
     g_is_recording = 0;
     SetWindowTextA(g_hwnd_btn, "Record");
-    SetWindowTextA(g_hwnd_lbl_audio, "Recording (click to set marker):");
+    SetWindowTextA(g_hwnd_lbl_audio, "Recording (click to set marker, Ctrl+wheel to zoom):");
 
     /* Set scroll offset to start of recording to show from beginning */
     g_scroll_offset = 0;
@@ -3930,27 +5170,34 @@ static void stop_recording(void) {
 
 #include "drill.c"
 
-/* ---- Word slice playback (uses last-WAV cache) ---- */
+/* ---- Word slice playback (uses the TTS clip cache) ---- */
 
-static HANDLE g_word_slice_thread = NULL;
+static exec_task_t   *g_word_slice_task = NULL;
+static exec_cancel_t *g_word_slice_cancel = NULL;  /* stops only the slice, not TTS */
 
 typedef struct {
-    int16_t *pcm;       /* malloc'd PCM slice */
+    audio_block_t *block;  /* reference to the cached PCM, released on exit */
+    int      start;     /* first sample of the slice within block */
     int      n_samples;
-    int      sr;        /* source sample rate (from WAV header) */
+    int      sr;        /* device rate of the cached clip */
     int      offset_ms; /* ms offset into full audio (for karaoke highlight) */
+    int      speed_pct; /* g_tts_speed_pct at launch */
 } WordSliceArgs;
 
 /* Self-contained waveOut playback — uses local handles, not the globals,
  * to avoid racing with the main TTS worker thread. */
-static DWORD WINAPI word_slice_thread_proc(LPVOID param) {
+static void word_slice_task(void *param, exec_cancel_t *cancel) {
     WordSliceArgs *args = (WordSliceArgs *)param;
+    HANDLE done_event = NULL;
+    wsola_t *stretch = NULL;
+    int16_t *stretched = NULL;
+    if (exec_cancelled(cancel)) goto cleanup;
 
     /* Open our own waveOut device */
-    HANDLE done_event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    done_event = CreateEventA(NULL, FALSE, FALSE, NULL);
     if (!done_event) goto cleanup;
 
-    int base_rate = (args->sr == 24000) ? 48000 : args->sr;
+    int base_rate = args->sr;
     int device_rate = base_rate;
 
     WAVEFORMATEX wfx = {0};
@@ -3968,19 +5215,18 @@ static DWORD WINAPI word_slice_thread_proc(LPVOID param) {
         goto cleanup;
     }
 
-    /* Upsample 24kHz → 48kHz (same logic as main path) */
-    int16_t *upsampled = NULL;
-    const int16_t *play_pcm = args->pcm;
+    /* Cached clips are already at the device rate: play in place, or the
+     * whole slice stretched up front when not at 1x */
+    const int16_t *play_pcm = args->block->samples + args->start;
     int play_n = args->n_samples;
-    if (base_rate == 48000) {
-        upsampled = (int16_t *)malloc((size_t)play_n * 2 * sizeof(int16_t));
-        if (upsampled) {
-            for (int i = 0; i < play_n; i++) {
-                upsampled[i * 2]     = play_pcm[i];
-                upsampled[i * 2 + 1] = play_pcm[i];
-            }
-            play_pcm = upsampled;
-            play_n *= 2;
+    if (args->speed_pct != 100
+        && (stretch = wsola_create(base_rate, args->speed_pct / 100.0)) != NULL) {
+        int cap = (int)(play_n / wsola_speed(stretch)) + 1;
+        stretched = (int16_t *)malloc(cap * sizeof(int16_t));
+        if (stretched && wsola_write(stretch, play_pcm, play_n) == 0) {
+            wsola_end(stretch);
+            play_pcm = stretched;
+            play_n = wsola_read(stretch, stretched, cap);
         }
     }
 
@@ -3996,7 +5242,8 @@ static DWORD WINAPI word_slice_thread_proc(LPVOID param) {
     while (!(hdr.dwFlags & WHDR_DONE)) {
         DWORD ret = WaitForSingleObject(done_event, 50);
         (void)ret;
-        if (InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) {
+        if (exec_cancelled(cancel)
+            || InterlockedCompareExchange(&g_tts_interrupt, 0, 0)) {
             waveOutReset(hwo);
             break;
         }
@@ -4006,7 +5253,9 @@ static DWORD WINAPI word_slice_thread_proc(LPVOID param) {
             mmt.wType = TIME_SAMPLES;
             if (waveOutGetPosition(hwo, &mmt, sizeof(mmt)) == MMSYSERR_NOERROR
                 && mmt.wType == TIME_SAMPLES) {
-                int pos_ms = (int)((double)mmt.u.sample * 1000.0 / base_rate);
+                long long played = mmt.u.sample;
+                if (play_pcm == stretched) played = wsola_source_pos(stretch, played);
+                int pos_ms = (int)((double)played * 1000.0 / base_rate);
                 InterlockedExchange(&g_tts_playback_ms,
                     (LONG)(args->offset_ms + pos_ms));
             }
@@ -4015,92 +5264,85 @@ static DWORD WINAPI word_slice_thread_proc(LPVOID param) {
 
     InterlockedExchange(&g_tts_playback_ms, -1);
     waveOutUnprepareHeader(hwo, &hdr, sizeof(hdr));
-    free(upsampled);
     waveOutReset(hwo);
     waveOutClose(hwo);
     CloseHandle(done_event);
 
 cleanup:
-    free(args->pcm);
+    wsola_destroy(stretch);
+    free(stretched);
+    audio_block_release(args->block);
     free(args);
     PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0);
-    return 0;
 }
 
-/* Play a time slice from last-WAV cache. If not cached, triggers full fetch. */
-static void tts_play_word_slice(int start_ms, int end_ms) {
-    if (!g_drill_mode) return;
-    int cur_idx = g_drill_state.current_idx;
-
-    /* Try to get cached WAV for current sentence+voice */
-    char *wav_copy = NULL;
-    int wav_copy_len = 0;
-    EnterCriticalSection(&g_tts_last_wav_lock);
-    if (g_tts_last_wav && g_tts_last_wav_len > 0
-        && g_tts_last_wav_sentence == cur_idx
-        && g_tts_last_wav_voice == g_tts_voice_idx) {
-        wav_copy = (char *)malloc(g_tts_last_wav_len);
-        if (wav_copy) {
-            memcpy(wav_copy, g_tts_last_wav, g_tts_last_wav_len);
-            wav_copy_len = g_tts_last_wav_len;
-        }
+/* Cancel the running word slice (if any) and wait for it to close waveOut */
+static void word_slice_stop(unsigned long timeout_ms) {
+    if (g_word_slice_cancel) {
+        exec_cancel_set(g_word_slice_cancel);
+        exec_cancel_release(g_word_slice_cancel);
+        g_word_slice_cancel = NULL;
     }
-    LeaveCriticalSection(&g_tts_last_wav_lock);
-
-    /* No cached WAV — trigger full fetch if idle, else ignore */
-    if (!wav_copy) {
-        if (g_tts_state == 0) {
-            DrillSentence *sent = &g_drill_state.sentences[cur_idx];
-            if (sent->chinese[0])
-                tts_speak_server(sent->chinese, cur_idx,
-                                 g_tts_voice_seeds[g_tts_voice_idx]);
-        }
-        return;
+    if (g_word_slice_task) {
+        exec_task_wait(g_word_slice_task, timeout_ms);
+        exec_task_release(g_word_slice_task);
+        g_word_slice_task = NULL;
     }
+}
 
-    /* Parse WAV, extract slice, launch playback */
-    const int16_t *pcm = NULL;
-    int n_samples = 0, sr = 0;
-    if (wav_parse_header(wav_copy, wav_copy_len, &pcm, &n_samples, &sr) != 0) {
-        free(wav_copy);
+/* Play a time slice from the clip cache. If not cached, triggers full fetch. */
+static void tts_play_word_slice(int start_ms, int end_ms) {
+    if (!g_drill_mode) return;
+    int cur_idx = g_drill_state.current_idx;
+    DrillSentence *sent = &g_drill_state.sentences[cur_idx];
+
+    /* Try to get the cached clip for current sentence+voice+seed */
+    tts_clip_t *clip = tts_cache_get(g_tts_cache, sent->chinese,
+                                     tts_voices[g_tts_voice_idx],
+                                     tts_cache_seed(g_tts_voice_idx));
+
+    /* Not cached — trigger full fetch if idle, else ignore */
+    if (!clip) {
+        if (g_tts_state == 0 && sent->chinese[0])
+            tts_speak_server(sent->chinese, cur_idx,
+                             g_tts_voice_seeds[g_tts_voice_idx]);
         return;
     }
+    audio_block_t *block = clip->pcm;
+    int sr = clip->sample_rate;
+    audio_block_retain(block);
+    tts_clip_release(clip);
 
+    /* Pick the slice and launch playback straight from the cached block */
+    int n_samples = block->n_samples;
     int start_sample = (int)((double)start_ms / 1000.0 * sr);
     int end_sample   = (end_ms < 0) ? n_samples
                      : (int)((double)end_ms / 1000.0 * sr);
     if (start_sample < 0) start_sample = 0;
     if (end_sample > n_samples) end_sample = n_samples;
-    if (start_sample >= end_sample) { free(wav_copy); return; }
+    if (start_sample >= end_sample) { audio_block_release(block); return; }
 
-    int slice_n = end_sample - start_sample;
-    int16_t *slice_pcm = (int16_t *)malloc(slice_n * sizeof(int16_t));
-    if (!slice_pcm) { free(wav_copy); return; }
-    memcpy(slice_pcm, pcm + start_sample, slice_n * sizeof(int16_t));
-    free(wav_copy);
-
-    /* Interrupt previous word-slice playback (if any).
-     * Only set interrupt if a slice thread is running — avoid disturbing the
-     * main TTS worker's playback loop which checks the same flag. */
-    if (g_word_slice_thread) {
-        InterlockedExchange(&g_tts_interrupt, 1);
-        WaitForSingleObject(g_word_slice_thread, 2000);
-        CloseHandle(g_word_slice_thread);
-        g_word_slice_thread = NULL;
-        InterlockedExchange(&g_tts_interrupt, 0);
-    }
+    /* Interrupt previous word-slice playback (if any). Its own cancel
+     * token leaves the main TTS worker's interrupt flag alone. */
+    word_slice_stop(2000);
 
     WordSliceArgs *args = (WordSliceArgs *)malloc(sizeof(WordSliceArgs));
-    if (!args) { free(slice_pcm); return; }
-    args->pcm = slice_pcm;
-    args->n_samples = slice_n;
+    if (!args) { audio_block_release(block); return; }
+    args->block = block;
+    args->start = start_sample;
+    args->n_samples = end_sample - start_sample;
     args->sr = sr;
     args->offset_ms = start_ms;
+    args->speed_pct = (int)InterlockedCompareExchange(&g_tts_speed_pct, 0, 0);
 
     PostMessageA(g_hwnd_main, WM_TTS_STATUS, 2, 0); /* speaking */
-    g_word_slice_thread = CreateThread(NULL, 0, word_slice_thread_proc, args, 0, NULL);
-    if (!g_word_slice_thread) {
-        free(slice_pcm);
+    g_word_slice_cancel = exec_cancel_new();
+    if (!g_word_slice_cancel
+        || executor_submit(g_executor, EXEC_LANE_PLAYBACK, word_slice_task, args,
+                           g_word_slice_cancel, &g_word_slice_task) != 0) {
+        exec_cancel_release(g_word_slice_cancel);
+        g_word_slice_cancel = NULL;
+        audio_block_release(block);
         free(args);
         PostMessageA(g_hwnd_main, WM_TTS_STATUS, 0, 0);
     }
@@ -4230,25 +5472,27 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                 }
                 /* Live mode: send audio deltas every timer tick (~0.5s) */
                 else if (g_live_mode && g_live_session) {
-                    int delta = g_recording_samples - g_live_last_sent;
+                    int total = rec_store_count(g_rec_store);
+                    int delta = total - g_live_last_sent;
                     if (delta >= 8000) { /* 0.5s of audio */
                         char lb[128];
                         snprintf(lb, sizeof(lb), "Sending %d samples (%.1fs) at offset %d",
                                  delta, delta / 16000.0f, g_live_last_sent);
                         log_event("LIVE", lb);
-                        int rc = asr_live_send_audio(g_live_session,
-                                             g_recording_buffer + g_live_last_sent,
-                                             delta);
+                        audio_view_t chunk = {0};
+                        int rc = rec_store_view(g_rec_store, g_live_last_sent, delta, &chunk) > 0
+                               ? asr_live_send_view(g_live_session, &chunk) : -1;
+                        audio_view_release(&chunk);
                         if (rc != 0)
                             log_event("LIVE", "send_audio FAILED");
-                        g_live_last_sent = g_recording_samples;
+                        g_live_last_sent = total;
                     }
                 }
                 /* Retranscription mode: kick every ~3s of new audio */
                 else if (!g_live_mode
-                         && g_recording_samples - g_last_transcribe_samples
+                         && rec_store_count(g_rec_store) - g_last_transcribe_samples
                                 >= RETRANSCRIBE_INTERVAL_SAMPLES
-                         && g_recording_samples >= RETRANSCRIBE_MIN_SAMPLES) {
+                         && rec_store_count(g_rec_store) >= RETRANSCRIBE_MIN_SAMPLES) {
                     asr_kick_retranscribe(0);
                 }
             } else if (wParam == ID_TIMER_WAVEFORM && g_is_recording) {
@@ -4438,8 +5682,9 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                 LiveStopArgs *sa = (LiveStopArgs *)calloc(1, sizeof(LiveStopArgs));
                 if (sa) {
                     sa->session = session;
-                    HANDLE ht = CreateThread(NULL, 0, live_stop_thread, sa, 0, NULL);
-                    if (ht) CloseHandle(ht);
+                    if (executor_submit(g_executor, EXEC_LANE_INTERACTIVE, live_stop_task,
+                                        sa, NULL, NULL) != 0)
+                        free(sa);
                 }
             } else {
                 g_live_session = session;
@@ -4460,6 +5705,13 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
             g_token_buf_len = 0;
             g_token_chat_anchor = -1;
 
+            if (g_pass_pending) {
+                g_pass_pending = 0;
+                g_pass_req.client_ms = (double)(GetTickCount64() - g_pass_kick_tick);
+                if (g_session && sess_write_pass(g_session, &g_pass_req, tr) != 0)
+                    session_fail();
+            }
+
             /* Populate perf metrics from server response */
             if (tr) {
                 g_pass_count++;
@@ -4485,6 +5737,7 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                 if (result_len > 0) {
                     handle_transcribe_result(result);
                     g_committed_chars += result_len;
+                    session_commit(0, rec_store_count(g_rec_store), result);
                     log_event("LIVE", "Session done, text committed");
                 }
                 asr_free_result(tr);
@@ -4535,11 +5788,14 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                         log_event("FINAL", commit_buf);
                         handle_transcribe_result(commit_buf);
                         g_committed_chars += tlen;
+                        session_commit(g_committed_samples, g_last_transcribe_samples,
+                                       commit_buf);
                     }
                 } else if (result_len > 0 && g_stable_len == 0) {
                     log_event("FINAL", result);
                     handle_transcribe_result(result);
                     g_committed_chars += result_len;
+                    session_commit(g_committed_samples, g_last_transcribe_samples, result);
                 }
             } else if (result && result[0]) {
                 /* Sentence stability detection */
@@ -4716,9 +5972,12 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
                             advance = (int)((long long)g_window_samples
                                          * new_stable / result_len);
                         }
+                        int from = g_committed_samples;
                         g_committed_samples += advance;
                         if (g_committed_samples > g_last_transcribe_samples)
                             g_committed_samples = g_last_transcribe_samples;
+                        if (slen > 0)
+                            session_commit(from, g_committed_samples, sentence);
                     }
 
                     g_stable_len = 0;
@@ -4782,6 +6041,7 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
 
         case WM_TTS_STATUS: {
             g_tts_state = (int)wParam;
+            tts_current_words_reclaim();    /* not painting now */
             /* Playback highlight timer: repaint drill panel at 50ms while speaking */
             if ((int)wParam == 2 && g_drill_mode) {
                 SetTimer(g_hwnd_main, ID_TIMER_PLAYBACK, 50, NULL);
@@ -4863,6 +6123,8 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPara
             /* Shut down LLM worker */
             llm_worker_stop();
             /* Shut down server TTS worker */
+            tts_audition_stop();
+            tts_synth_stop();
             tts_worker_stop();
             /* Release SAPI TTS */
             if (g_tts_voice) {
@@ -4881,11 +6143,47 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     (void)lpCmdLine;
 
     QueryPerformanceFrequency(&g_freq);
-    InitializeCriticalSection(&g_audio_lock);
 
     /* Open log file */
     g_log_file = fopen("voice_test_gui.log", "a");
 
+    g_rec_store = rec_store_create(REC_MEM_BUDGET);
+    g_capture_ring = capture_ring_create(CAPTURE_RING_SAMPLES);
+    g_level_pyr = level_pyr_create();
+    g_vad = vad_create(WHISPER_SAMPLE_RATE);
+    {
+        const char *jobs_arg = strstr(GetCommandLineA(), "--prefetch-jobs=");
+        if (jobs_arg) g_tts_prefetch_jobs = atoi(jobs_arg + 16);
+        if (g_tts_prefetch_jobs < 1) g_tts_prefetch_jobs = 1;
+        if (g_tts_prefetch_jobs > TTS_PREFETCH_MAX_JOBS) g_tts_prefetch_jobs = TTS_PREFETCH_MAX_JOBS;
+        const char *predict_arg = strstr(GetCommandLineA(), "--predict=");
+        if (predict_arg) g_tts_predict_count = atoi(predict_arg + 10);
+        if (g_tts_predict_count < 0) g_tts_predict_count = 0;
+        if (g_tts_predict_count > TTS_PREDICT_MAX) g_tts_predict_count = TTS_PREDICT_MAX;
+        const char *aud_arg = strstr(GetCommandLineA(), "--audition=");
+        if (aud_arg) g_tts_audition_count = atoi(aud_arg + 11);
+        if (g_tts_audition_count < 1) g_tts_audition_count = 1;
+        if (g_tts_audition_count > TTS_AUDITION_MAX) g_tts_audition_count = TTS_AUDITION_MAX;
+        const char *aud_jobs_arg = strstr(GetCommandLineA(), "--audition-jobs=");
+        if (aud_jobs_arg) g_tts_audition_jobs = atoi(aud_jobs_arg + 16);
+        if (g_tts_audition_jobs < 1) g_tts_audition_jobs = 1;
+        if (g_tts_audition_jobs > TTS_AUDITION_MAX_JOBS) g_tts_audition_jobs = TTS_AUDITION_MAX_JOBS;
+    }
+    /* Room for every prefetch and audition step plus one disk write and one
+     * predicted take, with a streamed take's download, other playback work
+     * and interactive work still finding a free worker */
+    {
+        int background = g_tts_prefetch_jobs + g_tts_audition_jobs + 1;
+        g_executor = executor_create(background + 4 > EXECUTOR_WORKERS
+                                     ? background + 4 : EXECUTOR_WORKERS);
+        if (g_executor)
+            executor_set_lane_limit(g_executor, EXEC_LANE_PREFETCH, background);
+    }
+    if (!g_rec_store || !g_capture_ring || !g_level_pyr || !g_vad || !g_executor) {
+        log_event("INIT_ERR", "Failed to create recording store / capture ring / level pyramid / VAD / executor");
+        return 1;
+    }
+
     /* Install crash handler for minidump generation */
     SetUnhandledExceptionFilter(crash_handler);
 
@@ -4929,6 +6227,40 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
             if (port > 0 && port < 65536)
                 g_asr_port = port;
         }
+        const char *mel_arg = strstr(cmd, "--mel-upload");
+        if (mel_arg) {
+            const char *q = mel_arg + 12;
+            mel_quant_t quant = strncmp(q, "=int16", 6) == 0 ? MEL_Q_INT16
+                              : strncmp(q, "=int8", 5) == 0 || *q == '\0' || *q == ' '
+                              ? MEL_Q_INT8 : 0;
+            const char *bins_arg = strstr(cmd, "--mel-bins=");
+            int bins = bins_arg ? atoi(bins_arg + 11) : MEL_BINS_DEFAULT;
+            if (!quant || bins < 1 || bins > MEL_BINS_MAX) {
+                log_event("MEL_ERR", "Bad --mel-upload or --mel-bins value, uploading PCM");
+            } else {
+                g_mel = mel_fe_create(quant, bins);
+                log_event("MEL", g_mel ? "Uploading log-mel features instead of PCM"
+                                       : "Failed to create feature front-end, uploading PCM");
+            }
+        }
+        const char *model_arg = strstr(cmd, "--tts-model=");
+        if (model_arg) {
+            sscanf(model_arg + 12, "%63s", g_tts_model_id);
+            log_event("TTS_DISK", g_tts_model_id);
+        }
+        if (strstr(cmd, "--no-tts-stream")) {
+            g_tts_stream = 0;
+            log_event("TTS_SRV", "Streaming playback off");
+        }
+        if (strstr(cmd, "--tts-replies")) {
+            g_tts_server_replies = 1;
+            log_event("TTS_SRV", "Speaking replies with the server voice");
+        }
+        if (strstr(cmd, "--block-upload")) {
+            g_blk = blk_uploader_create(WHISPER_SAMPLE_RATE);
+            log_event("BLOCKS", g_blk ? "Uploading new audio blocks plus references"
+                                      : "Failed to create block uploader, uploading PCM");
+        }
     }
 
     /* Resolve drill sentence file path (relative to exe directory) */
@@ -5106,6 +6438,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     llm_worker_start();
 
     /* Start TTS worker thread (server-based) */
+    tts_grouping_index_open();
     tts_worker_start();
 
     /* Load per-voice locked seeds */
@@ -5150,12 +6483,14 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                 drill_advance(&g_drill_state);
                 tts_prefetch_prioritize(g_drill_state.current_idx);
                 tts_publish_cached_timestamps(g_drill_state.current_idx);
+                tts_predict_schedule();
                 g_drill_stream_len = 0;
                 if (g_hwnd_drill)
                     InvalidateRect(g_hwnd_drill, NULL, FALSE);
             }
             if (!g_ptt_held && !g_is_recording) {
-                /* Interrupt any TTS playback before recording */
+                /* Interrupt any TTS playback (and queued replies) before recording */
+                ttsq_drop_playback(g_tts_queue);
                 InterlockedExchange(&g_tts_interrupt, 1);
                 g_ptt_held = 1;
                 g_ptt_start_tick = GetTickCount();
@@ -5206,13 +6541,29 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                 g_tts_voice_idx = (g_tts_voice_idx + 1) % (int)TTS_NUM_VOICES;
             }
             InterlockedExchange(&g_tts_last_seed, -1);
-            tts_last_wav_clear();
-            log_event("TTS", g_tts_voices[g_tts_voice_idx]);
+            log_event("TTS", tts_voices[g_tts_voice_idx]);
+            tts_predict_schedule();
             InvalidateRect(g_hwnd_stats, NULL, FALSE);
             if (g_drill_mode && g_hwnd_drill)
                 InvalidateRect(g_hwnd_drill, NULL, FALSE);
             continue;
         }
+        /* +/- in drill mode: playback speed 0.5x..1.5x (from the next take) */
+        if (msg.message == WM_KEYDOWN && g_drill_mode
+            && (msg.wParam == VK_OEM_PLUS || msg.wParam == VK_ADD
+                || msg.wParam == VK_OEM_MINUS || msg.wParam == VK_SUBTRACT)
+            && !(GetKeyState(VK_CONTROL) & 0x8000)) {
+            LONG pct = InterlockedCompareExchange(&g_tts_speed_pct, 0, 0);
+            pct += (msg.wParam == VK_OEM_PLUS || msg.wParam == VK_ADD) ? 10 : -10;
+            if (pct < (LONG)(WSOLA_MIN_SPEED * 100)) pct = (LONG)(WSOLA_MIN_SPEED * 100);
+            if (pct > (LONG)(WSOLA_MAX_SPEED * 100)) pct = (LONG)(WSOLA_MAX_SPEED * 100);
+            InterlockedExchange(&g_tts_speed_pct, pct);
+            char speed_msg[32];
+            snprintf(speed_msg, sizeof(speed_msg), "Speed %.1fx", pct / 100.0);
+            log_event("TTS", speed_msg);
+            InvalidateRect(g_hwnd_stats, NULL, FALSE);
+            continue;
+        }
         /* Shift+L in drill mode: force fresh fetch and play */
         if (msg.message == WM_KEYDOWN && msg.wParam == 'L'
             && !(msg.lParam & (1 << 30))
@@ -5220,8 +6571,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
             && (GetKeyState(VK_SHIFT) & 0x8000)
             && g_drill_mode && !g_is_recording) {
             log_event("TTS_SRV", "Shift+L -- speaking fresh");
-            tts_last_wav_clear();
             DrillSentence *sent = &g_drill_state.sentences[g_drill_state.current_idx];
+            tts_cache_remove(g_tts_cache, sent->chinese, tts_voices[g_tts_voice_idx],
+                             tts_cache_seed(g_tts_voice_idx));
             if (sent->chinese[0]) {
                 tts_speak_server(sent->chinese, g_drill_state.current_idx,
                                 g_tts_voice_seeds[g_tts_voice_idx]);
@@ -5319,6 +6671,25 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
             InvalidateRect(g_hwnd_stats, NULL, FALSE);
             continue;
         }
+        /* Ctrl+Shift+> (period): audition batch, every voice x fresh seeds */
+        if (msg.message == WM_KEYDOWN && msg.wParam == VK_OEM_PERIOD
+            && (GetKeyState(VK_SHIFT) & 0x8000)
+            && (GetKeyState(VK_CONTROL) & 0x8000)
+            && !(msg.lParam & (1 << 30))
+            && g_drill_mode && !g_is_recording) {
+            tts_audition_start(g_drill_state.current_idx);
+            continue;
+        }
+        /* [ / ]: previous / next finished audition take */
+        if (msg.message == WM_KEYDOWN
+            && (msg.wParam == VK_OEM_4 || msg.wParam == VK_OEM_6)
+            && !(GetKeyState(VK_CONTROL) & 0x8000)
+            && g_drill_mode && !g_is_recording && g_tts_audition) {
+            tts_audition_flip(msg.wParam == VK_OEM_6 ? 1 : -1);
+            InvalidateRect(g_hwnd_stats, NULL, FALSE);
+            if (g_hwnd_drill) InvalidateRect(g_hwnd_drill, NULL, FALSE);
+            continue;
+        }
         /* Shift+< (comma): lock current seed for this voice */
         if (msg.message == WM_KEYDOWN && msg.wParam == VK_OEM_COMMA
             && (GetKeyState(VK_SHIFT) & 0x8000)
@@ -5328,7 +6699,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
             if (last >= 0) {
                 g_tts_voice_seeds[g_tts_voice_idx] = (int)last;
                 tts_seeds_save();
-                tts_last_wav_clear();
+                tts_cache_adopt_seed(g_drill_state.sentences[g_drill_state.current_idx].chinese,
+                                     g_tts_voice_idx, (int)last);
                 log_event("TTS_SRV", "Shift+< -- locked seed");
             }
             InvalidateRect(g_hwnd_stats, NULL, FALSE);
@@ -5342,7 +6714,6 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
             g_tts_voice_seeds[g_tts_voice_idx] = -1;
             InterlockedExchange(&g_tts_last_seed, -1);
             tts_seeds_save();
-            tts_last_wav_clear();
             log_event("TTS_SRV", "Ctrl+Shift+< -- unlocked seed");
             InvalidateRect(g_hwnd_stats, NULL, FALSE);
             continue;
@@ -5389,6 +6760,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                 g_drill_stream_len = 0;
                 tts_prefetch_prioritize(g_drill_state.current_idx);
                 tts_publish_cached_timestamps(g_drill_state.current_idx);
+                tts_predict_schedule();
 
                 SetWindowTextA(g_hwnd_lbl_claude, "Drill:");
                 log_event("DRILL", "Pronunciation Drill active");
@@ -5429,6 +6801,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
             drill_advance(&g_drill_state);
             tts_prefetch_prioritize(g_drill_state.current_idx);
             tts_publish_cached_timestamps(g_drill_state.current_idx);
+            tts_predict_schedule();
             g_drill_stream_len = 0;
             if (g_hwnd_drill)
                 InvalidateRect(g_hwnd_drill, NULL, FALSE);
@@ -5438,17 +6811,17 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         DispatchMessage(&msg);
     }
 
-    /* Cleanup */
-    if (g_log_file) {
-        fclose(g_log_file);
-    }
+    /* Cleanup. Cancel and drain every executor task (prefetch steps, word
+     * slices, archiving) before freeing what they use; they log as they
+     * finish, so the log closes last. */
     /* ASR model cleanup not needed -- transcription via HTTP server */
-    if (g_word_slice_thread) {
-        WaitForSingleObject(g_word_slice_thread, 1000);
-        CloseHandle(g_word_slice_thread);
-        g_word_slice_thread = NULL;
-    }
+    word_slice_stop(INFINITE);
     tts_prefetch_stop();
+    executor_destroy(g_executor, INFINITE);
+    g_executor = NULL;
+    pfq_destroy(g_tts_prefetch_queue);
+    tts_store_close(g_tts_store);
+    gidx_close(g_grouping_index);
     if (g_drill_mode) {
         drill_shutdown(&g_drill_state, g_drill_progress_path);
     }
@@ -5460,7 +6833,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     DeleteObject(g_font_italic);
     if (g_font_drill_chinese) DeleteObject(g_font_drill_chinese);
     DeleteObject(g_brush_bg);
-    DeleteCriticalSection(&g_audio_lock);
+    wav_recording_end(0);  /* executor is gone; the WAV stays as saved */
+    session_end();
+    rec_store_destroy(g_rec_store);
+    capture_ring_destroy(g_capture_ring);
+    level_pyr_destroy(g_level_pyr);
+    vad_destroy(g_vad);
+    mel_fe_destroy(g_mel);
+    blk_uploader_destroy(g_blk);
+    if (g_log_file) {
+        fclose(g_log_file);
+        g_log_file = NULL;
+    }
     MFShutdown();
     CoUninitialize();
 
@@ -23,12 +23,84 @@ echo Compiling asr_client...
 cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\asr_client.c" /Fo:"%BUILD_DIR%\asr_client.obj"
 if %ERRORLEVEL% NEQ 0 exit /b 1
 
+echo Compiling audio_buf...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\audio_buf.c" /Fo:"%BUILD_DIR%\audio_buf.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling silence_trim...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\silence_trim.c" /Fo:"%BUILD_DIR%\silence_trim.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling lac...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\lac.c" /Fo:"%BUILD_DIR%\lac.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling session_log...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\session_log.c" /Fo:"%BUILD_DIR%\session_log.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling fft...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\fft.c" /Fo:"%BUILD_DIR%\fft.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling vad...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\vad.c" /Fo:"%BUILD_DIR%\vad.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling mel_frontend...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\mel_frontend.c" /Fo:"%BUILD_DIR%\mel_frontend.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling block_upload...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\block_upload.c" /Fo:"%BUILD_DIR%\block_upload.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling tts_stream...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_stream.c" /Fo:"%BUILD_DIR%\tts_stream.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling base64...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\base64.c" /Fo:"%BUILD_DIR%\base64.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling tts_cache...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_cache.c" /Fo:"%BUILD_DIR%\tts_cache.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling tts_store...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_store.c" /Fo:"%BUILD_DIR%\tts_store.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling tts_request...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_request.c" /Fo:"%BUILD_DIR%\tts_request.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling grouping_index...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\grouping_index.c" /Fo:"%BUILD_DIR%\grouping_index.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling executor...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\executor.c" /Fo:"%BUILD_DIR%\executor.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling audio_sink...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\audio_sink.c" /Fo:"%BUILD_DIR%\audio_sink.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling wsola...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\wsola.c" /Fo:"%BUILD_DIR%\wsola.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
+echo Compiling tts_queue...
+cl /nologo /W3 /Od /Zi /DDEBUG /I"%SHARED_DIR%" /c "%SHARED_DIR%\tts_queue.c" /Fo:"%BUILD_DIR%\tts_queue.obj"
+if %ERRORLEVEL% NEQ 0 exit /b 1
+
 echo Compiling headless test...
 cl /nologo /W3 /Od /Zi /I"%SHARED_DIR%" /c src\main.c /Fo:"%BUILD_DIR%\main.obj"
 if %ERRORLEVEL% NEQ 0 exit /b 1
 
 echo Linking...
-link /nologo /DEBUG /SUBSYSTEM:CONSOLE /OUT:"%BIN_DIR%\voice-test-headless.exe" "%BUILD_DIR%\main.obj" "%BUILD_DIR%\asr_client.obj" winhttp.lib
+link /nologo /DEBUG /SUBSYSTEM:CONSOLE /OUT:"%BIN_DIR%\voice-test-headless.exe" "%BUILD_DIR%\main.obj" "%BUILD_DIR%\asr_client.obj" "%BUILD_DIR%\audio_buf.obj" "%BUILD_DIR%\silence_trim.obj" "%BUILD_DIR%\lac.obj" "%BUILD_DIR%\session_log.obj" "%BUILD_DIR%\fft.obj" "%BUILD_DIR%\vad.obj" "%BUILD_DIR%\mel_frontend.obj" "%BUILD_DIR%\block_upload.obj" "%BUILD_DIR%\tts_stream.obj" "%BUILD_DIR%\base64.obj" "%BUILD_DIR%\tts_cache.obj" "%BUILD_DIR%\tts_store.obj" "%BUILD_DIR%\tts_request.obj" "%BUILD_DIR%\grouping_index.obj" "%BUILD_DIR%\executor.obj" "%BUILD_DIR%\audio_sink.obj" "%BUILD_DIR%\wsola.obj" "%BUILD_DIR%\tts_queue.obj" winhttp.lib winmm.lib
 if %ERRORLEVEL% NEQ 0 exit /b 1
 
 echo Build complete: %BIN_DIR%\voice-test-headless.exe
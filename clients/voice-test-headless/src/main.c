@@ -7,8 +7,40 @@
  *   3. "timestamps" -- verbose_json response with per-token timestamps
  *   4. "sim" -- full GUI simulation (sliding window + stability detection)
  *
+ * Inputs may be WAV, .lac archives or .vses session archives (their
+ * audio). "pack" compresses 16 kHz 16-bit WAV recordings to .lac next to
+ * the originals; "replay" re-scores a session's recorded passes and
+ * commits. Neither needs the server.
+ *
+ * With --trim, windows in retranscribe/sim are silence-trimmed before upload
+ * (as in the GUI) and the audio seconds saved are reported. With
+ * --features int8|int16 they upload log-mel frames instead of PCM (frames
+ * are computed once per file, as the GUI does while recording); use it
+ * against clients/asr-standin until the server accepts input_format=log_mel.
+ * With --blocks they upload only audio blocks the server has not seen plus
+ * references to earlier ones (stand-in only, likewise).
+ *
+ * "vadcmp" scores the energy gate and the spectral VAD against hand labels
+ * (an Audacity label file next to the recording, <name>.labels) in 10 ms
+ * frames, without the server. --spectral-vad makes "vad" gate on the
+ * spectral VAD as the GUI does.
+ *
+ * "seeds" screens TTS voice seeds instead of transcribing: the inputs are
+ * drill sentence banks, and every voice/seed candidate speaks every
+ * sentence, --jobs requests at a time, ranked per voice for locking in the
+ * GUI (Shift+<). "warm" fills the GUI's on-disk take store and grouping
+ * index for drill banks in every voice/seed pair, skipping what is already
+ * there, so students never wait on synthesis.
+ *
+ * "executor" checks that interactive work still starts at once while the
+ * background lanes of the shared worker pool are full; it takes no inputs.
+ * "stream" likewise checks streamed TTS decoding into the file and null
+ * playback sinks, without a server or a sound device, "wsola" that the
+ * time-stretch is the identity at 1x, and "queue" that the TTS request
+ * queue plays repeated sentences again while sharing their takes.
+ *
  * Build: clients\voice-test-headless\build.bat
- * Usage: voice-test-headless.exe [options] <recording.wav> [...]
+ * Usage: voice-test-headless.exe [options] <recording.wav|.lac|.vses> [...]
  */
 
 #define _CRT_SECURE_NO_WARNINGS
@@ -18,17 +50,102 @@
 #include <ctype.h>
 #include <math.h>
 #include <windows.h>
+#include <winhttp.h>
 
 #include "asr_client.h"
+#include "silence_trim.h"
+#include "lac.h"
+#include "session_log.h"
+#include "vad.h"
+#include "mel_frontend.h"
+#include "block_upload.h"
+#include "tts_stream.h"
+#include "tts_store.h"
+#include "tts_request.h"
+#include "grouping_index.h"
+#include "executor.h"
+#include "audio_sink.h"
+#include "wsola.h"
+#include "tts_queue.h"
 
 #define SAMPLE_RATE 16000
 
-/* --- WAV reader --- */
+/* Linear resample to SAMPLE_RATE. Takes ownership of native. */
+static float *resample_to_16k(float *native, int native_samples, int sample_rate,
+                              int *out_samples) {
+    if (sample_rate != SAMPLE_RATE) {
+        int out_n = (int)((long long)native_samples * SAMPLE_RATE / sample_rate);
+        float *resampled = (float *)malloc(out_n * sizeof(float));
+        for (int i = 0; i < out_n; i++) {
+            double src_pos = (double)i * sample_rate / SAMPLE_RATE;
+            int idx = (int)src_pos;
+            double frac = src_pos - idx;
+            if (idx + 1 < native_samples)
+                resampled[i] = (float)(native[idx] * (1.0 - frac) + native[idx + 1] * frac);
+            else
+                resampled[i] = native[idx < native_samples ? idx : native_samples - 1];
+        }
+        free(native);
+        native = resampled;
+        native_samples = out_n;
+    }
+
+    *out_samples = native_samples;
+    return native;
+}
+
+/* --- LAC reader (compressed archive recordings) --- */
+static float *read_lac_f32(FILE *f, int *out_samples) {
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *data = size > 0 ? (unsigned char *)malloc(size) : NULL;
+    if (!data || fread(data, 1, size, f) != (size_t)size) { free(data); return NULL; }
+
+    int n = 0, sample_rate = 0;
+    int16_t *pcm = lac_decode(data, size, &n, &sample_rate);
+    free(data);
+    if (!pcm || sample_rate <= 0) { free(pcm); return NULL; }
+
+    float *native = (float *)malloc(n * sizeof(float));
+    for (int i = 0; i < n; i++)
+        native[i] = pcm[i] / 32768.0f;
+    free(pcm);
+    return resample_to_16k(native, n, sample_rate, out_samples);
+}
+
+/* --- Session archive audio --- */
+static float *read_session_f32(const char *path, int *out_samples) {
+    sess_reader_t *r = sess_reader_open(path);
+    if (!r) return NULL;
+    int n = 0;
+    int16_t *pcm = sess_read_audio(r, &n);
+    int sample_rate = sess_reader_sample_rate(r);
+    sess_reader_close(r);
+    if (!pcm || sample_rate <= 0) { free(pcm); return NULL; }
+
+    float *native = (float *)malloc(n * sizeof(float));
+    for (int i = 0; i < n; i++)
+        native[i] = pcm[i] / 32768.0f;
+    free(pcm);
+    return resample_to_16k(native, n, sample_rate, out_samples);
+}
+
+/* --- WAV reader (also accepts .lac and session archives) --- */
 static float *read_wav_f32(const char *path, int *out_samples) {
     FILE *f = fopen(path, "rb");
     if (!f) { fprintf(stderr, "Cannot open %s\n", path); return NULL; }
 
     char riff[4]; fread(riff, 1, 4, f);
+    if (memcmp(riff, "LAC1", 4) == 0) {
+        float *pcm = read_lac_f32(f, out_samples);
+        fclose(f);
+        return pcm;
+    }
+    if (memcmp(riff, "VSES", 4) == 0) {
+        fclose(f);
+        return read_session_f32(path, out_samples);
+    }
     if (memcmp(riff, "RIFF", 4) != 0) { fclose(f); return NULL; }
     fseek(f, 4, SEEK_CUR);
     char wave[4]; fread(wave, 1, 4, f);
@@ -84,25 +201,7 @@ static float *read_wav_f32(const char *path, int *out_samples) {
     }
     free(raw_data);
 
-    if (sample_rate != SAMPLE_RATE) {
-        int out_n = (int)((long long)native_samples * SAMPLE_RATE / sample_rate);
-        float *resampled = (float *)malloc(out_n * sizeof(float));
-        for (int i = 0; i < out_n; i++) {
-            double src_pos = (double)i * sample_rate / SAMPLE_RATE;
-            int idx = (int)src_pos;
-            double frac = src_pos - idx;
-            if (idx + 1 < native_samples)
-                resampled[i] = (float)(native[idx] * (1.0 - frac) + native[idx + 1] * frac);
-            else
-                resampled[i] = native[idx < native_samples ? idx : native_samples - 1];
-        }
-        free(native);
-        native = resampled;
-        native_samples = out_n;
-    }
-
-    *out_samples = native_samples;
-    return native;
+    return resample_to_16k(native, native_samples, sample_rate, out_samples);
 }
 
 /* --- Timer --- */
@@ -113,6 +212,169 @@ static double now_ms(void) {
     return (double)t.QuadPart / (double)perf_freq.QuadPart * 1000.0;
 }
 
+/* --- Pre-upload silence trimming (--trim) --- */
+static int g_trim = 0;
+static trim_opts_t g_trim_opts = { 0.010f, 300, 800 };
+static double g_trim_in_sec, g_trim_saved_sec;
+
+/* --- Log-mel feature upload (--features) --- */
+static mel_quant_t g_mel_quant = 0;
+static int g_mel_bins = MEL_BINS_DEFAULT;
+static mel_fe_t *g_mel = NULL;          /* frames of the current file */
+static const float *g_mel_audio = NULL; /* sample 0 of the current file */
+static double g_mel_ms, g_mel_bytes, g_mel_pcm_bytes;
+
+static void f32_to_s16(const float *src, int n, short *dst) {
+    for (int j = 0; j < n; j++) {
+        float v = src[j] * 32768.0f;
+        dst[j] = (short)(v > 32767.0f ? 32767 : v < -32768.0f ? -32768 : v);
+    }
+}
+
+/* Compute the whole file's frames up front; windows then only serialize */
+static void mel_prepare(const float *wav, int n_samples) {
+    if (!g_mel_quant) return;
+    if (!g_mel) g_mel = mel_fe_create(g_mel_quant, g_mel_bins);
+    if (!g_mel) return;
+    mel_fe_reset(g_mel);
+    g_mel_audio = wav;
+    double t0 = now_ms();
+    short buf[4096];
+    for (int i = 0; i < n_samples; i += 4096) {
+        int take = n_samples - i < 4096 ? n_samples - i : 4096;
+        f32_to_s16(wav + i, take, buf);
+        mel_fe_push_s16(g_mel, buf, take);
+    }
+    g_mel_ms = now_ms() - t0;
+}
+
+/* --- Incremental block upload (--blocks) --- */
+static int g_blocks = 0;
+static blk_uploader_t *g_blk = NULL;
+static audio_block_t *g_blk_pcm = NULL;     /* current file as int16 */
+static const float *g_blk_audio = NULL;     /* sample 0 of the current file */
+static double g_blk_bytes, g_blk_pcm_bytes;
+static int g_blk_misses;
+
+static void blk_prepare(const float *wav, int n_samples) {
+    if (!g_blocks) return;
+    if (!g_blk) g_blk = blk_uploader_create(SAMPLE_RATE);
+    audio_block_release(g_blk_pcm);
+    g_blk_pcm = g_blk ? audio_block_new(n_samples) : NULL;
+    if (!g_blk_pcm) return;
+    f32_to_s16(wav, n_samples, g_blk_pcm->samples);
+    blk_uploader_reset(g_blk);
+    g_blk_audio = wav;
+}
+
+/* Block upload of one window; a rejection falls back to a WAV upload, and
+ * one other than a cache miss (409) turns block upload off for the run */
+static AsrResult *transcribe_blocks(const float *wav, int n, int port,
+                                    const char *prompt) {
+    long long start = wav - g_blk_audio;
+    int base = (int)blk_align_down(start);
+    audio_view_t src = {0};
+    if (audio_view_append(&src, g_blk_pcm, base, (int)(start + n - base)) != 0)
+        return NULL;
+    size_t size = 0;
+    unsigned char *body = blk_build(g_blk, &src, start, n, &size, NULL);
+    audio_view_release(&src);
+    if (!body) return NULL;
+
+    int rejected = 0;
+    AsrResult *r = asr_transcribe_stream_blocks(body, size, port, NULL, prompt, 0,
+                                                NULL, NULL, &rejected);
+    free(body);
+    blk_finish(g_blk, r != NULL);
+    g_blk_bytes += (double)size;
+    g_blk_pcm_bytes += 44.0 + 2.0 * n;
+    if (!r && rejected) {
+        if (rejected == 409) {
+            g_blk_misses++;
+        } else {
+            fprintf(stderr, "Server rejected block upload (HTTP %d), "
+                    "sending full windows\n", rejected);
+            g_blocks = 0;
+        }
+        blk_uploader_reset(g_blk);
+        g_blk_bytes += 44.0 + 2.0 * n;
+        r = asr_transcribe(wav, n, port, NULL, prompt, 0);
+    }
+    return r;
+}
+
+/* asr_transcribe with optional trimming or feature upload. Timestamps come
+ * back on the untrimmed timeline. */
+static AsrResult *transcribe_window(const float *wav, int n, int port,
+                                    const char *prompt) {
+    if (g_mel && g_mel_audio) {
+        int first = mel_frame_at(wav - g_mel_audio);
+        int n_frames = n / MEL_HOP;
+        size_t size = 0;
+        unsigned char *feat = mel_fe_serialize(g_mel, first, n_frames, &size);
+        if (!feat) return NULL;
+        g_mel_bytes += (double)size;
+        g_mel_pcm_bytes += 44.0 + 2.0 * n;
+        AsrResult *r = asr_transcribe_stream_mel(feat, size, port, NULL, prompt, 0,
+                                                 NULL, NULL);
+        free(feat);
+        return r;
+    }
+    if (g_blocks && g_blk_pcm && g_blk_audio)
+        return transcribe_blocks(wav, n, port, prompt);
+
+    trim_map_t map;
+    if (!g_trim || trim_plan_f32(wav, n, SAMPLE_RATE, &g_trim_opts, &map) != 0)
+        return asr_transcribe(wav, n, port, NULL, prompt, 0);
+
+    g_trim_in_sec += (double)n / SAMPLE_RATE;
+    float *trimmed = NULL;
+    if (map.n_dst > 0 && map.n_dst < n)
+        trimmed = (float *)malloc(map.n_dst * sizeof(float));
+    if (!trimmed) {
+        trim_map_free(&map);
+        return asr_transcribe(wav, n, port, NULL, prompt, 0);
+    }
+    trim_apply_f32(wav, &map, trimmed);
+    g_trim_saved_sec += (double)(n - map.n_dst) / SAMPLE_RATE;
+
+    AsrResult *r = asr_transcribe(trimmed, map.n_dst, port, NULL, prompt, 0);
+    free(trimmed);
+    if (r) {
+        for (int t = 0; t < r->ts_count; t++)
+            r->timestamps[t].audio_ms = trim_map_ms(&map, r->timestamps[t].audio_ms,
+                                                    SAMPLE_RATE);
+    }
+    trim_map_free(&map);
+    return r;
+}
+
+static void print_trim_report(void) {
+    if (g_mel && g_mel_pcm_bytes > 0) {
+        printf("  Features: uploaded %.1f KB vs %.1f KB of PCM (%.0f%%), "
+               "front-end %.0fms for the whole file\n",
+               g_mel_bytes / 1024.0, g_mel_pcm_bytes / 1024.0,
+               g_mel_bytes * 100.0 / g_mel_pcm_bytes, g_mel_ms);
+        g_mel_bytes = 0;
+        g_mel_pcm_bytes = 0;
+    }
+    if (g_blk_pcm && g_blk_pcm_bytes > 0) {
+        printf("  Blocks: uploaded %.1f KB vs %.1f KB of full windows (%.0f%%), "
+               "%d cache misses\n",
+               g_blk_bytes / 1024.0, g_blk_pcm_bytes / 1024.0,
+               g_blk_bytes * 100.0 / g_blk_pcm_bytes, g_blk_misses);
+        g_blk_bytes = 0;
+        g_blk_pcm_bytes = 0;
+        g_blk_misses = 0;
+    }
+    if (!g_trim) return;
+    printf("  Trim: saved %.1fs of %.1fs uploaded audio (%.0f%%)\n",
+           g_trim_saved_sec, g_trim_in_sec,
+           g_trim_in_sec > 0 ? g_trim_saved_sec * 100.0 / g_trim_in_sec : 0.0);
+    g_trim_in_sec = 0;
+    g_trim_saved_sec = 0;
+}
+
 /* ========================================================================
  * Approach 1: Retranscribe growing audio every N seconds
  *
@@ -140,7 +402,7 @@ static void test_retranscribe(int port, const float *wav, int n_samples,
         float audio_time = (float)cursor / SAMPLE_RATE;
 
         double t0 = now_ms();
-        AsrResult *r = asr_transcribe(wav, cursor, port, NULL, NULL, 0);
+        AsrResult *r = transcribe_window(wav, cursor, port, NULL);
         double elapsed = now_ms() - t0;
         total_transcribe_ms += elapsed;
 
@@ -165,6 +427,7 @@ static void test_retranscribe(int port, const float *wav, int n_samples,
     printf("\n  Final: %s\n", prev_text ? prev_text : "(empty)");
     printf("  Total transcription time: %.0fms for %.1fs audio (%.1fx overhead)\n",
            total_transcribe_ms, duration, total_transcribe_ms / (duration * 1000));
+    print_trim_report();
     printf("\n");
     free(prev_text);
 }
@@ -177,12 +440,19 @@ static void test_retranscribe(int port, const float *wav, int n_samples,
 #define VAD_MIN_SPEECH_SAMPLES (SAMPLE_RATE * 1)
 #define VAD_CHECK_MS          500
 
+static int g_spectral_vad = 0;
+
 static void test_vad(int port, const float *wav, int n_samples) {
     float duration = (float)n_samples / SAMPLE_RATE;
     int samples_per_tick = SAMPLE_RATE * VAD_CHECK_MS / 1000;
 
-    printf("--- VAD-gated (threshold=%.3f, silence_chunks=%d) ---\n\n",
-           SILENCE_THRESHOLD, VAD_SILENCE_TO_TRANSCRIBE);
+    if (g_spectral_vad)
+        printf("--- VAD-gated (spectral, silence_chunks=%d) ---\n\n",
+               VAD_SILENCE_TO_TRANSCRIBE);
+    else
+        printf("--- VAD-gated (threshold=%.3f, silence_chunks=%d) ---\n\n",
+               SILENCE_THRESHOLD, VAD_SILENCE_TO_TRANSCRIBE);
+    vad_t *vad = g_spectral_vad ? vad_create(SAMPLE_RATE) : NULL;
 
     float *audio_buf = (float *)calloc(SAMPLE_RATE * 120, sizeof(float));
     int audio_len = 0;
@@ -206,6 +476,11 @@ static void test_vad(int port, const float *wav, int n_samples) {
 
         float t = (float)end / SAMPLE_RATE;
         int is_speech = energy >= SILENCE_THRESHOLD;
+        if (vad) {
+            int speech_frames = 0;
+            vad_feed_f32(vad, wav + pos, chunk, &speech_frames);
+            is_speech = speech_frames > 0 || vad_active(vad);
+        }
 
         if (is_speech) {
             if (!vad_speech) vad_speech = 1;
@@ -249,6 +524,130 @@ static void test_vad(int port, const float *wav, int n_samples) {
     printf("\n  Segments: %d, Total transcription: %.0fms for %.1fs audio\n\n",
            segment_count, total_transcribe_ms, duration);
     free(audio_buf);
+    vad_destroy(vad);
+}
+
+/* ========================================================================
+ * VAD comparison: energy gate vs spectral VAD against hand labels
+ *
+ * Both detectors are run as they are used live and rasterised to
+ * VAD_HOP_MS frames: the energy gate decides whole VAD_CHECK_MS chunks,
+ * the spectral VAD decides each frame as it completes.
+ * ======================================================================== */
+#define VADCMP_HOP (SAMPLE_RATE * VAD_HOP_MS / 1000)
+
+typedef struct {
+    int tp, fp, fn, tn;
+    int onsets_false;       /* speech runs that touch no labelled speech */
+} vad_score_t;
+
+/* Speech spans from "<stem>.labels" (Audacity: start end [text] per line,
+ * seconds) as per-frame flags. Returns 0, or -1 if there is no label file. */
+static int read_vad_labels(const char *path, unsigned char *truth, int n_frames) {
+    char lp[1024];
+    snprintf(lp, sizeof(lp), "%s", path);
+    char *ext = strrchr(lp, '.');
+    if (ext && (ext - lp) + 8 < (int)sizeof(lp)) strcpy(ext, ".labels");
+    FILE *f = fopen(lp, "r");
+    if (!f) return -1;
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        double a, b;
+        if (sscanf(line, "%lf %lf", &a, &b) != 2) continue;
+        int fa = (int)(a * 1000.0 / VAD_HOP_MS), fb = (int)(b * 1000.0 / VAD_HOP_MS + 0.5);
+        if (fa < 0) fa = 0;
+        if (fb > n_frames) fb = n_frames;
+        for (int i = fa; i < fb; i++) truth[i] = 1;
+    }
+    fclose(f);
+    return 0;
+}
+
+static void score_vad(vad_score_t *s, const unsigned char *truth,
+                      const unsigned char *pred, int n_frames) {
+    memset(s, 0, sizeof(*s));
+    int run_start = -1, run_hit = 0;
+    for (int i = 0; i <= n_frames; i++) {
+        int p = i < n_frames && pred[i];
+        if (i < n_frames) {
+            int t = truth[i];
+            if (p && t) s->tp++;
+            else if (p) s->fp++;
+            else if (t) s->fn++;
+            else s->tn++;
+        }
+        if (p) {
+            if (run_start < 0) { run_start = i; run_hit = 0; }
+            if (truth[i]) run_hit = 1;
+        } else if (run_start >= 0) {
+            if (!run_hit) s->onsets_false++;
+            run_start = -1;
+        }
+    }
+}
+
+static void print_vad_score(const char *name, const vad_score_t *s) {
+    double prec = s->tp + s->fp ? (double)s->tp / (s->tp + s->fp) : 0.0;
+    double rec = s->tp + s->fn ? (double)s->tp / (s->tp + s->fn) : 0.0;
+    double f1 = prec + rec > 0 ? 2 * prec * rec / (prec + rec) : 0.0;
+    printf("  %-9s precision %5.1f%%  recall %5.1f%%  F1 %.3f  "
+           "false %5.1fs (%d triggers)  missed %5.1fs\n",
+           name, prec * 100, rec * 100, f1, s->fp * VAD_HOP_MS / 1000.0,
+           s->onsets_false, s->fn * VAD_HOP_MS / 1000.0);
+}
+
+static void test_vad_compare(const char *path, const float *wav, int n_samples) {
+    int n_frames = n_samples / VADCMP_HOP;
+    if (n_frames <= 0) return;
+    unsigned char *truth = (unsigned char *)calloc(n_frames, 1);
+    unsigned char *gate = (unsigned char *)calloc(n_frames, 1);
+    unsigned char *spec = (unsigned char *)calloc(n_frames, 1);
+
+    int chunk = SAMPLE_RATE * VAD_CHECK_MS / 1000;
+    for (int pos = 0; pos < n_samples; pos += chunk) {
+        int end = pos + chunk < n_samples ? pos + chunk : n_samples;
+        float energy = 0;
+        for (int i = pos; i < end; i++) energy += fabsf(wav[i]);
+        if (energy / (end - pos) < SILENCE_THRESHOLD) continue;
+        for (int fi = pos / VADCMP_HOP; fi < end / VADCMP_HOP && fi < n_frames; fi++)
+            gate[fi] = 1;
+    }
+
+    vad_t *vad = vad_create(SAMPLE_RATE);
+    double t0 = now_ms();
+    for (int fi = 0; fi < n_frames; fi++) {
+        int speech_frames = 0;
+        vad_feed_f32(vad, wav + fi * VADCMP_HOP, VADCMP_HOP, &speech_frames);
+        spec[fi] = speech_frames > 0;
+    }
+    double vad_ms = now_ms() - t0;
+    vad_destroy(vad);
+
+    double dur = (double)n_samples / SAMPLE_RATE;
+    printf("--- VAD compare (%d frames of %dms) ---\n\n", n_frames, VAD_HOP_MS);
+    if (read_vad_labels(path, truth, n_frames) == 0) {
+        vad_score_t sg, ss;
+        score_vad(&sg, truth, gate, n_frames);
+        score_vad(&ss, truth, spec, n_frames);
+        print_vad_score("energy", &sg);
+        print_vad_score("spectral", &ss);
+    } else {
+        int agree = 0, n_gate = 0, n_spec = 0;
+        for (int i = 0; i < n_frames; i++) {
+            agree += gate[i] == spec[i];
+            n_gate += gate[i];
+            n_spec += spec[i];
+        }
+        printf("  No labels; speech energy %.1fs, spectral %.1fs, agreement %.1f%%\n",
+               n_gate * VAD_HOP_MS / 1000.0, n_spec * VAD_HOP_MS / 1000.0,
+               agree * 100.0 / n_frames);
+    }
+    printf("  Spectral VAD cost: %.1fms for %.1fs audio (%.3f%% of a core)\n\n",
+           vad_ms, dur, vad_ms / (dur * 10.0));
+
+    free(truth);
+    free(gate);
+    free(spec);
 }
 
 /* ========================================================================
@@ -402,8 +801,8 @@ static void test_sim(int port, const float *wav, int n_samples,
         pass_num++;
 
         double t0 = now_ms();
-        AsrResult *ar = asr_transcribe(wav + start, ws, port, NULL,
-                                       prompt[0] ? prompt : NULL, 0);
+        AsrResult *ar = transcribe_window(wav + start, ws, port,
+                                          prompt[0] ? prompt : NULL);
         double elapsed = now_ms() - t0;
         total_transcribe_ms += elapsed;
 
@@ -628,8 +1027,1284 @@ static void test_sim(int port, const float *wav, int n_samples,
         if (recording_samples >= n_samples) break;
     }
 
-    printf("\n  Total transcription: %.0fms for %.1fs audio (%.1fx overhead)\n\n",
+    printf("\n  Total transcription: %.0fms for %.1fs audio (%.1fx overhead)\n",
            total_transcribe_ms, duration, total_transcribe_ms / (duration * 1000));
+    print_trim_report();
+    printf("\n");
+}
+
+/* ========================================================================
+ * Replay: re-score a recorded session without the server
+ *
+ * Walks the session archive in order, printing each pass and commit with
+ * its wall-clock time, then summarizes upload overhead, latency, interim
+ * rewrites (a pass that does not extend the previous pass's text) and the
+ * lag between the end of committed audio and the commit itself.
+ * ======================================================================== */
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void test_replay(const char *path) {
+    sess_reader_t *r = sess_reader_open(path);
+    if (!r) { fprintf(stderr, "Not a session archive: %s\n", path); return; }
+    int sr = sess_reader_sample_rate(r);
+    int count = sess_reader_count(r);
+
+    printf("--- Replay (%d records, %d Hz) ---\n\n", count, sr);
+
+    double *latency = (double *)malloc((count > 0 ? count : 1) * sizeof(double));
+    int passes = 0, rewrites = 0, commits = 0;
+    long long recorded = 0;
+    double uploaded_sec = 0, server_ms = 0, lag_sum = 0;
+    char *prev_text = NULL;
+    long long prev_start = -1;
+    char transcript[65536] = "";
+    size_t tlen = 0;
+
+    for (int i = 0; i < count; i++) {
+        sess_record_t rec;
+        if (sess_reader_get(r, i, &rec) != 0) break;
+        double t = rec.t_ms / 1000.0;
+
+        if (rec.type == SESS_REC_AUDIO) {
+            long long end = *(const long long *)rec.data + (rec.len - 8) / 2;
+            if (end > recorded) recorded = end;
+        } else if (rec.type == SESS_REC_EVENT) {
+            const char *tag, *detail;
+            if (sess_parse_event(&rec, &tag, &detail) == 0)
+                printf("[%6.1fs] %-6s %s\n", t, tag, detail);
+        } else if (rec.type == SESS_REC_PASS) {
+            sess_pass_t meta;
+            AsrResult *ar = NULL;
+            if (sess_parse_pass(&rec, &meta, &ar) != 0) continue;
+            latency[passes++] = meta.client_ms;
+            uploaded_sec += (double)meta.window_samples / sr;
+            server_ms += ar->perf_total_ms;
+
+            /* Same window start: the new text should extend the old */
+            if (prev_text && meta.window_start == prev_start) {
+                size_t pl = strlen(prev_text);
+                if (_strnicmp(ar->text, prev_text, pl) != 0) rewrites++;
+            }
+            free(prev_text);
+            prev_text = _strdup(ar->text);
+            prev_start = meta.window_start;
+
+            printf("[%6.1fs] pass#%-3d %s win %.1f-%.1fs %4.0fms (srv %4.0fms) %s\n",
+                   t, meta.pass_no, meta.is_final ? "FINAL" : "     ",
+                   (double)meta.window_start / sr,
+                   (double)(meta.window_start + meta.window_samples) / sr,
+                   meta.client_ms, ar->perf_total_ms, ar->text);
+            asr_free_result(ar);
+        } else if (rec.type == SESS_REC_COMMIT) {
+            long long from, to;
+            const char *text;
+            if (sess_parse_commit(&rec, &from, &to, &text) != 0) continue;
+            commits++;
+            lag_sum += t - (double)to / sr;
+            printf("[%6.1fs] COMMIT %.1f-%.1fs [You] %s\n",
+                   t, (double)from / sr, (double)to / sr, text);
+            size_t n = strlen(text);
+            if (tlen + n + 2 < sizeof(transcript)) {
+                if (tlen > 0) transcript[tlen++] = ' ';
+                memcpy(transcript + tlen, text, n + 1);
+                tlen += n;
+            }
+        }
+    }
+
+    double rec_sec = (double)recorded / (sr > 0 ? sr : 1);
+    printf("\n  Recorded: %.1fs audio, %d passes, %d commits\n", rec_sec, passes, commits);
+    if (passes > 0) {
+        qsort(latency, passes, sizeof(double), cmp_double);
+        double mean = 0;
+        for (int i = 0; i < passes; i++) mean += latency[i];
+        mean /= passes;
+        printf("  Uploaded: %.1fs (%.1fx recorded), server %.0fms total\n",
+               uploaded_sec, rec_sec > 0 ? uploaded_sec / rec_sec : 0.0, server_ms);
+        printf("  Pass latency: mean %.0fms, p50 %.0fms, p95 %.0fms\n",
+               mean, latency[passes / 2], latency[(passes * 95) / 100 < passes
+                                                   ? (passes * 95) / 100 : passes - 1]);
+        printf("  Interim rewrites: %d of %d passes\n", rewrites, passes);
+    }
+    if (commits > 0)
+        printf("  Commit lag: mean %.2fs after the committed audio\n", lag_sum / commits);
+    printf("\n  Transcript: %s\n\n", transcript[0] ? transcript : "(empty)");
+
+    free(prev_text);
+    free(latency);
+    sess_reader_close(r);
+}
+
+/* ========================================================================
+ * Pack: compress a recording to .lac
+ *
+ * Samples come back through read_wav_f32, which is exact for 16 kHz
+ * 16-bit sources (the recordings/ format). The WAV is kept.
+ * ======================================================================== */
+static void pack_lac(const char *path, const float *wav, int n_samples) {
+    char out[1024];
+    snprintf(out, sizeof(out), "%s", path);
+    char *ext = strrchr(out, '.');
+    if (ext && (ext - out) + 5 < (int)sizeof(out)) strcpy(ext, ".lac");
+    if (strcmp(out, path) == 0) {
+        printf("--- Pack: input is already .lac ---\n\n");
+        return;
+    }
+
+    double t0 = now_ms();
+    lac_writer_t *w = lac_writer_open(out, SAMPLE_RATE);
+    if (!w) { fprintf(stderr, "Cannot create %s\n", out); return; }
+    short buf[4096];
+    int rc = 0;
+    for (int i = 0; i < n_samples && rc == 0; i += 4096) {
+        int take = n_samples - i < 4096 ? n_samples - i : 4096;
+        f32_to_s16(wav + i, take, buf);
+        rc = lac_writer_write(w, buf, take);
+    }
+    long long bytes = lac_writer_bytes(w);
+    if (lac_writer_close(w) < 0 || rc != 0) {
+        fprintf(stderr, "Pack failed: %s\n", out);
+        DeleteFileA(out);
+        return;
+    }
+    double wav_bytes = 44.0 + 2.0 * n_samples;
+    printf("--- Pack ---\n\n  %s: %.1f KB -> %.1f KB (%.0f%%) in %.0fms\n\n",
+           out, wav_bytes / 1024.0, bytes / 1024.0, bytes * 100.0 / wav_bytes,
+           now_ms() - t0);
+}
+
+/* ========================================================================
+ * Seeds: bulk seed screening for the TTS voices
+ *
+ * A locked seed speaks every drill sentence, so each (voice, seed)
+ * candidate speaks every sentence of the given banks (drill format
+ * "chinese|pinyin|english", # comments), --jobs requests at a time. Takes
+ * are scored on failures, clipping, near-silence and pacing: a take's
+ * length against the median of that voice's candidates for the same
+ * sentence, so a seed that rushes, drags or truncates stands out. With
+ * --out every take is written as <voice>_<seed>_<sentence>.wav to listen to
+ * the best few.
+ * ======================================================================== */
+#define SEEDS_MAX_VOICES     16
+#define SEEDS_MAX_CANDIDATES 32
+#define SEEDS_MAX_SENTENCES  4096
+#define SEEDS_MAX_JOBS       16
+#define SEEDS_SILENT_DB      (-50.0)
+
+typedef struct {
+    int      ok;
+    double   latency_ms;
+    int      sr, n;
+    double   peak_db, rms_db;
+    int      clipped;           /* samples at full scale */
+} SeedTake;
+
+typedef struct {
+    int          port;
+    const char  *voices[SEEDS_MAX_VOICES];
+    int          n_voices;
+    int          seeds[SEEDS_MAX_VOICES][SEEDS_MAX_CANDIDATES];
+    int          n_seeds;
+    char        *sentences[SEEDS_MAX_SENTENCES];
+    int          n_sentences;
+    const char  *out_dir;
+    SeedTake    *takes;         /* [voice][seed][sentence] */
+    volatile LONG next;         /* next take to synthesize */
+    volatile LONG done;
+} SeedRun;
+
+static SeedRun g_seed_run;
+
+/* PCM gathered from one response */
+typedef struct {
+    int16_t *pcm;
+    int      n, cap, sr;
+} SeedPcm;
+
+static int seed_pcm_cb(void *ctx, const int16_t *samples, int n, int sample_rate) {
+    SeedPcm *p = (SeedPcm *)ctx;
+    if (p->n + n > p->cap) {
+        int cap = p->cap ? p->cap : 65536;
+        while (cap < p->n + n) cap *= 2;
+        int16_t *grown = (int16_t *)realloc(p->pcm, cap * sizeof(int16_t));
+        if (!grown) return 1;
+        p->pcm = grown;
+        p->cap = cap;
+    }
+    memcpy(p->pcm + p->n, samples, n * sizeof(int16_t));
+    p->n += n;
+    p->sr = sample_rate;
+    return 0;
+}
+
+/* Bounded search for key in [p, end) */
+static const char *find_in(const char *p, const char *end, const char *key) {
+    size_t k = strlen(key);
+    for (; p + k <= end; p++)
+        if (memcmp(p, key, k) == 0) return p;
+    return NULL;
+}
+
+/* Value after "key": inside [p, end), or NULL */
+static const char *json_value_in(const char *p, const char *end, const char *key) {
+    char pattern[32];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    p = find_in(p, end, pattern);
+    if (!p) return NULL;
+    p += strlen(pattern);
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p < end ? p : NULL;
+}
+
+/* The "words":[{"word":..,"start":s,"end":s},..] array of a timestamped
+ * response (malloc'd, caller frees). Returns the count. */
+static int seed_parse_words(const char *json, int len, tts_word_t **out) {
+    *out = NULL;
+    const char *end = json + len;
+    const char *p = json_value_in(json, end, "words");
+    if (!p || *p != '[') return 0;
+    int n = 0, cap = 0;
+    tts_word_t *words = NULL;
+    for (p++; p < end && *p != ']'; ) {
+        if (*p != '{') { p++; continue; }
+        const char *close = memchr(p, '}', end - p);
+        if (!close) break;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 32;
+            tts_word_t *grown = (tts_word_t *)realloc(words, cap * sizeof(tts_word_t));
+            if (!grown) break;
+            words = grown;
+        }
+        tts_word_t *w = &words[n++];
+        memset(w, 0, sizeof(*w));
+        const char *v = json_value_in(p, close, "word");
+        if (v && *v == '"') {
+            int k = 0;
+            for (v++; v < close && *v != '"' && k < (int)sizeof(w->word) - 1; v++) {
+                if (*v == '\\' && v + 1 < close) v++;
+                w->word[k++] = *v;
+            }
+        }
+        v = json_value_in(p, close, "start");
+        if (v) w->start_ms = (int)(atof(v) * 1000.0);
+        v = json_value_in(p, close, "end");
+        if (v) w->end_ms = (int)(atof(v) * 1000.0);
+        p = close + 1;
+    }
+    if (n == 0) { free(words); words = NULL; }
+    *out = words;
+    return n;
+}
+
+/* POST body to /v1/audio/speech, decoding the response into pcm and, if
+ * words is given, the word timestamps into *words / *n_words (caller
+ * frees). Returns 0 on success. */
+static int seed_synthesize(int port, const char *body, SeedPcm *pcm,
+                           tts_word_t **words, int *n_words) {
+    if (words) { *words = NULL; *n_words = 0; }
+    HINTERNET hs = WinHttpOpen(L"VoiceTestHeadless/1.0", WINHTTP_ACCESS_TYPE_NO_PROXY,
+                               WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+    if (!hs) return -1;
+    HINTERNET hc = WinHttpConnect(hs, L"localhost", (INTERNET_PORT)port, 0);
+    HINTERNET hr = hc ? WinHttpOpenRequest(hc, L"POST", L"/v1/audio/speech", NULL,
+                                           WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, 0)
+                      : NULL;
+    tts_stream_t *st = tts_stream_new(seed_pcm_cb, pcm);
+    int rc = -1;
+    if (hr && st) {
+        WinHttpSetTimeouts(hr, 5000, 5000, 120000, 120000);
+        DWORD len = (DWORD)strlen(body);
+        DWORD status = 0, sz = sizeof(status);
+        if (WinHttpSendRequest(hr, L"Content-Type: application/json\r\n", (DWORD)-1L,
+                               (LPVOID)body, len, len, 0)
+            && WinHttpReceiveResponse(hr, NULL)
+            && WinHttpQueryHeaders(hr, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                   NULL, &status, &sz, NULL)
+            && status == 200) {
+            char chunk[16384];
+            DWORD got = 0;
+            while (WinHttpReadData(hr, chunk, sizeof(chunk), &got)) {
+                if (got == 0) { rc = tts_stream_finish(st); break; }
+                if (tts_stream_feed(st, chunk, (int)got) != 0) break;
+            }
+        }
+    }
+    int json_len = 0;
+    const char *json = st ? tts_stream_json(st, &json_len) : NULL;
+    if (rc == 0 && words && json) *n_words = seed_parse_words(json, json_len, words);
+    tts_stream_free(st);
+    if (hr) WinHttpCloseHandle(hr);
+    if (hc) WinHttpCloseHandle(hc);
+    WinHttpCloseHandle(hs);
+    return rc;
+}
+
+static void seed_write_wav(const char *path, const int16_t *pcm, int n, int sr) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return;
+    unsigned int data = (unsigned int)n * 2, riff = 36 + data, fmt = 16, rate = (unsigned int)sr;
+    unsigned int byte_rate = rate * 2;
+    unsigned short pcm_fmt = 1, ch = 1, align = 2, bits = 16;
+    fwrite("RIFF", 1, 4, f); fwrite(&riff, 4, 1, f); fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt, 4, 1, f); fwrite(&pcm_fmt, 2, 1, f); fwrite(&ch, 2, 1, f);
+    fwrite(&rate, 4, 1, f); fwrite(&byte_rate, 4, 1, f); fwrite(&align, 2, 1, f);
+    fwrite(&bits, 2, 1, f); fwrite("data", 1, 4, f); fwrite(&data, 4, 1, f);
+    fwrite(pcm, 2, n, f);
+    fclose(f);
+}
+
+static void seed_run_take(int idx) {
+    SeedRun *r = &g_seed_run;
+    int sentence = idx % r->n_sentences;
+    int cand = idx / r->n_sentences % r->n_seeds;
+    int voice = idx / r->n_sentences / r->n_seeds;
+    int seed = r->seeds[voice][cand];
+    SeedTake *t = &r->takes[idx];
+
+    char body[8192];
+    int fits = tts_build_body(r->sentences[sentence], r->voices[voice], seed, 0, 0,
+                              body, sizeof(body)) == 0;
+
+    SeedPcm pcm = {0};
+    double t0 = now_ms();
+    t->ok = fits && seed_synthesize(r->port, body, &pcm, NULL, NULL) == 0 && pcm.n > 0;
+    t->latency_ms = now_ms() - t0;
+    if (t->ok) {
+        t->sr = pcm.sr;
+        t->n = pcm.n;
+        int peak = 0;
+        double sq = 0;
+        for (int i = 0; i < pcm.n; i++) {
+            int a = abs(pcm.pcm[i]);
+            if (a > peak) peak = a;
+            if (a >= 32767) t->clipped++;
+            sq += (double)pcm.pcm[i] * pcm.pcm[i];
+        }
+        t->peak_db = 20.0 * log10((peak + 1) / 32768.0);
+        t->rms_db = 10.0 * log10(sq / pcm.n / (32768.0 * 32768.0) + 1e-12);
+        if (r->out_dir) {
+            char path[MAX_PATH];
+            snprintf(path, sizeof(path), "%s\\%s_%d_%03d.wav",
+                     r->out_dir, r->voices[voice], seed, sentence + 1);
+            seed_write_wav(path, pcm.pcm, pcm.n, pcm.sr);
+        }
+    }
+    free(pcm.pcm);
+
+    LONG done = InterlockedIncrement(&r->done);
+    fprintf(stderr, "\r  %ld/%d takes", done,
+            r->n_voices * r->n_seeds * r->n_sentences);
+}
+
+static DWORD WINAPI seed_worker(LPVOID param) {
+    (void)param;
+    int total = g_seed_run.n_voices * g_seed_run.n_seeds * g_seed_run.n_sentences;
+    for (;;) {
+        LONG idx = InterlockedIncrement(&g_seed_run.next) - 1;
+        if (idx >= total) break;
+        seed_run_take((int)idx);
+    }
+    return 0;
+}
+
+/* Add the sentences of a drill bank. Returns the number added. */
+static int seed_load_bank(SeedRun *r, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) { fprintf(stderr, "Cannot open %s\n", path); return 0; }
+    char line[2048];
+    int added = 0;
+    while (r->n_sentences < SEEDS_MAX_SENTENCES && fgets(line, sizeof(line), f)) {
+        char *bar = strchr(line, '|');
+        if (bar) *bar = '\0';
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!line[0] || line[0] == '#') continue;
+        r->sentences[r->n_sentences++] = _strdup(line);
+        added++;
+    }
+    fclose(f);
+    return added;
+}
+
+typedef struct {
+    int    seed;
+    int    fails, silent, clipped;
+    double pace_dev;            /* mean |length / median - 1| */
+    double latency_ms;
+} SeedScore;
+
+static int cmp_seed_score(const void *a, const void *b) {
+    const SeedScore *x = (const SeedScore *)a, *y = (const SeedScore *)b;
+    if (x->fails + x->silent != y->fails + y->silent)
+        return (x->fails + x->silent) - (y->fails + y->silent);
+    if ((x->clipped > 0) != (y->clipped > 0)) return x->clipped > 0 ? 1 : -1;
+    return x->pace_dev < y->pace_dev ? -1 : x->pace_dev > y->pace_dev;
+}
+
+static void test_seeds(int port, int jobs) {
+    SeedRun *r = &g_seed_run;
+    r->port = port;
+    int total = r->n_voices * r->n_seeds * r->n_sentences;
+    printf("--- Seed screening (%d voices x %d seeds x %d sentences, %d jobs, port=%d) ---\n\n",
+           r->n_voices, r->n_seeds, r->n_sentences, jobs, port);
+    r->takes = (SeedTake *)calloc(total, sizeof(SeedTake));
+    if (!r->takes) return;
+
+    HANDLE threads[SEEDS_MAX_JOBS];
+    int n_threads = 0;
+    double t0 = now_ms();
+    for (int j = 0; j < jobs; j++) {
+        threads[n_threads] = CreateThread(NULL, 0, seed_worker, NULL, 0, NULL);
+        if (threads[n_threads]) n_threads++;
+    }
+    if (n_threads == 0) seed_worker(NULL);
+    WaitForMultipleObjects(n_threads, threads, TRUE, INFINITE);
+    for (int j = 0; j < n_threads; j++) CloseHandle(threads[j]);
+    double wall_ms = now_ms() - t0;
+    fprintf(stderr, "\n");
+
+    double audio_sec = 0, lat_sum = 0;
+    int ok = 0;
+    double *lens = (double *)malloc(r->n_seeds * sizeof(double));
+    SeedScore *scores = (SeedScore *)malloc(r->n_seeds * sizeof(SeedScore));
+    double *medians = (double *)malloc(r->n_sentences * sizeof(double));
+    for (int v = 0; v < r->n_voices && lens && scores && medians; v++) {
+        SeedTake *vt = r->takes + (size_t)v * r->n_seeds * r->n_sentences;
+
+        /* Median length per sentence across this voice's candidates */
+        for (int s = 0; s < r->n_sentences; s++) {
+            int k = 0;
+            for (int c = 0; c < r->n_seeds; c++) {
+                SeedTake *t = &vt[c * r->n_sentences + s];
+                if (t->ok && t->rms_db > SEEDS_SILENT_DB) lens[k++] = (double)t->n / t->sr;
+            }
+            qsort(lens, k, sizeof(double), cmp_double);
+            medians[s] = k ? (k & 1 ? lens[k / 2] : (lens[k / 2 - 1] + lens[k / 2]) / 2) : 0;
+        }
+
+        for (int c = 0; c < r->n_seeds; c++) {
+            SeedScore *sc = &scores[c];
+            memset(sc, 0, sizeof(*sc));
+            sc->seed = r->seeds[v][c];
+            int paced = 0, timed = 0;
+            for (int s = 0; s < r->n_sentences; s++) {
+                SeedTake *t = &vt[c * r->n_sentences + s];
+                if (!t->ok) { sc->fails++; continue; }
+                ok++;
+                audio_sec += (double)t->n / t->sr;
+                lat_sum += t->latency_ms;
+                sc->latency_ms += t->latency_ms;
+                timed++;
+                if (t->rms_db <= SEEDS_SILENT_DB) { sc->silent++; continue; }
+                if (t->clipped) sc->clipped++;
+                if (medians[s] > 0) {
+                    sc->pace_dev += fabs((double)t->n / t->sr / medians[s] - 1.0);
+                    paced++;
+                }
+            }
+            if (paced) sc->pace_dev /= paced;
+            if (timed) sc->latency_ms /= timed;
+        }
+        qsort(scores, r->n_seeds, sizeof(SeedScore), cmp_seed_score);
+
+        printf("  %s\n", r->voices[v]);
+        printf("    %10s  %5s  %6s  %7s  %8s  %8s\n",
+               "seed", "fails", "silent", "clipped", "pace dev", "mean ms");
+        for (int c = 0; c < r->n_seeds; c++) {
+            SeedScore *sc = &scores[c];
+            printf("    %10d  %5d  %6d  %7d  %7.1f%%  %8.0f%s\n",
+                   sc->seed, sc->fails, sc->silent, sc->clipped, sc->pace_dev * 100.0,
+                   sc->latency_ms, c == 0 ? "  <- best" : "");
+        }
+        printf("\n");
+    }
+    free(lens);
+    free(scores);
+    free(medians);
+
+    printf("  %d/%d takes in %.1fs: %.2f takes/s, %.1fs audio, mean latency %.0fms\n\n",
+           ok, total, wall_ms / 1000.0, total * 1000.0 / wall_ms, audio_sec,
+           ok ? lat_sum / ok : 0.0);
+    free(r->takes);
+    r->takes = NULL;
+}
+
+/* ========================================================================
+ * Warm: fill the GUI's on-disk TTS caches for drill banks
+ *
+ * Every sentence of the given banks is synthesized in every (voice, seed)
+ * pair -- the listed voices under --seed-list, or under the seeds locked in
+ * the GUI's tts_cache\seeds.txt -- with word timestamps, the way the GUI
+ * requests a locked take, and filed in the take store (tts_cache\audio) and
+ * the grouping index (tts_cache\groupings.idx). Keys already on disk are
+ * skipped and each take is committed as it lands, so a stopped run resumes
+ * where it left off. Jobs run sentence by sentence, so a partial run covers
+ * the start of each bank in every voice. --jobs requests run at once,
+ * spread over the --ports servers; a failed take is retried once on the
+ * next server. With no seed at all only the groupings are fetched (first
+ * voice, random seed), as the GUI's prefetch does.
+ * ======================================================================== */
+#define WARM_MAX_PORTS   8
+#define WARM_MAX_PAIRS   (SEEDS_MAX_VOICES * SEEDS_MAX_CANDIDATES)
+#define WARM_ATTEMPTS    2
+#define WARM_STORE_FULL  (TTS_STORE_BYTES / 8 * 7)   /* below the GUI's trim */
+
+typedef struct {
+    int sentence;
+    int pair;               /* index into pairs */
+} WarmJob;
+
+typedef struct {
+    int          ports[WARM_MAX_PORTS];
+    int          n_ports;
+    const char  *model;
+    tts_store_t *store;
+    gidx_t      *groupings;
+    const char  *pair_voice[WARM_MAX_PAIRS];
+    int          pair_seed[WARM_MAX_PAIRS];     /* -1: groupings only */
+    int          n_pairs;
+    WarmJob     *jobs;
+    int          n_jobs;
+    volatile LONG next;
+    volatile LONG done, cached, fetched, failed;
+    volatile LONG over_cap;                     /* takes left out: store full */
+    volatile LONG audio_ms;                     /* of the fetched takes */
+    volatile LONG port_takes[WARM_MAX_PORTS];
+    volatile LONG port_fails[WARM_MAX_PORTS];
+    double       t0;
+} WarmRun;
+
+static WarmRun g_warm;
+
+static int warm_has_grouping(const char *text) {
+    tts_word_t *words = NULL;
+    int n = 0;
+    int hit = gidx_get(g_warm.groupings, text, &words, &n) && n > 0;
+    free(words);
+    return hit;
+}
+
+static void warm_progress(void) {
+    WarmRun *w = &g_warm;
+    LONG done = InterlockedCompareExchange(&w->done, 0, 0);
+    double sec = (now_ms() - w->t0) / 1000.0;
+    double rate = sec > 0 ? done / sec : 0;
+    double eta = rate > 0 ? (w->n_jobs - done) / rate : 0;
+    fprintf(stderr, "\r  %ld/%d  (%ld new, %ld cached, %ld failed)  %.2f/s  %.1fx realtime  ETA %dm%02ds ",
+            done, w->n_jobs, w->fetched, w->cached, w->failed, rate,
+            sec > 0 ? w->audio_ms / 1000.0 / sec : 0.0,
+            (int)eta / 60, (int)eta % 60);
+}
+
+static void warm_run_job(const WarmJob *job, int slot) {
+    WarmRun *w = &g_warm;
+    const char *text = g_seed_run.sentences[job->sentence];
+    const char *voice = w->pair_voice[job->pair];
+    int seed = w->pair_seed[job->pair];
+
+    /* Already warm? A stored take also carries the groupings if the index
+     * lost them. */
+    int cached = 0;
+    if (seed >= 0) {
+        tts_clip_t *have = tts_store_get(w->store, text, voice, seed, w->model);
+        if (have) {
+            if (have->word_count > 0 && !warm_has_grouping(text))
+                gidx_put(w->groupings, text, have->words, have->word_count);
+            tts_clip_release(have);
+            cached = 1;
+        }
+    } else {
+        cached = warm_has_grouping(text);
+    }
+    if (cached) {
+        InterlockedIncrement(&w->cached);
+        InterlockedIncrement(&w->done);
+        warm_progress();
+        return;
+    }
+    /* A take past the GUI's cap would only push out one warmed earlier
+     * (or this one) at the GUI's next trim. The margin covers the takes
+     * still in flight. */
+    if (seed >= 0 && tts_store_bytes(w->store) >= (long long)WARM_STORE_FULL) {
+        InterlockedIncrement(&w->over_cap);
+        InterlockedIncrement(&w->done);
+        warm_progress();
+        return;
+    }
+
+    char body[8192];
+    SeedPcm pcm = {0};
+    tts_word_t *words = NULL;
+    int n_words = 0, ok = 0;
+    int fits = tts_build_body(text, voice, seed, 1, 0, body, sizeof(body)) == 0;
+    for (int attempt = 0; fits && attempt < WARM_ATTEMPTS && !ok; attempt++) {
+        int p = (slot + attempt) % w->n_ports;
+        pcm.n = 0;
+        ok = seed_synthesize(w->ports[p], body, &pcm, &words, &n_words) == 0 && pcm.n > 0;
+        InterlockedIncrement(ok ? &w->port_takes[p] : &w->port_fails[p]);
+        if (!ok) {
+            free(words);
+            words = NULL;
+        }
+    }
+
+    if (ok && seed >= 0
+        && tts_store_put(w->store, text, voice, seed, w->model, pcm.pcm, pcm.n, pcm.sr,
+                         words, n_words) != 0)
+        ok = 0;
+    if (ok && n_words > 0 && !warm_has_grouping(text)
+        && gidx_put(w->groupings, text, words, n_words) != 0)
+        ok = 0;
+    if (ok) {
+        InterlockedIncrement(&w->fetched);
+        InterlockedExchangeAdd(&w->audio_ms, (LONG)((double)pcm.n * 1000.0 / pcm.sr));
+    } else {
+        InterlockedIncrement(&w->failed);
+        fprintf(stderr, "\n  Failed: %s seed %d, sentence %d\n", voice, seed, job->sentence + 1);
+    }
+    free(words);
+    free(pcm.pcm);
+    InterlockedIncrement(&w->done);
+    warm_progress();
+}
+
+static DWORD WINAPI warm_worker(LPVOID param) {
+    int slot = (int)(INT_PTR)param;
+    for (;;) {
+        LONG idx = InterlockedIncrement(&g_warm.next) - 1;
+        if (idx >= g_warm.n_jobs) break;
+        warm_run_job(&g_warm.jobs[idx], slot);
+    }
+    return 0;
+}
+
+/* Seeds locked in the GUI (seeds.txt lines "voice<TAB>seed") for the
+ * voices of the run, as pairs. Returns the number added. */
+static int warm_load_locked(WarmRun *w, const char *cache_dir) {
+    char path[MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\seeds.txt", cache_dir);
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    char line[256], name[64];
+    int seed, added = 0;
+    while (fgets(line, sizeof(line), f) && w->n_pairs < WARM_MAX_PAIRS) {
+        if (sscanf(line, "%63s %d", name, &seed) != 2 || seed < 0) continue;
+        for (int v = 0; v < g_seed_run.n_voices; v++) {
+            if (strcmp(g_seed_run.voices[v], name) != 0) continue;
+            w->pair_voice[w->n_pairs] = g_seed_run.voices[v];
+            w->pair_seed[w->n_pairs++] = seed;
+            added++;
+        }
+    }
+    fclose(f);
+    return added;
+}
+
+/* ports: "8090,8091" or NULL for port alone. seed_list: as for seeds mode,
+ * or NULL for the locked seeds. Returns 0, or -1 if the caches can't be
+ * opened. */
+static int test_warm(const char *ports, int port, const char *seed_list,
+                     const char *cache_dir, const char *model, int jobs) {
+    WarmRun *w = &g_warm;
+    SeedRun *r = &g_seed_run;
+    w->model = model;
+    if (ports) {
+        char *list = _strdup(ports);
+        for (char *t = strtok(list, ","); t && w->n_ports < WARM_MAX_PORTS; t = strtok(NULL, ","))
+            if (atoi(t) > 0) w->ports[w->n_ports++] = atoi(t);
+        free(list);
+    }
+    if (w->n_ports == 0) w->ports[w->n_ports++] = port;
+
+    if (seed_list) {
+        char *list = _strdup(seed_list);
+        for (char *t = strtok(list, ","); t; t = strtok(NULL, ","))
+            for (int v = 0; v < r->n_voices && w->n_pairs < WARM_MAX_PAIRS; v++) {
+                w->pair_voice[w->n_pairs] = r->voices[v];
+                w->pair_seed[w->n_pairs++] = atoi(t);
+            }
+        free(list);
+    } else {
+        warm_load_locked(w, cache_dir);
+    }
+    int groupings_only = w->n_pairs == 0;
+    if (groupings_only) {
+        w->pair_voice[0] = r->voices[0];
+        w->pair_seed[0] = -1;
+        w->n_pairs = 1;
+    }
+
+    char path[MAX_PATH];
+    CreateDirectoryA(cache_dir, NULL);
+    snprintf(path, sizeof(path), "%s\\audio", cache_dir);
+    w->store = tts_store_open(path, TTS_STORE_BYTES);
+    snprintf(path, sizeof(path), "%s\\groupings.idx", cache_dir);
+    w->groupings = gidx_open(path);
+    if (!w->store || !w->groupings) {
+        fprintf(stderr, "Cannot open the caches in %s\n", cache_dir);
+        tts_store_close(w->store);
+        gidx_close(w->groupings);
+        return -1;
+    }
+
+    w->n_jobs = r->n_sentences * w->n_pairs;
+    w->jobs = (WarmJob *)malloc(w->n_jobs * sizeof(WarmJob));
+    if (!w->jobs) {
+        tts_store_close(w->store);
+        gidx_close(w->groupings);
+        return -1;
+    }
+    for (int s = 0, k = 0; s < r->n_sentences; s++)
+        for (int p = 0; p < w->n_pairs; p++, k++) {
+            w->jobs[k].sentence = s;
+            w->jobs[k].pair = p;
+        }
+
+    printf("--- Cache warm-up (%d sentences x %d voice/seed pairs, %d jobs, %d server%s, model %s) ---\n",
+           r->n_sentences, w->n_pairs, jobs, w->n_ports, w->n_ports > 1 ? "s" : "", model);
+    printf("  Cache: %s (%d groupings)\n", cache_dir, gidx_count(w->groupings));
+    /* Trim as the GUI does at startup, before warming: it sizes the store
+     * for the cap check, and only takes from before this run can go */
+    int dropped = tts_store_trim(w->store);
+    printf("  Take store: %.1f MB of the GUI's %llu MB\n",
+           tts_store_bytes(w->store) / (1024.0 * 1024.0), TTS_STORE_BYTES >> 20);
+    if (dropped > 0)
+        printf("  %d least recently used takes dropped to get under it\n", dropped);
+    if (groupings_only)
+        printf("  No seeds for these voices (none locked in seeds.txt): groupings only\n");
+    printf("\n");
+
+    HANDLE threads[SEEDS_MAX_JOBS];
+    int n_threads = 0;
+    w->t0 = now_ms();
+    for (int j = 0; j < jobs; j++) {
+        threads[n_threads] = CreateThread(NULL, 0, warm_worker, (LPVOID)(INT_PTR)j, 0, NULL);
+        if (threads[n_threads]) n_threads++;
+    }
+    if (n_threads == 0) warm_worker(NULL);
+    WaitForMultipleObjects(n_threads, threads, TRUE, INFINITE);
+    for (int j = 0; j < n_threads; j++) CloseHandle(threads[j]);
+    double wall_sec = (now_ms() - w->t0) / 1000.0;
+    fprintf(stderr, "\n");
+
+    printf("\n  %d jobs in %.1fs: %ld fetched, %ld already cached, %ld failed\n",
+           w->n_jobs, wall_sec, w->fetched, w->cached, w->failed);
+    if (w->fetched > 0)
+        printf("  %.2f takes/s, %.1fs audio (%.1fx realtime)\n",
+               w->fetched / wall_sec, w->audio_ms / 1000.0, w->audio_ms / 1000.0 / wall_sec);
+    for (int p = 0; p < w->n_ports; p++)
+        printf("  port %d: %ld takes, %ld failed requests\n",
+               w->ports[p], w->port_takes[p], w->port_fails[p]);
+    printf("  %d groupings in the index\n", gidx_count(w->groupings));
+    printf("  Take store: %.1f MB\n", tts_store_bytes(w->store) / (1024.0 * 1024.0));
+    if (w->over_cap > 0)
+        printf("  %ld takes left out: the store reached %llu MB, 7/8 of the GUI's cap\n",
+               w->over_cap, (unsigned long long)WARM_STORE_FULL >> 20);
+    printf("\n");
+
+    free(w->jobs);
+    w->jobs = NULL;
+    tts_store_close(w->store);
+    gidx_close(w->groupings);
+    return w->failed > 0 ? -1 : 0;
+}
+
+/* ========================================================================
+ * Executor: interactive start latency with the background lanes saturated
+ *
+ * Fills the playback, prefetch and idle lanes of a pool sized like the
+ * GUI's with tasks that block until released, then submits interactive
+ * tasks one at a time and times how long each waits for a worker. Needs no
+ * server and no input files.
+ * ======================================================================== */
+#define EXEC_CHECK_WORKERS  11      /* the GUI's pool, 3 prefetch + 3 audition jobs */
+#define EXEC_CHECK_PREFETCH 7       /* and its prefetch lane cap */
+#define EXEC_CHECK_ROUNDS   20
+#define EXEC_CHECK_MAX_MS   50.0
+
+static volatile LONG g_exec_running, g_exec_peak;
+static HANDLE g_exec_release;
+
+static void exec_block_task(void *arg, exec_cancel_t *cancel) {
+    (void)arg;
+    LONG n = InterlockedIncrement(&g_exec_running);
+    LONG peak;
+    while (n > (peak = g_exec_peak)
+           && InterlockedCompareExchange(&g_exec_peak, n, peak) != peak) {}
+    if (!exec_cancelled(cancel)) WaitForSingleObject(g_exec_release, INFINITE);
+    InterlockedDecrement(&g_exec_running);
+}
+
+static void exec_probe_task(void *arg, exec_cancel_t *cancel) {
+    (void)cancel;
+    *(double *)arg = now_ms();
+}
+
+/* Returns 0 if every interactive task started within EXEC_CHECK_MAX_MS and
+ * the background lanes never held the whole pool, else -1. */
+static int test_executor(void) {
+    static const struct { exec_lane_t lane; const char *name; int n; } fill[] = {
+        { EXEC_LANE_PLAYBACK, "playback", 8 },
+        { EXEC_LANE_PREFETCH, "prefetch", 8 },
+        { EXEC_LANE_IDLE,     "idle",     4 },
+    };
+    executor_t *ex = executor_create(EXEC_CHECK_WORKERS);
+    g_exec_release = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!ex || !g_exec_release) {
+        fprintf(stderr, "Executor setup failed\n");
+        return -1;
+    }
+    executor_set_lane_limit(ex, EXEC_LANE_PREFETCH, EXEC_CHECK_PREFETCH);
+
+    printf("=== Executor: %d workers, background lanes saturated ===\n", EXEC_CHECK_WORKERS);
+    int queued = 0;
+    for (int f = 0; f < (int)(sizeof(fill) / sizeof(fill[0])); f++) {
+        for (int i = 0; i < fill[f].n; i++)
+            if (executor_submit(ex, fill[f].lane, exec_block_task, NULL, NULL, NULL) == 0)
+                queued++;
+        printf("  Queued %d blocking %s tasks\n", fill[f].n, fill[f].name);
+    }
+    /* Let the workers take all the background work they are allowed */
+    for (int i = 0; i < 100 && g_exec_running < EXEC_CHECK_WORKERS - 1; i++) Sleep(10);
+    Sleep(50);
+    LONG background = g_exec_running;
+    printf("  Background tasks running: %ld of %d queued\n\n", (long)background, queued);
+
+    double worst = 0.0, sum = 0.0;
+    int started = 0;
+    for (int r = 0; r < EXEC_CHECK_ROUNDS; r++) {
+        double start = 0.0;
+        exec_task_t *t = NULL;
+        double submitted = now_ms();
+        if (executor_submit(ex, EXEC_LANE_INTERACTIVE, exec_probe_task, &start, NULL, &t) != 0)
+            continue;
+        if (exec_task_wait(t, 5000) == 0) {
+            double wait = start - submitted;
+            if (wait > worst) worst = wait;
+            sum += wait;
+            started++;
+        }
+        exec_task_release(t);
+    }
+
+    SetEvent(g_exec_release);
+    executor_destroy(ex, INFINITE);
+    CloseHandle(g_exec_release);
+
+    int pass = started == EXEC_CHECK_ROUNDS && worst <= EXEC_CHECK_MAX_MS
+               && g_exec_peak <= EXEC_CHECK_WORKERS - 1;
+    printf("  Interactive tasks started: %d/%d\n", started, EXEC_CHECK_ROUNDS);
+    printf("  Start latency: avg %.2f ms, worst %.2f ms (limit %.0f ms)\n",
+           started ? sum / started : 0.0, worst, EXEC_CHECK_MAX_MS);
+    printf("  Background peak: %ld of %d workers\n", (long)g_exec_peak, EXEC_CHECK_WORKERS);
+    printf("  %s\n", pass ? "PASS" : "FAIL");
+    return pass ? 0 : -1;
+}
+
+/* ========================================================================
+ * Stream: streamed TTS responses into the file and null sinks
+ *
+ * Wraps a known tone in each response format the GUI gets from the speech
+ * endpoint (chunked WAV, SSE events, a JSON body around a base64 WAV),
+ * feeds it to tts_stream in uneven pieces as a socket would return them,
+ * and plays the PCM into a WAV file sink and a paced null sink the way the
+ * GUI plays into waveOut. Passes if the file holds the tone sample for
+ * sample, the null sink plays all of it out and base64 audio starts coming
+ * out before its string ends. Needs no server and no sound device.
+ * ======================================================================== */
+#define STREAM_CHECK_RATE    24000
+#define STREAM_CHECK_SAMPLES (STREAM_CHECK_RATE * 3 / 2)
+#define STREAM_CHECK_EVENT   4800       /* samples per SSE event */
+#define STREAM_CHECK_WAIT_MS 10
+
+typedef struct {
+    audio_sink_t *file;
+    audio_sink_t *null;
+    int rate;
+    int error;
+    int fed;                    /* response bytes fed so far */
+    int first_at;               /* fed when the first samples came out */
+} StreamCheckPlay;
+
+static int stream_check_pcm(void *ctx, const int16_t *samples, int n, int sample_rate) {
+    StreamCheckPlay *p = (StreamCheckPlay *)ctx;
+    if (p->rate && p->rate != sample_rate) p->error = 1;
+    p->rate = sample_rate;
+    if (p->first_at < 0) p->first_at = p->fed;
+    /* The null sink takes everything; pace it like a device anyway */
+    if (audio_sink_write(p->file, samples, n) != n || audio_sink_write(p->null, samples, n) != n)
+        p->error = 1;
+    while (audio_sink_pending(p->null) > STREAM_CHECK_EVENT)
+        audio_sink_wait(p->null, STREAM_CHECK_WAIT_MS);
+    return 0;
+}
+
+static char *stream_check_b64(const unsigned char *in, int len, char *out) {
+    static const char abc[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (int i = 0; i < len; i += 3) {
+        unsigned v = (unsigned)in[i] << 16;
+        if (i + 1 < len) v |= (unsigned)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        *out++ = abc[v >> 18];
+        *out++ = abc[(v >> 12) & 63];
+        *out++ = i + 1 < len ? abc[(v >> 6) & 63] : '=';
+        *out++ = i + 2 < len ? abc[v & 63] : '=';
+    }
+    *out = '\0';
+    return out;
+}
+
+static void stream_check_wav_header(unsigned char *h, uint32_t data_bytes) {
+    uint32_t riff = data_bytes == 0xFFFFFFFFu ? data_bytes : 36 + data_bytes;
+    uint32_t fmt_size = 16, rate = STREAM_CHECK_RATE, byte_rate = rate * 2;
+    uint16_t format = 1, channels = 1, align = 2, bits = 16;
+    memcpy(h, "RIFF", 4);
+    memcpy(h + 4, &riff, 4);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    memcpy(h + 16, &fmt_size, 4);
+    memcpy(h + 20, &format, 2);
+    memcpy(h + 22, &channels, 2);
+    memcpy(h + 24, &rate, 4);
+    memcpy(h + 28, &byte_rate, 4);
+    memcpy(h + 32, &align, 2);
+    memcpy(h + 34, &bits, 2);
+    memcpy(h + 36, "data", 4);
+    memcpy(h + 40, &data_bytes, 4);
+}
+
+/* The response for format f (0 chunked WAV, 1 SSE, 2 JSON) around pcm.
+ * Returns malloc'd bytes and sets *len. */
+static char *stream_check_response(int f, const int16_t *pcm, int n, int *len) {
+    size_t pcm_bytes = (size_t)n * 2;
+    char *r = (char *)malloc(pcm_bytes * 2 + 65536);
+    if (!r) return NULL;
+    char *o = r;
+    if (f == 0) {
+        stream_check_wav_header((unsigned char *)o, 0xFFFFFFFFu);  /* size unknown */
+        memcpy(o + 44, pcm, pcm_bytes);
+        o += 44 + pcm_bytes;
+    } else if (f == 1) {
+        for (int i = 0; i < n; i += STREAM_CHECK_EVENT) {
+            int k = n - i < STREAM_CHECK_EVENT ? n - i : STREAM_CHECK_EVENT;
+            o += sprintf(o, "data: {\"type\":\"speech.audio.delta\",\"sample_rate\":%d,"
+                         "\"audio\":\"", STREAM_CHECK_RATE);
+            o = stream_check_b64((const unsigned char *)(pcm + i), k * 2, o);
+            o += sprintf(o, "\"}\r\n\r\n");
+        }
+        o += sprintf(o, "data: {\"type\":\"speech.audio.done\",\"seed\":7,"
+                     "\"words\":[]}\n\ndata: [DONE]\n\n");
+    } else {
+        unsigned char *wav = (unsigned char *)malloc(44 + pcm_bytes);
+        if (!wav) {
+            free(r);
+            return NULL;
+        }
+        stream_check_wav_header(wav, (uint32_t)pcm_bytes);
+        memcpy(wav + 44, pcm, pcm_bytes);
+        o += sprintf(o, "{\"audio\":\"");
+        o = stream_check_b64(wav, (int)(44 + pcm_bytes), o);
+        o += sprintf(o, "\",\"seed\":7,\"words\":[]}");
+        free(wav);
+    }
+    *len = (int)(o - r);
+    return r;
+}
+
+/* Returns 0 if every format came through both sinks intact, else -1. */
+static int test_stream_sinks(void) {
+    static const char *names[] = { "chunked WAV", "SSE", "JSON + base64 WAV" };
+    int16_t *tone = (int16_t *)malloc(STREAM_CHECK_SAMPLES * sizeof(int16_t));
+    int16_t *back = (int16_t *)malloc((STREAM_CHECK_SAMPLES + 1) * sizeof(int16_t));
+    if (!tone || !back) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    for (int i = 0; i < STREAM_CHECK_SAMPLES; i++)
+        tone[i] = (int16_t)(12000.0 * sin(6.283185307179586 * 440.0 * i / STREAM_CHECK_RATE)
+                            + (i % 7) - 3);
+
+    char path[MAX_PATH];
+    GetTempPathA(sizeof(path) - 32, path);
+    strcat(path, "tts_stream_check.wav");
+
+    printf("=== Stream: %.1fs tone at %d Hz into file and null sinks ===\n",
+           (double)STREAM_CHECK_SAMPLES / STREAM_CHECK_RATE, STREAM_CHECK_RATE);
+    int failures = 0;
+    for (int f = 0; f < 3; f++) {
+        int len = 0;
+        char *resp = stream_check_response(f, tone, STREAM_CHECK_SAMPLES, &len);
+        StreamCheckPlay play = {0};
+        play.first_at = -1;
+        play.file = audio_sink_open_file(path, STREAM_CHECK_RATE);
+        play.null = audio_sink_open_null(STREAM_CHECK_RATE, 1);
+        tts_stream_t *st = tts_stream_new(stream_check_pcm, &play);
+        int rc = -1;
+        if (resp && play.file && play.null && st) {
+            /* Uneven pieces, some splitting headers, lines and quanta */
+            unsigned x = 12345;
+            rc = 0;
+            for (int pos = 0; pos < len && rc == 0;) {
+                x = x * 1103515245u + 12345u;
+                int k = 1 + (int)((x >> 16) % 1500);
+                if (k > len - pos) k = len - pos;
+                play.fed = pos + k;
+                rc = tts_stream_feed(st, resp + pos, k);
+                pos += k;
+            }
+            if (rc == 0) rc = tts_stream_finish(st);
+        }
+        int json_len = 0;
+        const char *json = st ? tts_stream_json(st, &json_len) : NULL;
+        int want_json = f != 0;
+        int json_ok = !want_json || (json && json_len > 0 && strstr(json, "\"seed\":7"));
+        /* Audio must come out while its base64 string is still arriving */
+        int early = 1;
+        const char *b64 = resp ? strstr(resp, "\"audio\":\"") : NULL;
+        if (b64) {
+            const char *b64_end = strchr(b64 + 9, '"');
+            early = play.first_at >= 0 && b64_end && play.first_at < (int)(b64_end - resp);
+        }
+
+        /* Play the null sink out in device-sized waits */
+        int waits = 0;
+        if (play.null) {
+            audio_sink_flush(play.null);
+            while (audio_sink_pending(play.null) > 0 && waits < 100000) {
+                audio_sink_wait(play.null, STREAM_CHECK_WAIT_MS);
+                waits++;
+            }
+        }
+        long long null_played = audio_sink_played(play.null);
+        long long file_written = audio_sink_played(play.file);
+        audio_sink_close(play.null);
+        audio_sink_close(play.file);
+        tts_stream_free(st);
+        free(resp);
+
+        /* The file must hold a header for exactly the tone, then the tone */
+        int same = 0;
+        FILE *fp = fopen(path, "rb");
+        if (fp) {
+            unsigned char h[44];
+            uint32_t data_bytes = 0;
+            if (fread(h, 1, 44, fp) == 44) memcpy(&data_bytes, h + 40, 4);
+            size_t got = fread(back, sizeof(int16_t), STREAM_CHECK_SAMPLES + 1, fp);
+            same = data_bytes == STREAM_CHECK_SAMPLES * 2 && got == STREAM_CHECK_SAMPLES
+                && memcmp(back, tone, STREAM_CHECK_SAMPLES * sizeof(int16_t)) == 0;
+            fclose(fp);
+        }
+        DeleteFileA(path);
+
+        int pass = rc == 0 && !play.error && play.rate == STREAM_CHECK_RATE && json_ok
+                   && early && same && file_written == STREAM_CHECK_SAMPLES
+                   && null_played == STREAM_CHECK_SAMPLES;
+        printf("  %-18s %s: file %lld samples%s, null played %lld in %d waits%s%s\n",
+               names[f], pass ? "PASS" : "FAIL", file_written, same ? " (identical)" : "",
+               null_played, waits, want_json ? (json_ok ? ", metadata kept" : ", metadata lost")
+                                             : "",
+               early ? "" : ", audio held until its string ended");
+        if (!pass) failures++;
+    }
+    free(tone);
+    free(back);
+    printf("  %s\n", failures ? "FAIL" : "PASS");
+    return failures ? -1 : 0;
+}
+
+/* ========================================================================
+ * WSOLA: 1x identity and stretched lengths
+ *
+ * Runs a speech-like test signal (voiced stretches with a gliding pitch and
+ * noise, a periodic stretch that swells, true and near silence) through
+ * wsola in uneven pieces. At 1x every frame must stay at its nominal
+ * position, so the output has to equal the input sample for sample; at the
+ * other speeds only the length, round(input / speed), is checked.
+ * ======================================================================== */
+#define WSOLA_CHECK_RATE    24000
+#define WSOLA_CHECK_SAMPLES (WSOLA_CHECK_RATE * 4)
+
+static void wsola_check_signal(int16_t *x, int n) {
+    unsigned r = 1;
+    double ph = 0.0;
+    for (int i = 0; i < n; i++) {
+        double t = (double)i / WSOLA_CHECK_RATE, v;
+        r = r * 1103515245u + 12345u;
+        double noise = (double)((r >> 16) & 0x7FFF) / 16384.0 - 1.0;
+        if (t < 1.0) {
+            ph += 6.283185307179586 * (110.0 + 60.0 * t) / WSOLA_CHECK_RATE;
+            v = 6000.0 * (sin(ph) + 0.5 * sin(2.0 * ph) + 0.25 * sin(3.0 * ph)) + 300.0 * noise;
+        } else if (t < 1.5) {
+            v = 0.0;
+        } else if (t < 2.0) {
+            v = (double)(int)(noise * 1.5);       /* -1..1: near silence */
+        } else if (t < 3.0) {
+            v = (t - 2.0) * 20000.0 * sin(6.283185307179586 * 200.0 * t);
+        } else {
+            v = 2000.0 * noise;
+        }
+        x[i] = (int16_t)(v > 32767.0 ? 32767 : v < -32768.0 ? -32768 : v);
+    }
+}
+
+/* Stretch in through wsola at speed, writing and reading in uneven pieces.
+ * Returns the output length (out holds up to cap samples). */
+static int wsola_check_run(const int16_t *in, int n, double speed, int16_t *out, int cap) {
+    wsola_t *w = wsola_create(WSOLA_CHECK_RATE, speed);
+    if (!w) return -1;
+    unsigned x = 777;
+    int pos = 0, got = 0;
+    while (pos < n) {
+        x = x * 1103515245u + 12345u;
+        int k = 1 + (int)((x >> 16) % 3000);
+        if (k > n - pos) k = n - pos;
+        wsola_write(w, in + pos, k);
+        pos += k;
+        if (pos == n) wsola_end(w);
+        int m;
+        while ((m = wsola_read(w, out + got, cap - got)) > 0) got += m;
+    }
+    wsola_destroy(w);
+    return got;
+}
+
+/* Returns 0 if 1x is the identity and every speed gives the right length. */
+static int test_wsola(void) {
+    static const double speeds[] = { 1.0, 0.5, 0.75, 1.25, 1.5 };
+    int cap = WSOLA_CHECK_SAMPLES * 2 + 1;
+    int16_t *in = (int16_t *)malloc(WSOLA_CHECK_SAMPLES * sizeof(int16_t));
+    int16_t *out = (int16_t *)malloc(cap * sizeof(int16_t));
+    if (!in || !out) {
+        fprintf(stderr, "Out of memory\n");
+        return -1;
+    }
+    wsola_check_signal(in, WSOLA_CHECK_SAMPLES);
+
+    printf("=== WSOLA: %.1fs test signal at %d Hz ===\n",
+           (double)WSOLA_CHECK_SAMPLES / WSOLA_CHECK_RATE, WSOLA_CHECK_RATE);
+    int failures = 0;
+    for (int s = 0; s < (int)(sizeof(speeds) / sizeof(speeds[0])); s++) {
+        int want = (int)floor(WSOLA_CHECK_SAMPLES / speeds[s] + 0.5);
+        int got = wsola_check_run(in, WSOLA_CHECK_SAMPLES, speeds[s], out, cap);
+        int pass = got == want;
+        int diff = -1;
+        if (speeds[s] == 1.0 && pass) {
+            for (int i = 0; i < got && diff < 0; i++)
+                if (out[i] != in[i]) diff = i;
+            pass = diff < 0;
+        }
+        printf("  %.2fx %s: %d samples (want %d)%s\n", speeds[s], pass ? "PASS" : "FAIL",
+               got, want, speeds[s] != 1.0 ? "" : diff < 0 ? ", identical" : ", differs");
+        if (diff >= 0)
+            printf("    first difference at %.3fs\n", (double)diff / WSOLA_CHECK_RATE);
+        if (!pass) failures++;
+    }
+    free(in);
+    free(out);
+    printf("  %s\n", failures ? "FAIL" : "PASS");
+    return failures ? -1 : 0;
+}
+
+/* ========================================================================
+ * Queue: TTS request coalescing
+ *
+ * Drives tts_queue the way the GUI's player and synthesizer do. Synthesis
+ * ahead must fold into an equal request, but every playback push must play:
+ * a reply that says A, B, A plays A twice, from one take.
+ * ======================================================================== */
+#define QUEUE_CHECK_VOICE 0
+#define QUEUE_CHECK_SEED  7
+
+static int queue_check_push(ttsq_t *q, const char *text, int cls) {
+    return ttsq_push(q, text, QUEUE_CHECK_VOICE, QUEUE_CHECK_SEED, -1, cls);
+}
+
+/* Take every playback request and compare the texts with want (a string of
+ * one-letter texts). Returns 1 on a match. */
+static int queue_check_plays(ttsq_t *q, const char *want, char *got, int cap) {
+    int n = 0;
+    ttsq_item_t *it;
+    while ((it = ttsq_take_play(q)) != NULL) {
+        if (n + 1 < cap) got[n++] = it->text[0];
+        ttsq_item_free(it);
+    }
+    got[n] = '\0';
+    return strcmp(got, want) == 0;
+}
+
+static int queue_check_report(const char *name, int pass, const char *detail) {
+    printf("  %-34s %s%s%s\n", name, pass ? "PASS" : "FAIL", detail[0] ? ": " : "", detail);
+    return pass ? 0 : 1;
+}
+
+/* Returns 0 if every case plays and synthesizes as expected, else -1. */
+static int test_queue(void) {
+    char got[32], detail[96];
+    int failures = 0;
+    printf("=== Queue: TTS request coalescing ===\n");
+
+    /* A reply that repeats a sentence plays it again */
+    ttsq_t *q = ttsq_create();
+    queue_check_push(q, "A", TTSQ_PLAY);
+    queue_check_push(q, "B", TTSQ_PLAY);
+    queue_check_push(q, "A", TTSQ_PLAY);
+    int pass = queue_check_plays(q, "ABA", got, sizeof(got));
+    snprintf(detail, sizeof(detail), "played %s", got);
+    failures += queue_check_report("PLAY A, B, A", pass, detail);
+    ttsq_destroy(q);
+
+    /* A replay of a sentence queued to play plays both, replay first */
+    q = ttsq_create();
+    queue_check_push(q, "A", TTSQ_PLAY);
+    queue_check_push(q, "A", TTSQ_INTERACTIVE);
+    pass = queue_check_plays(q, "AA", got, sizeof(got));
+    snprintf(detail, sizeof(detail), "played %s", got);
+    failures += queue_check_report("PLAY A, INTERACTIVE A", pass, detail);
+    ttsq_destroy(q);
+
+    /* Synthesis ahead folds into playback, either way round */
+    q = ttsq_create();
+    queue_check_push(q, "C", TTSQ_PREFETCH);
+    queue_check_push(q, "C", TTSQ_PLAY);
+    queue_check_push(q, "D", TTSQ_PLAY);
+    queue_check_push(q, "D", TTSQ_SPECULATIVE);
+    queue_check_push(q, "E", TTSQ_PREFETCH);
+    queue_check_push(q, "E", TTSQ_SPECULATIVE);
+    int queued = ttsq_count(q, TTSQ_PREFETCH);
+    pass = queued == 3 && ttsq_count(q, TTSQ_SPECULATIVE) == 3;
+    pass = queue_check_plays(q, "CD", got, sizeof(got)) && pass;
+    snprintf(detail, sizeof(detail), "%d queued, played %s", queued, got);
+    failures += queue_check_report("Synthesis ahead coalesces", pass, detail);
+    ttsq_destroy(q);
+
+    /* A repeat shares the take: one synthesis, then both are ready */
+    q = ttsq_create();
+    queue_check_push(q, "X", TTSQ_PLAY);
+    queue_check_push(q, "A", TTSQ_PLAY);
+    queue_check_push(q, "A", TTSQ_PLAY);
+    ttsq_item_t *playing = ttsq_take_play(q);           /* X; the player is busy */
+    ttsq_item_t *first = ttsq_take_synth(q);            /* the first A */
+    ttsq_item_t *second = ttsq_take_synth(q);           /* nothing: the repeat waits */
+    int synths = (first != NULL) + (second != NULL);
+    if (first) ttsq_synth_done(q, first);
+    if (second) ttsq_synth_done(q, second);
+    ttsq_item_t *after = ttsq_take_synth(q);            /* nothing: both ready */
+    synths += after != NULL;
+    if (after) ttsq_synth_done(q, after);
+    queue_check_push(q, "A", TTSQ_PLAY);                /* a third, after the take */
+    ttsq_item_t *third = ttsq_take_synth(q);
+    synths += third != NULL;
+    if (third) ttsq_synth_done(q, third);
+    ttsq_item_free(playing);
+    pass = synths == 1 && queue_check_plays(q, "AAA", got, sizeof(got));
+    snprintf(detail, sizeof(detail), "%d synthesized, played %s", synths, got);
+    failures += queue_check_report("Repeats share one take", pass, detail);
+    ttsq_destroy(q);
+
+    printf("  %s\n", failures ? "FAIL" : "PASS");
+    return failures ? -1 : 0;
 }
 
 /* ========================================================================
@@ -638,11 +2313,31 @@ static void test_sim(int port, const float *wav, int n_samples,
 int main(int argc, char **argv) {
     if (argc < 2) {
         fprintf(stderr,
-            "Usage: %s [options] <recording.wav> [...]\n"
+            "Usage: %s [options] <recording.wav|.lac|.vses> [...]\n"
             "Options:\n"
-            "  --mode <retranscribe|vad|timestamps|sim|all>  (default: all)\n"
+            "  --mode <retranscribe|vad|vadcmp|timestamps|sim|pack|replay|seeds|warm|executor|stream|wsola|queue|all>  (default: all)\n"
             "  --interval <sec>   Retranscribe interval (default 2.0)\n"
-            "  --port <n>         ASR server port (default 8090)\n",
+            "  --port <n>         ASR server port (default 8090)\n"
+            "  --trim             Trim silence before upload (retranscribe, sim)\n"
+            "  --guard <ms>       Silence kept around speech (default 300)\n"
+            "  --max-pause <ms>   Cut internal pauses to this, 0 = keep (default 800)\n"
+            "  --spectral-vad     Gate the vad approach on the spectral VAD\n"
+            "  --features <int8|int16>  Upload log-mel frames instead of PCM (retranscribe, sim)\n"
+            "  --mel-bins <n>     Mel bins of the server's encoder (default 128)\n"
+            "  --blocks           Upload new audio blocks plus references (retranscribe, sim)\n"
+            "Seed screening (--mode seeds, inputs are drill sentence banks):\n"
+            "  --voices <a,b,..>  Voices to screen (default: all nine)\n"
+            "  --seeds <n>        Random candidate seeds per voice (default 4)\n"
+            "  --seed-list <a,b,..>  Screen these seeds instead\n"
+            "  --jobs <n>         Concurrent requests (default 3)\n"
+            "  --out <dir>        Write every take as a WAV\n"
+            "Cache warm-up (--mode warm, inputs are drill sentence banks):\n"
+            "  --voices <a,b,..>  Voices to warm (default: all nine)\n"
+            "  --seed-list <a,b,..>  Warm these seeds (default: the GUI's locked seeds)\n"
+            "  --jobs <n>         Concurrent requests (default 3)\n"
+            "  --ports <a,b,..>   TTS servers to spread them over (default: --port)\n"
+            "  --cache <dir>      GUI cache directory (default: ..\\tts_cache next to the exe)\n"
+            "  --tts-model <id>   Model id in the take keys (default qwen3-tts)\n",
             argv[0]);
         return 1;
     }
@@ -653,6 +2348,9 @@ int main(int argc, char **argv) {
     float interval = 2.0f;
     int port = 8090;
     int first_file = 0;
+    const char *voice_list = NULL, *seed_list = NULL;
+    const char *port_list = NULL, *cache_dir = NULL, *tts_model = "qwen3-tts";
+    int n_seeds = 4, jobs = 3;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
@@ -661,23 +2359,146 @@ int main(int argc, char **argv) {
             interval = (float)atof(argv[++i]);
         } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
             port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--trim") == 0) {
+            g_trim = 1;
+        } else if (strcmp(argv[i], "--guard") == 0 && i + 1 < argc) {
+            g_trim_opts.guard_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-pause") == 0 && i + 1 < argc) {
+            g_trim_opts.max_pause_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spectral-vad") == 0) {
+            g_spectral_vad = 1;
+        } else if (strcmp(argv[i], "--features") == 0 && i + 1 < argc) {
+            const char *q = argv[++i];
+            g_mel_quant = strcmp(q, "int16") == 0 ? MEL_Q_INT16
+                        : strcmp(q, "int8") == 0 ? MEL_Q_INT8 : 0;
+            if (!g_mel_quant) {
+                fprintf(stderr, "Unknown --features %s (int8 or int16)\n", q);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--mel-bins") == 0 && i + 1 < argc) {
+            g_mel_bins = atoi(argv[++i]);
+            if (g_mel_bins < 1 || g_mel_bins > MEL_BINS_MAX) {
+                fprintf(stderr, "--mel-bins must be 1..%d\n", MEL_BINS_MAX);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--blocks") == 0) {
+            g_blocks = 1;
+        } else if (strcmp(argv[i], "--voices") == 0 && i + 1 < argc) {
+            voice_list = argv[++i];
+        } else if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) {
+            n_seeds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed-list") == 0 && i + 1 < argc) {
+            seed_list = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            g_seed_run.out_dir = argv[++i];
+        } else if (strcmp(argv[i], "--ports") == 0 && i + 1 < argc) {
+            port_list = argv[++i];
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--tts-model") == 0 && i + 1 < argc) {
+            tts_model = argv[++i];
         } else if (argv[i][0] != '-') {
             if (!first_file) first_file = i;
         }
     }
+    if (strcmp(mode, "executor") == 0)
+        return test_executor() == 0 ? 0 : 1;
+    if (strcmp(mode, "stream") == 0)
+        return test_stream_sinks() == 0 ? 0 : 1;
+    if (strcmp(mode, "wsola") == 0)
+        return test_wsola() == 0 ? 0 : 1;
+    if (strcmp(mode, "queue") == 0)
+        return test_queue() == 0 ? 0 : 1;
     if (!first_file) {
         fprintf(stderr, "No input files\n");
         return 1;
     }
 
+    if (strcmp(mode, "seeds") == 0 || strcmp(mode, "warm") == 0) {
+        SeedRun *r = &g_seed_run;
+        if (voice_list) {
+            char *list = _strdup(voice_list);
+            for (char *v = strtok(list, ","); v && r->n_voices < SEEDS_MAX_VOICES;
+                 v = strtok(NULL, ","))
+                r->voices[r->n_voices++] = _strdup(v);
+            free(list);
+        } else {
+            for (int v = 0; v < TTS_NUM_VOICES; v++)
+                r->voices[r->n_voices++] = tts_voices[v];
+        }
+        if (strcmp(mode, "warm") == 0) {
+            for (int i = first_file; i < argc; i++) {
+                if (argv[i][0] == '-') continue;
+                seed_load_bank(r, argv[i]);
+            }
+            if (r->n_voices == 0 || r->n_sentences == 0) {
+                fprintf(stderr, "Nothing to warm\n");
+                return 1;
+            }
+            char default_cache[MAX_PATH];
+            if (!cache_dir) {
+                /* bin\..\tts_cache, where the GUI keeps it */
+                GetModuleFileNameA(NULL, default_cache, MAX_PATH);
+                char *slash = strrchr(default_cache, '\\');
+                if (slash) *slash = '\0';
+                strncat(default_cache, "\\..\\tts_cache",
+                        sizeof(default_cache) - strlen(default_cache) - 1);
+                cache_dir = default_cache;
+            }
+            return test_warm(port_list, port, seed_list, cache_dir, tts_model,
+                             jobs < 1 ? 1 : jobs > SEEDS_MAX_JOBS ? SEEDS_MAX_JOBS : jobs) == 0 ? 0 : 1;
+        }
+        if (seed_list) {
+            char *list = _strdup(seed_list);
+            for (char *t = strtok(list, ","); t && r->n_seeds < SEEDS_MAX_CANDIDATES;
+                 t = strtok(NULL, ","))
+                r->seeds[0][r->n_seeds++] = atoi(t);
+            free(list);
+            for (int v = 1; v < r->n_voices; v++)
+                memcpy(r->seeds[v], r->seeds[0], sizeof(r->seeds[0]));
+        } else {
+            /* Fresh candidates per voice, as Shift+> would draw them */
+            r->n_seeds = n_seeds < 1 ? 1 : n_seeds > SEEDS_MAX_CANDIDATES
+                       ? SEEDS_MAX_CANDIDATES : n_seeds;
+            srand(GetTickCount());
+            for (int v = 0; v < r->n_voices; v++)
+                for (int c = 0; c < r->n_seeds; c++)
+                    r->seeds[v][c] = ((rand() << 15) | rand()) & 0x3FFFFFFF;
+        }
+        for (int i = first_file; i < argc; i++) {
+            if (argv[i][0] == '-') continue;
+            seed_load_bank(r, argv[i]);
+        }
+        if (r->n_voices == 0 || r->n_seeds == 0 || r->n_sentences == 0) {
+            fprintf(stderr, "Nothing to screen\n");
+            return 1;
+        }
+        if (g_seed_run.out_dir) CreateDirectoryA(g_seed_run.out_dir, NULL);
+        test_seeds(port, jobs < 1 ? 1 : jobs > SEEDS_MAX_JOBS ? SEEDS_MAX_JOBS : jobs);
+        return 0;
+    }
+
     int do_retranscribe = strcmp(mode, "retranscribe") == 0 || strcmp(mode, "all") == 0;
     int do_vad = strcmp(mode, "vad") == 0 || strcmp(mode, "all") == 0;
+    int do_vadcmp = strcmp(mode, "vadcmp") == 0;
     int do_timestamps = strcmp(mode, "timestamps") == 0;
     int do_sim = strcmp(mode, "sim") == 0;
+    int do_pack = strcmp(mode, "pack") == 0;
+    int do_replay = strcmp(mode, "replay") == 0;
 
     for (int i = first_file; i < argc; i++) {
         if (argv[i][0] == '-') continue;
 
+        if (do_replay) {
+            printf("\n================================================\n");
+            printf("Session: %s\n", argv[i]);
+            printf("================================================\n\n");
+            test_replay(argv[i]);
+            continue;
+        }
+
         int n_samples;
         float *wav = read_wav_f32(argv[i], &n_samples);
         if (!wav) { fprintf(stderr, "Failed: %s\n", argv[i]); continue; }
@@ -687,13 +2508,24 @@ int main(int argc, char **argv) {
         printf("File: %s (%.1fs, port=%d)\n", argv[i], dur, port);
         printf("================================================\n\n");
 
+        if (do_retranscribe || do_sim) {
+            mel_prepare(wav, n_samples);
+            blk_prepare(wav, n_samples);
+        }
         if (do_retranscribe) test_retranscribe(port, wav, n_samples, interval);
         if (do_vad)          test_vad(port, wav, n_samples);
+        if (do_vadcmp)       test_vad_compare(argv[i], wav, n_samples);
         if (do_timestamps)   test_timestamps(port, wav, n_samples);
         if (do_sim)          test_sim(port, wav, n_samples, interval);
+        if (do_pack)         pack_lac(argv[i], wav, n_samples);
 
+        g_mel_audio = NULL;
+        g_blk_audio = NULL;
         free(wav);
     }
+    mel_fe_destroy(g_mel);
+    audio_block_release(g_blk_pcm);
+    blk_uploader_destroy(g_blk);
 
     return 0;
 }
@@ -13,11 +13,9 @@
 #include <windows.h>
 #include <winhttp.h>
 
-unsigned char *asr_encode_wav(const float *samples, int n_samples, size_t *out_size) {
-    int data_bytes = n_samples * 2;  /* 16-bit PCM */
+/* Write the 44-byte header of a 16kHz mono 16-bit WAV */
+static void write_wav_header(unsigned char *buf, int data_bytes) {
     int file_size = 44 + data_bytes;
-    unsigned char *buf = (unsigned char *)malloc(file_size);
-    if (!buf) return NULL;
 
     /* RIFF header */
     memcpy(buf, "RIFF", 4);
@@ -37,6 +35,14 @@ unsigned char *asr_encode_wav(const float *samples, int n_samples, size_t *out_s
     /* data chunk */
     memcpy(buf + 36, "data", 4);
     *(int *)(buf + 40) = data_bytes;
+}
+
+unsigned char *asr_encode_wav(const float *samples, int n_samples, size_t *out_size) {
+    int data_bytes = n_samples * 2;  /* 16-bit PCM */
+    int file_size = 44 + data_bytes;
+    unsigned char *buf = (unsigned char *)malloc(file_size);
+    if (!buf) return NULL;
+    write_wav_header(buf, data_bytes);
 
     /* Convert float32 [-1,1] to int16 */
     short *pcm = (short *)(buf + 44);
@@ -194,10 +200,12 @@ AsrResult *asr_parse_response(const char *json, int json_len, int is_final) {
     return r;
 }
 
-/* Build multipart body with custom response_format field. */
+/* Build multipart body with custom response_format field. file_type is
+ * NULL for WAV, or the input_format of another payload ("log_mel" LMEL
+ * feature block, "pcm_blocks" PBLK block list), sent as an opaque file. */
 static unsigned char *build_multipart_fmt(const unsigned char *wav, size_t wav_size,
                                           const char *language, const char *prompt,
-                                          const char *format,
+                                          const char *format, const char *file_type,
                                           size_t *out_size, char *out_boundary,
                                           size_t bnd_size) {
     LARGE_INTEGER ticks;
@@ -211,9 +219,18 @@ static unsigned char *build_multipart_fmt(const unsigned char *wav, size_t wav_s
 
 #define MP2_APPEND(fmt, ...) pos += snprintf((char *)body + pos, est - pos, fmt, ##__VA_ARGS__)
 
-    MP2_APPEND("--%s\r\nContent-Disposition: form-data; name=\"file\"; "
-               "filename=\"audio.wav\"\r\nContent-Type: audio/wav\r\n\r\n",
-               out_boundary);
+    if (file_type) {
+        MP2_APPEND("--%s\r\nContent-Disposition: form-data; name=\"input_format\""
+                   "\r\n\r\n%s\r\n", out_boundary, file_type);
+        MP2_APPEND("--%s\r\nContent-Disposition: form-data; name=\"file\"; "
+                   "filename=\"%s\"\r\nContent-Type: application/octet-stream"
+                   "\r\n\r\n", out_boundary,
+                   strcmp(file_type, "log_mel") == 0 ? "features.lmel" : "audio.pblk");
+    } else {
+        MP2_APPEND("--%s\r\nContent-Disposition: form-data; name=\"file\"; "
+                   "filename=\"audio.wav\"\r\nContent-Type: audio/wav\r\n\r\n",
+                   out_boundary);
+    }
     memcpy(body + pos, wav, wav_size);
     pos += wav_size;
     MP2_APPEND("\r\n");
@@ -281,6 +298,45 @@ static int sse_parse_token_event(const char *json, int len,
     return 1;
 }
 
+/* Open a POST to the transcription endpoint with the usual timeouts (2 s
+ * connect, 60 s receive: test files can be long). Returns the request, or
+ * NULL with nothing left open. */
+static HINTERNET open_transcription(int port, HINTERNET *hSession, HINTERNET *hConnect) {
+    *hSession = WinHttpOpen(L"AsrClient/1.0",
+                            WINHTTP_ACCESS_TYPE_NO_PROXY,
+                            WINHTTP_NO_PROXY_NAME,
+                            WINHTTP_NO_PROXY_BYPASS, 0);
+    if (!*hSession) return NULL;
+
+    *hConnect = WinHttpConnect(*hSession, L"localhost", (INTERNET_PORT)port, 0);
+    if (!*hConnect) {
+        WinHttpCloseHandle(*hSession);
+        return NULL;
+    }
+
+    HINTERNET hRequest = WinHttpOpenRequest(*hConnect, L"POST",
+                                             L"/v1/audio/transcriptions",
+                                             NULL, WINHTTP_NO_REFERER,
+                                             WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
+    if (!hRequest) {
+        WinHttpCloseHandle(*hConnect);
+        WinHttpCloseHandle(*hSession);
+        return NULL;
+    }
+    WinHttpSetTimeouts(hRequest, 2000, 2000, 60000, 60000);
+    return hRequest;
+}
+
+static void close_transcription(HINTERNET hRequest, HINTERNET hConnect, HINTERNET hSession) {
+    WinHttpCloseHandle(hRequest);
+    WinHttpCloseHandle(hConnect);
+    WinHttpCloseHandle(hSession);
+}
+
+static void multipart_content_type(wchar_t *buf, int size, const char *boundary) {
+    _snwprintf(buf, size, L"Content-Type: multipart/form-data; boundary=%hs", boundary);
+}
+
 void asr_free_result(AsrResult *r) {
     if (!r) return;
     free(r->text);
@@ -305,41 +361,15 @@ AsrResult *asr_transcribe(const float *samples, int n_samples,
     if (!body) return NULL;
 
     /* HTTP POST to ASR server */
-    HINTERNET hSession = WinHttpOpen(L"AsrClient/1.0",
-                                      WINHTTP_ACCESS_TYPE_NO_PROXY,
-                                      WINHTTP_NO_PROXY_NAME,
-                                      WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) {
-        free(body);
-        return NULL;
-    }
-
-    HINTERNET hConnect = WinHttpConnect(hSession, L"localhost",
-                                         (INTERNET_PORT)port, 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        free(body);
-        return NULL;
-    }
-
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST",
-                                             L"/v1/audio/transcriptions",
-                                             NULL, WINHTTP_NO_REFERER,
-                                             WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
+    HINTERNET hSession, hConnect;
+    HINTERNET hRequest = open_transcription(port, &hSession, &hConnect);
     if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
         free(body);
         return NULL;
     }
 
-    /* Set timeouts: 2s connect, 60s receive (test files can be long) */
-    WinHttpSetTimeouts(hRequest, 2000, 2000, 60000, 60000);
-
-    /* Build Content-Type header */
     wchar_t ct_header[256];
-    _snwprintf(ct_header, 256,
-               L"Content-Type: multipart/form-data; boundary=%hs", boundary);
+    multipart_content_type(ct_header, 256, boundary);
 
     BOOL ok = WinHttpSendRequest(hRequest, ct_header, (DWORD)-1L,
                                   body, (DWORD)body_size, (DWORD)body_size, 0);
@@ -367,9 +397,118 @@ AsrResult *asr_transcribe(const float *samples, int n_samples,
         }
     }
 
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
+    close_transcription(hRequest, hConnect, hSession);
+
+    return result;
+}
+
+/* Read an SSE transcription response, firing token_cb per token event.
+ * Returns the parsed done event, or NULL if none arrived. */
+static AsrResult *read_sse_response(HINTERNET hRequest, int is_final,
+                                    asr_token_cb token_cb, void *userdata) {
+    AsrResult *result = NULL;
+    /* Read SSE stream incrementally */
+    char line_buf[4096];
+    int line_pos = 0;
+    char done_buf[65536];
+    int done_len = 0;
+    int got_done = 0;
+
+    for (;;) {
+        DWORD avail = 0;
+        if (!WinHttpQueryDataAvailable(hRequest, &avail)) break;
+        if (avail == 0) break;
+
+        char chunk[4096];
+        DWORD to_read = avail < sizeof(chunk) ? avail : sizeof(chunk);
+        DWORD bytes_read = 0;
+        if (!WinHttpReadData(hRequest, chunk, to_read, &bytes_read)) break;
+        if (bytes_read == 0) break;
+
+        /* Process bytes: accumulate lines, handle "data: " prefix */
+        for (DWORD i = 0; i < bytes_read; i++) {
+            char c = chunk[i];
+            if (c == '\n') {
+                line_buf[line_pos] = '\0';
+                /* Strip trailing \r */
+                if (line_pos > 0 && line_buf[line_pos - 1] == '\r')
+                    line_buf[--line_pos] = '\0';
+
+                if (line_pos > 6 && memcmp(line_buf, "data: ", 6) == 0) {
+                    const char *payload = line_buf + 6;
+                    int payload_len = line_pos - 6;
+
+                    if (strstr(payload, "\"done\"")) {
+                        /* Done event -- accumulate for final parse */
+                        if (payload_len < (int)sizeof(done_buf) - 1) {
+                            memcpy(done_buf, payload, payload_len);
+                            done_buf[payload_len] = '\0';
+                            done_len = payload_len;
+                            got_done = 1;
+                        }
+                    } else if (token_cb) {
+                        /* Token event */
+                        char token_text[512];
+                        int ams = 0, boff = 0;
+                        if (sse_parse_token_event(payload, payload_len,
+                                                   token_text,
+                                                   sizeof(token_text),
+                                                   &ams, &boff)) {
+                            token_cb(token_text, ams, boff, userdata);
+                        }
+                    }
+                }
+                line_pos = 0;
+            } else {
+                if (line_pos < (int)sizeof(line_buf) - 1)
+                    line_buf[line_pos++] = c;
+            }
+        }
+    }
+
+    if (got_done) {
+        result = asr_parse_response(done_buf, done_len, is_final);
+    }
+    return result;
+}
+
+/* POST a prepared multipart body and read the SSE response. Frees body.
+ * *status (if non-NULL) gets the HTTP status, 0 if none arrived; only a
+ * 2xx response is parsed. */
+static AsrResult *post_multipart_sse(unsigned char *body, size_t body_size,
+                                     const char *boundary, int port, int is_final,
+                                     asr_token_cb token_cb, void *userdata,
+                                     int *status) {
+    if (status) *status = 0;
+    HINTERNET hSession, hConnect;
+    HINTERNET hRequest = open_transcription(port, &hSession, &hConnect);
+    if (!hRequest) {
+        free(body);
+        return NULL;
+    }
+
+    wchar_t ct_header[256];
+    multipart_content_type(ct_header, 256, boundary);
+
+    BOOL ok = WinHttpSendRequest(hRequest, ct_header, (DWORD)-1L,
+                                  body, (DWORD)body_size, (DWORD)body_size, 0);
+    free(body);
+
+    if (ok) ok = WinHttpReceiveResponse(hRequest, NULL);
+
+    DWORD code = 0, code_size = sizeof(code);
+    if (ok && WinHttpQueryHeaders(hRequest,
+                                  WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                  WINHTTP_HEADER_NAME_BY_INDEX, &code, &code_size,
+                                  WINHTTP_NO_HEADER_INDEX)) {
+        if (status) *status = (int)code;
+        if (code < 200 || code >= 300) ok = FALSE;
+    }
+
+    AsrResult *result = NULL;
+    if (ok) result = read_sse_response(hRequest, is_final, token_cb, userdata);
+
+    close_transcription(hRequest, hConnect, hSession);
 
     return result;
 }
@@ -385,119 +524,127 @@ AsrResult *asr_transcribe_stream(const float *samples, int n_samples,
     char boundary[64];
     size_t body_size = 0;
     unsigned char *body = build_multipart_fmt(wav, wav_size, language, prompt,
-                                              "streaming_verbose_json",
+                                              "streaming_verbose_json", NULL,
                                               &body_size, boundary,
                                               sizeof(boundary));
     free(wav);
     if (!body) return NULL;
 
-    HINTERNET hSession = WinHttpOpen(L"AsrClient/1.0",
-                                      WINHTTP_ACCESS_TYPE_NO_PROXY,
-                                      WINHTTP_NO_PROXY_NAME,
-                                      WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) { free(body); return NULL; }
+    return post_multipart_sse(body, body_size, boundary, port, is_final,
+                              token_cb, userdata, NULL);
+}
 
-    HINTERNET hConnect = WinHttpConnect(hSession, L"localhost",
-                                         (INTERNET_PORT)port, 0);
-    if (!hConnect) {
-        WinHttpCloseHandle(hSession);
-        free(body);
-        return NULL;
+AsrResult *asr_transcribe_stream_mel(const unsigned char *feat, size_t feat_size,
+                                      int port, const char *language,
+                                      const char *prompt, int is_final,
+                                      asr_token_cb token_cb, void *userdata) {
+    if (!feat || feat_size == 0) return NULL;
+    char boundary[64];
+    size_t body_size = 0;
+    unsigned char *body = build_multipart_fmt(feat, feat_size, language, prompt,
+                                              "streaming_verbose_json", "log_mel",
+                                              &body_size, boundary,
+                                              sizeof(boundary));
+    if (!body) return NULL;
+
+    return post_multipart_sse(body, body_size, boundary, port, is_final,
+                              token_cb, userdata, NULL);
+}
+
+AsrResult *asr_transcribe_stream_blocks(const unsigned char *blocks, size_t size,
+                                         int port, const char *language,
+                                         const char *prompt, int is_final,
+                                         asr_token_cb token_cb, void *userdata,
+                                         int *rejected) {
+    if (rejected) *rejected = 0;
+    if (!blocks || size == 0) return NULL;
+    char boundary[64];
+    size_t body_size = 0;
+    unsigned char *body = build_multipart_fmt(blocks, size, language, prompt,
+                                              "streaming_verbose_json", "pcm_blocks",
+                                              &body_size, boundary,
+                                              sizeof(boundary));
+    if (!body) return NULL;
+
+    int status = 0;
+    AsrResult *r = post_multipart_sse(body, body_size, boundary, port, is_final,
+                                      token_cb, userdata, &status);
+    if (rejected && !r && status != 0 && (status < 200 || status >= 300))
+        *rejected = status;
+    return r;
+}
+
+/* Stream each span of a view straight from block memory as request body. */
+static BOOL write_view_body(HINTERNET hRequest, const audio_view_t *view) {
+    for (int i = 0; i < view->n_spans; i++) {
+        const audio_span_t *sp = &view->spans[i];
+        DWORD len = (DWORD)sp->length * 2;
+        DWORD written = 0;
+        if (!WinHttpWriteData(hRequest, sp->block->samples + sp->offset,
+                              len, &written) || written != len)
+            return FALSE;
     }
+    return TRUE;
+}
 
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST",
-                                             L"/v1/audio/transcriptions",
-                                             NULL, WINHTTP_NO_REFERER,
-                                             WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        free(body);
-        return NULL;
+AsrResult *asr_transcribe_stream_view(const audio_view_t *view,
+                                       int port, const char *language,
+                                       const char *prompt, int is_final,
+                                       asr_token_cb token_cb, void *userdata) {
+    if (!view || view->n_samples <= 0) return NULL;
+
+    LARGE_INTEGER ticks;
+    QueryPerformanceCounter(&ticks);
+    char boundary[64];
+    snprintf(boundary, sizeof(boundary), "----AsrClient%lld", ticks.QuadPart);
+
+    /* Head: file part header + WAV header; samples follow from the view */
+    unsigned char head[256 + 44];
+    int head_len = snprintf((char *)head, 256,
+                            "--%s\r\nContent-Disposition: form-data; name=\"file\"; "
+                            "filename=\"audio.wav\"\r\nContent-Type: audio/wav\r\n\r\n",
+                            boundary);
+    int data_bytes = view->n_samples * 2;
+    write_wav_header(head + head_len, data_bytes);
+    head_len += 44;
+
+    char tail[2048];
+    int tail_len = 0;
+#define TAIL_APPEND(fmt, ...) tail_len += snprintf(tail + tail_len, sizeof(tail) - tail_len, fmt, ##__VA_ARGS__)
+    TAIL_APPEND("\r\n--%s\r\nContent-Disposition: form-data; name=\"response_format\""
+                "\r\n\r\nstreaming_verbose_json\r\n", boundary);
+    if (language && language[0]) {
+        TAIL_APPEND("--%s\r\nContent-Disposition: form-data; name=\"language\""
+                    "\r\n\r\n%s\r\n", boundary, language);
     }
+    if (prompt && prompt[0]) {
+        TAIL_APPEND("--%s\r\nContent-Disposition: form-data; name=\"prompt\""
+                    "\r\n\r\n%s\r\n", boundary, prompt);
+    }
+    TAIL_APPEND("--%s--\r\n", boundary);
+#undef TAIL_APPEND
+    if (tail_len >= (int)sizeof(tail)) return NULL;
 
-    WinHttpSetTimeouts(hRequest, 2000, 2000, 60000, 60000);
+    HINTERNET hSession, hConnect;
+    HINTERNET hRequest = open_transcription(port, &hSession, &hConnect);
+    if (!hRequest) return NULL;
 
     wchar_t ct_header[256];
-    _snwprintf(ct_header, 256,
-               L"Content-Type: multipart/form-data; boundary=%hs", boundary);
+    multipart_content_type(ct_header, 256, boundary);
 
+    DWORD total = (DWORD)head_len + (DWORD)data_bytes + (DWORD)tail_len;
+    DWORD written = 0;
     BOOL ok = WinHttpSendRequest(hRequest, ct_header, (DWORD)-1L,
-                                  body, (DWORD)body_size, (DWORD)body_size, 0);
-    free(body);
-
+                                  WINHTTP_NO_REQUEST_DATA, 0, total, 0);
+    if (ok) ok = WinHttpWriteData(hRequest, head, (DWORD)head_len, &written);
+    if (ok) ok = write_view_body(hRequest, view);
+    if (ok) ok = WinHttpWriteData(hRequest, tail, (DWORD)tail_len, &written);
     if (ok) ok = WinHttpReceiveResponse(hRequest, NULL);
 
     AsrResult *result = NULL;
+    if (ok) result = read_sse_response(hRequest, is_final, token_cb, userdata);
 
-    if (ok) {
-        /* Read SSE stream incrementally */
-        char line_buf[4096];
-        int line_pos = 0;
-        char done_buf[65536];
-        int done_len = 0;
-        int got_done = 0;
-
-        for (;;) {
-            DWORD avail = 0;
-            if (!WinHttpQueryDataAvailable(hRequest, &avail)) break;
-            if (avail == 0) break;
-
-            char chunk[4096];
-            DWORD to_read = avail < sizeof(chunk) ? avail : sizeof(chunk);
-            DWORD bytes_read = 0;
-            if (!WinHttpReadData(hRequest, chunk, to_read, &bytes_read)) break;
-            if (bytes_read == 0) break;
-
-            /* Process bytes: accumulate lines, handle "data: " prefix */
-            for (DWORD i = 0; i < bytes_read; i++) {
-                char c = chunk[i];
-                if (c == '\n') {
-                    line_buf[line_pos] = '\0';
-                    /* Strip trailing \r */
-                    if (line_pos > 0 && line_buf[line_pos - 1] == '\r')
-                        line_buf[--line_pos] = '\0';
-
-                    if (line_pos > 6 && memcmp(line_buf, "data: ", 6) == 0) {
-                        const char *payload = line_buf + 6;
-                        int payload_len = line_pos - 6;
-
-                        if (strstr(payload, "\"done\"")) {
-                            /* Done event -- accumulate for final parse */
-                            if (payload_len < (int)sizeof(done_buf) - 1) {
-                                memcpy(done_buf, payload, payload_len);
-                                done_buf[payload_len] = '\0';
-                                done_len = payload_len;
-                                got_done = 1;
-                            }
-                        } else if (token_cb) {
-                            /* Token event */
-                            char token_text[512];
-                            int ams = 0, boff = 0;
-                            if (sse_parse_token_event(payload, payload_len,
-                                                       token_text,
-                                                       sizeof(token_text),
-                                                       &ams, &boff)) {
-                                token_cb(token_text, ams, boff, userdata);
-                            }
-                        }
-                    }
-                    line_pos = 0;
-                } else {
-                    if (line_pos < (int)sizeof(line_buf) - 1)
-                        line_buf[line_pos++] = c;
-                }
-            }
-        }
-
-        if (got_done) {
-            result = asr_parse_response(done_buf, done_len, is_final);
-        }
-    }
-
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
+    close_transcription(hRequest, hConnect, hSession);
 
     return result;
 }
@@ -707,6 +854,38 @@ int asr_live_send_audio(asr_live_session_t *s, const float *samples, int n_sampl
     return ret;
 }
 
+int asr_live_send_view(asr_live_session_t *s, const audio_view_t *view) {
+    if (!s || !view || view->n_samples <= 0) return -1;
+
+    DWORD data_bytes = (DWORD)view->n_samples * 2;
+    HINTERNET hReq = WinHttpOpenRequest(s->hConnect, L"POST",
+                                         L"/v1/audio/transcriptions/live/audio",
+                                         NULL, WINHTTP_NO_REFERER,
+                                         WINHTTP_DEFAULT_ACCEPT_TYPES, 0);
+    if (!hReq) {
+        fprintf(stderr, "[asr_live_send_view] OpenRequest failed: err=%lu\n", GetLastError());
+        return -1;
+    }
+    WinHttpSetTimeouts(hReq, 2000, 2000, 5000, 5000);
+    BOOL ok = WinHttpSendRequest(hReq,
+                                  L"Content-Type: application/octet-stream",
+                                  (DWORD)-1L, WINHTTP_NO_REQUEST_DATA, 0,
+                                  data_bytes, 0);
+    if (ok) ok = write_view_body(hReq, view);
+    if (ok) ok = WinHttpReceiveResponse(hReq, NULL);
+    int ret = -1;
+    if (ok) {
+        char buf[256];
+        DWORD br = 0;
+        WinHttpReadData(hReq, buf, sizeof(buf), &br);
+        ret = 0;
+    } else {
+        fprintf(stderr, "[asr_live_send_view] FAILED: err=%lu\n", GetLastError());
+    }
+    WinHttpCloseHandle(hReq);
+    return ret;
+}
+
 AsrResult *asr_live_stop(asr_live_session_t *s) {
     if (!s) return NULL;
     fprintf(stderr, "[asr_live_stop] Sending stop request\n");
@@ -10,6 +10,8 @@
 
 #include <stddef.h>
 
+#include "audio_buf.h"
+
 typedef struct {
     char *text;
     int is_final;
@@ -58,6 +60,35 @@ AsrResult *asr_transcribe_stream(const float *samples, int n_samples,
                                   const char *prompt, int is_final,
                                   asr_token_cb token_cb, void *userdata);
 
+/* Streaming transcribe from int16 view: the WAV body is written span by
+ * span from block memory, with no float conversion or body copy. The caller
+ * keeps ownership of view. */
+AsrResult *asr_transcribe_stream_view(const audio_view_t *view,
+                                       int port, const char *language,
+                                       const char *prompt, int is_final,
+                                       asr_token_cb token_cb, void *userdata);
+
+/* Streaming transcribe from client-side log-mel features: feat is an LMEL
+ * block (mel_fe_serialize) uploaded in place of WAV, with
+ * input_format=log_mel. audio_ms values are relative to the first frame.
+ * The caller keeps ownership of feat. */
+AsrResult *asr_transcribe_stream_mel(const unsigned char *feat, size_t feat_size,
+                                      int port, const char *language,
+                                      const char *prompt, int is_final,
+                                      asr_token_cb token_cb, void *userdata);
+
+/* Streaming transcribe from a PBLK block list (blk_build), uploaded with
+ * input_format=pcm_blocks. Returns NULL with *rejected set to the HTTP
+ * status if the server answered but refused the blocks: 409 if it no
+ * longer holds a referenced block, anything else if it does not take
+ * blocks at all. The caller then uploads the window in full. *rejected is
+ * 0 if no answer arrived. The caller keeps ownership of blocks. */
+AsrResult *asr_transcribe_stream_blocks(const unsigned char *blocks, size_t size,
+                                         int port, const char *language,
+                                         const char *prompt, int is_final,
+                                         asr_token_cb token_cb, void *userdata,
+                                         int *rejected);
+
 /* ---- Live streaming ASR ---- */
 
 typedef struct asr_live_session asr_live_session_t;
@@ -73,6 +104,10 @@ asr_live_session_t *asr_live_start(int port, const char *language,
  * Returns 0 on success, -1 on failure. */
 int asr_live_send_audio(asr_live_session_t *s, const float *samples, int n_samples);
 
+/* Send incremental int16 audio straight from a view's blocks.
+ * Returns 0 on success, -1 on failure. */
+int asr_live_send_view(asr_live_session_t *s, const audio_view_t *view);
+
 /* Signal end of audio and wait for the done event.
  * Returns final AsrResult (caller must asr_free_result), or NULL on error.
  * Frees the session handle. */
@@ -0,0 +1,150 @@
+/*
+ * audio_buf.c - Reference-counted immutable int16 audio blocks and views
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "audio_buf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+audio_block_t *audio_block_new(int n_samples) {
+    if (n_samples < 0) return NULL;
+    audio_block_t *b = (audio_block_t *)malloc(sizeof(audio_block_t)
+                                               + (size_t)n_samples * sizeof(int16_t));
+    if (!b) return NULL;
+    b->refs = 1;
+    b->samples = (int16_t *)(b + 1);
+    b->n_samples = n_samples;
+    b->destroy = NULL;
+    b->ctx = NULL;
+    return b;
+}
+
+audio_block_t *audio_block_wrap(int16_t *samples, int n_samples,
+                                void (*destroy)(audio_block_t *b), void *ctx) {
+    audio_block_t *b = (audio_block_t *)malloc(sizeof(audio_block_t));
+    if (!b) return NULL;
+    b->refs = 1;
+    b->samples = samples;
+    b->n_samples = n_samples;
+    b->destroy = destroy;
+    b->ctx = ctx;
+    return b;
+}
+
+void audio_block_retain(audio_block_t *b) {
+    if (b) InterlockedIncrement((volatile LONG *)&b->refs);
+}
+
+void audio_block_release(audio_block_t *b) {
+    if (!b) return;
+    if (InterlockedDecrement((volatile LONG *)&b->refs) != 0) return;
+    if (b->destroy) b->destroy(b);
+    free(b);
+}
+
+/* ---- Views ---- */
+
+int audio_view_append(audio_view_t *v, audio_block_t *block, int offset, int length) {
+    if (!v || !block || length <= 0) return 0;
+    if (v->n_spans > 0) {
+        audio_span_t *last = &v->spans[v->n_spans - 1];
+        if (last->block == block && last->offset + last->length == offset) {
+            last->length += length;
+            v->n_samples += length;
+            return 0;
+        }
+    }
+    if (v->n_spans == v->cap_spans) {
+        int cap = v->cap_spans ? v->cap_spans * 2 : 8;
+        audio_span_t *ns = (audio_span_t *)realloc(v->spans, cap * sizeof(audio_span_t));
+        if (!ns) return -1;
+        v->spans = ns;
+        v->cap_spans = cap;
+    }
+    audio_block_retain(block);
+    audio_span_t *sp = &v->spans[v->n_spans++];
+    sp->block = block;
+    sp->offset = offset;
+    sp->length = length;
+    v->n_samples += length;
+    return 0;
+}
+
+void audio_view_release(audio_view_t *v) {
+    if (!v) return;
+    for (int i = 0; i < v->n_spans; i++)
+        audio_block_release(v->spans[i].block);
+    free(v->spans);
+    memset(v, 0, sizeof(*v));
+}
+
+static int clamp_view_range(const audio_view_t *v, int start, int n) {
+    if (!v || start < 0 || start >= v->n_samples || n <= 0) return 0;
+    return n < v->n_samples - start ? n : v->n_samples - start;
+}
+
+/* Find the span containing sample start; *skip = offset within that span */
+static int find_span(const audio_view_t *v, int start, int *skip) {
+    int si = 0;
+    while (si < v->n_spans && start >= v->spans[si].length) {
+        start -= v->spans[si].length;
+        si++;
+    }
+    *skip = start;
+    return si;
+}
+
+int audio_view_slice(const audio_view_t *src, int start, int n, audio_view_t *out) {
+    if (!out) return 0;
+    n = clamp_view_range(src, start, n);
+    int skip;
+    int si = find_span(src, start, &skip);
+    while (n > 0 && si < src->n_spans) {
+        const audio_span_t *sp = &src->spans[si++];
+        int take = sp->length - skip;
+        if (take > n) take = n;
+        if (audio_view_append(out, sp->block, sp->offset + skip, take) != 0) {
+            audio_view_release(out);
+            return 0;
+        }
+        n -= take;
+        skip = 0;
+    }
+    return out->n_samples;
+}
+
+int audio_view_read_s16(const audio_view_t *v, int start, int n, int16_t *dst) {
+    if (!dst) return 0;
+    n = clamp_view_range(v, start, n);
+    int skip, done = 0;
+    int si = find_span(v, start, &skip);
+    while (done < n && si < v->n_spans) {
+        const audio_span_t *sp = &v->spans[si++];
+        int take = sp->length - skip;
+        if (take > n - done) take = n - done;
+        memcpy(dst + done, sp->block->samples + sp->offset + skip, take * sizeof(int16_t));
+        done += take;
+        skip = 0;
+    }
+    return done;
+}
+
+int audio_view_read_f32(const audio_view_t *v, int start, int n, float *dst) {
+    if (!dst) return 0;
+    n = clamp_view_range(v, start, n);
+    int skip, done = 0;
+    int si = find_span(v, start, &skip);
+    while (done < n && si < v->n_spans) {
+        const audio_span_t *sp = &v->spans[si++];
+        int take = sp->length - skip;
+        if (take > n - done) take = n - done;
+        const int16_t *src = sp->block->samples + sp->offset + skip;
+        for (int i = 0; i < take; i++)
+            dst[done + i] = src[i] / 32768.0f;
+        done += take;
+        skip = 0;
+    }
+    return done;
+}
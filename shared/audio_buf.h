@@ -0,0 +1,66 @@
+/*
+ * audio_buf.h - Reference-counted immutable int16 audio blocks and views
+ *
+ * A block owns a run of int16 samples. Samples a reader can see are never
+ * modified afterwards. Writers may only fill the tail of a block that has
+ * not been published yet. A view is a list of (block, offset, length) spans
+ * holding one reference per span, so a pass or playback job can keep audio
+ * alive after its producer moves on, without copying it.
+ */
+#ifndef AUDIO_BUF_H
+#define AUDIO_BUF_H
+
+#include <stdint.h>
+
+typedef struct audio_block audio_block_t;
+
+struct audio_block {
+    volatile long refs;
+    int16_t *samples;
+    int n_samples;
+    /* Called when the last reference goes; NULL for audio_block_new blocks */
+    void (*destroy)(audio_block_t *b);
+    void *ctx;
+};
+
+typedef struct {
+    audio_block_t *block;
+    int offset;
+    int length;
+} audio_span_t;
+
+typedef struct {
+    audio_span_t *spans;
+    int n_spans;
+    int cap_spans;
+    int n_samples;
+} audio_view_t;
+
+/* Allocate a block with room for n_samples (samples stored inline).
+ * Returns block with one reference, or NULL. */
+audio_block_t *audio_block_new(int n_samples);
+
+/* Wrap existing storage. destroy(b) runs on last release and must free
+ * whatever backs b->samples (b itself is freed afterwards). */
+audio_block_t *audio_block_wrap(int16_t *samples, int n_samples,
+                                void (*destroy)(audio_block_t *b), void *ctx);
+
+void audio_block_retain(audio_block_t *b);
+void audio_block_release(audio_block_t *b);
+
+/* Append a span to v, taking a reference on block. Adjacent spans of the
+ * same block are merged. Returns 0 on success, -1 on allocation failure. */
+int audio_view_append(audio_view_t *v, audio_block_t *block, int offset, int length);
+
+/* Drop all references and reset v to empty. */
+void audio_view_release(audio_view_t *v);
+
+/* Append references to [start, start+n) of src onto out. Returns out's
+ * total samples (0 on failure, with out released). */
+int audio_view_slice(const audio_view_t *src, int start, int n, audio_view_t *out);
+
+/* Copy [start, start+n) into dst. Returns samples copied. */
+int audio_view_read_s16(const audio_view_t *v, int start, int n, int16_t *dst);
+int audio_view_read_f32(const audio_view_t *v, int start, int n, float *dst);
+
+#endif /* AUDIO_BUF_H */
@@ -0,0 +1,347 @@
+/*
+ * audio_sink.c - Destination for playback PCM (waveOut, WAV file or null)
+ *
+ * Each backend embeds audio_sink_t first and supplies its ops. The waveOut
+ * ring is only touched by the writing thread; the device reports finished
+ * blocks through WHDR_DONE and the callback event. Only the waveOut sink
+ * needs Windows; the file and null sinks are plain C, so they also build
+ * where there is no sound device API.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "audio_sink.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+typedef struct {
+    int  (*write)(audio_sink_t *s, const int16_t *samples, int n);
+    void (*flush)(audio_sink_t *s);
+    void (*wait)(audio_sink_t *s, unsigned long timeout_ms);
+    long long (*played)(audio_sink_t *s);
+    long long (*pending)(audio_sink_t *s);
+    void (*close)(audio_sink_t *s);
+} sink_ops_t;
+
+struct audio_sink {
+    const sink_ops_t *ops;
+    int sample_rate;
+    long long written;
+};
+
+/* ---- waveOut ---- */
+
+#ifdef _WIN32
+
+#define SINK_BLOCK_MS 40
+#define SINK_BLOCKS   16    /* 640 ms of device-side buffering */
+
+typedef struct {
+    audio_sink_t base;
+    HWAVEOUT wo;
+    HANDLE done_event;
+    WAVEHDR hdr[SINK_BLOCKS];
+    int busy[SINK_BLOCKS];      /* submitted and not yet reclaimed */
+    int16_t *buf;               /* SINK_BLOCKS * block_samples */
+    int block_samples;
+    int fill;                   /* block being filled */
+    int fill_n;
+    int start_samples;
+    int holding;                /* paused until start_samples are queued */
+    long long queued;           /* samples in busy blocks */
+} wo_sink_t;
+
+static void wo_reclaim(wo_sink_t *w) {
+    for (int i = 0; i < SINK_BLOCKS; i++) {
+        if (!w->busy[i] || !(w->hdr[i].dwFlags & WHDR_DONE)) continue;
+        waveOutUnprepareHeader(w->wo, &w->hdr[i], sizeof(WAVEHDR));
+        w->queued -= w->hdr[i].dwBufferLength / sizeof(int16_t);
+        w->busy[i] = 0;
+    }
+}
+
+static int wo_submit(wo_sink_t *w) {
+    WAVEHDR *h = &w->hdr[w->fill];
+    /* Nothing left on the device mid-stream: rebuffer before resuming */
+    if (!w->holding && w->queued == 0) {
+        waveOutPause(w->wo);
+        w->holding = 1;
+    }
+    memset(h, 0, sizeof(*h));
+    h->lpData = (LPSTR)(w->buf + (size_t)w->fill * w->block_samples);
+    h->dwBufferLength = (DWORD)(w->fill_n * sizeof(int16_t));
+    if (waveOutPrepareHeader(w->wo, h, sizeof(*h)) != MMSYSERR_NOERROR) return -1;
+    if (waveOutWrite(w->wo, h, sizeof(*h)) != MMSYSERR_NOERROR) {
+        waveOutUnprepareHeader(w->wo, h, sizeof(*h));
+        return -1;
+    }
+    w->busy[w->fill] = 1;
+    w->queued += w->fill_n;
+    w->fill = (w->fill + 1) % SINK_BLOCKS;
+    w->fill_n = 0;
+    if (w->holding && w->queued >= w->start_samples) {
+        waveOutRestart(w->wo);
+        w->holding = 0;
+    }
+    return 0;
+}
+
+static int wo_write(audio_sink_t *s, const int16_t *samples, int n) {
+    wo_sink_t *w = (wo_sink_t *)s;
+    wo_reclaim(w);
+    int taken = 0;
+    while (taken < n && !w->busy[w->fill]) {
+        int k = w->block_samples - w->fill_n;
+        if (k > n - taken) k = n - taken;
+        memcpy(w->buf + (size_t)w->fill * w->block_samples + w->fill_n,
+               samples + taken, k * sizeof(int16_t));
+        w->fill_n += k;
+        taken += k;
+        if (w->fill_n == w->block_samples && wo_submit(w) != 0) return -1;
+    }
+    return taken;
+}
+
+static void wo_flush(audio_sink_t *s) {
+    wo_sink_t *w = (wo_sink_t *)s;
+    wo_reclaim(w);
+    if (w->fill_n > 0 && !w->busy[w->fill]) wo_submit(w);
+    if (w->holding) {
+        waveOutRestart(w->wo);
+        w->holding = 0;
+    }
+}
+
+static void wo_wait(audio_sink_t *s, unsigned long timeout_ms) {
+    wo_sink_t *w = (wo_sink_t *)s;
+    if (w->queued > 0) WaitForSingleObject(w->done_event, timeout_ms);
+    wo_reclaim(w);
+}
+
+static long long wo_played(audio_sink_t *s) {
+    wo_sink_t *w = (wo_sink_t *)s;
+    MMTIME mmt = {0};
+    mmt.wType = TIME_SAMPLES;
+    if (waveOutGetPosition(w->wo, &mmt, sizeof(mmt)) != MMSYSERR_NOERROR
+        || mmt.wType != TIME_SAMPLES)
+        return s->written - w->queued - w->fill_n;
+    long long played = (long long)mmt.u.sample;
+    return played < s->written ? played : s->written;
+}
+
+static long long wo_pending(audio_sink_t *s) {
+    wo_sink_t *w = (wo_sink_t *)s;
+    wo_reclaim(w);
+    return w->queued + w->fill_n;
+}
+
+static void wo_close(audio_sink_t *s) {
+    wo_sink_t *w = (wo_sink_t *)s;
+    waveOutReset(w->wo);
+    for (int i = 0; i < SINK_BLOCKS; i++)
+        if (w->busy[i]) waveOutUnprepareHeader(w->wo, &w->hdr[i], sizeof(WAVEHDR));
+    waveOutClose(w->wo);
+    CloseHandle(w->done_event);
+    free(w->buf);
+    free(w);
+}
+
+static const sink_ops_t wo_ops = {
+    wo_write, wo_flush, wo_wait, wo_played, wo_pending, wo_close
+};
+
+audio_sink_t *audio_sink_open_waveout(int sample_rate, int start_ms) {
+    if (sample_rate <= 0) return NULL;
+    wo_sink_t *w = (wo_sink_t *)calloc(1, sizeof(wo_sink_t));
+    if (!w) return NULL;
+    w->base.ops = &wo_ops;
+    w->base.sample_rate = sample_rate;
+    w->block_samples = sample_rate * SINK_BLOCK_MS / 1000;
+    w->start_samples = (int)((long long)sample_rate * start_ms / 1000);
+    /* The ring must be able to hold the threshold */
+    if (w->start_samples > w->block_samples * (SINK_BLOCKS - 1))
+        w->start_samples = w->block_samples * (SINK_BLOCKS - 1);
+    w->buf = (int16_t *)malloc((size_t)SINK_BLOCKS * w->block_samples * sizeof(int16_t));
+    w->done_event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    if (!w->buf || !w->done_event) goto fail;
+
+    WAVEFORMATEX wfx = {0};
+    wfx.wFormatTag = WAVE_FORMAT_PCM;
+    wfx.nChannels = 1;
+    wfx.nSamplesPerSec = (DWORD)sample_rate;
+    wfx.wBitsPerSample = 16;
+    wfx.nBlockAlign = 2;
+    wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * 2;
+    if (waveOutOpen(&w->wo, WAVE_MAPPER, &wfx, (DWORD_PTR)w->done_event, 0,
+                    CALLBACK_EVENT) != MMSYSERR_NOERROR)
+        goto fail;
+    waveOutPause(w->wo);
+    w->holding = 1;
+    return &w->base;
+
+fail:
+    if (w->done_event) CloseHandle(w->done_event);
+    free(w->buf);
+    free(w);
+    return NULL;
+}
+
+#else
+
+audio_sink_t *audio_sink_open_waveout(int sample_rate, int start_ms) {
+    (void)sample_rate;
+    (void)start_ms;
+    return NULL;
+}
+
+#endif /* _WIN32 */
+
+/* ---- WAV file ---- */
+
+typedef struct {
+    audio_sink_t base;
+    FILE *f;
+} file_sink_t;
+
+static void file_header(FILE *f, int sample_rate, long long n_samples) {
+    uint32_t data = (uint32_t)(n_samples * 2);
+    uint32_t riff = 36 + data;
+    uint32_t fmt_size = 16, rate = (uint32_t)sample_rate, byte_rate = rate * 2;
+    uint16_t format = 1, channels = 1, align = 2, bits = 16;
+    fwrite("RIFF", 1, 4, f);
+    fwrite(&riff, 4, 1, f);
+    fwrite("WAVEfmt ", 1, 8, f);
+    fwrite(&fmt_size, 4, 1, f);
+    fwrite(&format, 2, 1, f);
+    fwrite(&channels, 2, 1, f);
+    fwrite(&rate, 4, 1, f);
+    fwrite(&byte_rate, 4, 1, f);
+    fwrite(&align, 2, 1, f);
+    fwrite(&bits, 2, 1, f);
+    fwrite("data", 1, 4, f);
+    fwrite(&data, 4, 1, f);
+}
+
+static int file_write(audio_sink_t *s, const int16_t *samples, int n) {
+    file_sink_t *fs = (file_sink_t *)s;
+    return fwrite(samples, sizeof(int16_t), n, fs->f) == (size_t)n ? n : -1;
+}
+
+static void file_flush(audio_sink_t *s) { fflush(((file_sink_t *)s)->f); }
+static void file_wait(audio_sink_t *s, unsigned long timeout_ms) { (void)s; (void)timeout_ms; }
+static long long file_played(audio_sink_t *s) { return s->written; }
+static long long file_pending(audio_sink_t *s) { (void)s; return 0; }
+
+static void file_close(audio_sink_t *s) {
+    file_sink_t *fs = (file_sink_t *)s;
+    fseek(fs->f, 0, SEEK_SET);
+    file_header(fs->f, s->sample_rate, s->written);
+    fclose(fs->f);
+    free(fs);
+}
+
+static const sink_ops_t file_ops = {
+    file_write, file_flush, file_wait, file_played, file_pending, file_close
+};
+
+audio_sink_t *audio_sink_open_file(const char *path, int sample_rate) {
+    if (sample_rate <= 0) return NULL;
+    file_sink_t *fs = (file_sink_t *)calloc(1, sizeof(file_sink_t));
+    if (!fs) return NULL;
+    fs->f = fopen(path, "wb");
+    if (!fs->f) {
+        free(fs);
+        return NULL;
+    }
+    fs->base.ops = &file_ops;
+    fs->base.sample_rate = sample_rate;
+    file_header(fs->f, sample_rate, 0);
+    return &fs->base;
+}
+
+/* ---- Null ---- */
+
+/* With realtime set, the clock only moves in null_wait: each wait plays
+ * the samples its timeout covers, at once. Playback is then paced by the
+ * caller's waits, as with a device, without reading any wall clock. */
+typedef struct {
+    audio_sink_t base;
+    int realtime;
+    long long played;
+} null_sink_t;
+
+static int null_write(audio_sink_t *s, const int16_t *samples, int n) {
+    (void)s;
+    (void)samples;
+    return n;
+}
+
+static void null_flush(audio_sink_t *s) { (void)s; }
+
+static long long null_played(audio_sink_t *s) {
+    null_sink_t *ns = (null_sink_t *)s;
+    return ns->realtime ? ns->played : s->written;
+}
+
+static long long null_pending(audio_sink_t *s) { return s->written - null_played(s); }
+
+static void null_wait(audio_sink_t *s, unsigned long timeout_ms) {
+    null_sink_t *ns = (null_sink_t *)s;
+    if (!ns->realtime) return;
+    long long step = (long long)timeout_ms * s->sample_rate / 1000;
+    if (step < 1) step = 1;
+    ns->played = s->written - ns->played > step ? ns->played + step : s->written;
+}
+
+static void null_close(audio_sink_t *s) { free(s); }
+
+static const sink_ops_t null_ops = {
+    null_write, null_flush, null_wait, null_played, null_pending, null_close
+};
+
+audio_sink_t *audio_sink_open_null(int sample_rate, int realtime) {
+    if (sample_rate <= 0) return NULL;
+    null_sink_t *ns = (null_sink_t *)calloc(1, sizeof(null_sink_t));
+    if (!ns) return NULL;
+    ns->base.ops = &null_ops;
+    ns->base.sample_rate = sample_rate;
+    ns->realtime = realtime;
+    return &ns->base;
+}
+
+/* ---- Common ---- */
+
+int audio_sink_write(audio_sink_t *s, const int16_t *samples, int n) {
+    if (!s || n <= 0) return 0;
+    int k = s->ops->write(s, samples, n);
+    if (k > 0) s->written += k;
+    return k;
+}
+
+void audio_sink_flush(audio_sink_t *s) {
+    if (s) s->ops->flush(s);
+}
+
+void audio_sink_wait(audio_sink_t *s, unsigned long timeout_ms) {
+    if (s) s->ops->wait(s, timeout_ms);
+}
+
+long long audio_sink_played(audio_sink_t *s) {
+    return s ? s->ops->played(s) : 0;
+}
+
+long long audio_sink_pending(audio_sink_t *s) {
+    return s ? s->ops->pending(s) : 0;
+}
+
+int audio_sink_rate(const audio_sink_t *s) {
+    return s ? s->sample_rate : 0;
+}
+
+void audio_sink_close(audio_sink_t *s) {
+    if (s) s->ops->close(s);
+}
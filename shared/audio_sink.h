@@ -0,0 +1,51 @@
+/*
+ * audio_sink.h - Destination for playback PCM (waveOut, WAV file or null)
+ *
+ * A sink takes mono int16 PCM in pieces as it becomes available. The
+ * waveOut sink copies it into a ring of small blocks: nothing is heard
+ * until start_ms is queued (or the writer flushes), and after an underrun
+ * it holds off again until start_ms is back. Writes never block; a full
+ * ring takes fewer samples and the caller waits with audio_sink_wait.
+ *
+ * The file and null sinks keep the same interface and clock, so code that
+ * streams into a sink runs without a sound device (they also build off
+ * Windows, where audio_sink_open_waveout returns NULL).
+ */
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include <stdint.h>
+
+typedef struct audio_sink audio_sink_t;
+
+/* Returns NULL on failure. */
+audio_sink_t *audio_sink_open_waveout(int sample_rate, int start_ms);
+/* Writes a WAV file; everything written counts as played. */
+audio_sink_t *audio_sink_open_file(const char *path, int sample_rate);
+/* Drops samples. With realtime, samples count as played only as
+ * audio_sink_wait is called, timeout_ms worth per call (a simulated device
+ * clock); otherwise as soon as they are written. */
+audio_sink_t *audio_sink_open_null(int sample_rate, int realtime);
+
+/* Queue up to n samples. Returns the number taken (0 when full), or -1 on
+ * a device or I/O error. */
+int audio_sink_write(audio_sink_t *s, const int16_t *samples, int n);
+
+/* End of input: queue any partial block and start playback even if the
+ * start threshold was not reached. */
+void audio_sink_flush(audio_sink_t *s);
+
+/* Wait up to timeout_ms for queued audio to play (room to write, or the
+ * end of playback after a flush). */
+void audio_sink_wait(audio_sink_t *s, unsigned long timeout_ms);
+
+/* Samples played so far, and samples written but not played yet */
+long long audio_sink_played(audio_sink_t *s);
+long long audio_sink_pending(audio_sink_t *s);
+
+int audio_sink_rate(const audio_sink_t *s);
+
+/* Stop at once, dropping anything unplayed, and free s. */
+void audio_sink_close(audio_sink_t *s);
+
+#endif /* AUDIO_SINK_H */
@@ -0,0 +1,194 @@
+/*
+ * base64.c - Incremental base64 decoder
+ *
+ * The vector path classifies 16 characters at once with two nibble lookup
+ * tables (any byte outside the alphabet sends the block to the scalar
+ * loop), maps them to 6-bit values with a third, and packs 16 values into
+ * 12 bytes. It only runs on a quantum boundary, so a block never straddles
+ * bits carried over from the previous piece.
+ */
+#include "base64.h"
+
+#include <stdint.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <tmmintrin.h>
+#define B64_SSSE3 1
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#include <arm_neon.h>
+#define B64_NEON 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define B64_SKIP (-2)   /* whitespace, JSON escape backslash */
+#define B64_PAD  (-3)
+
+static const signed char b64_table[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-2,-2,-1,-1,-2,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -2,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,62,-1,-1,-1,63,
+    52,53,54,55,56,57,58,59,60,61,-1,-1,-1,-3,-1,-1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
+    15,16,17,18,19,20,21,22,23,24,25,-1,-2,-1,-1,-1,
+    -1,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
+    41,42,43,44,45,46,47,48,49,50,51,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+/* Nibble tables: a character is in the alphabet when the low- and
+ * high-nibble classes share no bit; the roll is added to get its value
+ * (index 1 is taken by '/', the only character whose roll differs from the
+ * rest of its high nibble). */
+static const uint8_t b64_lut_lo[16] = {
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+};
+static const uint8_t b64_lut_hi[16] = {
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+};
+static const int8_t b64_lut_roll[16] = {
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+};
+/* Big-endian 24-bit groups out of each 32-bit lane */
+static const uint8_t b64_pack[16] = {
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/* ---- Vector blocks ---- */
+
+#ifdef B64_SSSE3
+
+#if defined(__GNUC__) || defined(__clang__)
+#define B64_SSSE3_FN __attribute__((target("ssse3")))
+#else
+#define B64_SSSE3_FN
+#endif
+
+static int cpu_has_ssse3(void) {
+    static int known = -1;  /* racing first calls store the same answer */
+    if (known < 0) {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 1);
+        known = (info[2] >> 9) & 1;
+#else
+        known = __builtin_cpu_supports("ssse3") ? 1 : 0;
+#endif
+    }
+    return known;
+}
+
+/* Decode whole clean 16-character blocks. Returns characters consumed. */
+B64_SSSE3_FN
+static int decode_blocks(const char *in, int len, unsigned char *out) {
+    if (!cpu_has_ssse3()) return 0;
+    const __m128i lut_lo = _mm_loadu_si128((const __m128i *)b64_lut_lo);
+    const __m128i lut_hi = _mm_loadu_si128((const __m128i *)b64_lut_hi);
+    const __m128i lut_roll = _mm_loadu_si128((const __m128i *)b64_lut_roll);
+    const __m128i pack = _mm_loadu_si128((const __m128i *)b64_pack);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; len - i >= 16; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i hi = _mm_and_si128(_mm_srli_epi32(v, 4), nibble);
+        __m128i lo = _mm_and_si128(v, nibble);
+        __m128i cls = _mm_and_si128(_mm_shuffle_epi8(lut_lo, lo),
+                                    _mm_shuffle_epi8(lut_hi, hi));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(cls, zero))) break;
+        __m128i roll = _mm_shuffle_epi8(lut_roll,
+                                        _mm_add_epi8(_mm_cmpeq_epi8(v, slash), hi));
+        __m128i vals = _mm_add_epi8(v, roll);
+        /* aaaaaa bbbbbb -> 12 bits, then two of those -> 24 bits per lane */
+        __m128i ab = _mm_maddubs_epi16(vals, _mm_set1_epi32(0x01400140));
+        __m128i abcd = _mm_madd_epi16(ab, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i *)(out + i / 4 * 3), _mm_shuffle_epi8(abcd, pack));
+    }
+    return i;
+}
+
+#elif defined(B64_NEON)
+
+static int decode_blocks(const char *in, int len, unsigned char *out) {
+    const uint8x16_t lut_lo = vld1q_u8(b64_lut_lo);
+    const uint8x16_t lut_hi = vld1q_u8(b64_lut_hi);
+    const uint8x16_t lut_roll = vld1q_u8((const uint8_t *)b64_lut_roll);
+    const uint8x16_t pack = vld1q_u8(b64_pack);
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+    const uint32x4_t byte = vdupq_n_u32(0xFF);
+    int i = 0;
+    for (; len - i >= 16; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(in + i));
+        uint8x16_t hi = vshrq_n_u8(v, 4);
+        uint8x16_t cls = vandq_u8(vqtbl1q_u8(lut_lo, vandq_u8(v, nibble)),
+                                  vqtbl1q_u8(lut_hi, hi));
+        if (vmaxvq_u8(cls) != 0) break;
+        uint8x16_t roll = vqtbl1q_u8(lut_roll,
+                                     vaddq_u8(vceqq_u8(v, vdupq_n_u8('/')), hi));
+        uint32x4_t w = vreinterpretq_u32_u8(vaddq_u8(v, roll));
+        uint32x4_t abcd = vorrq_u32(
+            vorrq_u32(vshlq_n_u32(vandq_u32(w, byte), 18),
+                      vshlq_n_u32(vandq_u32(vshrq_n_u32(w, 8), byte), 12)),
+            vorrq_u32(vshlq_n_u32(vandq_u32(vshrq_n_u32(w, 16), byte), 6),
+                      vshrq_n_u32(w, 24)));
+        vst1q_u8(out + i / 4 * 3, vqtbl1q_u8(vreinterpretq_u8_u32(abcd), pack));
+    }
+    return i;
+}
+
+#else
+
+static int decode_blocks(const char *in, int len, unsigned char *out) {
+    (void)in;
+    (void)len;
+    (void)out;
+    return 0;
+}
+
+#endif
+
+/* ---- Decoder ---- */
+
+void b64_decode_init(b64_decoder_t *d) {
+    d->acc = 0;
+    d->bits = 0;
+    d->done = 0;
+    d->bad = 0;
+}
+
+int b64_decode_update(b64_decoder_t *d, const char *in, int len, unsigned char *out) {
+    int i = 0, n = 0;
+    while (i < len && !d->done) {
+        if (d->bits == 0 && len - i >= 16) {
+            int k = decode_blocks(in + i, len - i, out + n);
+            i += k;
+            n += k / 4 * 3;
+            if (i >= len) break;
+        }
+        int v = b64_table[(unsigned char)in[i++]];
+        if (v < 0) {
+            if (v == B64_PAD) d->done = 1;
+            else if (v != B64_SKIP) d->bad++;
+            continue;
+        }
+        d->acc = (d->acc << 6) | (unsigned)v;
+        d->bits += 6;
+        if (d->bits >= 8) {
+            d->bits -= 8;
+            out[n++] = (unsigned char)(d->acc >> d->bits);
+            d->acc &= (1u << d->bits) - 1;
+        }
+    }
+    return n;
+}
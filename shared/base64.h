@@ -0,0 +1,30 @@
+/*
+ * base64.h - Incremental base64 decoder
+ *
+ * Input may arrive in pieces of any size (straight off the socket); bits of
+ * a partial quantum are carried to the next call, so the decoded bytes are
+ * identical however the text was split. Whitespace and the '\' of JSON's
+ * "\/" escape are skipped, '=' ends the input. Runs of 16 clean characters
+ * are decoded with SSSE3 (checked at run time) or NEON where available.
+ */
+#ifndef BASE64_H
+#define BASE64_H
+
+/* Output room needed for len input characters (includes 4 bytes of slack
+ * for the 16-byte vector stores) */
+#define B64_DECODED_MAX(len) (((len) + 3) / 4 * 3 + 4)
+
+typedef struct {
+    unsigned acc;       /* bits not yet written */
+    int bits;
+    int done;           /* '=' seen */
+    int bad;            /* characters outside the alphabet (dropped) */
+} b64_decoder_t;
+
+void b64_decode_init(b64_decoder_t *d);
+
+/* Decode len characters into out (at least B64_DECODED_MAX(len) bytes).
+ * Returns the number of bytes written. */
+int b64_decode_update(b64_decoder_t *d, const char *in, int len, unsigned char *out);
+
+#endif /* BASE64_H */
@@ -0,0 +1,204 @@
+/*
+ * block_upload.c - Incremental PCM upload with content-hashed blocks
+ *
+ * Per block index the uploader keeps the hash (computed the first time the
+ * block is complete) and whether the server holds it. Blocks carried by
+ * the request in flight are PENDING until blk_finish; a failed request
+ * turns them back to UNSENT. Because the recording is append-only, a full
+ * block's content and hash never change. A lock makes reset from the UI
+ * thread safe against blk_finish on a worker.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "block_upload.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define BLK_MAGIC    "PBLK"
+#define BLK_VERSION  1
+
+enum { BLK_UNSENT = 0, BLK_PENDING, BLK_SENT };
+
+typedef struct {
+    uint64_t hash;
+    unsigned char state;
+    unsigned char hashed;
+} blk_info_t;
+
+struct blk_uploader {
+    CRITICAL_SECTION lock;
+    int sample_rate;
+    blk_info_t *blocks;
+    int n_blocks;
+    int cap;
+};
+
+uint64_t blk_hash(const int16_t *pcm, int n) {
+    const unsigned char *p = (const unsigned char *)pcm;
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < (size_t)n * 2; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+blk_uploader_t *blk_uploader_create(int sample_rate) {
+    blk_uploader_t *u = (blk_uploader_t *)calloc(1, sizeof(blk_uploader_t));
+    if (!u) return NULL;
+    InitializeCriticalSection(&u->lock);
+    u->sample_rate = sample_rate;
+    return u;
+}
+
+void blk_uploader_destroy(blk_uploader_t *u) {
+    if (!u) return;
+    DeleteCriticalSection(&u->lock);
+    free(u->blocks);
+    free(u);
+}
+
+void blk_uploader_reset(blk_uploader_t *u) {
+    if (!u) return;
+    EnterCriticalSection(&u->lock);
+    u->n_blocks = 0;
+    LeaveCriticalSection(&u->lock);
+}
+
+long long blk_align_down(long long sample) {
+    return sample - sample % BLK_SAMPLES;
+}
+
+static blk_info_t *block_info(blk_uploader_t *u, int idx) {
+    if (idx >= u->cap) {
+        int nc = u->cap ? u->cap * 2 : 256;
+        while (nc <= idx) nc *= 2;
+        blk_info_t *nb = (blk_info_t *)realloc(u->blocks, nc * sizeof(blk_info_t));
+        if (!nb) return NULL;
+        u->blocks = nb;
+        u->cap = nc;
+    }
+    if (idx >= u->n_blocks) {
+        memset(u->blocks + u->n_blocks, 0, (idx + 1 - u->n_blocks) * sizeof(blk_info_t));
+        u->n_blocks = idx + 1;
+    }
+    return &u->blocks[idx];
+}
+
+typedef struct {
+    int kind;
+    int src_off;        /* block start within src */
+    int offset, length, block_samples;
+    uint64_t hash;
+} plan_t;
+
+unsigned char *blk_build(blk_uploader_t *u, const audio_view_t *src,
+                         long long win_start, int n, size_t *size, int *carried) {
+    if (!u || !src || n <= 0) return NULL;
+    long long base = blk_align_down(win_start);
+    int first = (int)(base / BLK_SAMPLES);
+    int head = (int)(win_start - base);
+    if (src->n_samples < head + n) return NULL;
+
+    int n_entries = (head + n + BLK_SAMPLES - 1) / BLK_SAMPLES;
+    plan_t *plan = (plan_t *)calloc(n_entries, sizeof(plan_t));
+    int16_t *tmp = (int16_t *)malloc(BLK_SAMPLES * sizeof(int16_t));
+    if (!plan || !tmp) {
+        free(plan);
+        free(tmp);
+        return NULL;
+    }
+
+    size_t total = BLK_HEADER_BYTES;
+    int data_samples = 0;
+    EnterCriticalSection(&u->lock);
+    for (int e = 0; e < n_entries; e++) {
+        plan_t *pl = &plan[e];
+        pl->src_off = e * BLK_SAMPLES;
+        int avail = src->n_samples - pl->src_off;
+        pl->block_samples = avail < BLK_SAMPLES ? avail : BLK_SAMPLES;
+        pl->offset = e == 0 ? head : 0;
+        int end = head + n - pl->src_off;
+        if (end > BLK_SAMPLES) end = BLK_SAMPLES;
+        pl->length = end - pl->offset;
+
+        if (pl->block_samples < BLK_SAMPLES) {
+            /* Still growing: send just the slice the window needs */
+            pl->kind = BLK_TAIL;
+            pl->src_off += pl->offset;
+            pl->offset = 0;
+            pl->block_samples = pl->length;
+        } else {
+            blk_info_t *bi = block_info(u, first + e);
+            if (!bi) {
+                LeaveCriticalSection(&u->lock);
+                free(plan);
+                free(tmp);
+                blk_finish(u, 0);
+                return NULL;
+            }
+            if (!bi->hashed) {
+                audio_view_read_s16(src, pl->src_off, BLK_SAMPLES, tmp);
+                bi->hash = blk_hash(tmp, BLK_SAMPLES);
+                bi->hashed = 1;
+            }
+            pl->hash = bi->hash;
+            if (bi->state == BLK_SENT) {
+                pl->kind = BLK_REF;
+            } else {
+                pl->kind = BLK_DATA;
+                bi->state = BLK_PENDING;
+            }
+        }
+        total += BLK_ENTRY_BYTES;
+        if (pl->kind != BLK_REF) {
+            total += (size_t)pl->block_samples * 2;
+            data_samples += pl->block_samples;
+        }
+    }
+    LeaveCriticalSection(&u->lock);
+    free(tmp);
+
+    unsigned char *out = (unsigned char *)malloc(total);
+    if (!out) {
+        free(plan);
+        blk_finish(u, 0);
+        return NULL;
+    }
+    memcpy(out, BLK_MAGIC, 4);
+    *(uint16_t *)(out + 4) = BLK_VERSION;
+    *(uint16_t *)(out + 6) = (uint16_t)n_entries;
+    *(uint32_t *)(out + 8) = (uint32_t)u->sample_rate;
+    *(uint32_t *)(out + 12) = (uint32_t)n;
+    size_t pos = BLK_HEADER_BYTES;
+    for (int e = 0; e < n_entries; e++) {
+        const plan_t *pl = &plan[e];
+        unsigned char *h = out + pos;
+        memset(h, 0, BLK_ENTRY_BYTES);
+        h[0] = (unsigned char)pl->kind;
+        *(uint32_t *)(h + 4) = (uint32_t)pl->offset;
+        *(uint32_t *)(h + 8) = (uint32_t)pl->length;
+        *(uint32_t *)(h + 12) = (uint32_t)pl->block_samples;
+        *(uint64_t *)(h + 16) = pl->hash;
+        pos += BLK_ENTRY_BYTES;
+        if (pl->kind != BLK_REF) {
+            audio_view_read_s16(src, pl->src_off, pl->block_samples, (int16_t *)(out + pos));
+            pos += (size_t)pl->block_samples * 2;
+        }
+    }
+    free(plan);
+    *size = total;
+    if (carried) *carried = data_samples;
+    return out;
+}
+
+void blk_finish(blk_uploader_t *u, int ok) {
+    if (!u) return;
+    EnterCriticalSection(&u->lock);
+    for (int i = 0; i < u->n_blocks; i++) {
+        if (u->blocks[i].state == BLK_PENDING)
+            u->blocks[i].state = ok ? BLK_SENT : BLK_UNSENT;
+    }
+    LeaveCriticalSection(&u->lock);
+}
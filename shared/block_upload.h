@@ -0,0 +1,66 @@
+/*
+ * block_upload.h - Incremental PCM upload with content-hashed blocks
+ *
+ * A recording is cut into BLK_SAMPLES blocks aligned to its start. Each
+ * full block is hashed once; after the server has acknowledged a pass that
+ * carried it, later passes reference it by hash instead of sending it
+ * again. Only blocks the server has not seen and the partial tail block
+ * travel as samples, so a pass uploads about as much as the audio that is
+ * new since the last one, not the whole window.
+ *
+ * Request body ("file" part, input_format=pcm_blocks), little-endian:
+ *   "PBLK" u16 version u16 n_entries u32 sample_rate u32 total_samples
+ *   n_entries * { u8 kind u8[3] 0 u32 offset u32 length u32 block_samples
+ *                 u64 hash [block_samples * int16 if kind != BLK_REF] }
+ * The window is the concatenation of each entry's [offset, offset+length)
+ * slice of its block. hash is 64-bit FNV-1a over the block's int16 bytes.
+ * A server that lacks a referenced block answers 409 and the client falls
+ * back to a full upload, then resends every block it references again.
+ *
+ * Calls are thread-safe, but blocks carried by the request in flight are
+ * tracked as one set, so keep a single pass in flight per uploader.
+ */
+#ifndef BLOCK_UPLOAD_H
+#define BLOCK_UPLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_buf.h"
+
+#define BLK_SAMPLES       4000      /* 250 ms at 16 kHz: bounds the resent tail */
+#define BLK_HEADER_BYTES  16
+#define BLK_ENTRY_BYTES   24
+
+typedef enum {
+    BLK_REF = 1,        /* block the server already has */
+    BLK_DATA,           /* full block: server caches it by hash */
+    BLK_TAIL            /* partial block: used once, not cached */
+} blk_kind_t;
+
+typedef struct blk_uploader blk_uploader_t;
+
+blk_uploader_t *blk_uploader_create(int sample_rate);
+void blk_uploader_destroy(blk_uploader_t *u);
+
+/* Forget what the server holds (new recording, or after a miss). */
+void blk_uploader_reset(blk_uploader_t *u);
+
+/* First sample of the block containing sample. */
+long long blk_align_down(long long sample);
+
+/* Build the body for window [win_start, win_start + n). src holds the
+ * recording from blk_align_down(win_start) to at least the window end.
+ * Returns malloc'd bytes (caller frees) and sets *size and, if non-NULL,
+ * *carried (samples sent as data), or NULL on failure. */
+unsigned char *blk_build(blk_uploader_t *u, const audio_view_t *src,
+                         long long win_start, int n, size_t *size, int *carried);
+
+/* Outcome of the last blk_build's request: acknowledged blocks become
+ * referenceable; on failure they will be sent again. */
+void blk_finish(blk_uploader_t *u, int ok);
+
+/* FNV-1a 64 of n samples. */
+uint64_t blk_hash(const int16_t *pcm, int n);
+
+#endif /* BLOCK_UPLOAD_H */
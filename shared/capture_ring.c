@@ -0,0 +1,146 @@
+/*
+ * capture_ring.c - Lock-free single-producer/single-consumer audio ring
+ *
+ * Producer and consumer indices sit on separate cache lines so the capture
+ * thread and the UI thread never share a written line. The energy pair is
+ * published under a sequence count, so readers never see one half updated.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "capture_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <windows.h>
+
+#define CACHE_LINE 64
+#define SPIN_LIMIT 64           /* energy read retries before yielding the CPU */
+
+struct capture_ring {
+    /* Written by the producer */
+    volatile LONG64 write_pos;
+    volatile LONG64 abs_sum;
+    volatile LONG64 overruns;
+    volatile LONG seq;           /* odd while write_pos/abs_sum are updating */
+    char pad0[CACHE_LINE - 3 * sizeof(LONG64) - sizeof(LONG)];
+    /* Written by the consumer */
+    volatile LONG64 read_pos;
+    char pad1[CACHE_LINE - sizeof(LONG64)];
+    /* Read-only after create */
+    int16_t *buf;
+    int64_t mask;
+    int capacity;
+};
+
+capture_ring_t *capture_ring_create(int min_samples) {
+    int cap = 1024;
+    while (cap < min_samples) cap <<= 1;
+    capture_ring_t *r = (capture_ring_t *)_aligned_malloc(sizeof(capture_ring_t), CACHE_LINE);
+    if (!r) return NULL;
+    memset(r, 0, sizeof(*r));
+    r->buf = (int16_t *)_aligned_malloc(cap * sizeof(int16_t), CACHE_LINE);
+    if (!r->buf) {
+        _aligned_free(r);
+        return NULL;
+    }
+    r->capacity = cap;
+    r->mask = cap - 1;
+    return r;
+}
+
+void capture_ring_destroy(capture_ring_t *r) {
+    if (!r) return;
+    _aligned_free(r->buf);
+    _aligned_free(r);
+}
+
+void capture_ring_reset(capture_ring_t *r) {
+    if (!r) return;
+    InterlockedExchange64(&r->write_pos, 0);
+    InterlockedExchange64(&r->abs_sum, 0);
+    InterlockedExchange64(&r->overruns, 0);
+    InterlockedExchange64(&r->read_pos, 0);
+}
+
+/* Copy n samples into the ring at absolute position pos; returns sum |x| */
+static int64_t copy_in(capture_ring_t *r, int64_t pos, const int16_t *src, int n) {
+    int64_t acc = 0;
+    int off = (int)(pos & r->mask);
+    int first = r->capacity - off;
+    if (first > n) first = n;
+    int16_t *dst = r->buf + off;
+    for (int i = 0; i < first; i++) {
+        int v = src[i];
+        dst[i] = (int16_t)v;
+        acc += v < 0 ? -v : v;
+    }
+    dst = r->buf;
+    for (int i = first; i < n; i++) {
+        int v = src[i];
+        dst[i - first] = (int16_t)v;
+        acc += v < 0 ? -v : v;
+    }
+    return acc;
+}
+
+static void copy_out(const capture_ring_t *r, int64_t pos, int16_t *dst, int n) {
+    int off = (int)(pos & r->mask);
+    int first = r->capacity - off;
+    if (first > n) first = n;
+    memcpy(dst, r->buf + off, first * sizeof(int16_t));
+    if (n > first)
+        memcpy(dst + first, r->buf, (n - first) * sizeof(int16_t));
+}
+
+int capture_ring_write(capture_ring_t *r, const int16_t *pcm, int n) {
+    if (!r || n <= 0) return 0;
+    int64_t w = r->write_pos;
+    int64_t space = r->capacity - (w - r->read_pos);
+    if (n > space) {
+        InterlockedExchange64(&r->overruns, r->overruns + (n - space));
+        n = (int)space;
+        if (n <= 0) return 0;
+    }
+
+    int64_t acc = copy_in(r, w, pcm, n);
+
+    InterlockedIncrement(&r->seq);
+    InterlockedExchange64(&r->abs_sum, r->abs_sum + acc);
+    InterlockedExchange64(&r->write_pos, w + n);
+    InterlockedIncrement(&r->seq);
+    return n;
+}
+
+int capture_ring_read(capture_ring_t *r, int16_t *dst, int max) {
+    if (!r || max <= 0) return 0;
+    int64_t rd = r->read_pos;
+    int64_t avail = r->write_pos - rd;
+    int n = avail < max ? (int)avail : max;
+    if (n <= 0) return 0;
+    copy_out(r, rd, dst, n);
+    InterlockedExchange64(&r->read_pos, rd + n);
+    return n;
+}
+
+void capture_ring_energy(capture_ring_t *r, int64_t *pos, int64_t *abs_sum) {
+    int64_t p = 0, a = 0;
+    if (r) {
+        for (int spins = 0;; spins++) {
+            /* A preempted producer can leave seq odd; stop burning its CPU */
+            if (spins >= SPIN_LIMIT) SwitchToThread();
+            else if (spins > 0) YieldProcessor();
+            LONG s1 = r->seq;
+            if (s1 & 1) continue;
+            p = r->write_pos;
+            a = r->abs_sum;
+            MemoryBarrier();
+            if (r->seq == s1) break;
+        }
+    }
+    if (pos) *pos = p;
+    if (abs_sum) *abs_sum = a;
+}
+
+int64_t capture_ring_overruns(capture_ring_t *r) {
+    return r ? r->overruns : 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * capture_ring.h - Lock-free single-producer/single-consumer audio ring
+ *
+ * The capture thread writes int16 samples; one consumer drains them in
+ * order. Any thread may read the running energy total, which the producer
+ * accumulates in the same pass as the copy. Positions are absolute sample
+ * counts since the last reset.
+ */
+#ifndef CAPTURE_RING_H
+#define CAPTURE_RING_H
+
+#include <stdint.h>
+
+typedef struct capture_ring capture_ring_t;
+
+/* Create a ring holding at least min_samples (rounded up to a power of two).
+ * Returns NULL on failure. */
+capture_ring_t *capture_ring_create(int min_samples);
+void capture_ring_destroy(capture_ring_t *r);
+
+/* Rewind all positions to zero. Only while the producer is stopped. */
+void capture_ring_reset(capture_ring_t *r);
+
+/* Producer: append samples. If the consumer has fallen a full ring behind,
+ * the excess is dropped and counted as an overrun. Returns samples written. */
+int capture_ring_write(capture_ring_t *r, const int16_t *pcm, int n);
+
+/* Consumer: take up to max samples in order. Returns samples read. */
+int capture_ring_read(capture_ring_t *r, int16_t *dst, int max);
+
+/* Any thread: absolute write position and running sum of |sample| (int16
+ * units) up to that position, read as a consistent pair. Retries only if a
+ * producer write lands mid-read, yielding the CPU if that keeps happening.
+ * Energy over an interval is the difference of two readings divided by the
+ * sample difference. */
+void capture_ring_energy(capture_ring_t *r, int64_t *pos, int64_t *abs_sum);
+
+/* Total samples dropped because the consumer fell behind. */
+int64_t capture_ring_overruns(capture_ring_t *r);
+
+#endif /* CAPTURE_RING_H */
@@ -0,0 +1,350 @@
+/*
+ * executor.c - Fixed worker pool with priority lanes and cancellation
+ *
+ * One critical section guards the per-lane FIFOs and the active counts;
+ * idle workers sleep on a condition variable. A worker takes the head of
+ * the first lane that has work and is under its concurrency cap. The lower
+ * lanes also share one cap, n_workers - 1, so together they can never fill
+ * the pool. Delayed tasks wait in a list sorted by due time, holding no
+ * worker; idle workers sleep until the earliest is due and move due tasks
+ * onto their lanes.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "executor.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define EXEC_MAX_WORKERS 16
+
+struct exec_cancel {
+    volatile LONG refs;
+    volatile LONG cancelled;
+    HANDLE event;               /* manual-reset, signalled on cancel */
+};
+
+struct exec_task {
+    volatile LONG refs;
+    exec_fn fn;
+    void *arg;
+    exec_cancel_t *cancel;
+    exec_lane_t lane;
+    ULONGLONG due;              /* GetTickCount64 time, while delayed */
+    HANDLE done;                /* manual-reset; only if a handle was asked for */
+    exec_task_t *next;
+};
+
+typedef struct {
+    exec_task_t *head, *tail;
+    int active;
+    int max_active;
+} exec_queue_t;
+
+struct executor {
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+    exec_queue_t lanes[EXEC_LANE_COUNT];
+    exec_task_t *delayed;       /* not yet due, earliest first */
+    exec_task_t *running[EXEC_MAX_WORKERS];
+    HANDLE threads[EXEC_MAX_WORKERS];
+    int n_workers;
+    int background_active;      /* running tasks of the lanes below interactive */
+    int shutdown;
+};
+
+/* ---- Cancellation tokens ---- */
+
+exec_cancel_t *exec_cancel_new(void) {
+    exec_cancel_t *c = (exec_cancel_t *)calloc(1, sizeof(exec_cancel_t));
+    if (!c) return NULL;
+    c->event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!c->event) {
+        free(c);
+        return NULL;
+    }
+    c->refs = 1;
+    return c;
+}
+
+void exec_cancel_retain(exec_cancel_t *c) {
+    if (c) InterlockedIncrement(&c->refs);
+}
+
+void exec_cancel_release(exec_cancel_t *c) {
+    if (!c || InterlockedDecrement(&c->refs) != 0) return;
+    CloseHandle(c->event);
+    free(c);
+}
+
+void exec_cancel_set(exec_cancel_t *c) {
+    if (!c) return;
+    if (InterlockedExchange(&c->cancelled, 1) == 0)
+        SetEvent(c->event);
+}
+
+int exec_cancelled(const exec_cancel_t *c) {
+    return c ? c->cancelled != 0 : 0;
+}
+
+int exec_cancel_wait(exec_cancel_t *c, unsigned long timeout_ms) {
+    if (!c) {
+        Sleep(timeout_ms);
+        return 0;
+    }
+    return WaitForSingleObject(c->event, timeout_ms) == WAIT_OBJECT_0;
+}
+
+/* ---- Tasks ---- */
+
+static void task_release(exec_task_t *t) {
+    if (!t || InterlockedDecrement(&t->refs) != 0) return;
+    exec_cancel_release(t->cancel);
+    if (t->done) CloseHandle(t->done);
+    free(t);
+}
+
+int exec_task_wait(exec_task_t *t, unsigned long timeout_ms) {
+    if (!t || !t->done) return 0;
+    return WaitForSingleObject(t->done, timeout_ms) == WAIT_OBJECT_0 ? 0 : -1;
+}
+
+void exec_task_release(exec_task_t *t) {
+    task_release(t);
+}
+
+/* ---- Workers ---- */
+
+/* Append t to its lane. Caller holds the lock. */
+static void enqueue(executor_t *ex, exec_task_t *t) {
+    exec_queue_t *q = &ex->lanes[t->lane];
+    t->next = NULL;
+    if (q->tail) q->tail->next = t;
+    else q->head = t;
+    q->tail = t;
+}
+
+/* Move delayed tasks that are due (all of them at shutdown, or those
+ * sharing the token only if only is non-NULL) onto their lanes. Returns
+ * the number moved. Caller holds the lock. */
+static int promote_delayed(executor_t *ex, ULONGLONG now, const exec_cancel_t *only) {
+    int moved = 0;
+    exec_task_t **pp = &ex->delayed;
+    while (*pp) {
+        exec_task_t *t = *pp;
+        int go = only ? t->cancel == only : ex->shutdown || t->due <= now;
+        if (!go) {
+            if (!only) break;   /* sorted: the rest are later */
+            pp = &t->next;
+            continue;
+        }
+        *pp = t->next;
+        enqueue(ex, t);
+        moved++;
+    }
+    return moved;
+}
+
+/* Next runnable task, or NULL. Caller holds the lock. */
+static exec_task_t *take_task(executor_t *ex) {
+    for (int l = 0; l < EXEC_LANE_COUNT; l++) {
+        exec_queue_t *q = &ex->lanes[l];
+        if (!q->head || q->active >= q->max_active) continue;
+        /* Keep one worker for interactive work (until shutdown drains) */
+        if (l != EXEC_LANE_INTERACTIVE && !ex->shutdown
+            && ex->background_active >= ex->n_workers - 1)
+            break;
+        exec_task_t *t = q->head;
+        q->head = t->next;
+        if (!q->head) q->tail = NULL;
+        t->next = NULL;
+        q->active++;
+        if (l != EXEC_LANE_INTERACTIVE) ex->background_active++;
+        return t;
+    }
+    return NULL;
+}
+
+typedef struct {
+    executor_t *ex;
+    int index;
+} exec_worker_arg_t;
+
+static DWORD WINAPI exec_worker(LPVOID param) {
+    exec_worker_arg_t *wa = (exec_worker_arg_t *)param;
+    executor_t *ex = wa->ex;
+    int index = wa->index;
+    free(wa);
+
+    EnterCriticalSection(&ex->lock);
+    for (;;) {
+        ULONGLONG now = GetTickCount64();
+        if (ex->delayed && promote_delayed(ex, now, NULL) > 1)
+            WakeAllConditionVariable(&ex->wake);
+        exec_task_t *t = take_task(ex);
+        if (!t) {
+            if (ex->shutdown) break;
+            DWORD wait_ms = ex->delayed ? (DWORD)(ex->delayed->due - now) : INFINITE;
+            SleepConditionVariableCS(&ex->wake, &ex->lock, wait_ms);
+            continue;
+        }
+        if (ex->shutdown) exec_cancel_set(t->cancel);
+        ex->running[index] = t;
+        LeaveCriticalSection(&ex->lock);
+
+        t->fn(t->arg, t->cancel);
+        if (t->done) SetEvent(t->done);
+
+        EnterCriticalSection(&ex->lock);
+        ex->running[index] = NULL;
+        ex->lanes[t->lane].active--;
+        if (t->lane != EXEC_LANE_INTERACTIVE) ex->background_active--;
+        /* A lane slot opened up; a capped task may now be runnable */
+        WakeAllConditionVariable(&ex->wake);
+        LeaveCriticalSection(&ex->lock);
+        task_release(t);
+        EnterCriticalSection(&ex->lock);
+    }
+    LeaveCriticalSection(&ex->lock);
+    return 0;
+}
+
+executor_t *executor_create(int n_workers) {
+    if (n_workers < 2) n_workers = 2;
+    if (n_workers > EXEC_MAX_WORKERS) n_workers = EXEC_MAX_WORKERS;
+    executor_t *ex = (executor_t *)calloc(1, sizeof(executor_t));
+    if (!ex) return NULL;
+    InitializeCriticalSection(&ex->lock);
+    InitializeConditionVariable(&ex->wake);
+
+    /* Lower lanes leave workers free for the ones above them */
+    ex->lanes[EXEC_LANE_INTERACTIVE].max_active = n_workers;
+    ex->lanes[EXEC_LANE_PLAYBACK].max_active = n_workers - 1;
+    ex->lanes[EXEC_LANE_PREFETCH].max_active = n_workers / 2;
+    ex->lanes[EXEC_LANE_IDLE].max_active = 1;
+
+    for (int i = 0; i < n_workers; i++) {
+        exec_worker_arg_t *wa = (exec_worker_arg_t *)malloc(sizeof(exec_worker_arg_t));
+        HANDLE h = NULL;
+        if (wa) {
+            wa->ex = ex;
+            wa->index = i;
+            h = CreateThread(NULL, 0, exec_worker, wa, 0, NULL);
+            if (!h) free(wa);
+        }
+        if (!h) break;
+        ex->threads[ex->n_workers++] = h;
+    }
+    if (ex->n_workers < n_workers) {
+        executor_destroy(ex, INFINITE);
+        return NULL;
+    }
+    return ex;
+}
+
+int executor_set_lane_limit(executor_t *ex, exec_lane_t lane, int max_active) {
+    if (!ex || lane <= EXEC_LANE_INTERACTIVE || lane >= EXEC_LANE_COUNT) return -1;
+    if (max_active > ex->n_workers - 1) max_active = ex->n_workers - 1;
+    if (max_active < 1) max_active = 1;
+    EnterCriticalSection(&ex->lock);
+    if (!ex->shutdown) {
+        ex->lanes[lane].max_active = max_active;
+        /* A raised cap may make queued tasks runnable */
+        WakeAllConditionVariable(&ex->wake);
+    }
+    LeaveCriticalSection(&ex->lock);
+    return max_active;
+}
+
+void executor_destroy(executor_t *ex, unsigned long timeout_ms) {
+    if (!ex) return;
+    EnterCriticalSection(&ex->lock);
+    ex->shutdown = 1;
+    /* Queued and delayed tasks still run (to free their args) but see a
+     * cancel */
+    promote_delayed(ex, 0, NULL);
+    for (int l = 0; l < EXEC_LANE_COUNT; l++) {
+        for (exec_task_t *t = ex->lanes[l].head; t; t = t->next)
+            exec_cancel_set(t->cancel);
+        ex->lanes[l].max_active = ex->n_workers;
+    }
+    for (int i = 0; i < ex->n_workers; i++)
+        if (ex->running[i]) exec_cancel_set(ex->running[i]->cancel);
+    WakeAllConditionVariable(&ex->wake);
+    LeaveCriticalSection(&ex->lock);
+
+    if (ex->n_workers > 0
+        && WaitForMultipleObjects(ex->n_workers, ex->threads, TRUE, timeout_ms)
+               == WAIT_TIMEOUT)
+        return;
+    for (int i = 0; i < ex->n_workers; i++)
+        CloseHandle(ex->threads[i]);
+    DeleteCriticalSection(&ex->lock);
+    free(ex);
+}
+
+int executor_submit(executor_t *ex, exec_lane_t lane, exec_fn fn, void *arg,
+                    exec_cancel_t *cancel, exec_task_t **out_task) {
+    return executor_submit_delayed(ex, lane, 0, fn, arg, cancel, out_task);
+}
+
+int executor_submit_delayed(executor_t *ex, exec_lane_t lane, unsigned long delay_ms,
+                            exec_fn fn, void *arg, exec_cancel_t *cancel,
+                            exec_task_t **out_task) {
+    if (out_task) *out_task = NULL;
+    if (!ex || !fn || lane < 0 || lane >= EXEC_LANE_COUNT) return -1;
+
+    exec_task_t *t = (exec_task_t *)calloc(1, sizeof(exec_task_t));
+    if (!t) return -1;
+    t->refs = out_task ? 2 : 1;
+    t->fn = fn;
+    t->arg = arg;
+    t->lane = lane;
+    if (cancel) {
+        exec_cancel_retain(cancel);
+        t->cancel = cancel;
+    } else {
+        t->cancel = exec_cancel_new();
+    }
+    if (out_task) t->done = CreateEventA(NULL, TRUE, FALSE, NULL);
+    if (!t->cancel || (out_task && !t->done)) {
+        exec_cancel_release(t->cancel);
+        if (t->done) CloseHandle(t->done);
+        free(t);
+        return -1;
+    }
+
+    EnterCriticalSection(&ex->lock);
+    if (ex->shutdown) {
+        LeaveCriticalSection(&ex->lock);
+        exec_cancel_release(t->cancel);
+        if (t->done) CloseHandle(t->done);
+        free(t);
+        return -1;
+    }
+    if (delay_ms == 0) {
+        enqueue(ex, t);
+        WakeConditionVariable(&ex->wake);
+    } else {
+        t->due = GetTickCount64() + delay_ms;
+        exec_task_t **pp = &ex->delayed;
+        while (*pp && (*pp)->due <= t->due) pp = &(*pp)->next;
+        t->next = *pp;
+        *pp = t;
+        /* A new earliest due time shortens some idle worker's sleep */
+        if (ex->delayed == t) WakeConditionVariable(&ex->wake);
+    }
+    LeaveCriticalSection(&ex->lock);
+
+    if (out_task) *out_task = t;
+    return 0;
+}
+
+void executor_cancel(executor_t *ex, exec_cancel_t *c) {
+    if (!c) return;
+    exec_cancel_set(c);
+    if (!ex) return;
+    EnterCriticalSection(&ex->lock);
+    if (promote_delayed(ex, 0, c) > 0) WakeAllConditionVariable(&ex->wake);
+    LeaveCriticalSection(&ex->lock);
+}
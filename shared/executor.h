@@ -0,0 +1,78 @@
+/*
+ * executor.h - Fixed worker pool with priority lanes and cancellation
+ *
+ * Short-lived background work (ASR passes, live session start/stop, word
+ * playback, prefetch steps) runs here instead of on a fresh thread per
+ * operation. Queued tasks are taken from the highest-priority lane first.
+ * Each lower lane has its own cap, and together they never hold more than
+ * n_workers - 1 workers, so an interactive task always finds a free worker;
+ * the idle lane runs one task at a time. A task can also be submitted to
+ * start later (a retry backoff) without holding a worker while it waits.
+ */
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+typedef enum {
+    EXEC_LANE_INTERACTIVE = 0,  /* ASR passes, live session control */
+    EXEC_LANE_PLAYBACK,         /* TTS / word-slice playback */
+    EXEC_LANE_PREFETCH,         /* speculative fetches, auditions, background archiving */
+    EXEC_LANE_IDLE,             /* guesses at future work (predictive synthesis) */
+    EXEC_LANE_COUNT
+} exec_lane_t;
+
+typedef struct executor executor_t;
+typedef struct exec_cancel exec_cancel_t;
+typedef struct exec_task exec_task_t;
+
+/* Task body. Runs exactly once, even if cancelled before it started (then
+ * exec_cancelled(cancel) is already true and it should just free arg). */
+typedef void (*exec_fn)(void *arg, exec_cancel_t *cancel);
+
+/* Start n_workers threads. Returns NULL on failure. */
+executor_t *executor_create(int n_workers);
+
+/* Cancel every queued and running task, let them finish, join the workers
+ * and free ex. A task still running after timeout_ms (e.g. stuck in a
+ * blocking HTTP call) is abandoned and ex is leaked instead of freed under
+ * it, so only use a finite timeout at process exit. */
+void executor_destroy(executor_t *ex, unsigned long timeout_ms);
+
+/* Change the concurrency cap of a lower lane, clamped to 1..n_workers-1 so
+ * the interactive lane always finds a worker. Returns the cap applied, or
+ * -1 for the interactive lane or a bad argument. */
+int executor_set_lane_limit(executor_t *ex, exec_lane_t lane, int max_active);
+
+/* Queue fn(arg) on lane. cancel may be NULL (a private token is made) and
+ * is retained until the task finishes. If out_task is non-NULL it receives
+ * a handle to wait on; release it with exec_task_release.
+ * Returns 0, or -1 on failure (fn will not run; caller still owns arg). */
+int executor_submit(executor_t *ex, exec_lane_t lane, exec_fn fn, void *arg,
+                    exec_cancel_t *cancel, exec_task_t **out_task);
+
+/* Like executor_submit, but the task joins its lane only after delay_ms.
+ * It holds no worker while it waits. Cancelling its token with
+ * executor_cancel (or executor_destroy) makes it run at once. */
+int executor_submit_delayed(executor_t *ex, exec_lane_t lane, unsigned long delay_ms,
+                            exec_fn fn, void *arg, exec_cancel_t *cancel,
+                            exec_task_t **out_task);
+
+/* exec_cancel_set(c), and start every delayed task of ex holding c now so
+ * it sees the cancel instead of waiting out its delay. */
+void executor_cancel(executor_t *ex, exec_cancel_t *c);
+
+/* Wait for a task to finish. Returns 0 when done, -1 on timeout. */
+int exec_task_wait(exec_task_t *t, unsigned long timeout_ms);
+void exec_task_release(exec_task_t *t);
+
+/* ---- Cancellation tokens (refcounted, shareable across tasks) ---- */
+
+exec_cancel_t *exec_cancel_new(void);
+void exec_cancel_retain(exec_cancel_t *c);
+void exec_cancel_release(exec_cancel_t *c);
+void exec_cancel_set(exec_cancel_t *c);
+int exec_cancelled(const exec_cancel_t *c);
+
+/* Sleep up to timeout_ms, waking early on cancel. Returns 1 if cancelled. */
+int exec_cancel_wait(exec_cancel_t *c, unsigned long timeout_ms);
+
+#endif /* EXECUTOR_H */
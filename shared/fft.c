@@ -0,0 +1,150 @@
+/*
+ * fft.c - Small real-input FFT
+ *
+ * The n real samples are packed as z[k] = x[2k] + i x[2k+1] and run through
+ * an iterative radix-2 complex FFT of m = n/2 points (split re/im arrays).
+ * Twiddles are stored per stage, contiguous, so the SSE2 butterfly can load
+ * four at a time once a stage is four or more butterflies wide. A split
+ * pass then recovers the n/2+1 real-input bins.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "fft.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FFT_SSE2 1
+#endif
+
+#define FFT_PI 3.14159265358979323846
+
+struct fft_plan {
+    int n, m;
+    int *rev;               /* bit reversal of 0..m-1 */
+    float *tw_re, *tw_im;   /* stage with h butterflies: entries [h-1, 2h-1) */
+    float *sp_re, *sp_im;   /* split twiddles e^{-2 pi i k / n}, k = 0..m */
+};
+
+fft_plan_t *fft_plan_create(int n) {
+    if (n < 16 || n > 65536 || (n & (n - 1)) != 0) return NULL;
+    fft_plan_t *p = (fft_plan_t *)calloc(1, sizeof(fft_plan_t));
+    if (!p) return NULL;
+    p->n = n;
+    p->m = n / 2;
+    int m = p->m;
+    p->rev = (int *)malloc(m * sizeof(int));
+    p->tw_re = (float *)malloc(m * sizeof(float));
+    p->tw_im = (float *)malloc(m * sizeof(float));
+    p->sp_re = (float *)malloc((m + 1) * sizeof(float));
+    p->sp_im = (float *)malloc((m + 1) * sizeof(float));
+    if (!p->rev || !p->tw_re || !p->tw_im || !p->sp_re || !p->sp_im) {
+        fft_plan_destroy(p);
+        return NULL;
+    }
+
+    int bits = 0;
+    while ((1 << bits) < m) bits++;
+    for (int i = 0; i < m; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++)
+            if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        p->rev[i] = r;
+    }
+    for (int h = 1; h < m; h *= 2) {
+        for (int j = 0; j < h; j++) {
+            double a = -FFT_PI * j / h;
+            p->tw_re[h - 1 + j] = (float)cos(a);
+            p->tw_im[h - 1 + j] = (float)sin(a);
+        }
+    }
+    for (int k = 0; k <= m; k++) {
+        double a = -2.0 * FFT_PI * k / n;
+        p->sp_re[k] = (float)cos(a);
+        p->sp_im[k] = (float)sin(a);
+    }
+    return p;
+}
+
+void fft_plan_destroy(fft_plan_t *p) {
+    if (!p) return;
+    free(p->rev);
+    free(p->tw_re);
+    free(p->tw_im);
+    free(p->sp_re);
+    free(p->sp_im);
+    free(p);
+}
+
+int fft_size(const fft_plan_t *p) {
+    return p ? p->n : 0;
+}
+
+/* Complex FFT of the packed input into zr/zi (m points each) */
+static void fft_core(const fft_plan_t *p, const float *in, float *zr, float *zi) {
+    int m = p->m;
+    for (int k = 0; k < m; k++) {
+        zr[p->rev[k]] = in[2 * k];
+        zi[p->rev[k]] = in[2 * k + 1];
+    }
+
+    for (int h = 1; h < m; h *= 2) {
+        const float *wr = p->tw_re + h - 1, *wi = p->tw_im + h - 1;
+        for (int g = 0; g < m; g += 2 * h) {
+            float *ar = zr + g, *ai = zi + g, *br = zr + g + h, *bi = zi + g + h;
+            int j = 0;
+#ifdef FFT_SSE2
+            for (; j + 4 <= h; j += 4) {
+                __m128 vwr = _mm_loadu_ps(wr + j), vwi = _mm_loadu_ps(wi + j);
+                __m128 vbr = _mm_loadu_ps(br + j), vbi = _mm_loadu_ps(bi + j);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(vbr, vwr), _mm_mul_ps(vbi, vwi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(vbr, vwi), _mm_mul_ps(vbi, vwr));
+                __m128 var = _mm_loadu_ps(ar + j), vai = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(br + j, _mm_sub_ps(var, tr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(vai, ti));
+                _mm_storeu_ps(ar + j, _mm_add_ps(var, tr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(vai, ti));
+            }
+#endif
+            for (; j < h; j++) {
+                float tr = br[j] * wr[j] - bi[j] * wi[j];
+                float ti = br[j] * wi[j] + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+/* Bin k of the real-input transform from the packed complex result */
+static void split_bin(const fft_plan_t *p, const float *zr, const float *zi, int k,
+                      float *re, float *im) {
+    int m = p->m;
+    int a = k % m, c = (m - k) % m;
+    float fe_r = 0.5f * (zr[a] + zr[c]), fe_i = 0.5f * (zi[a] - zi[c]);
+    float fo_r = 0.5f * (zi[a] + zi[c]), fo_i = -0.5f * (zr[a] - zr[c]);
+    float wr = p->sp_re[k], wi = p->sp_im[k];
+    *re = fe_r + wr * fo_r - wi * fo_i;
+    *im = fe_i + wr * fo_i + wi * fo_r;
+}
+
+void fft_real(const fft_plan_t *p, const float *in, float *re, float *im,
+              float *scratch) {
+    float *zr = scratch, *zi = scratch + p->m;
+    fft_core(p, in, zr, zi);
+    for (int k = 0; k <= p->m; k++)
+        split_bin(p, zr, zi, k, &re[k], &im[k]);
+}
+
+void fft_power(const fft_plan_t *p, const float *in, float *power, float *scratch) {
+    float *zr = scratch, *zi = scratch + p->m;
+    fft_core(p, in, zr, zi);
+    for (int k = 0; k <= p->m; k++) {
+        float re, im;
+        split_bin(p, zr, zi, k, &re, &im);
+        power[k] = re * re + im * im;
+    }
+}
@@ -0,0 +1,30 @@
+/*
+ * fft.h - Small real-input FFT
+ *
+ * Radix-2 FFT for power-of-two frame sizes, used for per-frame spectral
+ * features (VAD, log-mel). A real frame of n samples is transformed as an
+ * n/2-point complex FFT plus a split pass. Butterflies use SSE2 where
+ * available. Plans are immutable after creation and may be shared between
+ * threads; the scratch buffer is the caller's.
+ */
+#ifndef FFT_H
+#define FFT_H
+
+typedef struct fft_plan fft_plan_t;
+
+/* Plan a real FFT of n samples (power of two, 16..65536). Returns NULL
+ * on failure. */
+fft_plan_t *fft_plan_create(int n);
+void fft_plan_destroy(fft_plan_t *p);
+
+int fft_size(const fft_plan_t *p);
+
+/* Forward transform of n real samples into n/2+1 bins (re, im).
+ * scratch holds n floats (also for fft_power). */
+void fft_real(const fft_plan_t *p, const float *in, float *re, float *im,
+              float *scratch);
+
+/* |X[k]|^2 for the n/2+1 bins. */
+void fft_power(const fft_plan_t *p, const float *in, float *power, float *scratch);
+
+#endif /* FFT_H */
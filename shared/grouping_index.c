@@ -0,0 +1,441 @@
+/*
+ * grouping_index.c - Packed on-disk index of per-sentence word groupings
+ *
+ * Writes go through WriteFile at explicit offsets into a file grown in
+ * GIDX_GROW_BYTES chunks, so the read-only mapping (which sees those
+ * writes) is only recreated when a chunk fills up. The data end, the
+ * live count and the dead bytes are recovered by a slot scan on open.
+ * Lookups and puts share one lock: puts are rare (one per newly fetched
+ * sentence).
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "grouping_index.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define GIDX_MAGIC         "GIDX"
+#define GIDX_VERSION       1
+#define GIDX_HEADER_BYTES  64
+#define GIDX_SLOT_BYTES    16
+#define GIDX_REC_HEADER    24
+#define GIDX_WORD_BYTES    16
+#define GIDX_INITIAL_SLOTS 1024
+#define GIDX_GROW_BYTES    (256 * 1024)    /* file and mapping growth step */
+#define GIDX_SYNC_PUTS     32              /* flush after this many puts, or on */
+#define GIDX_SYNC_MS       2000            /* a put this long after the first */
+#define GIDX_COMPACT_BYTES (64 * 1024)     /* compact once dead records pass this */
+
+struct gidx {
+    CRITICAL_SECTION lock;
+    char path[MAX_PATH];
+    HANDLE file;
+    HANDLE map;
+    const unsigned char *base;
+    long long size;             /* file and mapping size */
+    long long end;              /* end of the last committed record */
+    long long dead;             /* bytes of replaced records */
+    uint32_t n_slots;
+    int count;
+    int unsynced;               /* puts since the last flush */
+    DWORD unsynced_since;
+};
+
+typedef struct {
+    uint64_t key;
+    uint64_t offset;
+} gidx_slot_t;
+
+static uint32_t pad_to(uint32_t n, uint32_t a) { return (n + a - 1) & ~(a - 1); }
+
+static uint64_t text_key(const char *text) {
+    uint64_t h = tts_text_hash(text);
+    return h ? h : 1;   /* 0 marks an empty slot */
+}
+
+static int write_at(HANDLE f, long long offset, const void *buf, DWORD len) {
+    OVERLAPPED ov = {0};
+    ov.Offset = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD written = 0;
+    return WriteFile(f, buf, len, &written, &ov) && written == len ? 0 : -1;
+}
+
+static long long slots_end(uint32_t n_slots) {
+    return GIDX_HEADER_BYTES + (long long)n_slots * GIDX_SLOT_BYTES;
+}
+
+/* ---- Mapping (caller holds the lock) ---- */
+
+static void unmap(gidx_t *g) {
+    if (g->base) UnmapViewOfFile(g->base);
+    if (g->map) CloseHandle(g->map);
+    g->base = NULL;
+    g->map = NULL;
+}
+
+static int remap(gidx_t *g) {
+    unmap(g);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(g->file, &size)) return -1;
+    g->size = size.QuadPart;
+    g->map = CreateFileMappingA(g->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!g->map) return -1;
+    g->base = (const unsigned char *)MapViewOfFile(g->map, FILE_MAP_READ, 0, 0, 0);
+    return g->base ? 0 : -1;
+}
+
+static gidx_slot_t slot_at(const gidx_t *g, uint32_t i) {
+    gidx_slot_t s;
+    memcpy(&s, g->base + GIDX_HEADER_BYTES + (size_t)i * GIDX_SLOT_BYTES, sizeof(s));
+    return s;
+}
+
+/* Record at offset if it is intact and belongs to key. Fills the text span. */
+static const unsigned char *record_at(const gidx_t *g, uint64_t offset, uint64_t key,
+                                      uint32_t *rec_bytes) {
+    if (offset < (uint64_t)slots_end(g->n_slots)
+        || offset + GIDX_REC_HEADER > (uint64_t)g->size)
+        return NULL;
+    const unsigned char *r = g->base + offset;
+    uint32_t bytes, n_words, text_bytes, pool_bytes;
+    uint64_t rkey;
+    memcpy(&bytes, r, 4);
+    memcpy(&n_words, r + 4, 4);
+    memcpy(&rkey, r + 8, 8);
+    memcpy(&text_bytes, r + 16, 4);
+    memcpy(&pool_bytes, r + 20, 4);
+    if (rkey != key || bytes > (uint64_t)g->size - offset) return NULL;
+    uint64_t need = GIDX_REC_HEADER + (uint64_t)pad_to(text_bytes, 4)
+                  + (uint64_t)n_words * GIDX_WORD_BYTES + pad_to(pool_bytes, 8);
+    if (need != bytes) return NULL;
+    *rec_bytes = bytes;
+    return r;
+}
+
+static int record_text_is(const unsigned char *r, const char *text, size_t len) {
+    uint32_t text_bytes;
+    memcpy(&text_bytes, r + 16, 4);
+    return text_bytes == len && memcmp(r + GIDX_REC_HEADER, text, len) == 0;
+}
+
+/* Slot holding text, or the empty slot where it would go. Returns the slot
+ * index and sets *found; -1 if the table is full. */
+static int probe(const gidx_t *g, uint64_t key, const char *text, int *found) {
+    size_t len = strlen(text);
+    uint32_t mask = g->n_slots - 1;
+    *found = 0;
+    for (uint32_t n = 0, i = (uint32_t)key & mask; n < g->n_slots; n++, i = (i + 1) & mask) {
+        gidx_slot_t s = slot_at(g, i);
+        if (s.key == 0) return (int)i;
+        if (s.key != key) continue;
+        uint32_t rec_bytes;
+        const unsigned char *r = record_at(g, s.offset, key, &rec_bytes);
+        if (!r) return (int)i;          /* torn commit: reuse the slot */
+        if (record_text_is(r, text, len)) {
+            *found = 1;
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/* ---- Open / create ---- */
+
+static int write_empty(HANDLE f, uint32_t n_slots) {
+    unsigned char hdr[GIDX_HEADER_BYTES] = {0};
+    uint16_t version = GIDX_VERSION, header_bytes = GIDX_HEADER_BYTES;
+    memcpy(hdr, GIDX_MAGIC, 4);
+    memcpy(hdr + 4, &version, 2);
+    memcpy(hdr + 6, &header_bytes, 2);
+    memcpy(hdr + 8, &n_slots, 4);
+    size_t table = (size_t)n_slots * GIDX_SLOT_BYTES;
+    unsigned char *zero = (unsigned char *)calloc(1, table);
+    if (!zero) return -1;
+    int rc = write_at(f, 0, hdr, sizeof(hdr));
+    if (rc == 0) rc = write_at(f, GIDX_HEADER_BYTES, zero, (DWORD)table);
+    free(zero);
+    return rc;
+}
+
+/* Open g->path, creating or resetting it if missing or not an index */
+static int load(gidx_t *g) {
+    g->file = CreateFileA(g->path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                          OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (g->file == INVALID_HANDLE_VALUE) return -1;
+
+    LARGE_INTEGER size;
+    int fresh = !GetFileSizeEx(g->file, &size) || size.QuadPart < GIDX_HEADER_BYTES;
+    if (!fresh) {
+        unsigned char hdr[GIDX_HEADER_BYTES];
+        DWORD got = 0;
+        OVERLAPPED ov = {0};
+        uint16_t version = 0, header_bytes = 0;
+        uint32_t n_slots = 0;
+        if (ReadFile(g->file, hdr, sizeof(hdr), &got, &ov) && got == sizeof(hdr)) {
+            memcpy(&version, hdr + 4, 2);
+            memcpy(&header_bytes, hdr + 6, 2);
+            memcpy(&n_slots, hdr + 8, 4);
+        }
+        fresh = memcmp(hdr, GIDX_MAGIC, 4) != 0 || version != GIDX_VERSION
+             || header_bytes != GIDX_HEADER_BYTES || n_slots == 0
+             || (n_slots & (n_slots - 1)) || n_slots > (1u << 24)
+             || size.QuadPart < slots_end(n_slots);
+        g->n_slots = n_slots;
+    }
+    if (fresh) {
+        g->n_slots = GIDX_INITIAL_SLOTS;
+        SetFilePointer(g->file, 0, NULL, FILE_BEGIN);
+        SetEndOfFile(g->file);
+        if (write_empty(g->file, g->n_slots) != 0) return -1;
+    }
+    if (remap(g) != 0) return -1;
+
+    /* Records past the last committed one (a crash between record and
+     * slot, or the unused rest of a chunk) get overwritten */
+    long long live = 0;
+    g->count = 0;
+    g->end = slots_end(g->n_slots);
+    for (uint32_t i = 0; i < g->n_slots; i++) {
+        gidx_slot_t s = slot_at(g, i);
+        if (s.key == 0) continue;
+        g->count++;
+        uint32_t rec_bytes;
+        if (!record_at(g, s.offset, s.key, &rec_bytes)) continue;
+        live += rec_bytes;
+        if ((long long)s.offset + rec_bytes > g->end) g->end = (long long)s.offset + rec_bytes;
+    }
+    g->dead = g->end - slots_end(g->n_slots) - live;
+    g->unsynced = 0;
+    return 0;
+}
+
+static void flush_writes(gidx_t *g) {
+    if (g->unsynced && g->file != INVALID_HANDLE_VALUE) FlushFileBuffers(g->file);
+    g->unsynced = 0;
+}
+
+/* Make room for bytes more at g->end: extend the file by whole chunks and
+ * map it again. Caller holds the lock. */
+static int reserve(gidx_t *g, uint32_t bytes) {
+    long long need = ((g->end + 7) & ~7LL) + bytes;
+    if (need <= g->size) return 0;
+    LARGE_INTEGER size;
+    size.QuadPart = (need + GIDX_GROW_BYTES - 1) / GIDX_GROW_BYTES * GIDX_GROW_BYTES;
+    unmap(g);
+    if (!SetFilePointerEx(g->file, size, NULL, FILE_BEGIN) || !SetEndOfFile(g->file)) {
+        remap(g);
+        return -1;
+    }
+    return remap(g);
+}
+
+static void unload(gidx_t *g) {
+    flush_writes(g);
+    unmap(g);
+    if (g->file != INVALID_HANDLE_VALUE && g->file) CloseHandle(g->file);
+    g->file = INVALID_HANDLE_VALUE;
+}
+
+gidx_t *gidx_open(const char *path) {
+    gidx_t *g = (gidx_t *)calloc(1, sizeof(gidx_t));
+    if (!g) return NULL;
+    strncpy(g->path, path, sizeof(g->path) - 1);
+    g->file = INVALID_HANDLE_VALUE;
+    if (load(g) != 0) {
+        unload(g);
+        free(g);
+        return NULL;
+    }
+    InitializeCriticalSection(&g->lock);
+    return g;
+}
+
+void gidx_close(gidx_t *g) {
+    if (!g) return;
+    unload(g);
+    DeleteCriticalSection(&g->lock);
+    free(g);
+}
+
+/* ---- Lookup ---- */
+
+int gidx_get(gidx_t *g, const char *text, tts_word_t **words, int *n_words) {
+    *words = NULL;
+    *n_words = 0;
+    if (!g || !text) return 0;
+    uint64_t key = text_key(text);
+    int hit = 0;
+    EnterCriticalSection(&g->lock);
+    int found = 0;
+    int i = g->base ? probe(g, key, text, &found) : -1;
+    if (i >= 0 && found) {
+        uint32_t rec_bytes, n, text_bytes, pool_bytes;
+        const unsigned char *r = record_at(g, slot_at(g, (uint32_t)i).offset, key, &rec_bytes);
+        memcpy(&n, r + 4, 4);
+        memcpy(&text_bytes, r + 16, 4);
+        memcpy(&pool_bytes, r + 20, 4);
+        const unsigned char *wt = r + GIDX_REC_HEADER + pad_to(text_bytes, 4);
+        const unsigned char *pool = wt + (size_t)n * GIDX_WORD_BYTES;
+        tts_word_t *out = n ? (tts_word_t *)calloc(n, sizeof(tts_word_t)) : NULL;
+        if (out || n == 0) {
+            for (uint32_t k = 0; k < n; k++) {
+                uint32_t off, len;
+                int32_t start, end;
+                memcpy(&off, wt + k * GIDX_WORD_BYTES, 4);
+                memcpy(&len, wt + k * GIDX_WORD_BYTES + 4, 4);
+                memcpy(&start, wt + k * GIDX_WORD_BYTES + 8, 4);
+                memcpy(&end, wt + k * GIDX_WORD_BYTES + 12, 4);
+                if (off > pool_bytes || len > pool_bytes - off) len = 0;
+                if (len >= sizeof(out[k].word)) len = sizeof(out[k].word) - 1;
+                if (len) memcpy(out[k].word, pool + off, len);
+                out[k].start_ms = start;
+                out[k].end_ms = end;
+            }
+            *words = out;
+            *n_words = (int)n;
+            hit = 1;
+        }
+    }
+    LeaveCriticalSection(&g->lock);
+    return hit;
+}
+
+int gidx_count(gidx_t *g) {
+    if (!g) return 0;
+    EnterCriticalSection(&g->lock);
+    int n = g->count;
+    LeaveCriticalSection(&g->lock);
+    return n;
+}
+
+/* ---- Append ---- */
+
+/* Serialize one record. Returns malloc'd bytes, *size set. */
+static unsigned char *build_record(uint64_t key, const char *text,
+                                   const tts_word_t *words, int n_words, uint32_t *size) {
+    uint32_t text_bytes = (uint32_t)strlen(text);
+    uint32_t pool_bytes = 0;
+    for (int i = 0; i < n_words; i++) pool_bytes += (uint32_t)strlen(words[i].word);
+    uint32_t bytes = GIDX_REC_HEADER + pad_to(text_bytes, 4)
+                   + (uint32_t)n_words * GIDX_WORD_BYTES + pad_to(pool_bytes, 8);
+    unsigned char *r = (unsigned char *)calloc(1, bytes);
+    if (!r) return NULL;
+    uint32_t nw = (uint32_t)n_words;
+    memcpy(r, &bytes, 4);
+    memcpy(r + 4, &nw, 4);
+    memcpy(r + 8, &key, 8);
+    memcpy(r + 16, &text_bytes, 4);
+    memcpy(r + 20, &pool_bytes, 4);
+    memcpy(r + GIDX_REC_HEADER, text, text_bytes);
+    unsigned char *wt = r + GIDX_REC_HEADER + pad_to(text_bytes, 4);
+    unsigned char *pool = wt + (size_t)n_words * GIDX_WORD_BYTES;
+    uint32_t off = 0;
+    for (int i = 0; i < n_words; i++) {
+        uint32_t len = (uint32_t)strlen(words[i].word);
+        int32_t start = words[i].start_ms, end = words[i].end_ms;
+        memcpy(wt + i * GIDX_WORD_BYTES, &off, 4);
+        memcpy(wt + i * GIDX_WORD_BYTES + 4, &len, 4);
+        memcpy(wt + i * GIDX_WORD_BYTES + 8, &start, 4);
+        memcpy(wt + i * GIDX_WORD_BYTES + 12, &end, 4);
+        memcpy(pool + off, words[i].word, len);
+        off += len;
+    }
+    *size = bytes;
+    return r;
+}
+
+/* Copy the live records into a file with n_slots slots and swap it in */
+static int rebuild(gidx_t *g, uint32_t n_slots) {
+    char tmp[MAX_PATH + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", g->path);
+    HANDLE f = CreateFileA(tmp, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return -1;
+    gidx_slot_t *table = (gidx_slot_t *)calloc(n_slots, sizeof(gidx_slot_t));
+    int ok = table && write_empty(f, n_slots) == 0;
+
+    long long pos = slots_end(n_slots);
+    for (uint32_t i = 0; ok && i < g->n_slots; i++) {
+        gidx_slot_t s = slot_at(g, i);
+        uint32_t rec_bytes;
+        const unsigned char *r = s.key ? record_at(g, s.offset, s.key, &rec_bytes) : NULL;
+        if (!r) continue;
+        uint32_t j = (uint32_t)s.key & (n_slots - 1);
+        while (table[j].key) j = (j + 1) & (n_slots - 1);
+        table[j].key = s.key;
+        table[j].offset = (uint64_t)pos;
+        ok = write_at(f, pos, r, rec_bytes) == 0;
+        pos += rec_bytes;
+    }
+    if (ok) ok = write_at(f, GIDX_HEADER_BYTES, table,
+                          (DWORD)((size_t)n_slots * GIDX_SLOT_BYTES)) == 0;
+    if (ok) ok = FlushFileBuffers(f) != 0;
+    CloseHandle(f);
+    free(table);
+    if (!ok) {
+        DeleteFileA(tmp);
+        return -1;
+    }
+
+    unload(g);
+    if (!MoveFileExA(tmp, g->path, MOVEFILE_REPLACE_EXISTING)) DeleteFileA(tmp);
+    return load(g);
+}
+
+int gidx_put(gidx_t *g, const char *text, const tts_word_t *words, int n_words) {
+    if (!g || !text || !text[0] || n_words < 0 || (n_words > 0 && !words)) return -1;
+    uint64_t key = text_key(text);
+    int rc = -1;
+    EnterCriticalSection(&g->lock);
+    if (!g->base && load(g) != 0) goto out;
+
+    int found = 0;
+    int i = probe(g, key, text, &found);
+    if (!found && (i < 0 || (long long)(g->count + 1) * 10 > (long long)g->n_slots * 7)) {
+        if (rebuild(g, g->n_slots * 2) != 0) goto out;
+        i = probe(g, key, text, &found);
+        if (i < 0) goto out;
+    }
+
+    uint32_t rec_bytes;
+    unsigned char *rec = build_record(key, text, words, n_words, &rec_bytes);
+    if (!rec) goto out;
+    if (reserve(g, rec_bytes) != 0) {
+        free(rec);
+        goto out;
+    }
+    long long offset = (g->end + 7) & ~7LL;
+
+    /* Record first, then the slot that commits it. There is no flush in
+     * between: a record that never reached the disk fails its key check
+     * after a crash, and its slot is reused. */
+    gidx_slot_t old = slot_at(g, (uint32_t)i);
+    uint32_t old_bytes = 0;
+    if (found) record_at(g, old.offset, key, &old_bytes);
+    gidx_slot_t s = { key, (uint64_t)offset };
+    int ok = write_at(g->file, offset, rec, rec_bytes) == 0
+          && write_at(g->file, GIDX_HEADER_BYTES + (long long)i * GIDX_SLOT_BYTES,
+                      &s, sizeof(s)) == 0;
+    free(rec);
+    if (ok) {
+        if (old.key == 0) g->count++;
+        g->dead += old_bytes + (offset - g->end);
+        g->end = offset + rec_bytes;
+        if (g->unsynced++ == 0) g->unsynced_since = GetTickCount();
+        rc = 0;
+    }
+
+    /* Drop replaced records once they are a large share of the file */
+    if (g->dead >= GIDX_COMPACT_BYTES && g->dead * 2 >= g->end - slots_end(g->n_slots))
+        rebuild(g, g->n_slots);
+    else if (g->unsynced >= GIDX_SYNC_PUTS
+             || GetTickCount() - g->unsynced_since >= GIDX_SYNC_MS)
+        flush_writes(g);
+out:
+    LeaveCriticalSection(&g->lock);
+    return rc;
+}
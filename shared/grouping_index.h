@@ -0,0 +1,48 @@
+/*
+ * grouping_index.h - Packed on-disk index of per-sentence word groupings
+ *
+ * One file holds every sentence's word timestamps. An open-addressing hash
+ * table of 64-bit text keys sits at the front; each slot points at an
+ * append-only record holding the sentence text (checked on lookup) and its
+ * words, whose strings live in the record's own pool. The file is mapped,
+ * so a lookup is a probe plus a copy, with no parsing.
+ *
+ * A put appends the record, then writes the slot: the 16-byte slot write
+ * is the commit, so a crash leaves at worst an unreferenced record at the
+ * end, or a slot whose record fails its key check and is reused. Puts are
+ * flushed to disk in batches (and on close). The table is rebuilt into a
+ * new file, dropping replaced records, when it passes 70% load or when
+ * replaced records make up half the file.
+ *
+ * File layout (little-endian):
+ *   header (64 bytes): "GIDX" u16 version u16 header_bytes u32 n_slots, 0...
+ *   n_slots * { u64 key u64 record_offset }          (key 0 = empty)
+ *   records, 8-byte aligned:
+ *     u32 record_bytes u32 n_words u64 key u32 text_bytes u32 pool_bytes
+ *     text, zero-padded to 4
+ *     n_words * { u32 pool_offset u32 bytes i32 start_ms i32 end_ms }
+ *     pool, zero-padded to 8
+ *
+ * All calls are thread-safe.
+ */
+#ifndef GROUPING_INDEX_H
+#define GROUPING_INDEX_H
+
+#include "tts_cache.h"
+
+typedef struct gidx gidx_t;
+
+/* Open or create the index at path. Returns NULL on failure. */
+gidx_t *gidx_open(const char *path);
+void gidx_close(gidx_t *g);
+
+/* Look up text. On a hit returns 1 and a malloc'd copy of its words
+ * (caller frees); 0 on a miss. */
+int gidx_get(gidx_t *g, const char *text, tts_word_t **words, int *n_words);
+
+/* Add or replace text's words. Returns 0, or -1 on failure. */
+int gidx_put(gidx_t *g, const char *text, const tts_word_t *words, int n_words);
+
+int gidx_count(gidx_t *g);
+
+#endif /* GROUPING_INDEX_H */
@@ -0,0 +1,581 @@
+/*
+ * lac.c - Lossless audio codec for archived recordings
+ *
+ * File: 16-byte header ("LAC1", u32 sample rate, u32 sample count or
+ * 0xFFFFFFFF while open, u16 block size, u16 reserved), then frames of
+ * u32 payload bytes + u16 samples + payload.
+ *
+ * Payload (MSB-first bits): 3-bit type. Types 0-4 are fixed polynomial
+ * predictors of that order, 5 is quantized LPC (4-bit order, 5-bit shift,
+ * LAC_LPC_PREC-bit coefficients), 6 is verbatim 16-bit samples. Predicted
+ * blocks store `order` warm-up samples raw, then a 3-bit partition order and
+ * per partition a 5-bit Rice parameter followed by zigzagged residuals.
+ * A unary prefix of LAC_RICE_ESC ones escapes to a raw 32-bit value.
+ *
+ * The encoder picks the predictor with the smallest estimated size, then
+ * searches partition orders exactly. Fixed-order differences and the LPC
+ * autocorrelation use SSE2 where available (always on x64).
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "lac.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LAC_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define LAC_MAGIC        "LAC1"
+#define LAC_FRAME_HDR    6
+#define LAC_MAX_FIXED    4
+#define LAC_LPC_ORDER    8
+#define LAC_LPC_PREC     12
+#define LAC_MAX_PART     6
+#define LAC_RICE_ESC     32
+#define LAC_COUNT_OPEN   0xFFFFFFFFu
+/* Worst case: every residual escaped (64 bits) plus headers */
+#define LAC_MAX_PAYLOAD  (LAC_BLOCK_SAMPLES * 8 + 512)
+
+enum { LAC_TYPE_LPC = 5, LAC_TYPE_VERBATIM = 6 };
+
+/* ---- Bit I/O ---- */
+
+typedef struct {
+    unsigned char *buf;
+    size_t len;
+    uint64_t acc;
+    int n;
+} bitw_t;
+
+static void bw_put(bitw_t *b, uint32_t v, int n) {
+    if (n == 0) return;
+    b->acc = (b->acc << n) | (v & (uint32_t)((1ULL << n) - 1));
+    b->n += n;
+    while (b->n >= 8) {
+        b->n -= 8;
+        b->buf[b->len++] = (unsigned char)(b->acc >> b->n);
+    }
+}
+
+static void bw_flush(bitw_t *b) {
+    if (b->n > 0) bw_put(b, 0, 8 - b->n);
+}
+
+static void bw_rice(bitw_t *b, uint32_t u, int k) {
+    uint32_t q = u >> k;
+    if (q < LAC_RICE_ESC) {
+        bw_put(b, ((1u << q) - 1) << 1, (int)q + 1);
+        bw_put(b, u, k);
+    } else {
+        bw_put(b, 0xFFFFFFFFu, 32);
+        bw_put(b, u, 32);
+    }
+}
+
+/* Left-aligned 64-bit cache; reads past the end yield zeros and are
+ * caught by comparing used bits against the payload size. */
+typedef struct {
+    const unsigned char *p, *end;
+    uint64_t cache;
+    int bits;
+    size_t used;
+} bitr_t;
+
+static void br_refill(bitr_t *b) {
+    while (b->bits <= 56) {
+        uint64_t byte = b->p < b->end ? *b->p++ : 0;
+        b->cache |= byte << (56 - b->bits);
+        b->bits += 8;
+    }
+}
+
+static uint32_t br_get(bitr_t *b, int n) {
+    if (n == 0) return 0;
+    br_refill(b);
+    uint32_t v = (uint32_t)(b->cache >> (64 - n));
+    b->cache <<= n;
+    b->bits -= n;
+    b->used += n;
+    return v;
+}
+
+static int clz64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return 63 - (int)i;
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+static uint32_t br_rice(bitr_t *b, int k) {
+    br_refill(b);
+    if ((b->cache >> 32) == 0xFFFFFFFFu) {
+        br_get(b, 32);
+        return br_get(b, 32);
+    }
+    int q = clz64(~b->cache);   /* < 32: a zero sits in the top 32 bits */
+    b->cache <<= q + 1;
+    b->bits -= q + 1;
+    b->used += q + 1;
+    return ((uint32_t)q << k) | br_get(b, k);
+}
+
+static uint32_t zigzag(int32_t r) { return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31); }
+static int32_t unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+/* ---- Prediction (shared by encoder and decoder so both round alike) ---- */
+
+static const int32_t k_fixed[LAC_MAX_FIXED + 1][LAC_MAX_FIXED] = {
+    { 0 }, { 1 }, { 2, -1 }, { 3, -3, 1 }, { 4, -6, 4, -1 },
+};
+
+/* x points at the sample being predicted; history is x[-1], x[-2], ... */
+static int32_t predict(const int32_t *coef, int order, int shift, const int16_t *x) {
+    int32_t acc = 0;  /* |coef| < 2^11 (LPC) or <= 6, order <= 8: fits */
+    for (int j = 0; j < order; j++)
+        acc += coef[j] * (int32_t)x[-1 - j];
+    return acc >> shift;
+}
+
+/* ---- Encoder analysis ---- */
+
+/* cur[i] = prev[i] - prev[i-1] for i in [from, n); returns sum |cur[i]| */
+static uint64_t diff_abs(const int32_t *prev, int32_t *cur, int from, int n) {
+    uint64_t sum = 0;
+    int i = from;
+#ifdef LAC_SSE2
+    /* Per lane: <= 1024 values of |d| <= 2^19, so int32 lanes cannot overflow */
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(prev + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(prev + i - 1));
+        __m128i d = _mm_sub_epi32(a, b);
+        _mm_storeu_si128((__m128i *)(cur + i), d);
+        __m128i s = _mm_srai_epi32(d, 31);
+        acc = _mm_add_epi32(acc, _mm_sub_epi32(_mm_xor_si128(d, s), s));
+    }
+    int32_t lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, acc);
+    sum = (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; i < n; i++) {
+        cur[i] = prev[i] - prev[i - 1];
+        sum += (uint64_t)(cur[i] < 0 ? -cur[i] : cur[i]);
+    }
+    return sum;
+}
+
+static void autocorr(const double *x, int n, int order, double *r) {
+    for (int lag = 0; lag <= order; lag++) {
+        double s = 0.0;
+        int i = lag;
+#ifdef LAC_SSE2
+        __m128d acc = _mm_setzero_pd();
+        for (; i + 2 <= n; i += 2)
+            acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(x + i),
+                                             _mm_loadu_pd(x + i - lag)));
+        double t[2];
+        _mm_storeu_pd(t, acc);
+        s = t[0] + t[1];
+#endif
+        for (; i < n; i++)
+            s += x[i] * x[i - lag];
+        r[lag] = s;
+    }
+}
+
+/* Levinson-Durbin. Returns the usable order (0 if none). */
+static int levinson(const double *r, int order, double *lpc) {
+    double err = r[0];
+    double tmp[LAC_LPC_ORDER];
+    if (err <= 0.0) return 0;
+    for (int i = 0; i < order; i++) {
+        double acc = r[i + 1];
+        for (int j = 0; j < i; j++)
+            acc -= lpc[j] * r[i - j];
+        double k = acc / err;
+        memcpy(tmp, lpc, i * sizeof(double));
+        for (int j = 0; j < i; j++)
+            lpc[j] = tmp[j] - k * tmp[i - 1 - j];
+        lpc[i] = k;
+        err *= 1.0 - k * k;
+        if (err <= 0.0) return i + 1;
+    }
+    return order;
+}
+
+/* Quantize with error feedback. Returns shift, or -1 if unusable. */
+static int quantize_lpc(const double *lpc, int order, int32_t *q) {
+    double cmax = 0.0;
+    for (int i = 0; i < order; i++)
+        if (fabs(lpc[i]) > cmax) cmax = fabs(lpc[i]);
+    if (cmax <= 0.0) return -1;
+    int e;
+    frexp(cmax, &e);                      /* cmax < 2^e */
+    int shift = (LAC_LPC_PREC - 1) - e;
+    if (shift > 15) shift = 15;
+    if (shift < 0) return -1;
+    int qmax = (1 << (LAC_LPC_PREC - 1)) - 1;
+    double err = 0.0;
+    for (int i = 0; i < order; i++) {
+        err += lpc[i] * (double)(1 << shift);
+        int v = (int)floor(err + 0.5);
+        if (v > qmax) v = qmax;
+        if (v < -qmax - 1) v = -qmax - 1;
+        q[i] = v;
+        err -= v;
+    }
+    return shift;
+}
+
+/* Rough Rice size for m residuals with the given sum of |r| */
+static uint64_t estimate_bits(uint64_t abs_sum, int m) {
+    if (m <= 0) return 0;
+    uint64_t mean = 2 * abs_sum / (uint64_t)m;
+    int k = 0;
+    while (k < 30 && (2ULL << k) <= mean) k++;
+    return (uint64_t)m * (k + 1) + ((2 * abs_sum) >> k);
+}
+
+static uint64_t rice_cost(const uint32_t *u, int m, int k) {
+    uint64_t bits = 0;
+    for (int i = 0; i < m; i++) {
+        uint32_t q = u[i] >> k;
+        bits += q < LAC_RICE_ESC ? q + 1 + k : 64;
+    }
+    return bits;
+}
+
+static int best_k(const uint32_t *u, int m, uint64_t *cost) {
+    uint64_t sum = 0;
+    for (int i = 0; i < m; i++) sum += u[i];
+    int k0 = 0;
+    while (k0 < 30 && m > 0 && ((uint64_t)m << (k0 + 1)) <= sum) k0++;
+    int best = k0;
+    uint64_t bc = rice_cost(u, m, k0);
+    for (int k = k0 > 0 ? k0 - 1 : 0; k <= k0 + 1 && k <= 30; k++) {
+        if (k == k0) continue;
+        uint64_t c = rice_cost(u, m, k);
+        if (c < bc) { bc = c; best = k; }
+    }
+    *cost = bc;
+    return best;
+}
+
+/* ---- Writer ---- */
+
+struct lac_writer {
+    HANDLE file;
+    int failed;
+    long long offset;           /* where the next frame goes */
+    long long samples;
+    int16_t pending[LAC_BLOCK_SAMPLES];
+    int n_pending;
+    int32_t diff[LAC_MAX_FIXED + 1][LAC_BLOCK_SAMPLES];
+    double xw[LAC_BLOCK_SAMPLES];
+    uint32_t u[LAC_BLOCK_SAMPLES];
+    int16_t check[LAC_BLOCK_SAMPLES];
+    unsigned char frame[LAC_FRAME_HDR + LAC_MAX_PAYLOAD];
+};
+
+static int decode_payload(const unsigned char *p, size_t len, int n, int16_t *out);
+
+static int write_at(HANDLE f, long long offset, const void *buf, DWORD len) {
+    OVERLAPPED ov = {0};
+    ov.Offset = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD written = 0;
+    return WriteFile(f, buf, len, &written, &ov) && written == len ? 0 : -1;
+}
+
+/* Encode one block into w->frame payload. Returns payload bytes. */
+static size_t encode_block(lac_writer_t *w, const int16_t *x, int n) {
+    bitw_t bw = { w->frame + LAC_FRAME_HDR, 0, 0, 0 };
+
+    /* Fixed predictors: successive differences */
+    uint64_t fixed_sum[LAC_MAX_FIXED + 1];
+    int max_fixed = n - 1 < LAC_MAX_FIXED ? n - 1 : LAC_MAX_FIXED;
+    fixed_sum[0] = 0;
+    for (int i = 0; i < n; i++) {
+        w->diff[0][i] = x[i];
+        fixed_sum[0] += (uint64_t)(x[i] < 0 ? -x[i] : x[i]);
+    }
+    for (int k = 1; k <= max_fixed; k++)
+        fixed_sum[k] = diff_abs(w->diff[k - 1], w->diff[k], k, n);
+
+    int order = 0;
+    uint64_t best = estimate_bits(fixed_sum[0], n);
+    for (int k = 1; k <= max_fixed; k++) {
+        uint64_t b = estimate_bits(fixed_sum[k], n - k) + 16 * k;
+        if (b < best) { best = b; order = k; }
+    }
+    int type = order;
+
+    /* LPC on a Welch-windowed copy */
+    int32_t q[LAC_LPC_ORDER];
+    int lpc_order = 0, shift = 0;
+    if (n > 4 * LAC_LPC_ORDER) {
+        double r[LAC_LPC_ORDER + 1], lpc[LAC_LPC_ORDER];
+        double half = (n - 1) / 2.0, span = (n + 1) / 2.0;
+        for (int i = 0; i < n; i++) {
+            double t = (i - half) / span;
+            w->xw[i] = x[i] * (1.0 - t * t);
+        }
+        autocorr(w->xw, n, LAC_LPC_ORDER, r);
+        r[0] *= 1.0 + 1e-9;
+        lpc_order = levinson(r, LAC_LPC_ORDER, lpc);
+        if (lpc_order > 0) shift = quantize_lpc(lpc, lpc_order, q);
+        if (lpc_order > 0 && shift >= 0) {
+            uint64_t sum = 0;
+            for (int i = lpc_order; i < n; i++) {
+                int32_t res = x[i] - predict(q, lpc_order, shift, x + i);
+                sum += (uint64_t)(res < 0 ? -res : res);
+            }
+            uint64_t b = estimate_bits(sum, n - lpc_order)
+                       + 16 * lpc_order + LAC_LPC_PREC * lpc_order + 9;
+            if (b < best) { best = b; type = LAC_TYPE_LPC; order = lpc_order; }
+        }
+    }
+
+    /* Residuals for the chosen predictor */
+    int m = n - order;
+    if (type == LAC_TYPE_LPC) {
+        for (int i = order; i < n; i++)
+            w->u[i - order] = zigzag(x[i] - predict(q, order, shift, x + i));
+    } else {
+        for (int i = order; i < n; i++)
+            w->u[i - order] = zigzag(w->diff[order][i]);
+    }
+
+    /* Partition search */
+    int best_p = 0;
+    uint64_t best_cost = ~0ULL;
+    int ks[1 << LAC_MAX_PART], kt[1 << LAC_MAX_PART];
+    for (int p = 0; p <= LAC_MAX_PART; p++) {
+        if (p > 0 && (m >> p) < 16) break;
+        int parts = 1 << p;
+        uint64_t cost = 3;
+        for (int j = 0; j < parts; j++) {
+            int a = (int)((long long)j * m >> p), b = (int)((long long)(j + 1) * m >> p);
+            uint64_t c;
+            kt[j] = best_k(w->u + a, b - a, &c);
+            cost += 5 + c;
+        }
+        if (cost < best_cost) {
+            best_cost = cost;
+            best_p = p;
+            memcpy(ks, kt, parts * sizeof(int));
+        }
+    }
+
+    uint64_t header_bits = 3 + 16 * (uint64_t)order
+                         + (type == LAC_TYPE_LPC ? 9 + LAC_LPC_PREC * order : 0);
+    if (header_bits + best_cost >= 3 + 16 * (uint64_t)n) {
+        bw_put(&bw, LAC_TYPE_VERBATIM, 3);
+        for (int i = 0; i < n; i++)
+            bw_put(&bw, (uint16_t)x[i], 16);
+        bw_flush(&bw);
+        return bw.len;
+    }
+
+    bw_put(&bw, (uint32_t)type, 3);
+    if (type == LAC_TYPE_LPC) {
+        bw_put(&bw, (uint32_t)order, 4);
+        bw_put(&bw, (uint32_t)shift, 5);
+        for (int j = 0; j < order; j++)
+            bw_put(&bw, (uint32_t)q[j], LAC_LPC_PREC);
+    }
+    for (int i = 0; i < order; i++)
+        bw_put(&bw, (uint16_t)x[i], 16);
+    bw_put(&bw, (uint32_t)best_p, 3);
+    for (int j = 0; j < (1 << best_p); j++) {
+        int a = (int)((long long)j * m >> best_p), b = (int)((long long)(j + 1) * m >> best_p);
+        bw_put(&bw, (uint32_t)ks[j], 5);
+        for (int i = a; i < b; i++)
+            bw_rice(&bw, w->u[i], ks[j]);
+    }
+    bw_flush(&bw);
+    return bw.len;
+}
+
+static int flush_block(lac_writer_t *w) {
+    int n = w->n_pending;
+    if (n == 0) return 0;
+    size_t len = encode_block(w, w->pending, n);
+    if (decode_payload(w->frame + LAC_FRAME_HDR, len, n, w->check) != 0
+        || memcmp(w->check, w->pending, n * sizeof(int16_t)) != 0)
+        return -1;
+    *(uint32_t *)w->frame = (uint32_t)len;
+    *(uint16_t *)(w->frame + 4) = (uint16_t)n;
+    if (write_at(w->file, w->offset, w->frame, (DWORD)(LAC_FRAME_HDR + len)) != 0)
+        return -1;
+    w->offset += LAC_FRAME_HDR + len;
+    w->samples += n;
+    w->n_pending = 0;
+    return 0;
+}
+
+static void fill_header(unsigned char *h, int sample_rate, uint32_t count) {
+    memcpy(h, LAC_MAGIC, 4);
+    *(uint32_t *)(h + 4) = (uint32_t)sample_rate;
+    *(uint32_t *)(h + 8) = count;
+    *(uint16_t *)(h + 12) = LAC_BLOCK_SAMPLES;
+    *(uint16_t *)(h + 14) = 0;
+}
+
+lac_writer_t *lac_writer_open(const char *path, int sample_rate) {
+    lac_writer_t *w = (lac_writer_t *)calloc(1, sizeof(lac_writer_t));
+    if (!w) return NULL;
+    w->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                          CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (w->file == INVALID_HANDLE_VALUE) {
+        free(w);
+        return NULL;
+    }
+    unsigned char h[LAC_HEADER_BYTES];
+    fill_header(h, sample_rate, LAC_COUNT_OPEN);
+    if (write_at(w->file, 0, h, sizeof(h)) != 0) {
+        CloseHandle(w->file);
+        DeleteFileA(path);
+        free(w);
+        return NULL;
+    }
+    w->offset = LAC_HEADER_BYTES;
+    return w;
+}
+
+int lac_writer_write(lac_writer_t *w, const int16_t *pcm, int n) {
+    if (!w || w->failed) return -1;
+    while (n > 0) {
+        int take = LAC_BLOCK_SAMPLES - w->n_pending;
+        if (take > n) take = n;
+        memcpy(w->pending + w->n_pending, pcm, take * sizeof(int16_t));
+        w->n_pending += take;
+        pcm += take;
+        n -= take;
+        if (w->n_pending == LAC_BLOCK_SAMPLES && flush_block(w) != 0) {
+            w->failed = 1;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int lac_writer_close(lac_writer_t *w) {
+    if (!w) return -1;
+    if (!w->failed && flush_block(w) != 0) w->failed = 1;
+    if (!w->failed) {
+        uint32_t count = w->samples < LAC_COUNT_OPEN ? (uint32_t)w->samples : LAC_COUNT_OPEN;
+        if (write_at(w->file, 8, &count, sizeof(count)) != 0) w->failed = 1;
+    }
+    CloseHandle(w->file);
+    int rc = w->failed ? -1 : (int)w->samples;
+    free(w);
+    return rc;
+}
+
+long long lac_writer_bytes(const lac_writer_t *w) {
+    return w ? w->offset : 0;
+}
+
+/* ---- Decoder ---- */
+
+static int decode_payload(const unsigned char *p, size_t len, int n, int16_t *out) {
+    bitr_t br = { p, p + len, 0, 0, 0 };
+    int type = (int)br_get(&br, 3);
+
+    if (type == LAC_TYPE_VERBATIM) {
+        for (int i = 0; i < n; i++)
+            out[i] = (int16_t)br_get(&br, 16);
+        return br.used <= len * 8 ? 0 : -1;
+    }
+
+    int32_t coef[LAC_LPC_ORDER];
+    int order, shift = 0;
+    if (type == LAC_TYPE_LPC) {
+        order = (int)br_get(&br, 4);
+        shift = (int)br_get(&br, 5);
+        if (order < 1 || order > LAC_LPC_ORDER) return -1;
+        for (int j = 0; j < order; j++) {
+            uint32_t v = br_get(&br, LAC_LPC_PREC);
+            coef[j] = (int32_t)(v << (32 - LAC_LPC_PREC)) >> (32 - LAC_LPC_PREC);
+        }
+    } else if (type <= LAC_MAX_FIXED) {
+        order = type;
+        memcpy(coef, k_fixed[order], sizeof(k_fixed[order]));
+    } else {
+        return -1;
+    }
+    if (order > n) return -1;
+
+    for (int i = 0; i < order; i++)
+        out[i] = (int16_t)br_get(&br, 16);
+
+    int m = n - order;
+    int part = (int)br_get(&br, 3);
+    if (part > LAC_MAX_PART) return -1;
+    for (int j = 0; j < (1 << part); j++) {
+        int a = (int)((long long)j * m >> part), b = (int)((long long)(j + 1) * m >> part);
+        int k = (int)br_get(&br, 5);
+        if (k > 30) return -1;
+        for (int i = order + a; i < order + b; i++) {
+            int32_t v = unzigzag(br_rice(&br, k)) + predict(coef, order, shift, out + i);
+            if (v < -32768 || v > 32767) return -1;
+            out[i] = (int16_t)v;
+        }
+    }
+    return br.used <= len * 8 ? 0 : -1;
+}
+
+int lac_probe(const unsigned char *data, size_t size) {
+    return data && size >= LAC_HEADER_BYTES && memcmp(data, LAC_MAGIC, 4) == 0;
+}
+
+int16_t *lac_decode(const unsigned char *data, size_t size,
+                    int *n_samples, int *sample_rate) {
+    if (!lac_probe(data, size)) return NULL;
+    int block = *(const uint16_t *)(data + 12);
+    if (block <= 0) return NULL;
+
+    /* Count samples in complete frames (the header count is unset if the
+     * writer never closed) */
+    long long total = 0;
+    size_t pos = LAC_HEADER_BYTES;
+    while (pos + LAC_FRAME_HDR <= size) {
+        uint32_t len = *(const uint32_t *)(data + pos);
+        int n = *(const uint16_t *)(data + pos + 4);
+        if (n == 0 || n > block || len > size - pos - LAC_FRAME_HDR) break;
+        total += n;
+        pos += LAC_FRAME_HDR + len;
+    }
+    if (total == 0 || total > 0x7FFFFFFF) return NULL;
+
+    int16_t *out = (int16_t *)malloc((size_t)total * sizeof(int16_t));
+    if (!out) return NULL;
+    long long done = 0;
+    pos = LAC_HEADER_BYTES;
+    while (done < total) {
+        uint32_t len = *(const uint32_t *)(data + pos);
+        int n = *(const uint16_t *)(data + pos + 4);
+        if (decode_payload(data + pos + LAC_FRAME_HDR, len, n, out + done) != 0)
+            break;
+        done += n;
+        pos += LAC_FRAME_HDR + len;
+    }
+    if (done == 0) {
+        free(out);
+        return NULL;
+    }
+    *n_samples = (int)done;
+    if (sample_rate) *sample_rate = (int)*(const uint32_t *)(data + 4);
+    return out;
+}
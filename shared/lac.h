@@ -0,0 +1,45 @@
+/*
+ * lac.h - Lossless audio codec for archived recordings
+ *
+ * FLAC-style compression of 16-bit mono PCM: each block of up to
+ * LAC_BLOCK_SAMPLES is coded with a fixed polynomial or quantized LPC
+ * predictor and partitioned Rice-coded residuals. Blocks are independent
+ * and length-prefixed, so a truncated file still decodes up to its last
+ * complete block. Speech typically packs to about half the WAV size.
+ */
+#ifndef LAC_H
+#define LAC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LAC_BLOCK_SAMPLES 4096
+#define LAC_HEADER_BYTES  16
+
+typedef struct lac_writer lac_writer_t;
+
+/* Create path and write the file header. Returns NULL on failure. */
+lac_writer_t *lac_writer_open(const char *path, int sample_rate);
+
+/* Encode samples (buffered into whole blocks). Every block is decoded again
+ * and compared before it is written. Returns 0, or -1 on an I/O or
+ * verification error (later calls keep failing). */
+int lac_writer_write(lac_writer_t *w, const int16_t *pcm, int n);
+
+/* Flush the last partial block, patch the sample count and close.
+ * Frees w. Returns samples written, or -1 if anything failed. */
+int lac_writer_close(lac_writer_t *w);
+
+/* Compressed bytes written so far, header included. */
+long long lac_writer_bytes(const lac_writer_t *w);
+
+/* Nonzero if data starts with a LAC header. */
+int lac_probe(const unsigned char *data, size_t size);
+
+/* Decode a whole file image. Returns malloc'd samples (caller frees) and
+ * sets *n_samples and *sample_rate, or NULL if the header is bad or no
+ * block decodes. */
+int16_t *lac_decode(const unsigned char *data, size_t size,
+                    int *n_samples, int *sample_rate);
+
+#endif /* LAC_H */
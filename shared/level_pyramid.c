@@ -0,0 +1,249 @@
+/*
+ * level_pyramid.c - Multi-resolution min/max/RMS waveform summary
+ *
+ * Each level is a growable cell array. Level L cell i covers samples
+ * [i, i+1) * (LEVEL_PYR_BASE << L). A query covers each pixel's range with
+ * the coarsest aligned cells that fit, so a pixel costs O(log) cells at
+ * worst and usually two or three. At the live edge it drops to finer levels
+ * and finally to the partial level-0 accumulator.
+ *
+ * Base cells are summarized with SSE2 where available (always on x64):
+ * min/max over 8 lanes and pmaddwd for the sum of squares.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "level_pyramid.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define LP_SSE2 1
+#endif
+
+#define LP_BASE_SHIFT 7      /* log2(LEVEL_PYR_BASE) */
+#define LP_MAX_LEVELS 26     /* level 25 cell = 2^32 samples */
+
+typedef struct {
+    int16_t mn, mx;
+    float sumsq;             /* sum of squares in int16 units / 2^30 */
+} lp_cell_t;
+
+typedef struct {
+    lp_cell_t *cells;
+    int64_t count;
+    int64_t cap;
+} lp_level_t;
+
+struct level_pyr {
+    lp_level_t levels[LP_MAX_LEVELS];
+    int n_levels;
+    /* Partial level-0 cell */
+    int acc_n;
+    int acc_mn, acc_mx;
+    int64_t acc_sq;
+    int64_t total;
+};
+
+#define LP_SQ_SCALE (1.0f / 1073741824.0f)   /* 2^-30 */
+
+level_pyr_t *level_pyr_create(void) {
+    level_pyr_t *p = (level_pyr_t *)calloc(1, sizeof(level_pyr_t));
+    if (!p) return NULL;
+    p->acc_mn = 32767;
+    p->acc_mx = -32768;
+    return p;
+}
+
+void level_pyr_destroy(level_pyr_t *p) {
+    if (!p) return;
+    for (int l = 0; l < LP_MAX_LEVELS; l++)
+        free(p->levels[l].cells);
+    free(p);
+}
+
+void level_pyr_reset(level_pyr_t *p) {
+    if (!p) return;
+    for (int l = 0; l < LP_MAX_LEVELS; l++)
+        p->levels[l].count = 0;  /* keep allocations for the next recording */
+    p->n_levels = 0;
+    p->acc_n = 0;
+    p->acc_mn = 32767;
+    p->acc_mx = -32768;
+    p->acc_sq = 0;
+    p->total = 0;
+}
+
+int64_t level_pyr_count(const level_pyr_t *p) {
+    return p ? p->total : 0;
+}
+
+/* ---- Build ---- */
+
+/* min/max/sum-of-squares of n samples, folded into *mn, *mx, *sq */
+static void summarize(const int16_t *x, int n, int *mn, int *mx, int64_t *sq) {
+    int i = 0;
+    int lo = *mn, hi = *mx;
+    int64_t s = 0;
+#ifdef LP_SSE2
+    if (n >= 8) {
+        __m128i vmn = _mm_set1_epi16(32767);
+        __m128i vmx = _mm_set1_epi16(-32768);
+        __m128i vsq = _mm_setzero_si128();   /* 2 x int64 */
+        __m128i zero = _mm_setzero_si128();
+        for (; i + 8 <= n; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(x + i));
+            vmn = _mm_min_epi16(vmn, v);
+            vmx = _mm_max_epi16(vmx, v);
+            /* Pair sums of squares are <= 2^31, so they fit as uint32 */
+            __m128i sq32 = _mm_madd_epi16(v, v);
+            vsq = _mm_add_epi64(vsq, _mm_unpacklo_epi32(sq32, zero));
+            vsq = _mm_add_epi64(vsq, _mm_unpackhi_epi32(sq32, zero));
+        }
+        int16_t amn[8], amx[8];
+        int64_t asq[2];
+        _mm_storeu_si128((__m128i *)amn, vmn);
+        _mm_storeu_si128((__m128i *)amx, vmx);
+        _mm_storeu_si128((__m128i *)asq, vsq);
+        for (int k = 0; k < 8; k++) {
+            if (amn[k] < lo) lo = amn[k];
+            if (amx[k] > hi) hi = amx[k];
+        }
+        s = asq[0] + asq[1];
+    }
+#endif
+    for (; i < n; i++) {
+        int v = x[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+        s += (int64_t)v * v;
+    }
+    *mn = lo;
+    *mx = hi;
+    *sq += s;
+}
+
+static void merge_cell(lp_cell_t *dst, const lp_cell_t *a, const lp_cell_t *b) {
+    dst->mn = a->mn < b->mn ? a->mn : b->mn;
+    dst->mx = a->mx > b->mx ? a->mx : b->mx;
+    dst->sumsq = a->sumsq + b->sumsq;
+}
+
+static int push_cell(level_pyr_t *p, int l, const lp_cell_t *c) {
+    if (l >= LP_MAX_LEVELS) return 0;
+    lp_level_t *lv = &p->levels[l];
+    if (lv->count == lv->cap) {
+        int64_t cap = lv->cap ? lv->cap * 2 : 1024;
+        lp_cell_t *nc = (lp_cell_t *)realloc(lv->cells, (size_t)cap * sizeof(lp_cell_t));
+        if (!nc) return -1;
+        lv->cells = nc;
+        lv->cap = cap;
+    }
+    lv->cells[lv->count++] = *c;
+    if (l + 1 > p->n_levels) p->n_levels = l + 1;
+    /* Every second cell completes a parent */
+    if ((lv->count & 1) == 0) {
+        lp_cell_t parent;
+        merge_cell(&parent, &lv->cells[lv->count - 2], &lv->cells[lv->count - 1]);
+        return push_cell(p, l + 1, &parent);
+    }
+    return 0;
+}
+
+int level_pyr_append(level_pyr_t *p, const int16_t *pcm, int n) {
+    if (!p || !pcm) return -1;
+    while (n > 0) {
+        int take = LEVEL_PYR_BASE - p->acc_n;
+        if (take > n) take = n;
+        summarize(pcm, take, &p->acc_mn, &p->acc_mx, &p->acc_sq);
+        p->acc_n += take;
+        p->total += take;
+        pcm += take;
+        n -= take;
+        if (p->acc_n == LEVEL_PYR_BASE) {
+            lp_cell_t c;
+            c.mn = (int16_t)p->acc_mn;
+            c.mx = (int16_t)p->acc_mx;
+            c.sumsq = (float)p->acc_sq * LP_SQ_SCALE;
+            p->acc_n = 0;
+            p->acc_mn = 32767;
+            p->acc_mx = -32768;
+            p->acc_sq = 0;
+            if (push_cell(p, 0, &c) != 0) return -1;
+        }
+    }
+    return 0;
+}
+
+/* ---- Query ---- */
+
+/* Largest level whose cells fit inside span samples (0 if none do) */
+static int level_for_span(const level_pyr_t *p, int64_t span) {
+    int l = 0;
+    while (l + 1 < p->n_levels
+           && ((int64_t)LEVEL_PYR_BASE << (l + 1)) <= span)
+        l++;
+    return l;
+}
+
+int level_pyr_query(const level_pyr_t *p, int64_t start, int64_t end,
+                    int n_px, level_px_t *out) {
+    if (!out || n_px <= 0) return 0;
+    memset(out, 0, (size_t)n_px * sizeof(level_px_t));
+    if (!p || end <= start || start >= p->total) return 0;
+
+    int64_t range = end - start;
+    int filled = 0;
+    for (int i = 0; i < n_px; i++) {
+        int64_t a = start + range * i / n_px;
+        int64_t b = start + range * (i + 1) / n_px;
+        if (b <= a) b = a + 1;
+        if (a >= p->total) break;
+        if (a < 0) a = 0;
+
+        int top = level_for_span(p, b - a);
+        int mn = 32767, mx = -32768;
+        double sumsq = 0.0;
+        int64_t covered = 0;
+
+        /* Snap to the base grid, then take the coarsest aligned cell that
+         * fits before b (only a base cell may overhang) */
+        int64_t pos = a & ~(int64_t)(LEVEL_PYR_BASE - 1);
+        while (pos < b) {
+            int l = top;
+            while (l >= 0) {
+                int64_t size = (int64_t)LEVEL_PYR_BASE << l;
+                if ((pos & (size - 1)) == 0
+                    && (l == 0 || pos + size <= b)
+                    && (pos >> (LP_BASE_SHIFT + l)) < p->levels[l].count)
+                    break;
+                l--;
+            }
+            if (l < 0) {
+                /* Live edge: only the partial accumulator is left */
+                if (p->acc_n > 0) {
+                    if (p->acc_mn < mn) mn = p->acc_mn;
+                    if (p->acc_mx > mx) mx = p->acc_mx;
+                    sumsq += (double)p->acc_sq * LP_SQ_SCALE;
+                    covered += p->acc_n;
+                }
+                break;
+            }
+            const lp_cell_t *c = &p->levels[l].cells[pos >> (LP_BASE_SHIFT + l)];
+            if (c->mn < mn) mn = c->mn;
+            if (c->mx > mx) mx = c->mx;
+            sumsq += c->sumsq;
+            int64_t size = (int64_t)LEVEL_PYR_BASE << l;
+            covered += size;
+            pos += size;
+        }
+        if (covered == 0) continue;
+        out[i].min = mn / 32768.0f;
+        out[i].max = mx / 32768.0f;
+        /* sumsq is in 2^-30 units; samples normalize by 2^15 each */
+        out[i].rms = (float)sqrt(sumsq / (double)covered);
+        filled++;
+    }
+    return filled;
+}
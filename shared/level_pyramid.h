@@ -0,0 +1,42 @@
+/*
+ * level_pyramid.h - Multi-resolution min/max/RMS waveform summary
+ *
+ * Built incrementally from int16 samples as they are recorded. Level 0
+ * summarizes every LEVEL_PYR_BASE samples and each higher level merges two
+ * cells of the one below, so any time range can be drawn at any pixel width
+ * by touching only a few cells per pixel. Single-threaded (UI thread).
+ */
+#ifndef LEVEL_PYRAMID_H
+#define LEVEL_PYRAMID_H
+
+#include <stdint.h>
+
+#define LEVEL_PYR_BASE 128   /* samples per level-0 cell (8 ms at 16 kHz) */
+
+typedef struct level_pyr level_pyr_t;
+
+/* One output pixel; all values normalized to [-1, 1] (rms to [0, 1]) */
+typedef struct {
+    float min;
+    float max;
+    float rms;
+} level_px_t;
+
+level_pyr_t *level_pyr_create(void);
+void level_pyr_destroy(level_pyr_t *p);
+void level_pyr_reset(level_pyr_t *p);
+
+/* Add samples. Returns 0, or -1 if a level could not grow (the pyramid
+ * keeps what it had). */
+int level_pyr_append(level_pyr_t *p, const int16_t *pcm, int n);
+
+/* Samples added since the last reset. */
+int64_t level_pyr_count(const level_pyr_t *p);
+
+/* Fill out[0..n_px) with levels for sample range [start, end), one pixel per
+ * (end-start)/n_px samples. Pixels past the recorded end are zero.
+ * Returns the number of pixels that covered any audio. */
+int level_pyr_query(const level_pyr_t *p, int64_t start, int64_t end,
+                    int n_px, level_px_t *out);
+
+#endif /* LEVEL_PYRAMID_H */
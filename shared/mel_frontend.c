@@ -0,0 +1,317 @@
+/*
+ * mel_frontend.c - Incremental log-mel front-end for feature upload
+ *
+ * Each frame is Hann-windowed (MEL_WIN samples), turned into a 400-point
+ * power spectrum and projected onto a Slaney-normalized mel filterbank
+ * (0-8 kHz, as librosa builds it for Whisper's front-end). 400 is not a
+ * power of two, so the spectrum comes from a small mixed-radix FFT
+ * (4 x 4 x 5 x 5) here rather than from fft.c. Filters are stored sparsely
+ * as (first bin, weights). Values are quantized as soon as they are
+ * computed; the float frame is never kept.
+ *
+ * The pending buffer holds the samples of the next frame. After a reset it
+ * starts half full (the reflected half), and the reflection is written in
+ * once the first half window of real samples has arrived.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "mel_frontend.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEL_MAGIC     "LMEL"
+#define MEL_VERSION   2
+#define MEL_FLAG_CENTER 1
+#define MEL_PI        3.14159265358979323846
+
+#define Q8_SCALE      (10.0f / 255.0f)
+#define Q8_OFFSET     (-3.0f)
+#define Q16_SCALE     (1.0f / 2048.0f)
+#define Q16_OFFSET    0.0f
+
+typedef struct {
+    float re, im;
+} mel_cpx_t;
+
+typedef struct {
+    int first;          /* first FFT bin */
+    int len;
+    float *w;
+} mel_filter_t;
+
+static const int k_factors[] = { 4, 4, 5, 5 };     /* MEL_NFFT */
+
+struct mel_fe {
+    mel_quant_t quant;
+    int elem;                       /* bytes per value */
+    int n_mels;
+    float window[MEL_WIN];
+    mel_cpx_t twiddle[MEL_NFFT];    /* e^{-2 pi i k / MEL_NFFT} */
+    mel_filter_t *filters;
+    float pending[MEL_WIN];
+    int fill;
+    int reflect;                    /* first frame's left half still to mirror */
+    float in[MEL_NFFT];
+    mel_cpx_t spec[MEL_NFFT];
+    float power[MEL_FFT_BINS];
+
+    unsigned char *data;            /* retained frames, frame-major */
+    int base;                       /* frame index of data[0] */
+    int count;                      /* frames retained */
+    int cap;
+};
+
+/* ---- FFT ---- */
+
+/* Decimation in time: the n-point DFT of x[0], x[stride], ... into out,
+ * splitting off one factor per level. */
+static void fft_mixed(const mel_fe_t *fe, const float *x, int stride, int n,
+                      const int *factors, mel_cpx_t *out) {
+    int p = factors[0], m = n / p;
+    if (m == 1) {
+        for (int u = 0; u < p; u++) {
+            out[u].re = x[u * stride];
+            out[u].im = 0.0f;
+        }
+    } else {
+        for (int q = 0; q < p; q++)
+            fft_mixed(fe, x + q * stride, stride * p, m, factors + 1, out + q * m);
+    }
+    /* p-point butterflies over the p sub-transforms */
+    const mel_cpx_t *tw = fe->twiddle;
+    int rot = MEL_NFFT / p;
+    for (int k = 0; k < m; k++) {
+        mel_cpx_t t[5];
+        for (int u = 0; u < p; u++) {
+            mel_cpx_t a = out[u * m + k], w = tw[u * k * stride];
+            t[u].re = a.re * w.re - a.im * w.im;
+            t[u].im = a.re * w.im + a.im * w.re;
+        }
+        for (int q = 0; q < p; q++) {
+            float re = t[0].re, im = t[0].im;
+            for (int u = 1; u < p; u++) {
+                mel_cpx_t w = tw[(u * q % p) * rot];
+                re += t[u].re * w.re - t[u].im * w.im;
+                im += t[u].re * w.im + t[u].im * w.re;
+            }
+            out[q * m + k].re = re;
+            out[q * m + k].im = im;
+        }
+    }
+}
+
+/* ---- Filterbank ---- */
+
+/* Slaney mel scale: linear below 1 kHz, logarithmic above */
+static double hz_to_mel(double hz) {
+    if (hz < 1000.0) return hz * 3.0 / 200.0;
+    return 15.0 + log(hz / 1000.0) / (log(6.4) / 27.0);
+}
+
+static double mel_to_hz(double mel) {
+    if (mel < 15.0) return mel * 200.0 / 3.0;
+    return 1000.0 * exp((mel - 15.0) * (log(6.4) / 27.0));
+}
+
+static int build_filters(mel_fe_t *fe) {
+    int n_mels = fe->n_mels;
+    double pts[MEL_BINS_MAX + 2];
+    double lo = hz_to_mel(0.0), hi = hz_to_mel(MEL_SAMPLE_RATE / 2.0);
+    for (int i = 0; i < n_mels + 2; i++)
+        pts[i] = mel_to_hz(lo + (hi - lo) * i / (n_mels + 1));
+
+    float w[MEL_FFT_BINS];
+    for (int m = 0; m < n_mels; m++) {
+        double f0 = pts[m], f1 = pts[m + 1], f2 = pts[m + 2];
+        double norm = 2.0 / (f2 - f0);
+        int first = -1, last = -1;
+        for (int k = 0; k < MEL_FFT_BINS; k++) {
+            double f = (double)k * MEL_SAMPLE_RATE / MEL_NFFT;
+            double up = (f - f0) / (f1 - f0), down = (f2 - f) / (f2 - f1);
+            double v = up < down ? up : down;
+            w[k] = v > 0.0 ? (float)(v * norm) : 0.0f;
+            if (w[k] > 0.0f) {
+                if (first < 0) first = k;
+                last = k;
+            }
+        }
+        /* A filter narrower than a bin (many mels) keeps one zero weight,
+         * as librosa's row of zeros */
+        if (first < 0) first = last = (int)(f1 * MEL_NFFT / MEL_SAMPLE_RATE);
+        mel_filter_t *flt = &fe->filters[m];
+        flt->first = first;
+        flt->len = last - first + 1;
+        flt->w = (float *)malloc(flt->len * sizeof(float));
+        if (!flt->w) return -1;
+        memcpy(flt->w, w + first, flt->len * sizeof(float));
+    }
+    return 0;
+}
+
+/* ---- Front-end ---- */
+
+mel_fe_t *mel_fe_create(mel_quant_t quant, int n_mels) {
+    if (quant != MEL_Q_INT8 && quant != MEL_Q_INT16) return NULL;
+    if (n_mels < 1 || n_mels > MEL_BINS_MAX) return NULL;
+    mel_fe_t *fe = (mel_fe_t *)calloc(1, sizeof(mel_fe_t));
+    if (!fe) return NULL;
+    fe->quant = quant;
+    fe->elem = quant == MEL_Q_INT8 ? 1 : 2;
+    fe->n_mels = n_mels;
+    fe->filters = (mel_filter_t *)calloc(n_mels, sizeof(mel_filter_t));
+    if (!fe->filters || build_filters(fe) != 0) {
+        mel_fe_destroy(fe);
+        return NULL;
+    }
+    /* Periodic Hann, as torch.hann_window */
+    for (int i = 0; i < MEL_WIN; i++)
+        fe->window[i] = (float)(0.5 - 0.5 * cos(2.0 * MEL_PI * i / MEL_WIN));
+    for (int k = 0; k < MEL_NFFT; k++) {
+        fe->twiddle[k].re = (float)cos(-2.0 * MEL_PI * k / MEL_NFFT);
+        fe->twiddle[k].im = (float)sin(-2.0 * MEL_PI * k / MEL_NFFT);
+    }
+    mel_fe_reset(fe);
+    return fe;
+}
+
+void mel_fe_destroy(mel_fe_t *fe) {
+    if (!fe) return;
+    if (fe->filters)
+        for (int m = 0; m < fe->n_mels; m++) free(fe->filters[m].w);
+    free(fe->filters);
+    free(fe->data);
+    free(fe);
+}
+
+void mel_fe_reset(mel_fe_t *fe) {
+    if (!fe) return;
+    /* Frame 0 is centered on sample 0: its first half is the reflection */
+    memset(fe->pending, 0, sizeof(fe->pending));
+    fe->fill = MEL_WIN / 2;
+    fe->reflect = 1;
+    fe->base = 0;
+    fe->count = 0;
+}
+
+static int grow(mel_fe_t *fe) {
+    if (fe->count < fe->cap) return 0;
+    int nc = fe->cap ? fe->cap * 2 : 1024;
+    unsigned char *nd = (unsigned char *)realloc(fe->data,
+                                                 (size_t)nc * fe->n_mels * fe->elem);
+    if (!nd) return -1;
+    fe->data = nd;
+    fe->cap = nc;
+    return 0;
+}
+
+/* Compute and quantize the frame in fe->pending */
+static int compute_frame(mel_fe_t *fe) {
+    if (grow(fe) != 0) return -1;
+    for (int i = 0; i < MEL_WIN; i++) fe->in[i] = fe->pending[i] * fe->window[i];
+    fft_mixed(fe, fe->in, 1, MEL_NFFT, k_factors, fe->spec);
+    for (int k = 0; k < MEL_FFT_BINS; k++)
+        fe->power[k] = fe->spec[k].re * fe->spec[k].re + fe->spec[k].im * fe->spec[k].im;
+
+    unsigned char *dst = fe->data + (size_t)fe->count * fe->n_mels * fe->elem;
+    for (int m = 0; m < fe->n_mels; m++) {
+        const mel_filter_t *flt = &fe->filters[m];
+        const float *p = fe->power + flt->first;
+        float e = 0.0f;
+        for (int k = 0; k < flt->len; k++) e += flt->w[k] * p[k];
+        float lg = log10f(e > 1e-10f ? e : 1e-10f);
+        if (fe->quant == MEL_Q_INT8) {
+            float q = floorf((lg - Q8_OFFSET) / Q8_SCALE + 0.5f);
+            if (q < -128.0f) q = -128.0f;
+            if (q > 127.0f) q = 127.0f;
+            ((int8_t *)dst)[m] = (int8_t)q;
+        } else {
+            float q = floorf((lg - Q16_OFFSET) / Q16_SCALE + 0.5f);
+            if (q < -32768.0f) q = -32768.0f;
+            if (q > 32767.0f) q = 32767.0f;
+            ((int16_t *)dst)[m] = (int16_t)q;
+        }
+    }
+    fe->count++;
+    return 0;
+}
+
+int mel_fe_push_s16(mel_fe_t *fe, const int16_t *pcm, int n) {
+    if (!fe || !pcm) return 0;
+    int added = 0;
+    while (n > 0) {
+        int take = MEL_WIN - fe->fill;
+        if (take > n) take = n;
+        for (int i = 0; i < take; i++) fe->pending[fe->fill + i] = pcm[i] / 32768.0f;
+        fe->fill += take;
+        pcm += take;
+        n -= take;
+        if (fe->fill < MEL_WIN) break;
+
+        if (fe->reflect) {
+            /* x[-j] = x[j]; slot 0 (x[-200]) has zero window weight */
+            int c = MEL_WIN / 2;
+            for (int j = 1; j < c; j++) fe->pending[c - j] = fe->pending[c + j];
+            fe->reflect = 0;
+        }
+        if (compute_frame(fe) != 0) return -1;
+        added++;
+        memmove(fe->pending, fe->pending + MEL_HOP, (MEL_WIN - MEL_HOP) * sizeof(float));
+        fe->fill = MEL_WIN - MEL_HOP;
+    }
+    return added;
+}
+
+int mel_fe_frames(const mel_fe_t *fe) {
+    return fe ? fe->base + fe->count : 0;
+}
+
+void mel_fe_discard_before(mel_fe_t *fe, int first_frame) {
+    if (!fe || first_frame <= fe->base) return;
+    int drop = first_frame - fe->base;
+    if (drop > fe->count) drop = fe->count;
+    size_t row = (size_t)fe->n_mels * fe->elem;
+    memmove(fe->data, fe->data + drop * row, (fe->count - drop) * row);
+    fe->count -= drop;
+    fe->base += drop;
+}
+
+unsigned char *mel_fe_serialize(const mel_fe_t *fe, int first_frame, int n_frames,
+                                size_t *size) {
+    if (!fe) return NULL;
+    if (first_frame < fe->base) {
+        n_frames -= fe->base - first_frame;
+        first_frame = fe->base;
+    }
+    int avail = fe->base + fe->count - first_frame;
+    if (n_frames > avail) n_frames = avail;
+    if (n_frames <= 0) return NULL;
+
+    size_t row = (size_t)fe->n_mels * fe->elem;
+    size_t total = MEL_HEADER_BYTES + (size_t)n_frames * row;
+    unsigned char *out = (unsigned char *)malloc(total);
+    if (!out) return NULL;
+    unsigned char *h = out;
+    memset(h, 0, MEL_HEADER_BYTES);
+    memcpy(h, MEL_MAGIC, 4);
+    *(uint16_t *)(h + 4) = MEL_VERSION;
+    *(uint16_t *)(h + 6) = (uint16_t)fe->n_mels;
+    *(uint32_t *)(h + 8) = (uint32_t)n_frames;
+    *(uint16_t *)(h + 12) = MEL_HOP;
+    *(uint16_t *)(h + 14) = MEL_WIN;
+    *(uint32_t *)(h + 16) = MEL_SAMPLE_RATE;
+    h[20] = (unsigned char)fe->quant;
+    h[21] = MEL_FLAG_CENTER;
+    *(uint16_t *)(h + 22) = MEL_NFFT;
+    *(float *)(h + 24) = fe->quant == MEL_Q_INT8 ? Q8_SCALE : Q16_SCALE;
+    *(float *)(h + 28) = fe->quant == MEL_Q_INT8 ? Q8_OFFSET : Q16_OFFSET;
+    *(uint16_t *)(h + 32) = MEL_FFT_BINS;
+    memcpy(out + MEL_HEADER_BYTES, fe->data + (size_t)(first_frame - fe->base) * row,
+           (size_t)n_frames * row);
+    *size = total;
+    return out;
+}
+
+int mel_frame_at(long long sample) {
+    return (int)((sample + MEL_HOP - 1) / MEL_HOP);
+}
@@ -0,0 +1,79 @@
+/*
+ * mel_frontend.h - Incremental log-mel front-end for feature upload
+ *
+ * Computes log10 mel frames the way the server's Whisper-style front-end
+ * does (400-point STFT of 25 ms periodic Hann frames, 10 ms hop, centered
+ * frames with reflect padding, Slaney mel filters over 0-8 kHz, 16 kHz)
+ * once, as audio arrives, and keeps them quantized to int8 or int16. The
+ * mel count is the encoder's (80 or 128). A pass serializes the frames of
+ * its window into an "LMEL" block that is uploaded instead of PCM, so the
+ * server can skip its spectrogram front-end and the upload shrinks (int8,
+ * 128 bins: 12.8 KB/s vs 32 KB/s of PCM).
+ *
+ * Frame i is centered on sample i * MEL_HOP and covers samples
+ * [i * MEL_HOP - MEL_WIN / 2, i * MEL_HOP + MEL_WIN / 2); before sample 0
+ * the recording is reflected. A window of n samples has n / MEL_HOP frames,
+ * as the server's front-end drops its final one. Only the recording start
+ * is padded: a window cut from the middle of a recording sees real audio
+ * around its edges where the server would reflect its own, which changes
+ * its first and last frame a little.
+ *
+ * LMEL block (version 2), little-endian:
+ *   "LMEL" u16 version u16 n_mels u32 n_frames u16 hop u16 win
+ *   u32 sample_rate u8 quant u8 flags u16 n_fft f32 scale f32 offset
+ *   u16 n_fft_bins u16 0
+ *   then n_frames * n_mels values (int8 or int16), frame-major;
+ *   log10(mel power) = q * scale + offset. flags bit 0: centered,
+ *   reflect-padded frames.
+ */
+#ifndef MEL_FRONTEND_H
+#define MEL_FRONTEND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MEL_SAMPLE_RATE   16000
+#define MEL_BINS_DEFAULT  128       /* large-v3-style encoders; older take 80 */
+#define MEL_BINS_MAX      256
+#define MEL_HOP           160
+#define MEL_WIN           400
+#define MEL_NFFT          400
+#define MEL_FFT_BINS      (MEL_NFFT / 2 + 1)
+#define MEL_HEADER_BYTES  36
+
+typedef enum {
+    MEL_Q_INT8 = 1,     /* ~0.04 log10 units per step, range [-8, 2] */
+    MEL_Q_INT16 = 2     /* 1/2048 per step, range +-16 */
+} mel_quant_t;
+
+typedef struct mel_fe mel_fe_t;
+
+/* n_mels: 1..MEL_BINS_MAX, the encoder's mel count. Returns NULL on
+ * failure. */
+mel_fe_t *mel_fe_create(mel_quant_t quant, int n_mels);
+void mel_fe_destroy(mel_fe_t *fe);
+
+/* Drop all frames and buffered samples (new recording). */
+void mel_fe_reset(mel_fe_t *fe);
+
+/* Append samples and compute every frame they complete. Returns frames
+ * added, or -1 on allocation failure. */
+int mel_fe_push_s16(mel_fe_t *fe, const int16_t *pcm, int n);
+
+/* Total frames computed since the last reset. */
+int mel_fe_frames(const mel_fe_t *fe);
+
+/* Release frames before first_frame (audio behind the committed window).
+ * They can no longer be serialized. */
+void mel_fe_discard_before(mel_fe_t *fe, int first_frame);
+
+/* LMEL block for frames [first_frame, first_frame + n_frames), clamped to
+ * what is retained. Returns malloc'd bytes (caller frees) and sets *size,
+ * or NULL if no frames are in range. */
+unsigned char *mel_fe_serialize(const mel_fe_t *fe, int first_frame, int n_frames,
+                                size_t *size);
+
+/* First frame at or after a sample position. */
+int mel_frame_at(long long sample);
+
+#endif /* MEL_FRONTEND_H */
@@ -0,0 +1,214 @@
+/*
+ * prefetch_queue.c - Priority work queue for background prefetch
+ *
+ * Ready ids live in a binary max-heap ordered by (priority, push order).
+ * Ids backing off stay out of the heap; pop scans them only while any
+ * exist, which is cheap next to the fetch each one stands for.
+ */
+#include "prefetch_queue.h"
+
+#include <stdlib.h>
+#include <windows.h>
+
+enum { PFQ_IDLE = 0, PFQ_QUEUED, PFQ_INFLIGHT, PFQ_BACKOFF, PFQ_DONE };
+
+typedef struct {
+    unsigned char state;
+    int priority;
+    unsigned long seq;
+    int attempts;
+    unsigned long retry_at;
+    int heap_pos;
+} pfq_item_t;
+
+struct pfq {
+    CRITICAL_SECTION lock;
+    pfq_item_t *items;
+    int n_items;
+    int *heap;
+    int heap_len;
+    int n_backoff;
+    unsigned long next_seq;
+    unsigned long base_ms, max_ms;
+};
+
+/* ---- Heap (caller holds the lock) ---- */
+
+static int before(const pfq_t *q, int a, int b) {
+    const pfq_item_t *x = &q->items[a], *y = &q->items[b];
+    if (x->priority != y->priority) return x->priority > y->priority;
+    return (long)(x->seq - y->seq) < 0;
+}
+
+static void heap_set(pfq_t *q, int pos, int id) {
+    q->heap[pos] = id;
+    q->items[id].heap_pos = pos;
+}
+
+static void sift_up(pfq_t *q, int pos) {
+    int id = q->heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!before(q, id, q->heap[parent])) break;
+        heap_set(q, pos, q->heap[parent]);
+        pos = parent;
+    }
+    heap_set(q, pos, id);
+}
+
+static void sift_down(pfq_t *q, int pos) {
+    int id = q->heap[pos];
+    for (;;) {
+        int child = pos * 2 + 1;
+        if (child >= q->heap_len) break;
+        if (child + 1 < q->heap_len && before(q, q->heap[child + 1], q->heap[child]))
+            child++;
+        if (!before(q, q->heap[child], id)) break;
+        heap_set(q, pos, q->heap[child]);
+        pos = child;
+    }
+    heap_set(q, pos, id);
+}
+
+static void heap_push(pfq_t *q, int id) {
+    q->items[id].state = PFQ_QUEUED;
+    heap_set(q, q->heap_len++, id);
+    sift_up(q, q->heap_len - 1);
+}
+
+static int heap_pop(pfq_t *q) {
+    int id = q->heap[0];
+    q->heap_len--;
+    if (q->heap_len > 0) {
+        heap_set(q, 0, q->heap[q->heap_len]);
+        sift_down(q, 0);
+    }
+    q->items[id].heap_pos = -1;
+    return id;
+}
+
+/* ---- Queue ---- */
+
+pfq_t *pfq_create(int n_items, unsigned long base_ms, unsigned long max_ms) {
+    if (n_items <= 0) return NULL;
+    pfq_t *q = (pfq_t *)calloc(1, sizeof(pfq_t));
+    if (!q) return NULL;
+    q->items = (pfq_item_t *)calloc(n_items, sizeof(pfq_item_t));
+    q->heap = (int *)malloc(n_items * sizeof(int));
+    if (!q->items || !q->heap) {
+        free(q->items);
+        free(q->heap);
+        free(q);
+        return NULL;
+    }
+    for (int i = 0; i < n_items; i++) q->items[i].heap_pos = -1;
+    InitializeCriticalSection(&q->lock);
+    q->n_items = n_items;
+    q->base_ms = base_ms ? base_ms : 1000;
+    q->max_ms = max_ms > q->base_ms ? max_ms : q->base_ms;
+    return q;
+}
+
+void pfq_destroy(pfq_t *q) {
+    if (!q) return;
+    DeleteCriticalSection(&q->lock);
+    free(q->items);
+    free(q->heap);
+    free(q);
+}
+
+void pfq_push(pfq_t *q, int id, int priority) {
+    if (!q || id < 0 || id >= q->n_items) return;
+    EnterCriticalSection(&q->lock);
+    pfq_item_t *it = &q->items[id];
+    switch (it->state) {
+    case PFQ_IDLE:
+        it->priority = priority;
+        it->seq = q->next_seq++;
+        heap_push(q, id);
+        break;
+    case PFQ_QUEUED:
+        if (priority > it->priority) {
+            it->priority = priority;
+            sift_up(q, it->heap_pos);
+        }
+        break;
+    case PFQ_BACKOFF:
+        /* Someone wants it now: skip the rest of the wait */
+        if (priority > it->priority) it->priority = priority;
+        q->n_backoff--;
+        heap_push(q, id);
+        break;
+    default:    /* in flight or done */
+        break;
+    }
+    LeaveCriticalSection(&q->lock);
+}
+
+int pfq_pop(pfq_t *q, unsigned long now_ms, long *wait_ms) {
+    if (wait_ms) *wait_ms = -1;
+    if (!q) return -1;
+    EnterCriticalSection(&q->lock);
+    long wait = -1;
+    if (q->n_backoff > 0) {
+        for (int i = 0; i < q->n_items; i++) {
+            pfq_item_t *it = &q->items[i];
+            if (it->state != PFQ_BACKOFF) continue;
+            long left = (long)(it->retry_at - now_ms);
+            if (left <= 0) {
+                q->n_backoff--;
+                heap_push(q, i);
+            } else if (wait < 0 || left < wait) {
+                wait = left;
+            }
+        }
+    }
+    int id = -1;
+    if (q->heap_len > 0) {
+        id = heap_pop(q);
+        q->items[id].state = PFQ_INFLIGHT;
+    } else if (wait_ms) {
+        *wait_ms = wait;
+    }
+    LeaveCriticalSection(&q->lock);
+    return id;
+}
+
+void pfq_finish(pfq_t *q, int id, int ok, unsigned long now_ms) {
+    if (!q || id < 0 || id >= q->n_items) return;
+    EnterCriticalSection(&q->lock);
+    pfq_item_t *it = &q->items[id];
+    if (it->state == PFQ_INFLIGHT) {
+        if (ok) {
+            it->state = PFQ_DONE;
+            it->attempts = 0;
+        } else {
+            unsigned long delay = q->base_ms;
+            for (int i = 0; i < it->attempts && delay < q->max_ms; i++) delay *= 2;
+            if (delay > q->max_ms) delay = q->max_ms;
+            it->attempts++;
+            it->retry_at = now_ms + delay;
+            it->state = PFQ_BACKOFF;
+            q->n_backoff++;
+        }
+    }
+    LeaveCriticalSection(&q->lock);
+}
+
+void pfq_reset(pfq_t *q, int id) {
+    if (!q || id < 0 || id >= q->n_items) return;
+    EnterCriticalSection(&q->lock);
+    if (q->items[id].state == PFQ_DONE) {
+        q->items[id].state = PFQ_IDLE;
+        q->items[id].attempts = 0;
+    }
+    LeaveCriticalSection(&q->lock);
+}
+
+int pfq_waiting(pfq_t *q) {
+    if (!q) return 0;
+    EnterCriticalSection(&q->lock);
+    int n = q->heap_len + q->n_backoff;
+    LeaveCriticalSection(&q->lock);
+    return n;
+}
@@ -0,0 +1,40 @@
+/*
+ * prefetch_queue.h - Priority work queue for background prefetch
+ *
+ * Items are small integer ids (0..n_items-1, e.g. sentence indices). Each
+ * id is queued at most once: pushing it again only raises its priority.
+ * Workers pop the highest-priority ready id (ties in push order), then
+ * report success or failure. A failed id is retried after an exponential
+ * backoff (base doubling per attempt up to a ceiling); a priority push
+ * cuts a pending backoff short. Finished ids stay done until reset. All
+ * calls are thread-safe.
+ */
+#ifndef PREFETCH_QUEUE_H
+#define PREFETCH_QUEUE_H
+
+typedef struct pfq pfq_t;
+
+/* base_ms / max_ms bound the retry backoff. Returns NULL on failure. */
+pfq_t *pfq_create(int n_items, unsigned long base_ms, unsigned long max_ms);
+void pfq_destroy(pfq_t *q);
+
+/* Queue id at priority (higher runs first). No-op for ids that are done or
+ * in flight; raises the priority of an id already waiting. */
+void pfq_push(pfq_t *q, int id, int priority);
+
+/* Take the best ready id and mark it in flight. Returns -1 if none is
+ * ready; *wait_ms (optional) is then the time until the next backoff
+ * expires, or -1 if nothing is waiting at all. */
+int pfq_pop(pfq_t *q, unsigned long now_ms, long *wait_ms);
+
+/* Finish an in-flight id: ok marks it done, otherwise it is requeued at its
+ * priority after the backoff. */
+void pfq_finish(pfq_t *q, int id, int ok, unsigned long now_ms);
+
+/* Forget id's done state so it can be pushed again */
+void pfq_reset(pfq_t *q, int id);
+
+/* Ids queued or backing off (not counting in flight) */
+int pfq_waiting(pfq_t *q);
+
+#endif /* PREFETCH_QUEUE_H */
@@ -0,0 +1,293 @@
+/*
+ * rec_store.c - Segmented int16 recording store
+ *
+ * Segments live in a two-level directory so the writer never reallocates
+ * anything a reader might be walking. Each segment is a refcounted
+ * audio_block_t; views take their own references, so a segment stays valid
+ * for as long as a pass or writer still holds it.
+ *
+ * Spilled segments are copied into fixed-size extents of a delete-on-close
+ * temp file, each mapped once. The store's heap block is swapped for one
+ * wrapping the mapped slot under an SRW lock, which readers hold only while
+ * taking references.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "rec_store.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define REC_SEG_BYTES      (REC_SEG_SAMPLES * sizeof(int16_t))
+#define REC_PAGE_SEGS      1024                  /* ~17 min per page */
+#define REC_DIR_PAGES      128                   /* ~36 h, counts fit an int */
+#define REC_EXTENT_SEGS    256                   /* 8 MB, multiple of 64 KB */
+#define REC_EXTENT_BYTES   ((ULONGLONG)REC_EXTENT_SEGS * REC_SEG_BYTES)
+
+/* One mapped view of the spill file; unmapped when the last block using it
+ * (and the store) let go */
+typedef struct {
+    volatile LONG refs;
+    void *view;
+} rec_extent_t;
+
+typedef struct {
+    audio_block_t *block;   /* heap block, or wrapper around an extent slot */
+    int on_disk;
+} rec_seg_t;
+
+struct rec_store {
+    rec_seg_t *dir[REC_DIR_PAGES];
+    volatile LONG count;        /* published samples */
+    int n_segs;                 /* segments allocated by the writer */
+    size_t mem_budget;
+    volatile LONG resident;
+    volatile LONG spilled;
+    int spill_next;             /* oldest segment still on the heap */
+    int spill_failed;
+    SRWLOCK lock;               /* shared while taking refs, exclusive for swaps */
+    HANDLE spill_file;
+    rec_extent_t **extents;
+    int n_extents, extents_cap;
+};
+
+static rec_seg_t *seg_at(const rec_store_t *s, int idx) {
+    return &s->dir[idx / REC_PAGE_SEGS][idx % REC_PAGE_SEGS];
+}
+
+static void extent_release(rec_extent_t *e) {
+    if (InterlockedDecrement(&e->refs) != 0) return;
+    UnmapViewOfFile(e->view);
+    free(e);
+}
+
+static void spilled_block_destroy(audio_block_t *b) {
+    extent_release((rec_extent_t *)b->ctx);
+}
+
+rec_store_t *rec_store_create(size_t mem_budget) {
+    rec_store_t *s = (rec_store_t *)calloc(1, sizeof(rec_store_t));
+    if (!s) return NULL;
+    s->mem_budget = mem_budget;
+    s->spill_file = INVALID_HANDLE_VALUE;
+    InitializeSRWLock(&s->lock);
+    return s;
+}
+
+static void release_segments(rec_store_t *s) {
+    for (int i = 0; i < s->n_segs; i++)
+        audio_block_release(seg_at(s, i)->block);
+    for (int p = 0; p < REC_DIR_PAGES && s->dir[p]; p++) {
+        free(s->dir[p]);
+        s->dir[p] = NULL;
+    }
+    for (int e = 0; e < s->n_extents; e++)
+        extent_release(s->extents[e]);
+    s->n_extents = 0;
+    s->n_segs = 0;
+    s->spill_next = 0;
+    s->resident = 0;
+    s->spilled = 0;
+    s->spill_failed = 0;
+    InterlockedExchange(&s->count, 0);
+    /* Outstanding views may still map the old file, so never reuse it;
+     * it is deleted once the last view is unmapped. */
+    if (s->spill_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(s->spill_file);
+        s->spill_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+void rec_store_destroy(rec_store_t *s) {
+    if (!s) return;
+    release_segments(s);
+    free(s->extents);
+    free(s);
+}
+
+void rec_store_reset(rec_store_t *s) {
+    if (!s) return;
+    release_segments(s);
+}
+
+/* ---- Spill ---- */
+
+static int open_spill_file(rec_store_t *s) {
+    char dir[MAX_PATH], path[MAX_PATH];
+    if (!GetTempPathA(sizeof(dir), dir)) return -1;
+    if (!GetTempFileNameA(dir, "rec", 0, path)) return -1;
+    s->spill_file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+                                CREATE_ALWAYS,
+                                FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                                NULL);
+    return s->spill_file == INVALID_HANDLE_VALUE ? -1 : 0;
+}
+
+static rec_extent_t *spill_extent(rec_store_t *s, int idx) {
+    int e = idx / REC_EXTENT_SEGS;
+    if (e < s->n_extents) return s->extents[e];
+
+    if (s->spill_file == INVALID_HANDLE_VALUE && open_spill_file(s) != 0)
+        return NULL;
+    if (s->n_extents == s->extents_cap) {
+        int cap = s->extents_cap ? s->extents_cap * 2 : 16;
+        rec_extent_t **ne = (rec_extent_t **)realloc(s->extents, cap * sizeof(*ne));
+        if (!ne) return NULL;
+        s->extents = ne;
+        s->extents_cap = cap;
+    }
+    rec_extent_t *ext = (rec_extent_t *)malloc(sizeof(rec_extent_t));
+    if (!ext) return NULL;
+
+    ULONGLONG off = (ULONGLONG)e * REC_EXTENT_BYTES;
+    ULONGLONG end = off + REC_EXTENT_BYTES;
+    HANDLE map = CreateFileMappingA(s->spill_file, NULL, PAGE_READWRITE,
+                                    (DWORD)(end >> 32), (DWORD)end, NULL);
+    if (!map) {
+        free(ext);
+        return NULL;
+    }
+    ext->view = MapViewOfFile(map, FILE_MAP_WRITE, (DWORD)(off >> 32),
+                              (DWORD)off, (SIZE_T)REC_EXTENT_BYTES);
+    CloseHandle(map);  /* the view keeps the mapping alive */
+    if (!ext->view) {
+        free(ext);
+        return NULL;
+    }
+    ext->refs = 1;  /* the store's reference */
+    s->extents[s->n_extents++] = ext;
+    return ext;
+}
+
+static void maybe_spill(rec_store_t *s) {
+    if (s->mem_budget == 0 || s->spill_failed) return;
+    /* Never spill the segment currently being filled */
+    while ((size_t)s->resident * REC_SEG_BYTES > s->mem_budget
+           && s->spill_next < s->n_segs - 1) {
+        rec_seg_t *seg = seg_at(s, s->spill_next);
+        rec_extent_t *ext = spill_extent(s, s->spill_next);
+        audio_block_t *mapped = NULL;
+        if (ext) {
+            int16_t *slot = (int16_t *)ext->view
+                          + (size_t)(s->spill_next % REC_EXTENT_SEGS) * REC_SEG_SAMPLES;
+            memcpy(slot, seg->block->samples, REC_SEG_BYTES);
+            mapped = audio_block_wrap(slot, REC_SEG_SAMPLES, spilled_block_destroy, ext);
+            if (mapped) InterlockedIncrement(&ext->refs);
+        }
+        if (!mapped) {
+            s->spill_failed = 1;
+            return;
+        }
+
+        AcquireSRWLockExclusive(&s->lock);
+        audio_block_t *old = seg->block;
+        seg->block = mapped;
+        seg->on_disk = 1;
+        ReleaseSRWLockExclusive(&s->lock);
+
+        /* Views holding the heap block keep it alive until they finish */
+        audio_block_release(old);
+        InterlockedDecrement(&s->resident);
+        InterlockedIncrement(&s->spilled);
+        s->spill_next++;
+    }
+}
+
+/* ---- Writer ---- */
+
+static int add_segment(rec_store_t *s) {
+    int page = s->n_segs / REC_PAGE_SEGS;
+    if (page >= REC_DIR_PAGES) return -1;
+    if (!s->dir[page]) {
+        s->dir[page] = (rec_seg_t *)calloc(REC_PAGE_SEGS, sizeof(rec_seg_t));
+        if (!s->dir[page]) return -1;
+    }
+    rec_seg_t *seg = seg_at(s, s->n_segs);
+    seg->block = audio_block_new(REC_SEG_SAMPLES);
+    if (!seg->block) return -1;
+    seg->on_disk = 0;
+    s->n_segs++;
+    InterlockedIncrement(&s->resident);
+    maybe_spill(s);
+    return 0;
+}
+
+int rec_store_append(rec_store_t *s, const int16_t *pcm, int n) {
+    if (!s || n <= 0) return 0;
+    int count = s->count;
+    int rc = 0;
+    while (n > 0) {
+        int idx = count / REC_SEG_SAMPLES;
+        int off = count % REC_SEG_SAMPLES;
+        if (idx >= s->n_segs && add_segment(s) != 0) {
+            rc = -1;
+            break;
+        }
+        int take = REC_SEG_SAMPLES - off;
+        if (take > n) take = n;
+        /* Only the unpublished tail of the segment is written */
+        memcpy(seg_at(s, idx)->block->samples + off, pcm, take * sizeof(int16_t));
+        count += take;
+        pcm += take;
+        n -= take;
+    }
+    /* Full barrier: segment writes are visible before the new count */
+    InterlockedExchange(&s->count, count);
+    return rc;
+}
+
+/* ---- Readers ---- */
+
+int rec_store_count(const rec_store_t *s) {
+    return s ? (int)s->count : 0;
+}
+
+static int clamp_range(const rec_store_t *s, int start, int n) {
+    int count = (int)s->count;
+    if (start < 0 || start >= count || n <= 0) return 0;
+    return n < count - start ? n : count - start;
+}
+
+int rec_store_view(rec_store_t *s, int start, int n, audio_view_t *out) {
+    if (!s || !out) return 0;
+    n = clamp_range(s, start, n);
+    AcquireSRWLockShared(&s->lock);
+    int done = 0;
+    while (done < n) {
+        int pos = start + done;
+        int off = pos % REC_SEG_SAMPLES;
+        int take = REC_SEG_SAMPLES - off;
+        if (take > n - done) take = n - done;
+        if (audio_view_append(out, seg_at(s, pos / REC_SEG_SAMPLES)->block,
+                              off, take) != 0)
+            break;
+        done += take;
+    }
+    ReleaseSRWLockShared(&s->lock);
+    if (done < n) {
+        audio_view_release(out);
+        return 0;
+    }
+    return n;
+}
+
+int rec_store_read_s16(rec_store_t *s, int start, int n, int16_t *dst) {
+    audio_view_t v = {0};
+    if (!dst || rec_store_view(s, start, n, &v) == 0) return 0;
+    int got = audio_view_read_s16(&v, 0, v.n_samples, dst);
+    audio_view_release(&v);
+    return got;
+}
+
+int rec_store_read_f32(rec_store_t *s, int start, int n, float *dst) {
+    audio_view_t v = {0};
+    if (!dst || rec_store_view(s, start, n, &v) == 0) return 0;
+    int got = audio_view_read_f32(&v, 0, v.n_samples, dst);
+    audio_view_release(&v);
+    return got;
+}
+
+void rec_store_stats(const rec_store_t *s, int *resident, int *spilled) {
+    if (resident) *resident = s ? (int)s->resident : 0;
+    if (spilled) *spilled = s ? (int)s->spilled : 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * rec_store.h - Segmented int16 recording store
+ *
+ * Holds a recording as fixed-size int16 segments that grow up to ~36 h
+ * (sample positions are ints).
+ * Once resident segments exceed a memory budget, the oldest ones are spilled
+ * to a temporary file-backed mapping. Any sample range can be taken as a
+ * zero-copy view (segments are refcounted audio blocks) or copied out as
+ * int16 or float.
+ *
+ * One writer thread appends; other threads may read published samples.
+ */
+#ifndef REC_STORE_H
+#define REC_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_buf.h"
+
+#define REC_SEG_SAMPLES 16000   /* 1 s at 16 kHz */
+
+typedef struct rec_store rec_store_t;
+
+/* Create an empty store. mem_budget is the resident byte budget before
+ * segments spill to disk (0 = never spill). Returns NULL on failure. */
+rec_store_t *rec_store_create(size_t mem_budget);
+
+/* Free all segments and the spill file. */
+void rec_store_destroy(rec_store_t *s);
+
+/* Drop all samples. Must not race with append or reads. */
+void rec_store_reset(rec_store_t *s);
+
+/* Append int16 samples (writer thread only).
+ * Returns 0 on success, -1 if a segment could not be allocated or the store
+ * is full; samples before the failure are kept. */
+int rec_store_append(rec_store_t *s, const int16_t *pcm, int n);
+
+/* Number of samples readers may access. */
+int rec_store_count(const rec_store_t *s);
+
+/* Append references to [start, start+n) onto out (clamped to the published
+ * count). The view stays valid across later appends, spills and resets.
+ * Returns samples covered (0 on failure, with out released). */
+int rec_store_view(rec_store_t *s, int start, int n, audio_view_t *out);
+
+/* Copy [start, start+n) into dst. Range is clamped to the published count.
+ * Returns number of samples copied. */
+int rec_store_read_s16(rec_store_t *s, int start, int n, int16_t *dst);
+int rec_store_read_f32(rec_store_t *s, int start, int n, float *dst);
+
+/* Resident / spilled segment counts (for diagnostics). */
+void rec_store_stats(const rec_store_t *s, int *resident, int *spilled);
+
+#endif /* REC_STORE_H */
@@ -0,0 +1,421 @@
+/*
+ * session_log.c - Append-only session archive
+ *
+ * Layout (little-endian):
+ *   header   "VSES", u32 version, u32 sample rate, u32 reserved,
+ *            u64 start time (Unix epoch ms)
+ *   record   u32 type, u32 payload bytes, u64 t_ms, payload padded to 8
+ *   index    per record: u32 type, u32 payload bytes, u64 file offset
+ *   trailer  u64 index offset, u64 record count, "VSESIDX\0"
+ *
+ * Payloads:
+ *   AUDIO    i64 first sample, i16 samples[]
+ *   PASS     i64 window start, i32 window samples, i32 is_final, i32 pass,
+ *            i32 ts count, f64 total/audio/encode/decode/client ms,
+ *            i32 prompt bytes, i32 text bytes, (i32 byte, i32 ms)[ts count],
+ *            prompt + NUL, text + NUL
+ *   COMMIT   i64 from, i64 to, i32 text bytes, i32 pad, text + NUL
+ *   EVENT    tag + NUL, detail + NUL
+ *
+ * The writer is single-threaded and buffered through stdio; pass, commit
+ * and event records flush so a crash loses at most recent audio.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "session_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define SESS_MAGIC        "VSES"
+#define SESS_IDX_MAGIC    "VSESIDX"
+#define SESS_VERSION      1
+#define SESS_HEADER_BYTES 24
+#define SESS_REC_BYTES    16
+#define SESS_TRAILER_BYTES 24
+#define SESS_PASS_FIXED   72
+
+typedef struct {
+    uint32_t type;
+    uint32_t len;
+    uint64_t offset;
+} sess_idx_t;
+
+static uint32_t pad8(uint32_t n) { return (n + 7) & ~7u; }
+
+/* ---- Writer ---- */
+
+struct sess_writer {
+    FILE *f;
+    int failed;
+    long long offset;
+    ULONGLONG start_tick;
+    sess_idx_t *index;
+    int n_index, cap_index;
+};
+
+static long long now_unix_ms(void) {
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    ULONGLONG t = ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return (long long)(t / 10000ULL) - 11644473600000LL;
+}
+
+static void put(sess_writer_t *w, const void *p, size_t n) {
+    if (w->failed || n == 0) return;
+    if (fwrite(p, 1, n, w->f) != n) w->failed = 1;
+    w->offset += (long long)n;
+}
+
+/* Start a record; the caller then puts exactly len payload bytes and
+ * calls end_record */
+static void begin_record(sess_writer_t *w, uint32_t type, uint32_t len) {
+    if (w->n_index == w->cap_index) {
+        int cap = w->cap_index ? w->cap_index * 2 : 256;
+        sess_idx_t *ni = (sess_idx_t *)realloc(w->index, cap * sizeof(sess_idx_t));
+        if (!ni) {
+            w->failed = 1;
+            return;
+        }
+        w->index = ni;
+        w->cap_index = cap;
+    }
+    sess_idx_t *e = &w->index[w->n_index++];
+    e->type = type;
+    e->len = len;
+    e->offset = (uint64_t)w->offset;
+
+    unsigned char h[SESS_REC_BYTES];
+    *(uint32_t *)h = type;
+    *(uint32_t *)(h + 4) = len;
+    *(uint64_t *)(h + 8) = (uint64_t)(GetTickCount64() - w->start_tick);
+    put(w, h, sizeof(h));
+}
+
+static int end_record(sess_writer_t *w, uint32_t len, int flush) {
+    static const unsigned char zeros[8] = {0};
+    put(w, zeros, pad8(len) - len);
+    if (flush && !w->failed && fflush(w->f) != 0) w->failed = 1;
+    return w->failed ? -1 : 0;
+}
+
+sess_writer_t *sess_writer_open(const char *path, int sample_rate) {
+    sess_writer_t *w = (sess_writer_t *)calloc(1, sizeof(sess_writer_t));
+    if (!w) return NULL;
+    w->f = fopen(path, "wb");
+    if (!w->f) {
+        free(w);
+        return NULL;
+    }
+    setvbuf(w->f, NULL, _IOFBF, 1 << 16);
+    w->start_tick = GetTickCount64();
+
+    unsigned char h[SESS_HEADER_BYTES] = {0};
+    memcpy(h, SESS_MAGIC, 4);
+    *(uint32_t *)(h + 4) = SESS_VERSION;
+    *(uint32_t *)(h + 8) = (uint32_t)sample_rate;
+    *(int64_t *)(h + 16) = now_unix_ms();
+    put(w, h, sizeof(h));
+    if (w->failed || fflush(w->f) != 0) {
+        fclose(w->f);
+        free(w);
+        return NULL;
+    }
+    return w;
+}
+
+int sess_write_audio(sess_writer_t *w, long long first_sample,
+                     const int16_t *pcm, int n) {
+    if (!w) return -1;
+    if (n <= 0) return w->failed ? -1 : 0;
+    uint32_t len = 8 + (uint32_t)n * sizeof(int16_t);
+    int64_t first = first_sample;
+    begin_record(w, SESS_REC_AUDIO, len);
+    put(w, &first, 8);
+    put(w, pcm, (size_t)n * sizeof(int16_t));
+    return end_record(w, len, 0);
+}
+
+int sess_write_pass(sess_writer_t *w, const sess_pass_t *pass,
+                    const AsrResult *result) {
+    if (!w || !pass) return -1;
+    const char *prompt = pass->prompt ? pass->prompt : "";
+    const char *text = result && result->text ? result->text : "";
+    int32_t ts_count = result && result->timestamps ? result->ts_count : 0;
+    int32_t prompt_len = (int32_t)strlen(prompt);
+    int32_t text_len = (int32_t)strlen(text);
+    uint32_t len = SESS_PASS_FIXED + (uint32_t)ts_count * 8
+                 + (uint32_t)prompt_len + 1 + (uint32_t)text_len + 1;
+
+    unsigned char fixed[SESS_PASS_FIXED];
+    *(int64_t *)fixed = pass->window_start;
+    *(int32_t *)(fixed + 8) = pass->window_samples;
+    *(int32_t *)(fixed + 12) = pass->is_final;
+    *(int32_t *)(fixed + 16) = pass->pass_no;
+    *(int32_t *)(fixed + 20) = ts_count;
+    *(double *)(fixed + 24) = result ? result->perf_total_ms : 0.0;
+    *(double *)(fixed + 32) = result ? result->perf_audio_ms : 0.0;
+    *(double *)(fixed + 40) = result ? result->perf_encode_ms : 0.0;
+    *(double *)(fixed + 48) = result ? result->perf_decode_ms : 0.0;
+    *(double *)(fixed + 56) = pass->client_ms;
+    *(int32_t *)(fixed + 64) = prompt_len;
+    *(int32_t *)(fixed + 68) = text_len;
+
+    begin_record(w, SESS_REC_PASS, len);
+    put(w, fixed, sizeof(fixed));
+    for (int i = 0; i < ts_count; i++) {
+        int32_t ts[2] = { result->timestamps[i].byte_offset,
+                          result->timestamps[i].audio_ms };
+        put(w, ts, sizeof(ts));
+    }
+    put(w, prompt, (size_t)prompt_len + 1);
+    put(w, text, (size_t)text_len + 1);
+    return end_record(w, len, 1);
+}
+
+int sess_write_commit(sess_writer_t *w, long long from_sample,
+                      long long to_sample, const char *text) {
+    if (!w) return -1;
+    if (!text) text = "";
+    int32_t text_len = (int32_t)strlen(text);
+    uint32_t len = 24 + (uint32_t)text_len + 1;
+    unsigned char fixed[24] = {0};
+    *(int64_t *)fixed = from_sample;
+    *(int64_t *)(fixed + 8) = to_sample;
+    *(int32_t *)(fixed + 16) = text_len;
+
+    begin_record(w, SESS_REC_COMMIT, len);
+    put(w, fixed, sizeof(fixed));
+    put(w, text, (size_t)text_len + 1);
+    return end_record(w, len, 1);
+}
+
+int sess_write_event(sess_writer_t *w, const char *tag, const char *detail) {
+    if (!w) return -1;
+    if (!tag) tag = "";
+    if (!detail) detail = "";
+    size_t tag_len = strlen(tag), detail_len = strlen(detail);
+    uint32_t len = (uint32_t)(tag_len + 1 + detail_len + 1);
+
+    begin_record(w, SESS_REC_EVENT, len);
+    put(w, tag, tag_len + 1);
+    put(w, detail, detail_len + 1);
+    return end_record(w, len, 1);
+}
+
+int sess_writer_close(sess_writer_t *w) {
+    if (!w) return -1;
+    uint64_t index_offset = (uint64_t)w->offset;
+    put(w, w->index, (size_t)w->n_index * sizeof(sess_idx_t));
+    unsigned char t[SESS_TRAILER_BYTES] = {0};
+    *(uint64_t *)t = index_offset;
+    *(uint64_t *)(t + 8) = (uint64_t)w->n_index;
+    memcpy(t + 16, SESS_IDX_MAGIC, sizeof(SESS_IDX_MAGIC));
+    put(w, t, sizeof(t));
+    if (fclose(w->f) != 0) w->failed = 1;
+    int rc = w->failed ? -1 : 0;
+    free(w->index);
+    free(w);
+    return rc;
+}
+
+/* ---- Reader ---- */
+
+struct sess_reader {
+    HANDLE file, map;
+    const unsigned char *base;
+    uint64_t size;
+    sess_idx_t *index;      /* built by scanning when the footer is missing */
+    const sess_idx_t *idx;
+    int count;
+};
+
+/* Walk records from the header; stops at the first torn record */
+static int scan_records(sess_reader_t *r) {
+    int cap = 0;
+    uint64_t pos = SESS_HEADER_BYTES;
+    while (pos + SESS_REC_BYTES <= r->size) {
+        uint32_t type = *(const uint32_t *)(r->base + pos);
+        uint32_t len = *(const uint32_t *)(r->base + pos + 4);
+        if (type < SESS_REC_AUDIO || type > SESS_REC_EVENT
+            || pad8(len) > r->size - pos - SESS_REC_BYTES)
+            break;
+        if (r->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            sess_idx_t *ni = (sess_idx_t *)realloc(r->index, cap * sizeof(sess_idx_t));
+            if (!ni) return -1;
+            r->index = ni;
+        }
+        r->index[r->count].type = type;
+        r->index[r->count].len = len;
+        r->index[r->count].offset = pos;
+        r->count++;
+        pos += SESS_REC_BYTES + pad8(len);
+    }
+    r->idx = r->index;
+    return 0;
+}
+
+sess_reader_t *sess_reader_open(const char *path) {
+    sess_reader_t *r = (sess_reader_t *)calloc(1, sizeof(sess_reader_t));
+    if (!r) return NULL;
+    r->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                          NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    if (r->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(r->file, &size)
+        || size.QuadPart < SESS_HEADER_BYTES)
+        goto fail;
+    r->size = (uint64_t)size.QuadPart;
+    r->map = CreateFileMappingA(r->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!r->map) goto fail;
+    r->base = (const unsigned char *)MapViewOfFile(r->map, FILE_MAP_READ, 0, 0, 0);
+    if (!r->base || memcmp(r->base, SESS_MAGIC, 4) != 0) goto fail;
+
+    /* Use the footer index when it is intact */
+    if (r->size >= SESS_HEADER_BYTES + SESS_TRAILER_BYTES) {
+        const unsigned char *t = r->base + r->size - SESS_TRAILER_BYTES;
+        uint64_t off = *(const uint64_t *)t;
+        uint64_t count = *(const uint64_t *)(t + 8);
+        if (memcmp(t + 16, SESS_IDX_MAGIC, sizeof(SESS_IDX_MAGIC)) == 0
+            && off >= SESS_HEADER_BYTES && count < 0x7FFFFFFF
+            && off + count * sizeof(sess_idx_t) == r->size - SESS_TRAILER_BYTES) {
+            r->idx = (const sess_idx_t *)(r->base + off);
+            r->count = (int)count;
+            return r;
+        }
+    }
+    if (scan_records(r) == 0) return r;
+
+fail:
+    sess_reader_close(r);
+    return NULL;
+}
+
+void sess_reader_close(sess_reader_t *r) {
+    if (!r) return;
+    if (r->base) UnmapViewOfFile(r->base);
+    if (r->map) CloseHandle(r->map);
+    if (r->file && r->file != INVALID_HANDLE_VALUE) CloseHandle(r->file);
+    free(r->index);
+    free(r);
+}
+
+int sess_reader_count(const sess_reader_t *r) {
+    return r ? r->count : 0;
+}
+
+int sess_reader_sample_rate(const sess_reader_t *r) {
+    return r ? (int)*(const uint32_t *)(r->base + 8) : 0;
+}
+
+long long sess_reader_start_ms(const sess_reader_t *r) {
+    return r ? *(const int64_t *)(r->base + 16) : 0;
+}
+
+int sess_reader_get(const sess_reader_t *r, int i, sess_record_t *out) {
+    if (!r || i < 0 || i >= r->count) return -1;
+    const sess_idx_t *e = &r->idx[i];
+    if (e->offset + SESS_REC_BYTES + e->len > r->size) return -1;
+    const unsigned char *h = r->base + e->offset;
+    out->type = (int)e->type;
+    out->len = e->len;
+    out->t_ms = (long long)*(const uint64_t *)(h + 8);
+    out->data = h + SESS_REC_BYTES;
+    return 0;
+}
+
+int sess_parse_pass(const sess_record_t *rec, sess_pass_t *meta, AsrResult **result) {
+    if (!rec || rec->type != SESS_REC_PASS || rec->len < SESS_PASS_FIXED) return -1;
+    const unsigned char *d = rec->data;
+    int32_t ts_count = *(const int32_t *)(d + 20);
+    int32_t prompt_len = *(const int32_t *)(d + 64);
+    int32_t text_len = *(const int32_t *)(d + 68);
+    if (ts_count < 0 || prompt_len < 0 || text_len < 0
+        || (uint64_t)SESS_PASS_FIXED + (uint64_t)ts_count * 8
+           + (uint64_t)prompt_len + 1 + (uint64_t)text_len + 1 != rec->len)
+        return -1;
+    const unsigned char *ts = d + SESS_PASS_FIXED;
+    const char *prompt = (const char *)(ts + (size_t)ts_count * 8);
+    const char *text = prompt + prompt_len + 1;
+
+    if (meta) {
+        meta->window_start = *(const int64_t *)d;
+        meta->window_samples = *(const int32_t *)(d + 8);
+        meta->is_final = *(const int32_t *)(d + 12);
+        meta->pass_no = *(const int32_t *)(d + 16);
+        meta->client_ms = *(const double *)(d + 56);
+        meta->prompt = prompt;
+    }
+    if (!result) return 0;
+
+    AsrResult *res = (AsrResult *)calloc(1, sizeof(AsrResult));
+    if (!res) return -1;
+    res->text = (char *)malloc((size_t)text_len + 1);
+    if (ts_count > 0)
+        res->timestamps = malloc((size_t)ts_count * sizeof(*res->timestamps));
+    if (!res->text || (ts_count > 0 && !res->timestamps)) {
+        asr_free_result(res);
+        return -1;
+    }
+    memcpy(res->text, text, (size_t)text_len + 1);
+    for (int i = 0; i < ts_count; i++) {
+        res->timestamps[i].byte_offset = *(const int32_t *)(ts + i * 8);
+        res->timestamps[i].audio_ms = *(const int32_t *)(ts + i * 8 + 4);
+    }
+    res->ts_count = ts_count;
+    res->is_final = *(const int32_t *)(d + 12);
+    res->perf_total_ms = *(const double *)(d + 24);
+    res->perf_audio_ms = *(const double *)(d + 32);
+    res->perf_encode_ms = *(const double *)(d + 40);
+    res->perf_decode_ms = *(const double *)(d + 48);
+    *result = res;
+    return 0;
+}
+
+int sess_parse_commit(const sess_record_t *rec, long long *from_sample,
+                      long long *to_sample, const char **text) {
+    if (!rec || rec->type != SESS_REC_COMMIT || rec->len < 25) return -1;
+    int32_t text_len = *(const int32_t *)(rec->data + 16);
+    if (text_len < 0 || 24 + (uint32_t)text_len + 1 != rec->len) return -1;
+    if (from_sample) *from_sample = *(const int64_t *)rec->data;
+    if (to_sample) *to_sample = *(const int64_t *)(rec->data + 8);
+    if (text) *text = (const char *)(rec->data + 24);
+    return 0;
+}
+
+int sess_parse_event(const sess_record_t *rec, const char **tag, const char **detail) {
+    if (!rec || rec->type != SESS_REC_EVENT || rec->len < 2
+        || rec->data[rec->len - 1] != '\0')
+        return -1;
+    const char *t = (const char *)rec->data;
+    size_t tag_len = strnlen(t, rec->len);
+    if (tag_len + 1 >= rec->len) return -1;
+    if (tag) *tag = t;
+    if (detail) *detail = t + tag_len + 1;
+    return 0;
+}
+
+int16_t *sess_read_audio(const sess_reader_t *r, int *n_samples) {
+    long long total = 0;
+    sess_record_t rec;
+    for (int i = 0; i < sess_reader_count(r); i++) {
+        if (sess_reader_get(r, i, &rec) != 0 || rec.type != SESS_REC_AUDIO || rec.len < 8)
+            continue;
+        long long end = *(const int64_t *)rec.data + (rec.len - 8) / 2;
+        if (end > total) total = end;
+    }
+    if (total <= 0 || total > 0x7FFFFFFF) return NULL;
+
+    int16_t *pcm = (int16_t *)calloc((size_t)total, sizeof(int16_t));
+    if (!pcm) return NULL;
+    for (int i = 0; i < sess_reader_count(r); i++) {
+        if (sess_reader_get(r, i, &rec) != 0 || rec.type != SESS_REC_AUDIO || rec.len < 8)
+            continue;
+        long long first = *(const int64_t *)rec.data;
+        if (first < 0) continue;
+        memcpy(pcm + first, rec.data + 8, (size_t)(rec.len - 8) / 2 * sizeof(int16_t));
+    }
+    *n_samples = (int)total;
+    return pcm;
+}
@@ -0,0 +1,91 @@
+/*
+ * session_log.h - Append-only session archive
+ *
+ * One file per recording session holding the captured audio, every ASR pass
+ * (window, prompt, text, timestamps, perf), commit events and free-form
+ * events, each stamped with milliseconds since the session started. Records
+ * are appended as they happen; closing the writer adds a footer index so a
+ * reader can map the file and jump to any record. A file without an index
+ * (crash) is scanned record by record instead.
+ */
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include <stdint.h>
+
+#include "asr_client.h"
+
+typedef enum {
+    SESS_REC_AUDIO = 1,     /* int16 samples starting at a sample index */
+    SESS_REC_PASS,          /* one ASR request and its response */
+    SESS_REC_COMMIT,        /* text committed and the window advance */
+    SESS_REC_EVENT          /* tag + detail string */
+} sess_rec_type_t;
+
+/* Request side of a pass */
+typedef struct {
+    long long window_start;     /* first sample of the window */
+    int window_samples;
+    int is_final;
+    int pass_no;
+    double client_ms;           /* kick to result, as seen by the client */
+    const char *prompt;         /* may be NULL */
+} sess_pass_t;
+
+/* ---- Writer ---- */
+
+typedef struct sess_writer sess_writer_t;
+
+/* Create path and write the header. Returns NULL on failure. */
+sess_writer_t *sess_writer_open(const char *path, int sample_rate);
+
+/* Append records. Each returns 0, or -1 after a write error. */
+int sess_write_audio(sess_writer_t *w, long long first_sample,
+                     const int16_t *pcm, int n);
+int sess_write_pass(sess_writer_t *w, const sess_pass_t *pass,
+                    const AsrResult *result);
+int sess_write_commit(sess_writer_t *w, long long from_sample,
+                      long long to_sample, const char *text);
+int sess_write_event(sess_writer_t *w, const char *tag, const char *detail);
+
+/* Write the footer index and close. Frees w. Returns 0 or -1. */
+int sess_writer_close(sess_writer_t *w);
+
+/* ---- Reader ---- */
+
+typedef struct sess_reader sess_reader_t;
+
+typedef struct {
+    int type;                   /* sess_rec_type_t */
+    long long t_ms;             /* since session start */
+    const unsigned char *data;  /* payload inside the mapping */
+    uint32_t len;
+} sess_record_t;
+
+/* Map a session file. Returns NULL if it is not a session archive. */
+sess_reader_t *sess_reader_open(const char *path);
+void sess_reader_close(sess_reader_t *r);
+
+int sess_reader_count(const sess_reader_t *r);
+int sess_reader_sample_rate(const sess_reader_t *r);
+long long sess_reader_start_ms(const sess_reader_t *r);   /* Unix epoch ms */
+
+/* Record i in file order. Returns 0, or -1 if i is out of range. */
+int sess_reader_get(const sess_reader_t *r, int i, sess_record_t *out);
+
+/* Decode a SESS_REC_PASS record. meta->prompt points into the mapping.
+ * *result is heap-allocated (asr_free_result). Returns 0 or -1. */
+int sess_parse_pass(const sess_record_t *rec, sess_pass_t *meta, AsrResult **result);
+
+/* Decode a SESS_REC_COMMIT record; text points into the mapping. */
+int sess_parse_commit(const sess_record_t *rec, long long *from_sample,
+                      long long *to_sample, const char **text);
+
+/* Decode a SESS_REC_EVENT record; strings point into the mapping. */
+int sess_parse_event(const sess_record_t *rec, const char **tag, const char **detail);
+
+/* All audio records laid out by sample index (gaps are silent).
+ * Returns malloc'd samples (caller frees) or NULL if there is no audio. */
+int16_t *sess_read_audio(const sess_reader_t *r, int *n_samples);
+
+#endif /* SESSION_LOG_H */
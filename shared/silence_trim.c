@@ -0,0 +1,176 @@
+/*
+ * silence_trim.c - Pre-upload silence trimming with timestamp remapping
+ *
+ * Audio is classified in TRIM_FRAME_MS frames by RMS. Everything from
+ * guard_ms before the first speech frame to guard_ms after the last one is
+ * kept. A pause between speech runs longer than max_pause_ms keeps half of
+ * max_pause_ms on each side and drops the middle, so the model still sees a
+ * sentence break. Each kept range becomes one trim_seg_t.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "silence_trim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int frame_samples(int sample_rate) {
+    int f = sample_rate * TRIM_FRAME_MS / 1000;
+    return f > 0 ? f : 1;
+}
+
+static int add_seg(trim_map_t *map, int *cap, int src, int len) {
+    if (len <= 0) return 0;
+    if (map->n_segs == *cap) {
+        int nc = *cap ? *cap * 2 : 8;
+        trim_seg_t *ns = (trim_seg_t *)realloc(map->segs, nc * sizeof(trim_seg_t));
+        if (!ns) return -1;
+        map->segs = ns;
+        *cap = nc;
+    }
+    trim_seg_t *sg = &map->segs[map->n_segs++];
+    sg->src = src;
+    sg->dst = map->n_dst;
+    sg->len = len;
+    map->n_dst += len;
+    return 0;
+}
+
+/* Turn per-frame speech flags into kept segments */
+static int plan_from_frames(const unsigned char *speech, int n_frames, int n,
+                            int sample_rate, const trim_opts_t *o,
+                            trim_map_t *map) {
+    int fs = frame_samples(sample_rate);
+    int guard = (int)((long long)o->guard_ms * sample_rate / 1000);
+    int pause = (int)((long long)o->max_pause_ms * sample_rate / 1000);
+    int cap = 0;
+
+    memset(map, 0, sizeof(*map));
+    map->n_src = n;
+
+    int first = 0, last = n_frames - 1;
+    while (first < n_frames && !speech[first]) first++;
+    while (last > first && !speech[last]) last--;
+    if (first == n_frames)
+        return add_seg(map, &cap, 0, n);
+
+    int keep_from = first * fs - guard;
+    if (keep_from < 0) keep_from = 0;
+
+    int f = first;
+    while (f <= last) {
+        while (f <= last && speech[f]) f++;
+        if (f > last) break;
+        int gap_start = f;
+        while (!speech[f]) f++;             /* speech[last] stops this */
+        int gap = (f - gap_start) * fs;
+        if (pause > 0 && gap > pause) {
+            int cut_from = gap_start * fs + pause / 2;
+            if (add_seg(map, &cap, keep_from, cut_from - keep_from) != 0)
+                goto fail;
+            keep_from = f * fs - (pause - pause / 2);
+        }
+    }
+
+    int keep_to = (last + 1) * fs + guard;
+    if (keep_to > n) keep_to = n;
+    if (add_seg(map, &cap, keep_from, keep_to - keep_from) != 0)
+        goto fail;
+    return 0;
+
+fail:
+    trim_map_free(map);
+    return -1;
+}
+
+int trim_plan_view(const audio_view_t *v, int sample_rate,
+                   const trim_opts_t *o, trim_map_t *map) {
+    int n = v ? v->n_samples : 0;
+    int fs = frame_samples(sample_rate);
+    int n_frames = (n + fs - 1) / fs;
+    unsigned char *speech = (unsigned char *)malloc(n_frames > 0 ? n_frames : 1);
+    if (!speech) return -1;
+
+    /* Compare sum of squares against threshold^2 in int16 scale */
+    double thr = (double)o->threshold * 32768.0;
+    thr *= thr;
+    long long acc = 0;
+    int in_frame = 0, frame = 0;
+    for (int si = 0; si < (v ? v->n_spans : 0); si++) {
+        const int16_t *p = v->spans[si].block->samples + v->spans[si].offset;
+        for (int i = 0; i < v->spans[si].length; i++) {
+            acc += (long long)p[i] * p[i];
+            if (++in_frame == fs) {
+                speech[frame++] = (double)acc >= thr * fs;
+                acc = 0;
+                in_frame = 0;
+            }
+        }
+    }
+    if (in_frame > 0)
+        speech[frame++] = (double)acc >= thr * in_frame;
+
+    int rc = plan_from_frames(speech, n_frames, n, sample_rate, o, map);
+    free(speech);
+    return rc;
+}
+
+int trim_plan_f32(const float *pcm, int n, int sample_rate,
+                  const trim_opts_t *o, trim_map_t *map) {
+    int fs = frame_samples(sample_rate);
+    int n_frames = (n + fs - 1) / fs;
+    unsigned char *speech = (unsigned char *)malloc(n_frames > 0 ? n_frames : 1);
+    if (!speech) return -1;
+
+    double thr = (double)o->threshold * o->threshold;
+    for (int f = 0; f < n_frames; f++) {
+        int a = f * fs;
+        int b = a + fs < n ? a + fs : n;
+        double acc = 0.0;
+        for (int i = a; i < b; i++)
+            acc += (double)pcm[i] * pcm[i];
+        speech[f] = acc >= thr * (b - a);
+    }
+
+    int rc = plan_from_frames(speech, n_frames, n, sample_rate, o, map);
+    free(speech);
+    return rc;
+}
+
+int trim_apply_view(const audio_view_t *src, const trim_map_t *map,
+                    audio_view_t *out) {
+    for (int i = 0; i < map->n_segs; i++) {
+        if (audio_view_slice(src, map->segs[i].src, map->segs[i].len, out) == 0)
+            return 0;
+    }
+    return out->n_samples;
+}
+
+void trim_apply_f32(const float *src, const trim_map_t *map, float *out) {
+    for (int i = 0; i < map->n_segs; i++)
+        memcpy(out + map->segs[i].dst, src + map->segs[i].src,
+               map->segs[i].len * sizeof(float));
+}
+
+int trim_map_src(const trim_map_t *map, int dst) {
+    if (!map || map->n_segs == 0) return dst;
+    if (dst < 0) dst = 0;
+    /* Last segment starting at or before dst */
+    int lo = 0, hi = map->n_segs - 1;
+    while (lo < hi) {
+        int mid = (lo + hi + 1) / 2;
+        if (map->segs[mid].dst <= dst) lo = mid;
+        else hi = mid - 1;
+    }
+    return map->segs[lo].src + (dst - map->segs[lo].dst);
+}
+
+int trim_map_ms(const trim_map_t *map, int ms, int sample_rate) {
+    int dst = (int)((long long)ms * sample_rate / 1000);
+    return (int)((long long)trim_map_src(map, dst) * 1000 / sample_rate);
+}
+
+void trim_map_free(trim_map_t *map) {
+    if (!map) return;
+    free(map->segs);
+    memset(map, 0, sizeof(*map));
+}
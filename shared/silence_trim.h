@@ -0,0 +1,57 @@
+/*
+ * silence_trim.h - Pre-upload silence trimming with timestamp remapping
+ *
+ * Cuts silent head and tail audio beyond a guard, and optionally shortens
+ * long internal pauses, so the server encodes less audio per pass. The plan
+ * is recorded as a segment map, which turns positions in the trimmed audio
+ * (e.g. returned audio_ms timestamps) back into original positions.
+ */
+#ifndef SILENCE_TRIM_H
+#define SILENCE_TRIM_H
+
+#include "audio_buf.h"
+
+#define TRIM_FRAME_MS 20
+
+typedef struct {
+    float threshold;    /* frame RMS (full scale 1.0) that counts as speech */
+    int guard_ms;       /* silence kept before the first and after the last speech */
+    int max_pause_ms;   /* internal pauses longer than this are cut to it; 0 = keep */
+} trim_opts_t;
+
+typedef struct {
+    int src;            /* first sample in the original audio */
+    int dst;            /* first sample in the trimmed audio */
+    int len;
+} trim_seg_t;
+
+typedef struct {
+    trim_seg_t *segs;
+    int n_segs;
+    int n_src;          /* original length */
+    int n_dst;          /* trimmed length */
+} trim_map_t;
+
+/* Plan which samples to keep. If no frame reaches the threshold the map
+ * keeps everything. Returns 0, or -1 on allocation failure. Free the map
+ * with trim_map_free. */
+int trim_plan_view(const audio_view_t *v, int sample_rate,
+                   const trim_opts_t *o, trim_map_t *map);
+int trim_plan_f32(const float *pcm, int n, int sample_rate,
+                  const trim_opts_t *o, trim_map_t *map);
+
+/* Build the trimmed audio. The view variant appends zero-copy spans to out
+ * (which must be empty) and returns samples covered. The float variant
+ * writes map->n_dst samples to out. */
+int trim_apply_view(const audio_view_t *src, const trim_map_t *map,
+                    audio_view_t *out);
+void trim_apply_f32(const float *src, const trim_map_t *map, float *out);
+
+/* Map a trimmed-audio position back to the original audio. Positions past
+ * the end extend linearly from the last kept segment. */
+int trim_map_src(const trim_map_t *map, int dst);
+int trim_map_ms(const trim_map_t *map, int ms, int sample_rate);
+
+void trim_map_free(trim_map_t *map);
+
+#endif /* SILENCE_TRIM_H */
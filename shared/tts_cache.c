@@ -0,0 +1,267 @@
+/*
+ * tts_cache.c - Memory-bounded LRU cache of synthesized speech
+ *
+ * Chained hash table over a doubly linked recency list (front = most
+ * recent). The text is kept as a 64-bit hash, the voice name verbatim
+ * (any length, so lookups never match a truncated name).
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "tts_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define TTS_CACHE_BUCKETS  256      /* power of two */
+
+typedef struct tts_entry {
+    uint64_t text_hash;
+    char *voice;
+    int seed;
+    uint64_t key_hash;
+    tts_clip_t *clip;
+    size_t bytes;
+    struct tts_entry *chain;        /* next in bucket */
+    struct tts_entry *prev, *next;  /* recency list */
+} tts_entry_t;
+
+struct tts_cache {
+    CRITICAL_SECTION lock;
+    size_t max_bytes;
+    size_t bytes;
+    int entries;
+    tts_entry_t *buckets[TTS_CACHE_BUCKETS];
+    tts_entry_t *head, *tail;
+    long long hits, misses, evictions;
+};
+
+/* ---- Clips ---- */
+
+tts_clip_t *tts_clip_new(audio_block_t *pcm, int sample_rate,
+                         const tts_word_t *words, int word_count, int seed) {
+    tts_clip_t *c = (tts_clip_t *)calloc(1, sizeof(tts_clip_t));
+    if (!c) { audio_block_release(pcm); return NULL; }
+    if (words && word_count > 0) {
+        c->words = (tts_word_t *)malloc((size_t)word_count * sizeof(tts_word_t));
+        if (!c->words) { free(c); audio_block_release(pcm); return NULL; }
+        memcpy(c->words, words, (size_t)word_count * sizeof(tts_word_t));
+        c->word_count = word_count;
+    }
+    c->refs = 1;
+    c->pcm = pcm;
+    c->sample_rate = sample_rate;
+    c->seed = seed;
+    return c;
+}
+
+void tts_clip_retain(tts_clip_t *c) {
+    if (c) InterlockedIncrement((volatile LONG *)&c->refs);
+}
+
+void tts_clip_release(tts_clip_t *c) {
+    if (!c) return;
+    if (InterlockedDecrement((volatile LONG *)&c->refs) != 0) return;
+    audio_block_release(c->pcm);
+    audio_block_release(c->source);
+    free(c->words);
+    free(c);
+}
+
+size_t tts_clip_bytes(const tts_clip_t *c) {
+    return sizeof(tts_clip_t)
+         + (c->pcm ? (size_t)c->pcm->n_samples * sizeof(int16_t) : 0)
+         + (c->source ? (size_t)c->source->n_samples * sizeof(int16_t) : 0)
+         + (size_t)c->word_count * sizeof(tts_word_t);
+}
+
+/* ---- Keys ---- */
+
+uint64_t tts_text_hash(const char *text) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; *text; text++) {
+        h ^= (unsigned char)*text;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t key_hash(uint64_t text_hash, const char *voice, int seed) {
+    uint64_t h = text_hash ^ tts_text_hash(voice) * 0x9e3779b97f4a7c15ULL;
+    h ^= (uint64_t)(uint32_t)seed * 0xff51afd7ed558ccdULL;
+    return h ^ (h >> 29);
+}
+
+/* Caller holds the lock */
+static tts_entry_t *find(tts_cache_t *c, uint64_t kh, uint64_t th,
+                         const char *voice, int seed, tts_entry_t ***link) {
+    tts_entry_t **pp = &c->buckets[kh & (TTS_CACHE_BUCKETS - 1)];
+    for (; *pp; pp = &(*pp)->chain) {
+        tts_entry_t *e = *pp;
+        if (e->key_hash == kh && e->text_hash == th && e->seed == seed
+            && strcmp(e->voice, voice) == 0) {
+            if (link) *link = pp;
+            return e;
+        }
+    }
+    if (link) *link = pp;
+    return NULL;
+}
+
+static void list_unlink(tts_cache_t *c, tts_entry_t *e) {
+    if (e->prev) e->prev->next = e->next; else c->head = e->next;
+    if (e->next) e->next->prev = e->prev; else c->tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void list_push_front(tts_cache_t *c, tts_entry_t *e) {
+    e->prev = NULL;
+    e->next = c->head;
+    if (c->head) c->head->prev = e; else c->tail = e;
+    c->head = e;
+}
+
+/* Unlink e from its bucket and the list and push it onto *dead. Dead
+ * entries are freed after the lock is dropped: the last release of a
+ * clip frees megabytes. */
+static void drop(tts_cache_t *c, tts_entry_t *e, tts_entry_t **dead) {
+    tts_entry_t **pp = &c->buckets[e->key_hash & (TTS_CACHE_BUCKETS - 1)];
+    while (*pp != e) pp = &(*pp)->chain;
+    *pp = e->chain;
+    list_unlink(c, e);
+    c->bytes -= e->bytes;
+    c->entries--;
+    e->chain = *dead;
+    *dead = e;
+}
+
+static void free_dead(tts_entry_t *e) {
+    while (e) {
+        tts_entry_t *next = e->chain;
+        tts_clip_release(e->clip);
+        free(e->voice);
+        free(e);
+        e = next;
+    }
+}
+
+/* ---- Cache ---- */
+
+tts_cache_t *tts_cache_create(size_t max_bytes) {
+    tts_cache_t *c = (tts_cache_t *)calloc(1, sizeof(tts_cache_t));
+    if (!c) return NULL;
+    InitializeCriticalSection(&c->lock);
+    c->max_bytes = max_bytes ? max_bytes : TTS_CACHE_DEFAULT_BYTES;
+    return c;
+}
+
+void tts_cache_destroy(tts_cache_t *c) {
+    if (!c) return;
+    tts_cache_clear(c);
+    DeleteCriticalSection(&c->lock);
+    free(c);
+}
+
+tts_clip_t *tts_cache_get(tts_cache_t *c, const char *text, const char *voice, int seed) {
+    if (!c || !text || !voice) return NULL;
+    uint64_t th = tts_text_hash(text);
+    uint64_t kh = key_hash(th, voice, seed);
+    tts_clip_t *clip = NULL;
+    EnterCriticalSection(&c->lock);
+    tts_entry_t *e = find(c, kh, th, voice, seed, NULL);
+    if (e) {
+        if (c->head != e) {
+            list_unlink(c, e);
+            list_push_front(c, e);
+        }
+        clip = e->clip;
+        tts_clip_retain(clip);
+        c->hits++;
+    } else {
+        c->misses++;
+    }
+    LeaveCriticalSection(&c->lock);
+    return clip;
+}
+
+void tts_cache_put(tts_cache_t *c, const char *text, const char *voice, int seed,
+                   tts_clip_t *clip) {
+    if (!c || !text || !voice || !clip) return;
+    size_t voice_len = strlen(voice) + 1;
+    size_t bytes = tts_clip_bytes(clip) + sizeof(tts_entry_t) + voice_len;
+    if (bytes > c->max_bytes) return;
+
+    tts_entry_t *n = (tts_entry_t *)calloc(1, sizeof(tts_entry_t));
+    if (!n) return;
+    n->voice = (char *)malloc(voice_len);
+    if (!n->voice) {
+        free(n);
+        return;
+    }
+    memcpy(n->voice, voice, voice_len);
+    n->text_hash = tts_text_hash(text);
+    n->seed = seed;
+    n->key_hash = key_hash(n->text_hash, n->voice, seed);
+    n->clip = clip;
+    n->bytes = bytes;
+    tts_clip_retain(clip);
+
+    tts_entry_t *dead = NULL;
+    EnterCriticalSection(&c->lock);
+    tts_entry_t **link;
+    tts_entry_t *old = find(c, n->key_hash, n->text_hash, n->voice, seed, &link);
+    if (old) {
+        drop(c, old, &dead);
+        find(c, n->key_hash, n->text_hash, n->voice, seed, &link);
+    }
+    *link = n;
+    list_push_front(c, n);
+    c->bytes += bytes;
+    c->entries++;
+    while (c->bytes > c->max_bytes && c->tail != n) {
+        drop(c, c->tail, &dead);
+        c->evictions++;
+    }
+    LeaveCriticalSection(&c->lock);
+    free_dead(dead);
+}
+
+void tts_cache_remove(tts_cache_t *c, const char *text, const char *voice, int seed) {
+    if (!c || !text || !voice) return;
+    uint64_t th = tts_text_hash(text);
+    uint64_t kh = key_hash(th, voice, seed);
+    tts_entry_t *dead = NULL;
+    EnterCriticalSection(&c->lock);
+    tts_entry_t *e = find(c, kh, th, voice, seed, NULL);
+    if (e) drop(c, e, &dead);
+    LeaveCriticalSection(&c->lock);
+    free_dead(dead);
+}
+
+void tts_cache_clear(tts_cache_t *c) {
+    if (!c) return;
+    EnterCriticalSection(&c->lock);
+    tts_entry_t *e = c->head;
+    c->head = c->tail = NULL;
+    memset(c->buckets, 0, sizeof(c->buckets));
+    c->bytes = 0;
+    c->entries = 0;
+    LeaveCriticalSection(&c->lock);
+    while (e) {
+        tts_entry_t *next = e->next;
+        e->chain = NULL;
+        free_dead(e);
+        e = next;
+    }
+}
+
+void tts_cache_stats(tts_cache_t *c, tts_cache_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (!c) return;
+    EnterCriticalSection(&c->lock);
+    out->entries = c->entries;
+    out->bytes = c->bytes;
+    out->hits = c->hits;
+    out->misses = c->misses;
+    out->evictions = c->evictions;
+    LeaveCriticalSection(&c->lock);
+}
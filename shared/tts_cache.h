@@ -0,0 +1,82 @@
+/*
+ * tts_cache.h - Memory-bounded LRU cache of synthesized speech
+ *
+ * Entries are keyed by (text, voice, seed) and hold a clip: decoded PCM at
+ * the playback device rate plus the word timestamps that came with it, so
+ * a replay or word slice needs neither a server call nor a conversion.
+ * Clips are immutable and refcounted; a lookup only finds the entry, bumps
+ * it to the front and takes a reference, so the lock is held for a few
+ * pointer updates. The least recently used entries are evicted once the
+ * total exceeds the byte budget.
+ */
+#ifndef TTS_CACHE_H
+#define TTS_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_buf.h"
+
+#define TTS_CACHE_DEFAULT_BYTES  (64u * 1024 * 1024)
+
+/* Word timestamp from the server's alignment of the generated audio */
+typedef struct {
+    char word[64];      /* UTF-8 word text */
+    int  start_ms;
+    int  end_ms;
+} tts_word_t;
+
+typedef struct {
+    volatile long refs;
+    audio_block_t *pcm;         /* samples at sample_rate */
+    int sample_rate;
+    tts_word_t *words;          /* NULL if none */
+    int word_count;
+    int seed;                   /* seed the server reported, -1 if unknown */
+    audio_block_t *source;      /* server-rate samples of a take not yet on
+                                   disk, so it can be stored once its seed is
+                                   locked; NULL if pcm is already that */
+    int source_rate;
+} tts_clip_t;
+
+/* Make a clip with one reference. Takes over the caller's reference on
+ * pcm and copies words. Returns NULL on failure (pcm is then released).
+ * source starts NULL; set it before the clip is shared. */
+tts_clip_t *tts_clip_new(audio_block_t *pcm, int sample_rate,
+                         const tts_word_t *words, int word_count, int seed);
+void tts_clip_retain(tts_clip_t *c);
+void tts_clip_release(tts_clip_t *c);
+
+/* Bytes a clip is charged against the budget */
+size_t tts_clip_bytes(const tts_clip_t *c);
+
+typedef struct tts_cache tts_cache_t;
+
+typedef struct {
+    int entries;
+    size_t bytes;
+    long long hits;
+    long long misses;
+    long long evictions;
+} tts_cache_stats_t;
+
+tts_cache_t *tts_cache_create(size_t max_bytes);
+void tts_cache_destroy(tts_cache_t *c);
+
+/* Look up a clip. Returns it with a reference the caller releases, or NULL. */
+tts_clip_t *tts_cache_get(tts_cache_t *c, const char *text, const char *voice, int seed);
+
+/* Insert or replace the entry; the cache takes its own reference. A clip
+ * larger than the whole budget is not cached. */
+void tts_cache_put(tts_cache_t *c, const char *text, const char *voice, int seed,
+                   tts_clip_t *clip);
+
+void tts_cache_remove(tts_cache_t *c, const char *text, const char *voice, int seed);
+void tts_cache_clear(tts_cache_t *c);
+
+void tts_cache_stats(tts_cache_t *c, tts_cache_stats_t *out);
+
+/* 64-bit FNV-1a of a NUL-terminated string */
+uint64_t tts_text_hash(const char *text);
+
+#endif /* TTS_CACHE_H */
@@ -0,0 +1,271 @@
+/*
+ * tts_queue.c - Prioritized speech request queue
+ *
+ * A handful of requests are queued at a time, so they are kept in one array
+ * in push order and every take scans it; push order doubles as the tie
+ * break within a class. In-flight synthesis copies are kept in a second
+ * array so ttsq_in_synth still sees one after the player took (or an
+ * interrupt dropped) the queued request it came from.
+ */
+#include "tts_queue.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+struct ttsq {
+    CRITICAL_SECTION lock;
+    ttsq_item_t **items;        /* queued, push order */
+    int len, cap;
+    ttsq_item_t **synth;        /* in-flight copies */
+    int n_synth, synth_cap;
+    unsigned long next_id;
+    int player_busy;
+};
+
+/* ---- Items (caller holds the lock) ---- */
+
+static int same_request(const ttsq_item_t *it, const char *text, int voice, int seed) {
+    return it->voice == voice && it->seed == seed && strcmp(it->text, text) == 0;
+}
+
+static ttsq_item_t *item_new(const char *text, int voice, int seed, int tag, int cls) {
+    ttsq_item_t *it = (ttsq_item_t *)calloc(1, sizeof(ttsq_item_t));
+    if (!it) return NULL;
+    size_t len = strlen(text) + 1;
+    it->text = (char *)malloc(len);
+    if (!it->text) {
+        free(it);
+        return NULL;
+    }
+    memcpy(it->text, text, len);
+    it->voice = voice;
+    it->seed = seed;
+    it->tag = tag;
+    it->cls = cls;
+    return it;
+}
+
+static int grow(ttsq_item_t ***arr, int *cap, int need) {
+    if (need <= *cap) return 0;
+    int n = *cap ? *cap * 2 : 16;
+    while (n < need) n *= 2;
+    ttsq_item_t **p = (ttsq_item_t **)realloc(*arr, n * sizeof(ttsq_item_t *));
+    if (!p) return -1;
+    *arr = p;
+    *cap = n;
+    return 0;
+}
+
+/* 1 if a request equal to it is being synthesized */
+static int in_synth(const ttsq_t *q, const ttsq_item_t *it) {
+    for (int i = 0; i < q->n_synth; i++)
+        if (same_request(q->synth[i], it->text, it->voice, it->seed)) return 1;
+    return 0;
+}
+
+static void remove_at(ttsq_t *q, int i) {
+    memmove(q->items + i, q->items + i + 1, (q->len - i - 1) * sizeof(ttsq_item_t *));
+    q->len--;
+}
+
+/* Index of the next playback request, or -1. Push order breaks class ties,
+ * except that a request raised to playback was moved to the end. */
+static int best_play(const ttsq_t *q) {
+    int best = -1;
+    for (int i = 0; i < q->len; i++) {
+        if (q->items[i]->cls < TTSQ_PLAY) continue;
+        if (best < 0 || q->items[i]->cls > q->items[best]->cls) best = i;
+    }
+    return best;
+}
+
+/* ---- Queue ---- */
+
+ttsq_t *ttsq_create(void) {
+    ttsq_t *q = (ttsq_t *)calloc(1, sizeof(ttsq_t));
+    if (!q) return NULL;
+    InitializeCriticalSection(&q->lock);
+    return q;
+}
+
+void ttsq_destroy(ttsq_t *q) {
+    if (!q) return;
+    for (int i = 0; i < q->len; i++) ttsq_item_free(q->items[i]);
+    for (int i = 0; i < q->n_synth; i++) ttsq_item_free(q->synth[i]);
+    free(q->items);
+    free(q->synth);
+    DeleteCriticalSection(&q->lock);
+    free(q);
+}
+
+int ttsq_push(ttsq_t *q, const char *text, int voice, int seed, int tag, int cls) {
+    if (!q || !text) return -1;
+    if (cls < TTSQ_PREFETCH) cls = TTSQ_PREFETCH;
+    if (cls >= TTSQ_CLASSES) cls = TTSQ_CLASSES - 1;
+    int rc = 0;
+    int ready = 0;
+    EnterCriticalSection(&q->lock);
+    for (int i = 0; i < q->len; i++) {
+        ttsq_item_t *it = q->items[i];
+        if (!same_request(it, text, voice, seed)) continue;
+        if (it->cls >= TTSQ_PLAY) {
+            /* Made for playback anyway. A repeat plays again, so it gets
+             * an entry of its own, sharing this one's take. */
+            if (cls < TTSQ_PLAY) goto out;
+            ready |= it->state == TTSQ_READY;
+            continue;
+        }
+        if (it->tag < 0) it->tag = tag;
+        if (cls > it->cls) {
+            /* Newly wanted for playback: play it after what is queued now */
+            if (cls >= TTSQ_PLAY && i + 1 < q->len) {
+                remove_at(q, i);
+                q->items[q->len++] = it;
+            }
+            it->cls = cls;
+        }
+        goto out;
+    }
+    if (cls < TTSQ_PLAY) {
+        for (int i = 0; i < q->n_synth; i++)
+            if (same_request(q->synth[i], text, voice, seed)) goto out;
+    }
+    ttsq_item_t *it = NULL;
+    if (grow(&q->items, &q->cap, q->len + 1) != 0
+        || !(it = item_new(text, voice, seed, tag, cls))) {
+        rc = -1;
+        goto out;
+    }
+    it->id = ++q->next_id;
+    if (ready) it->state = TTSQ_READY;
+    q->items[q->len++] = it;
+out:
+    LeaveCriticalSection(&q->lock);
+    return rc;
+}
+
+int ttsq_drop_playback(ttsq_t *q) {
+    if (!q) return 0;
+    int n = 0;
+    EnterCriticalSection(&q->lock);
+    for (int i = 0; i < q->len; ) {
+        if (q->items[i]->cls >= TTSQ_PLAY) {
+            ttsq_item_free(q->items[i]);
+            remove_at(q, i);
+            n++;
+        } else {
+            i++;
+        }
+    }
+    LeaveCriticalSection(&q->lock);
+    return n;
+}
+
+int ttsq_drop_class(ttsq_t *q, int cls) {
+    if (!q) return 0;
+    int n = 0;
+    EnterCriticalSection(&q->lock);
+    for (int i = 0; i < q->len; ) {
+        if (q->items[i]->cls == cls && q->items[i]->state == TTSQ_WAITING) {
+            ttsq_item_free(q->items[i]);
+            remove_at(q, i);
+            n++;
+        } else {
+            i++;
+        }
+    }
+    LeaveCriticalSection(&q->lock);
+    return n;
+}
+
+ttsq_item_t *ttsq_take_play(ttsq_t *q) {
+    if (!q) return NULL;
+    EnterCriticalSection(&q->lock);
+    ttsq_item_t *it = NULL;
+    int i = best_play(q);
+    if (i >= 0) {
+        it = q->items[i];
+        remove_at(q, i);
+    }
+    q->player_busy = it != NULL;
+    LeaveCriticalSection(&q->lock);
+    return it;
+}
+
+ttsq_item_t *ttsq_take_synth(ttsq_t *q) {
+    if (!q) return NULL;
+    EnterCriticalSection(&q->lock);
+    int skip = q->player_busy ? -1 : best_play(q);
+    int best = -1;
+    for (int i = 0; i < q->len; i++) {
+        if (i == skip || q->items[i]->state != TTSQ_WAITING || in_synth(q, q->items[i]))
+            continue;
+        if (best < 0 || q->items[i]->cls > q->items[best]->cls) best = i;
+    }
+    ttsq_item_t *copy = NULL;
+    if (best >= 0 && grow(&q->synth, &q->synth_cap, q->n_synth + 1) == 0) {
+        ttsq_item_t *it = q->items[best];
+        copy = item_new(it->text, it->voice, it->seed, it->tag, it->cls);
+        if (copy) {
+            it->state = TTSQ_SYNTH;
+            copy->id = it->id;
+            copy->state = TTSQ_SYNTH;
+            q->synth[q->n_synth++] = copy;
+        }
+    }
+    LeaveCriticalSection(&q->lock);
+    return copy;
+}
+
+void ttsq_synth_done(ttsq_t *q, ttsq_item_t *it) {
+    if (!q || !it) return;
+    EnterCriticalSection(&q->lock);
+    for (int i = 0; i < q->n_synth; i++) {
+        if (q->synth[i] != it) continue;
+        q->synth[i] = q->synth[--q->n_synth];
+        break;
+    }
+    /* Repeats queued for playback share the take */
+    for (int i = 0; i < q->len; ) {
+        ttsq_item_t *queued = q->items[i];
+        if (queued->id == it->id && queued->cls < TTSQ_PLAY) {
+            ttsq_item_free(queued);
+            remove_at(q, i);
+            continue;
+        }
+        if (queued->id == it->id
+            || (queued->cls >= TTSQ_PLAY && queued->state == TTSQ_WAITING
+                && same_request(queued, it->text, it->voice, it->seed)))
+            queued->state = TTSQ_READY;
+        i++;
+    }
+    LeaveCriticalSection(&q->lock);
+    ttsq_item_free(it);
+}
+
+int ttsq_in_synth(ttsq_t *q, const char *text, int voice, int seed) {
+    if (!q || !text) return 0;
+    int found = 0;
+    EnterCriticalSection(&q->lock);
+    for (int i = 0; i < q->n_synth && !found; i++)
+        found = same_request(q->synth[i], text, voice, seed);
+    LeaveCriticalSection(&q->lock);
+    return found;
+}
+
+int ttsq_count(ttsq_t *q, int cls) {
+    if (!q) return 0;
+    int n = 0;
+    EnterCriticalSection(&q->lock);
+    for (int i = 0; i < q->len; i++)
+        if (q->items[i]->cls >= cls) n++;
+    LeaveCriticalSection(&q->lock);
+    return n;
+}
+
+void ttsq_item_free(ttsq_item_t *it) {
+    if (!it) return;
+    free(it->text);
+    free(it);
+}
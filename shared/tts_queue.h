@@ -0,0 +1,85 @@
+/*
+ * tts_queue.h - Prioritized speech request queue
+ *
+ * Requests are (text, voice, seed) plus a caller tag (e.g. a sentence
+ * index) and a class. Playback classes are played one after another by a
+ * single player, interactive before queued, each in push order; the lower
+ * classes are only synthesized ahead into a cache. A synthesizer takes the
+ * best waiting request of any class, playback first, so the item after the
+ * one playing is made while it plays; the player's own next item is left to
+ * it while the player is idle (it can stream that one).
+ *
+ * Only synthesis ahead coalesces. A prefetch or speculative request equal
+ * to one still queued (or being synthesized) is absorbed by it. A playback
+ * request always gets an entry of its own, so a repeated sentence plays
+ * again: it takes over an equal synthesis request (and any take in flight
+ * for it), and shares the take of an equal playback request instead of
+ * synthesizing it twice. Interrupting is explicit: ttsq_drop_playback
+ * removes every queued playback request and leaves synthesis alone. All
+ * calls are thread-safe.
+ */
+#ifndef TTS_QUEUE_H
+#define TTS_QUEUE_H
+
+/* Classes, lowest first */
+enum {
+    TTSQ_PREFETCH = 0,      /* synthesize when nothing better is waiting */
+    TTSQ_SPECULATIVE,       /* likely next, synthesize soon */
+    TTSQ_PLAY,              /* play after the playback queued before it */
+    TTSQ_INTERACTIVE,       /* play next (replay key) */
+    TTSQ_CLASSES
+};
+
+/* Request states */
+enum { TTSQ_WAITING = 0, TTSQ_SYNTH, TTSQ_READY };
+
+typedef struct {
+    unsigned long id;
+    char *text;
+    int voice;
+    int seed;
+    int tag;
+    int cls;
+    int state;              /* when it was taken */
+} ttsq_item_t;
+
+typedef struct ttsq ttsq_t;
+
+ttsq_t *ttsq_create(void);
+void ttsq_destroy(ttsq_t *q);
+
+/* Queue a request. A synthesis request equal to one queued or being
+ * synthesized is absorbed; a playback request is always queued (see
+ * above). Returns 0, or -1 if out of memory. */
+int ttsq_push(ttsq_t *q, const char *text, int voice, int seed, int tag, int cls);
+
+/* Remove every queued playback request. Returns the number removed. */
+int ttsq_drop_playback(ttsq_t *q);
+
+/* Remove the waiting (not yet started) requests of class cls */
+int ttsq_drop_class(ttsq_t *q, int cls);
+
+/* Player: take the next playback request (highest class, then oldest), or
+ * NULL. The player counts as busy from an item until a NULL. Free the item
+ * with ttsq_item_free. */
+ttsq_item_t *ttsq_take_play(ttsq_t *q);
+
+/* Synthesizer: take the best waiting request and mark it in flight, or
+ * NULL. Returns a copy; pass it to ttsq_synth_done when finished. */
+ttsq_item_t *ttsq_take_synth(ttsq_t *q);
+
+/* Finish an in-flight copy: a playback request, and any repeat of it queued
+ * for playback, becomes ready (the player finds it cached, or fetches it
+ * itself if synthesis failed); a synthesis request is removed. Frees the
+ * copy. */
+void ttsq_synth_done(ttsq_t *q, ttsq_item_t *it);
+
+/* 1 if a request equal to this one is being synthesized */
+int ttsq_in_synth(ttsq_t *q, const char *text, int voice, int seed);
+
+/* Requests of class cls or above still queued (any state) */
+int ttsq_count(ttsq_t *q, int cls);
+
+void ttsq_item_free(ttsq_item_t *it);
+
+#endif /* TTS_QUEUE_H */
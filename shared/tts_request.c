@@ -0,0 +1,74 @@
+/*
+ * tts_request.c - Speech endpoint request pieces shared by the clients
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "tts_request.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+const char *const tts_voices[TTS_NUM_VOICES] = {
+    "Vivian", "Serena", "Uncle_Fu", "Dylan", "Eric",
+    "Ryan", "Aiden", "Ono_Anna", "Sohee"
+};
+
+/* ---- Body ---- */
+
+static int put(char *body, int size, int *n, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int k = vsnprintf(body + *n, size - *n, fmt, ap);
+    va_end(ap);
+    if (k < 0 || k >= size - *n) return -1;
+    *n += k;
+    return 0;
+}
+
+/* s as the inside of a JSON string. UTF-8 passes through; quotes,
+ * backslashes and everything below 0x20 are escaped. */
+static int put_escaped(char *body, int size, int *n, const char *s) {
+    for (const unsigned char *c = (const unsigned char *)s; *c; c++) {
+        char esc[8];
+        switch (*c) {
+        case '"':  strcpy(esc, "\\\""); break;
+        case '\\': strcpy(esc, "\\\\"); break;
+        case '\n': strcpy(esc, "\\n"); break;
+        case '\r': strcpy(esc, "\\r"); break;
+        case '\t': strcpy(esc, "\\t"); break;
+        default:
+            if (*c < 0x20) {
+                snprintf(esc, sizeof(esc), "\\u%04x", *c);
+            } else {
+                esc[0] = (char)*c;
+                esc[1] = '\0';
+            }
+        }
+        int k = (int)strlen(esc);
+        if (k >= size - *n) return -1;
+        memcpy(body + *n, esc, k);
+        *n += k;
+    }
+    body[*n] = '\0';
+    return 0;
+}
+
+int tts_build_body(const char *text, const char *voice, int seed, int want_ts,
+                   int stream, char *body, int body_size) {
+    int n = 0;
+    if (body_size <= 0) return -1;
+    body[0] = '\0';
+    if (put(body, body_size, &n, "{\"input\":\"") != 0
+        || put_escaped(body, body_size, &n, text) != 0
+        || put(body, body_size, &n, "\",\"voice\":\"") != 0
+        || put_escaped(body, body_size, &n, voice) != 0
+        || put(body, body_size, &n, stream
+               ? "\",\"response_format\":\"pcm\",\"stream\":true,\"stream_format\":\"sse\""
+               : "\",\"response_format\":\"wav\"") != 0)
+        return -1;
+    if (want_ts && put(body, body_size, &n, ",\"timestamps\":true,\"language\":\"Chinese\"") != 0)
+        return -1;
+    if (seed >= 0 && put(body, body_size, &n, ",\"seed\":%d", seed) != 0)
+        return -1;
+    return put(body, body_size, &n, "}");
+}
@@ -0,0 +1,25 @@
+/*
+ * tts_request.h - Speech endpoint request pieces shared by the clients
+ *
+ * The server's voice presets (Qwen3-TTS), in the order the GUI cycles
+ * through them, and the /v1/audio/speech request body. Seed lists, the
+ * on-disk take store and the grouping index are keyed by these names and
+ * the takes they hold come from these requests, so the GUI and the harness
+ * must agree on both.
+ */
+#ifndef TTS_REQUEST_H
+#define TTS_REQUEST_H
+
+#define TTS_NUM_VOICES 9
+
+extern const char *const tts_voices[TTS_NUM_VOICES];
+
+/* JSON body for one take: a WAV response, or with stream SSE events
+ * carrying base64 PCM; want_ts adds word timestamps (the WAV then comes
+ * base64 inside a JSON object); seed < 0 leaves the seed to the server.
+ * Text and voice are escaped, control characters included. Returns 0, or
+ * -1 if the body does not fit in body_size. */
+int tts_build_body(const char *text, const char *voice, int seed, int want_ts,
+                   int stream, char *body, int body_size);
+
+#endif /* TTS_REQUEST_H */
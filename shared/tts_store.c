@@ -0,0 +1,318 @@
+/*
+ * tts_store.c - Persistent on-disk tier for synthesized speech
+ *
+ * Files are opened with FILE_SHARE_DELETE so trim or a replacing put can
+ * remove a file a reader still has mapped; the mapping stays valid until
+ * the clip's last reference goes.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "tts_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define TTSA_MAGIC         "TTSA"
+#define TTSA_VERSION       1
+#define TTSA_HEADER_BYTES  32
+#define TTSA_WORD_BYTES    72
+
+struct tts_store {
+    CRITICAL_SECTION lock;
+    char dir[MAX_PATH];
+    unsigned long long max_bytes;
+    long long total;                /* -1 until the first trim */
+    volatile LONG trimming;
+};
+
+typedef struct {
+    char name[24];
+    unsigned long long mtime;
+    unsigned long long size;
+} store_file_t;
+
+/* ---- Keys and paths ---- */
+
+/* text NUL voice NUL model NUL. Returns malloc'd key, *len without padding. */
+static char *build_key(const char *text, const char *voice, const char *model,
+                       uint32_t *len) {
+    size_t lt = strlen(text) + 1, lv = strlen(voice) + 1, lm = strlen(model) + 1;
+    char *k = (char *)malloc(lt + lv + lm);
+    if (!k) return NULL;
+    memcpy(k, text, lt);
+    memcpy(k + lt, voice, lv);
+    memcpy(k + lt + lv, model, lm);
+    *len = (uint32_t)(lt + lv + lm);
+    return k;
+}
+
+static void file_path(const tts_store_t *s, const char *key, uint32_t key_len,
+                      int seed, char *out, size_t out_size) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (uint32_t i = 0; i < key_len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 0x100000001b3ULL;
+    }
+    h ^= (uint64_t)(uint32_t)seed;
+    h *= 0x100000001b3ULL;
+    snprintf(out, out_size, "%s\\%016llx.tta", s->dir, (unsigned long long)h);
+}
+
+static uint32_t pad8(uint32_t n) { return (n + 7u) & ~7u; }
+
+/* ---- Open / close ---- */
+
+tts_store_t *tts_store_open(const char *dir, unsigned long long max_bytes) {
+    CreateDirectoryA(dir, NULL);
+    DWORD attr = GetFileAttributesA(dir);
+    if (attr == INVALID_FILE_ATTRIBUTES || !(attr & FILE_ATTRIBUTE_DIRECTORY))
+        return NULL;
+    tts_store_t *s = (tts_store_t *)calloc(1, sizeof(tts_store_t));
+    if (!s) return NULL;
+    InitializeCriticalSection(&s->lock);
+    strncpy(s->dir, dir, sizeof(s->dir) - 1);
+    s->max_bytes = max_bytes;
+    s->total = -1;
+    return s;
+}
+
+void tts_store_close(tts_store_t *s) {
+    if (!s) return;
+    DeleteCriticalSection(&s->lock);
+    free(s);
+}
+
+/* ---- Read ---- */
+
+static void unmap_block_destroy(audio_block_t *b) {
+    UnmapViewOfFile(b->ctx);
+}
+
+static void touch(const char *path) {
+    HANDLE f = CreateFileA(path, FILE_WRITE_ATTRIBUTES,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return;
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    SetFileTime(f, NULL, NULL, &now);
+    CloseHandle(f);
+}
+
+tts_clip_t *tts_store_get(tts_store_t *s, const char *text, const char *voice,
+                          int seed, const char *model) {
+    if (!s || !text || !voice || !model) return NULL;
+    uint32_t key_len;
+    char *key = build_key(text, voice, model, &key_len);
+    if (!key) return NULL;
+    char path[MAX_PATH];
+    file_path(s, key, key_len, seed, path, sizeof(path));
+
+    HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) { free(key); return NULL; }
+    LARGE_INTEGER size;
+    const unsigned char *base = NULL;
+    if (GetFileSizeEx(f, &size) && size.QuadPart >= TTSA_HEADER_BYTES
+        && size.QuadPart < 0x7fffffff) {
+        HANDLE map = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (map) {
+            base = (const unsigned char *)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(map);
+        }
+    }
+    CloseHandle(f);
+    if (!base) { free(key); return NULL; }
+
+    uint16_t version, header_bytes;
+    uint32_t sr, n_samples, n_words, stored_key_len;
+    int32_t stored_seed;
+    memcpy(&version, base + 4, 2);
+    memcpy(&header_bytes, base + 6, 2);
+    memcpy(&sr, base + 8, 4);
+    memcpy(&n_samples, base + 12, 4);
+    memcpy(&n_words, base + 16, 4);
+    memcpy(&stored_seed, base + 20, 4);
+    memcpy(&stored_key_len, base + 24, 4);
+
+    int damaged = memcmp(base, TTSA_MAGIC, 4) != 0 || version != TTSA_VERSION
+               || header_bytes != TTSA_HEADER_BYTES || n_samples == 0
+               || n_words > 4096 || stored_key_len > (1u << 20);
+    unsigned long long words_at = TTSA_HEADER_BYTES + (unsigned long long)pad8(stored_key_len);
+    unsigned long long pcm_at = words_at + (unsigned long long)n_words * TTSA_WORD_BYTES;
+    if (!damaged && pcm_at + (unsigned long long)n_samples * 2 != (unsigned long long)size.QuadPart)
+        damaged = 1;
+    if (damaged) {
+        UnmapViewOfFile(base);
+        free(key);
+        DeleteFileA(path);
+        return NULL;
+    }
+    /* Hash collision: a different take owns this name */
+    if (stored_seed != seed || stored_key_len != key_len
+        || memcmp(base + TTSA_HEADER_BYTES, key, key_len) != 0) {
+        UnmapViewOfFile(base);
+        free(key);
+        return NULL;
+    }
+    free(key);
+
+    tts_word_t *words = NULL;
+    if (n_words > 0) {
+        words = (tts_word_t *)calloc(n_words, sizeof(tts_word_t));
+        if (!words) { UnmapViewOfFile(base); return NULL; }
+        for (uint32_t i = 0; i < n_words; i++) {
+            const unsigned char *w = base + words_at + (unsigned long long)i * TTSA_WORD_BYTES;
+            memcpy(words[i].word, w, sizeof(words[i].word));
+            words[i].word[sizeof(words[i].word) - 1] = '\0';
+            int32_t v;
+            memcpy(&v, w + 64, 4); words[i].start_ms = v;
+            memcpy(&v, w + 68, 4); words[i].end_ms = v;
+        }
+    }
+
+    audio_block_t *pcm = audio_block_wrap((int16_t *)(base + pcm_at), (int)n_samples,
+                                          unmap_block_destroy, (void *)base);
+    if (!pcm) { UnmapViewOfFile(base); free(words); return NULL; }
+    tts_clip_t *clip = tts_clip_new(pcm, (int)sr, words, (int)n_words, seed);
+    free(words);
+    if (clip) touch(path);
+    return clip;
+}
+
+/* ---- Write ---- */
+
+int tts_store_put(tts_store_t *s, const char *text, const char *voice, int seed,
+                  const char *model, const int16_t *pcm, int n_samples,
+                  int sample_rate, const tts_word_t *words, int n_words) {
+    if (!s || !text || !voice || !model || !pcm || n_samples <= 0) return -1;
+    if (n_words < 0 || (n_words > 0 && !words)) n_words = 0;
+    uint32_t key_len;
+    char *key = build_key(text, voice, model, &key_len);
+    if (!key) return -1;
+    char path[MAX_PATH], tmp[MAX_PATH + 16];
+    file_path(s, key, key_len, seed, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%lu.tmp", path, (unsigned long)GetCurrentThreadId());
+
+    FILE *f = fopen(tmp, "wb");
+    if (!f) { free(key); return -1; }
+
+    unsigned char hdr[TTSA_HEADER_BYTES] = {0};
+    uint16_t version = TTSA_VERSION, header_bytes = TTSA_HEADER_BYTES;
+    uint32_t sr = (uint32_t)sample_rate, ns = (uint32_t)n_samples, nw = (uint32_t)n_words;
+    int32_t sd = seed;
+    memcpy(hdr, TTSA_MAGIC, 4);
+    memcpy(hdr + 4, &version, 2);
+    memcpy(hdr + 6, &header_bytes, 2);
+    memcpy(hdr + 8, &sr, 4);
+    memcpy(hdr + 12, &ns, 4);
+    memcpy(hdr + 16, &nw, 4);
+    memcpy(hdr + 20, &sd, 4);
+    memcpy(hdr + 24, &key_len, 4);
+
+    static const unsigned char zeros[8] = {0};
+    int ok = fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr)
+          && fwrite(key, 1, key_len, f) == key_len
+          && fwrite(zeros, 1, pad8(key_len) - key_len, f) == pad8(key_len) - key_len;
+    free(key);
+    for (int i = 0; ok && i < n_words; i++) {
+        unsigned char w[TTSA_WORD_BYTES] = {0};
+        strncpy((char *)w, words[i].word, 63);
+        int32_t v = words[i].start_ms;
+        memcpy(w + 64, &v, 4);
+        v = words[i].end_ms;
+        memcpy(w + 68, &v, 4);
+        ok = fwrite(w, 1, sizeof(w), f) == sizeof(w);
+    }
+    if (ok) ok = fwrite(pcm, sizeof(int16_t), (size_t)n_samples, f) == (size_t)n_samples;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || !MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFileA(tmp);
+        return -1;
+    }
+
+    long long bytes = TTSA_HEADER_BYTES + pad8(key_len)
+                    + (long long)n_words * TTSA_WORD_BYTES + (long long)n_samples * 2;
+    EnterCriticalSection(&s->lock);
+    if (s->total >= 0) s->total += bytes;
+    LeaveCriticalSection(&s->lock);
+    return 0;
+}
+
+/* ---- Size cap ---- */
+
+int tts_store_needs_trim(tts_store_t *s) {
+    if (!s) return 0;
+    EnterCriticalSection(&s->lock);
+    int need = s->total < 0 || (unsigned long long)s->total > s->max_bytes;
+    LeaveCriticalSection(&s->lock);
+    return need;
+}
+
+long long tts_store_bytes(tts_store_t *s) {
+    if (!s) return -1;
+    EnterCriticalSection(&s->lock);
+    long long total = s->total;
+    LeaveCriticalSection(&s->lock);
+    return total;
+}
+
+static int cmp_mtime(const void *a, const void *b) {
+    unsigned long long x = ((const store_file_t *)a)->mtime;
+    unsigned long long y = ((const store_file_t *)b)->mtime;
+    return (x > y) - (x < y);
+}
+
+int tts_store_trim(tts_store_t *s) {
+    if (!s || InterlockedCompareExchange(&s->trimming, 1, 0) != 0) return 0;
+
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s\\*.tta", s->dir);
+    store_file_t *files = NULL;
+    int n = 0, cap = 0;
+    unsigned long long total = 0;
+    WIN32_FIND_DATAA fd;
+    HANDLE find = FindFirstFileA(pattern, &fd);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            if (strlen(fd.cFileName) >= sizeof(files[0].name)) continue;
+            if (n == cap) {
+                int nc = cap ? cap * 2 : 256;
+                store_file_t *nf = (store_file_t *)realloc(files, nc * sizeof(store_file_t));
+                if (!nf) break;
+                files = nf;
+                cap = nc;
+            }
+            store_file_t *e = &files[n++];
+            strcpy(e->name, fd.cFileName);
+            e->mtime = ((unsigned long long)fd.ftLastWriteTime.dwHighDateTime << 32)
+                     | fd.ftLastWriteTime.dwLowDateTime;
+            e->size = ((unsigned long long)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+            total += e->size;
+        } while (FindNextFileA(find, &fd));
+        FindClose(find);
+    }
+
+    int deleted = 0;
+    unsigned long long low_water = s->max_bytes / 8 * 7;
+    if (total > s->max_bytes && n > 0) {
+        qsort(files, n, sizeof(store_file_t), cmp_mtime);
+        for (int i = 0; i < n && total > low_water; i++) {
+            char path[MAX_PATH];
+            snprintf(path, sizeof(path), "%s\\%s", s->dir, files[i].name);
+            if (DeleteFileA(path)) {
+                total -= files[i].size;
+                deleted++;
+            }
+        }
+    }
+    free(files);
+
+    EnterCriticalSection(&s->lock);
+    s->total = (long long)total;
+    LeaveCriticalSection(&s->lock);
+    InterlockedExchange(&s->trimming, 0);
+    return deleted;
+}
@@ -0,0 +1,62 @@
+/*
+ * tts_store.h - Persistent on-disk tier for synthesized speech
+ *
+ * One file per take, named by a hash of (text, voice, seed, model) and
+ * holding that key verbatim, the word timestamps and the PCM at the rate
+ * the server produced it. Reads map the file and hand out a clip whose
+ * samples point into the mapping. A hit refreshes the file's write time;
+ * tts_store_trim deletes the least recently used files once the directory
+ * is over its byte cap. Only takes with a known seed are worth storing:
+ * an unlocked voice never asks for the same audio twice.
+ *
+ * File layout (little-endian):
+ *   "TTSA" u16 version u16 header_bytes u32 sample_rate u32 n_samples
+ *   u32 n_words i32 seed u32 key_bytes u32 0
+ *   key: text NUL voice NUL model NUL, zero-padded to 8 bytes
+ *   n_words * { char word[64] i32 start_ms i32 end_ms }
+ *   n_samples * int16
+ *
+ * All calls are thread-safe.
+ */
+#ifndef TTS_STORE_H
+#define TTS_STORE_H
+
+#include <stdint.h>
+
+#include "tts_cache.h"
+
+/* The GUI's cap on tts_cache\audio; the harness's warm-up stays under it */
+#define TTS_STORE_BYTES (512ull * 1024 * 1024)
+
+typedef struct tts_store tts_store_t;
+
+/* Open (creating if needed) the store directory. max_bytes caps the total
+ * file size. Returns NULL on failure. */
+tts_store_t *tts_store_open(const char *dir, unsigned long long max_bytes);
+void tts_store_close(tts_store_t *s);
+
+/* Look up a take. Returns a clip at the stored rate, its samples mapped
+ * from the file, with a reference the caller releases; NULL on miss. A
+ * damaged file is deleted. */
+tts_clip_t *tts_store_get(tts_store_t *s, const char *text, const char *voice,
+                          int seed, const char *model);
+
+/* Write a take (replacing any previous one) via a temp file and rename.
+ * Returns 0, or -1 on failure. */
+int tts_store_put(tts_store_t *s, const char *text, const char *voice, int seed,
+                  const char *model, const int16_t *pcm, int n_samples,
+                  int sample_rate, const tts_word_t *words, int n_words);
+
+/* 1 if the store may be over its cap: its size is not known yet (no trim
+ * has run) or puts have pushed it past. */
+int tts_store_needs_trim(tts_store_t *s);
+
+/* Scan the directory and delete the least recently used files until the
+ * total is below 7/8 of the cap. Meant for a background thread; returns
+ * at once if another trim is running. Returns the number of files deleted. */
+int tts_store_trim(tts_store_t *s);
+
+/* Bytes on disk as of the last trim plus puts since (-1 if never scanned) */
+long long tts_store_bytes(tts_store_t *s);
+
+#endif /* TTS_STORE_H */
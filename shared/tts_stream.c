@@ -0,0 +1,387 @@
+/*
+ * tts_stream.c - Incremental parser for streamed speech responses
+ */
+#include "tts_stream.h"
+#include "base64.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TTS_STREAM_MAX_HEADER 4096
+#define TTS_STREAM_MAX_JSON   (1024 * 1024)   /* metadata only; audio is not kept */
+#define TTS_STREAM_B64_PIECE  4096
+
+enum { TS_DETECT = 0, TS_WAV, TS_SSE, TS_JSON };
+enum { JS_HEAD = 0, JS_AUDIO, JS_TAIL };   /* before, inside, after "audio" */
+enum { SF_NAME = 0, SF_DATA, SF_SKIP };    /* SSE line: field name, data, other */
+
+struct tts_stream {
+    tts_stream_pcm_fn on_pcm;
+    void *ctx;
+    int mode;
+    int stopped;
+    int got_audio;
+    int rate;
+    int wav_data;           /* past the WAV header */
+    char *buf;              /* WAV header so far */
+    int len, cap;
+    unsigned char odd;      /* PCM byte left over from the last piece */
+    int has_odd;
+    int json_part;          /* JS_*, for a JSON body or SSE event */
+    int json_scan;          /* where the search for "audio" resumes */
+    int sse_field;          /* SF_*, for the SSE line being read */
+    int sse_name;           /* bytes of "data:" matched so far */
+    b64_decoder_t b64;
+    char *json;             /* JSON body or SSE event less its audio, NUL-terminated */
+    int json_len, json_cap;
+    char *kept;             /* last SSE event with words or a seed */
+    int kept_len;
+};
+
+static int grow_append(char **buf, int *len, int *cap, const char *data, int n, int limit) {
+    if (*len + n > limit) return -1;
+    if (*len + n + 1 > *cap) {
+        int c = *cap ? *cap : 4096;
+        while (c < *len + n + 1) c *= 2;
+        char *p = (char *)realloc(*buf, c);
+        if (!p) return -1;
+        *buf = p;
+        *cap = c;
+    }
+    memcpy(*buf + *len, data, n);
+    *len += n;
+    (*buf)[*len] = '\0';
+    return 0;
+}
+
+static int buf_append(tts_stream_t *st, const char *data, int len, int limit) {
+    return grow_append(&st->buf, &st->len, &st->cap, data, len, limit);
+}
+
+static void keep_json(tts_stream_t *st, const char *json, int len) {
+    char *p = (char *)malloc(len + 1);
+    if (!p) return;
+    memcpy(p, json, len);
+    p[len] = '\0';
+    free(st->kept);
+    st->kept = p;
+    st->kept_len = len;
+}
+
+/* ---- PCM ---- */
+
+/* Hand little-endian s16 bytes to the callback, carrying an odd byte over.
+ * On the little-endian targets this builds for, aligned bytes with nothing
+ * carried are the samples already and go out in place; anything else (a
+ * WAV straight off the socket) is copied. */
+static int emit_pcm(tts_stream_t *st, const unsigned char *bytes, int n) {
+    if (!st->has_odd && ((uintptr_t)bytes & 1) == 0) {
+        int k = n / 2;
+        if (n & 1) {
+            st->odd = bytes[n - 1];
+            st->has_odd = 1;
+        }
+        if (k > 0 && !st->stopped) {
+            st->got_audio = 1;
+            if (st->on_pcm(st->ctx, (const int16_t *)bytes, k, st->rate)) st->stopped = 1;
+        }
+        return st->stopped ? 1 : 0;
+    }
+    int16_t tmp[2048];
+    while (n > 0 && !st->stopped) {
+        int k = 0;
+        if (st->has_odd) {
+            tmp[k++] = (int16_t)(st->odd | (bytes[0] << 8));
+            bytes++;
+            n--;
+            st->has_odd = 0;
+        }
+        while (k < (int)(sizeof(tmp) / sizeof(tmp[0])) && n >= 2) {
+            tmp[k++] = (int16_t)(bytes[0] | (bytes[1] << 8));
+            bytes += 2;
+            n -= 2;
+        }
+        if (n == 1) {
+            st->odd = bytes[0];
+            st->has_odd = 1;
+            n = 0;
+        }
+        if (k > 0) {
+            st->got_audio = 1;
+            if (st->on_pcm(st->ctx, tmp, k, st->rate)) st->stopped = 1;
+        }
+    }
+    return st->stopped ? 1 : 0;
+}
+
+/* ---- JSON helpers (flat fields only) ---- */
+
+static const char *find_key(const char *json, int len, const char *key) {
+    char pattern[64];
+    int plen = (int)strlen(key) + 3;
+    if (plen >= (int)sizeof(pattern)) return NULL;
+    pattern[0] = '"';
+    memcpy(pattern + 1, key, plen - 3);
+    pattern[plen - 2] = '"';
+    pattern[plen - 1] = ':';
+    pattern[plen] = '\0';
+    for (int i = 0; i + plen <= len; i++) {
+        if (memcmp(json + i, pattern, plen) != 0) continue;
+        const char *p = json + i + plen;
+        while (p < json + len && (*p == ' ' || *p == '\t')) p++;
+        return p;
+    }
+    return NULL;
+}
+
+static int json_int(const char *json, int len, const char *key, int fallback) {
+    const char *p = find_key(json, len, key);
+    if (!p || p >= json + len || (*p != '-' && (*p < '0' || *p > '9'))) return fallback;
+    return atoi(p);
+}
+
+/* ---- WAV ---- */
+
+/* Parse the buffered header. Returns 1 once the data chunk is found (the
+ * bytes after it are passed on), 0 if more is needed, -1 if unusable. */
+static int wav_header(tts_stream_t *st) {
+    const unsigned char *b = (const unsigned char *)st->buf;
+    if (st->len < 12) return 0;
+    if (memcmp(b, "RIFF", 4) != 0 || memcmp(b + 8, "WAVE", 4) != 0) return -1;
+    int pos = 12, have_fmt = 0;
+    while (pos + 8 <= st->len) {
+        uint32_t size = (uint32_t)b[pos + 4] | ((uint32_t)b[pos + 5] << 8)
+                      | ((uint32_t)b[pos + 6] << 16) | ((uint32_t)b[pos + 7] << 24);
+        if (memcmp(b + pos, "data", 4) == 0) {
+            if (!have_fmt) return -1;
+            int body = pos + 8;
+            st->wav_data = 1;
+            if (st->len > body)
+                emit_pcm(st, b + body, st->len - body);
+            st->len = 0;
+            return 1;
+        }
+        if (size > TTS_STREAM_MAX_HEADER) return -1;
+        if (pos + 8 + (int)size > st->len) return 0;
+        if (memcmp(b + pos, "fmt ", 4) == 0 && size >= 16) {
+            int format = b[pos + 8] | (b[pos + 9] << 8);
+            int channels = b[pos + 10] | (b[pos + 11] << 8);
+            int rate = (int)(b[pos + 12] | (b[pos + 13] << 8) | (b[pos + 14] << 16)
+                             | ((uint32_t)b[pos + 15] << 24));
+            int bits = b[pos + 22] | (b[pos + 23] << 8);
+            if (format != 1 || channels != 1 || bits != 16 || rate <= 0) return -1;
+            st->rate = rate;
+            have_fmt = 1;
+        }
+        pos += 8 + (int)size + (int)(size & 1);
+    }
+    return 0;
+}
+
+static int feed_wav(tts_stream_t *st, const char *data, int len) {
+    /* Only the header is buffered: a piece may carry it and much more */
+    while (len > 0 && !st->wav_data) {
+        int k = TTS_STREAM_MAX_HEADER - st->len;
+        if (k > len) k = len;
+        if (k <= 0 || buf_append(st, data, k, TTS_STREAM_MAX_HEADER) != 0) return -1;
+        data += k;
+        len -= k;
+        if (wav_header(st) < 0) return -1;
+    }
+    if (len > 0 && !st->stopped)
+        return emit_pcm(st, (const unsigned char *)data, len);
+    return st->stopped ? 1 : 0;
+}
+
+/* ---- Base64 audio ---- */
+
+/* Decode base64 in pieces, passing the bytes on as WAV or raw PCM. PCM
+ * (raw, or a WAV past its header) is decoded straight into the samples
+ * handed to the callback, behind a byte carried over from the last piece. */
+static int decode_audio(tts_stream_t *st, const char *b64, int len, int wav) {
+    int16_t pcm[B64_DECODED_MAX(TTS_STREAM_B64_PIECE) / 2 + 1];
+    unsigned char *bytes = (unsigned char *)pcm;
+    while (len > 0 && !st->stopped) {
+        int k = len < TTS_STREAM_B64_PIECE ? len : TTS_STREAM_B64_PIECE;
+        int raw = !wav || st->wav_data;
+        int lead = raw && st->has_odd;
+        if (lead) {
+            bytes[0] = st->odd;
+            st->has_odd = 0;
+        }
+        int n = lead + b64_decode_update(&st->b64, b64, k, bytes + lead);
+        if (n > 0) {
+            if (raw) emit_pcm(st, bytes, n);
+            else if (feed_wav(st, (const char *)bytes, n) < 0) return -1;
+        }
+        b64 += k;
+        len -= k;
+    }
+    return 0;
+}
+
+/* ---- JSON objects (a body, or an SSE event) ---- */
+
+static int skip_ws(const char *j, int p, int n) {
+    while (p < n && (j[p] == ' ' || j[p] == '\t' || j[p] == '\r' || j[p] == '\n')) p++;
+    return p;
+}
+
+/* Offset in the kept JSON just past the quote opening the "audio" value,
+ * or -1 if it has not arrived yet */
+static int audio_value(tts_stream_t *st) {
+    const char *j = st->json;
+    int n = st->json_len;
+    for (int i = st->json_scan; i + 7 <= n; i++) {
+        if (memcmp(j + i, "\"audio\"", 7) != 0) continue;
+        int p = skip_ws(j, i + 7, n);
+        if (p < n && j[p] != ':') continue;
+        if (p < n) p = skip_ws(j, p + 1, n);
+        if (p == n) {
+            st->json_scan = i;  /* the rest of the key is still to come */
+            return -1;
+        }
+        if (j[p] == '"') return p + 1;
+    }
+    st->json_scan = n > 6 ? n - 6 : 0;
+    return -1;
+}
+
+/* Everything but the audio string is kept as metadata; the audio is decoded
+ * as it arrives, as a WAV (JSON body) or raw PCM (SSE event, at the
+ * "sample_rate" given ahead of it). */
+static int feed_json(tts_stream_t *st, const char *data, int len, int wav) {
+    while (len > 0 && !st->stopped) {
+        if (st->json_part == JS_AUDIO) {
+            const char *q = (const char *)memchr(data, '"', len);
+            int k = q ? (int)(q - data) : len;
+            if (decode_audio(st, data, k, wav) != 0) return -1;
+            if (!q) break;
+            st->json_part = JS_TAIL;    /* the closing quote goes to the metadata */
+            data += k;
+            len -= k;
+            continue;
+        }
+        int start = st->json_len;
+        if (grow_append(&st->json, &st->json_len, &st->json_cap, data, len,
+                        TTS_STREAM_MAX_JSON) != 0)
+            return -1;
+        if (st->json_part == JS_TAIL) break;
+        int body = audio_value(st);
+        if (body < 0) break;
+        st->json_len = body;
+        st->json[body] = '\0';
+        st->json_part = JS_AUDIO;
+        if (!wav) st->rate = json_int(st->json, body, "sample_rate", st->rate);
+        b64_decode_init(&st->b64);
+        data += body - start;
+        len -= body - start;
+    }
+    return st->stopped ? 1 : 0;
+}
+
+/* ---- SSE ---- */
+
+/* End of a data line: keep the event if it carries words or a seed, and
+ * start the next one */
+static void sse_event_end(tts_stream_t *st) {
+    const char *j = st->json;
+    int start = 0, end = st->json_len;
+    while (start < end && (j[start] == ' ' || j[start] == '\t')) start++;
+    while (end > start && (j[end - 1] == '\r' || j[end - 1] == ' ')) end--;
+    int len = end - start;
+    if (len > 0 && !(len == 6 && memcmp(j + start, "[DONE]", 6) == 0)
+        && (find_key(j + start, len, "words") || find_key(j + start, len, "seed")))
+        keep_json(st, j + start, len);
+    st->json_len = 0;
+    st->json_part = JS_HEAD;
+    st->json_scan = 0;
+}
+
+/* Data lines go through the JSON parser as they arrive, so an event's audio
+ * is decoded without waiting for the end of its line */
+static int feed_sse(tts_stream_t *st, const char *data, int len) {
+    while (len > 0 && !st->stopped) {
+        const char *nl = (const char *)memchr(data, '\n', len);
+        int k = nl ? (int)(nl - data) : len;
+        int used = 0;
+        while (st->sse_field == SF_NAME && used < k) {   /* event:, id:, comments */
+            if (data[used] != "data:"[st->sse_name]) st->sse_field = SF_SKIP;
+            else if (++st->sse_name == 5) st->sse_field = SF_DATA;
+            used++;
+        }
+        if (st->sse_field == SF_DATA && k > used
+            && feed_json(st, data + used, k - used, 0) < 0)
+            return -1;
+        if (!nl) break;
+        if (st->sse_field == SF_DATA) sse_event_end(st);
+        st->sse_field = SF_NAME;
+        st->sse_name = 0;
+        data += k + 1;
+        len -= k + 1;
+    }
+    return st->stopped ? 1 : 0;
+}
+
+/* ---- Stream ---- */
+
+tts_stream_t *tts_stream_new(tts_stream_pcm_fn on_pcm, void *ctx) {
+    if (!on_pcm) return NULL;
+    tts_stream_t *st = (tts_stream_t *)calloc(1, sizeof(tts_stream_t));
+    if (!st) return NULL;
+    st->on_pcm = on_pcm;
+    st->ctx = ctx;
+    st->rate = TTS_STREAM_DEFAULT_RATE;
+    return st;
+}
+
+void tts_stream_free(tts_stream_t *st) {
+    if (!st) return;
+    free(st->buf);
+    free(st->json);
+    free(st->kept);
+    free(st);
+}
+
+int tts_stream_feed(tts_stream_t *st, const char *data, int len) {
+    if (!st) return -1;
+    if (st->stopped) return 1;
+    if (st->mode == TS_DETECT) {
+        while (len > 0 && (*data == ' ' || *data == '\r' || *data == '\n' || *data == '\t')) {
+            data++;
+            len--;
+        }
+        if (len == 0) return 0;
+        if (*data == 'R') st->mode = TS_WAV;
+        else if (*data == '{') st->mode = TS_JSON;
+        else if (*data == 'd' || *data == 'e' || *data == ':' || *data == 'i') st->mode = TS_SSE;
+        else return -1;
+    }
+    switch (st->mode) {
+    case TS_WAV:
+        return feed_wav(st, data, len);
+    case TS_SSE:
+        return feed_sse(st, data, len);
+    default:
+        return feed_json(st, data, len, 1);
+    }
+}
+
+int tts_stream_finish(tts_stream_t *st) {
+    if (!st) return -1;
+    if (st->stopped) return 1;
+    if (st->mode == TS_SSE && st->sse_field == SF_DATA) {
+        sse_event_end(st);
+    } else if (st->mode == TS_JSON && st->json_part != JS_TAIL) {
+        return -1;  /* cut off inside (or before) the audio */
+    }
+    if (st->stopped) return 1;
+    return st->got_audio ? 0 : -1;
+}
+
+const char *tts_stream_json(const tts_stream_t *st, int *len) {
+    const char *json = !st ? NULL : st->mode == TS_SSE ? st->kept : st->json;
+    if (len) *len = !json ? 0 : st->mode == TS_SSE ? st->kept_len : st->json_len;
+    return json;
+}
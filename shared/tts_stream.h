@@ -0,0 +1,46 @@
+/*
+ * tts_stream.h - Incremental parser for streamed speech responses
+ *
+ * Response bytes are fed in whatever pieces the socket returns, and PCM is
+ * handed to a callback as soon as it is decoded. The format is taken from
+ * the first bytes:
+ *   "RIFF"  chunked WAV; the data chunk runs to the end of the response
+ *           (its size field may be 0 or 0xFFFFFFFF while streaming)
+ *   SSE     "data: {json}" events (OpenAI speech stream_format "sse"):
+ *           "audio" holds base64 s16le PCM at the "sample_rate" sent
+ *           ahead of it (default 24000), decoded as the line arrives;
+ *           the last event carrying "words" or "seed" is kept
+ *   "{"     a non-streamed JSON body (base64 WAV in "audio"); the audio
+ *           is decoded as it arrives and only the rest of the body is kept
+ * The JSON kept for the last two (less the audio) is available for
+ * word/seed parsing. Base64 audio is decoded straight into the samples
+ * handed to the callback.
+ */
+#ifndef TTS_STREAM_H
+#define TTS_STREAM_H
+
+#include <stdint.h>
+
+#define TTS_STREAM_DEFAULT_RATE 24000
+
+/* Receives decoded PCM. Return nonzero to stop the stream. */
+typedef int (*tts_stream_pcm_fn)(void *ctx, const int16_t *samples, int n,
+                                 int sample_rate);
+
+typedef struct tts_stream tts_stream_t;
+
+tts_stream_t *tts_stream_new(tts_stream_pcm_fn on_pcm, void *ctx);
+void tts_stream_free(tts_stream_t *st);
+
+/* Returns 0, 1 if the callback stopped the stream, -1 if malformed. */
+int tts_stream_feed(tts_stream_t *st, const char *data, int len);
+
+/* End of response. Returns 0 if any audio was decoded, 1 if stopped, -1
+ * otherwise. */
+int tts_stream_finish(tts_stream_t *st);
+
+/* Metadata JSON (final SSE event, or the JSON body with an empty "audio"
+ * string), or NULL. */
+const char *tts_stream_json(const tts_stream_t *st, int *len);
+
+#endif /* TTS_STREAM_H */
@@ -0,0 +1,100 @@
+/*
+ * upsample2.c - 2x half-band polyphase interpolator for int16 PCM
+ *
+ * Output pair m is x[m] followed by the odd-phase dot product over
+ * x[m-15 .. m+16], so pair m is due once x[m+16] has arrived. The last
+ * UP2_TAPS-1 inputs are carried between calls; each piece is laid out after
+ * them in a small window so the dot products read contiguous samples.
+ * Coefficients are Q15 and sum to exactly 1.0, so DC passes unchanged.
+ */
+#include "upsample2.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define UP2_SSE2 1
+#endif
+
+#define UP2_PIECE 1024
+
+/* Kaiser (beta 8) windowed sinc at offsets -15.5 .. 15.5 */
+static const int16_t up2_coef[UP2_TAPS] = {
+       -6,    16,   -34,    65,  -112,   183,  -283,   424,
+     -616,   878, -1237,  1746, -2514,  3827, -6742, 20789,
+    20789, -6742,  3827, -2514,  1746, -1237,   878,  -616,
+      424,  -283,   183,  -112,    65,   -34,    16,    -6
+};
+
+static int16_t up2_round(int acc) {
+    acc = (acc + (1 << 14)) >> 15;
+    if (acc > 32767) return 32767;
+    if (acc < -32768) return -32768;
+    return (int16_t)acc;
+}
+
+/* Pairs for the windows starting at w[0 .. n-1] */
+static void up2_run(const int16_t *w, int n, int16_t *out) {
+#ifdef UP2_SSE2
+    const __m128i c0 = _mm_loadu_si128((const __m128i *)(up2_coef + 0));
+    const __m128i c1 = _mm_loadu_si128((const __m128i *)(up2_coef + 8));
+    const __m128i c2 = _mm_loadu_si128((const __m128i *)(up2_coef + 16));
+    const __m128i c3 = _mm_loadu_si128((const __m128i *)(up2_coef + 24));
+    for (int i = 0; i < n; i++) {
+        const int16_t *x = w + i;
+        __m128i acc = _mm_add_epi32(
+            _mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)(x + 0)), c0),
+                          _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(x + 8)), c1)),
+            _mm_add_epi32(_mm_madd_epi16(_mm_loadu_si128((const __m128i *)(x + 16)), c2),
+                          _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(x + 24)), c3)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+        acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+        out[i * 2]     = x[UP2_DELAY - 1];
+        out[i * 2 + 1] = up2_round(_mm_cvtsi128_si32(acc));
+    }
+#else
+    for (int i = 0; i < n; i++) {
+        const int16_t *x = w + i;
+        int acc = 0;
+        for (int j = 0; j < UP2_TAPS; j++)
+            acc += x[j] * up2_coef[j];
+        out[i * 2]     = x[UP2_DELAY - 1];
+        out[i * 2 + 1] = up2_round(acc);
+    }
+#endif
+}
+
+void up2_init(up2_state_t *st) {
+    memset(st->hist, 0, sizeof(st->hist));
+    st->lead = UP2_DELAY;
+}
+
+int up2_process(up2_state_t *st, const int16_t *in, int n, int16_t *out) {
+    int16_t win[UP2_TAPS - 1 + UP2_PIECE];
+    int written = 0;
+    while (n > 0) {
+        int k = n < UP2_PIECE ? n : UP2_PIECE;
+        memcpy(win, st->hist, sizeof(st->hist));
+        memcpy(win + UP2_TAPS - 1, in, k * sizeof(int16_t));
+        int skip = st->lead < k ? st->lead : k;
+        st->lead -= skip;
+        up2_run(win + skip, k - skip, out + written);
+        written += (k - skip) * 2;
+        memcpy(st->hist, win + k, sizeof(st->hist));
+        in += k;
+        n -= k;
+    }
+    return written;
+}
+
+int up2_flush(up2_state_t *st, int16_t *out) {
+    static const int16_t zeros[UP2_DELAY];
+    return up2_process(st, zeros, UP2_DELAY, out);
+}
+
+void up2_block(const int16_t *in, int n, int16_t *out) {
+    up2_state_t st;
+    up2_init(&st);
+    int written = up2_process(&st, in, n, out);
+    up2_flush(&st, out + written);
+}
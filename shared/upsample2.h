@@ -0,0 +1,40 @@
+/*
+ * upsample2.h - 2x half-band polyphase interpolator for int16 PCM
+ *
+ * Doubles the sample rate (24 kHz TTS output to the 48 kHz device rate)
+ * with a 63-tap Kaiser-windowed half-band filter instead of repeating each
+ * sample: flat to 10 kHz, images 80 dB down from 14 kHz. Even outputs are
+ * the input samples themselves, so only the 32-tap odd phase is computed
+ * (SSE2 where available).
+ *
+ * Streaming: feed pieces of any size through up2_process and finish with
+ * up2_flush; the output is exactly 2n samples aligned with the input, the
+ * same as a single up2_block call.
+ */
+#ifndef UPSAMPLE2_H
+#define UPSAMPLE2_H
+
+#include <stdint.h>
+
+#define UP2_TAPS  32                /* odd-phase taps */
+#define UP2_DELAY (UP2_TAPS / 2)    /* input samples held back by up2_process */
+
+typedef struct {
+    int16_t hist[UP2_TAPS - 1];     /* last inputs seen */
+    int lead;                       /* inputs whose outputs are still dropped */
+} up2_state_t;
+
+void up2_init(up2_state_t *st);
+
+/* Interpolate n samples. out holds 2 * n samples; returns the number
+ * written (fewer while the first UP2_DELAY inputs are still held back). */
+int up2_process(up2_state_t *st, const int16_t *in, int n, int16_t *out);
+
+/* End of input: write the held-back tail (2 * UP2_DELAY samples room).
+ * Returns the number written. */
+int up2_flush(up2_state_t *st, int16_t *out);
+
+/* Whole buffer: out gets 2 * n samples. */
+void up2_block(const int16_t *in, int n, int16_t *out);
+
+#endif /* UPSAMPLE2_H */
@@ -0,0 +1,242 @@
+/*
+ * vad.c - Spectral voice activity detector
+ *
+ * Each frame is Hann-windowed, transformed with fft_power and summarised as
+ * VAD_BANDS log-spaced band energies between 200 and 4000 Hz. A frame is raw
+ * speech when the mean band SNR over the noise floor clears VAD_SNR_DB, the
+ * 300-3400 Hz spectrum is peaky rather than noise-flat, and the frame is
+ * above an absolute floor. Unvoiced consonants fail the flatness test on
+ * their own; the hangover carries them. The noise floor is a
+ * minimum-statistics estimate (lowest smoothed band energy over ~1.6 s), so
+ * a steady noise source is absorbed while speech, which has gaps, is not. Cost is one 512-point real FFT
+ * per 10 ms hop, a few microseconds.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "vad.h"
+#include "fft.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VAD_BANDS         8
+#define VAD_INIT_FRAMES   10        /* no decisions until the floor has data */
+#define VAD_SNR_DB        4.0f
+#define VAD_FLAT_MAX      0.35f     /* white noise ~0.55, fans ~0.4, voiced speech < 0.3 */
+#define VAD_MIN_RMS       0.002f    /* about -54 dBFS */
+#define VAD_SMOOTH        0.3f      /* band energy smoothing before the minimum */
+#define VAD_MIN_SUB       20        /* frames per sub-window */
+#define VAD_MIN_WINS      8         /* sub-windows in the minimum search */
+#define VAD_ONSET_FRAMES  3
+#define VAD_HANG_FRAMES   20
+
+static const float k_band_edges[VAD_BANDS + 1] = {
+    200, 300, 450, 700, 1000, 1500, 2200, 3000, 4000
+};
+
+struct vad {
+    int sample_rate;
+    int frame, hop;
+    fft_plan_t *plan;
+    int nfft;
+    float *window;
+    float *buf;                 /* frame samples, fill of them valid */
+    int fill;
+    float *in, *power, *scratch;
+    int band_lo[VAD_BANDS], band_hi[VAD_BANDS];
+    int flat_lo, flat_hi;
+    float smooth[VAD_BANDS];
+    float sub_min[VAD_BANDS];               /* current sub-window */
+    float win_min[VAD_MIN_WINS][VAD_BANDS]; /* completed sub-windows */
+    int n_wins, sub_frames;
+    float noise[VAD_BANDS];
+    int frames;
+    int run;                    /* consecutive raw speech frames */
+    int hang;                   /* frames left before release */
+    int active;
+    vad_info_t info;
+};
+
+static int hz_to_bin(const vad_t *v, float hz) {
+    int b = (int)(hz * v->nfft / v->sample_rate + 0.5f);
+    if (b < 1) b = 1;
+    if (b > v->nfft / 2) b = v->nfft / 2;
+    return b;
+}
+
+vad_t *vad_create(int sample_rate) {
+    if (sample_rate < 8000) return NULL;
+    vad_t *v = (vad_t *)calloc(1, sizeof(vad_t));
+    if (!v) return NULL;
+    v->sample_rate = sample_rate;
+    v->frame = sample_rate * VAD_FRAME_MS / 1000;
+    v->hop = sample_rate * VAD_HOP_MS / 1000;
+    v->nfft = 16;
+    while (v->nfft < v->frame) v->nfft *= 2;
+    v->plan = fft_plan_create(v->nfft);
+    v->window = (float *)malloc(v->frame * sizeof(float));
+    v->buf = (float *)malloc(v->frame * sizeof(float));
+    v->in = (float *)calloc(v->nfft, sizeof(float));
+    v->power = (float *)malloc((v->nfft / 2 + 1) * sizeof(float));
+    v->scratch = (float *)malloc(v->nfft * sizeof(float));
+    if (!v->plan || !v->window || !v->buf || !v->in || !v->power || !v->scratch) {
+        vad_destroy(v);
+        return NULL;
+    }
+    for (int i = 0; i < v->frame; i++)
+        v->window[i] = 0.5f - 0.5f * cosf(6.2831853f * i / (v->frame - 1));
+    for (int b = 0; b < VAD_BANDS; b++) {
+        v->band_lo[b] = hz_to_bin(v, k_band_edges[b]);
+        v->band_hi[b] = hz_to_bin(v, k_band_edges[b + 1]);
+        if (v->band_hi[b] <= v->band_lo[b]) v->band_hi[b] = v->band_lo[b] + 1;
+    }
+    v->flat_lo = hz_to_bin(v, 300.0f);
+    v->flat_hi = hz_to_bin(v, 3400.0f);
+    vad_reset(v);
+    return v;
+}
+
+void vad_destroy(vad_t *v) {
+    if (!v) return;
+    fft_plan_destroy(v->plan);
+    free(v->window);
+    free(v->buf);
+    free(v->in);
+    free(v->power);
+    free(v->scratch);
+    free(v);
+}
+
+void vad_reset(vad_t *v) {
+    if (!v) return;
+    v->fill = 0;
+    v->frames = 0;
+    v->run = 0;
+    v->hang = 0;
+    v->active = 0;
+    v->n_wins = 0;
+    v->sub_frames = 0;
+    memset(&v->info, 0, sizeof(v->info));
+}
+
+/* Classify the frame in v->buf and advance the smoothing state */
+static int process_frame(vad_t *v) {
+    float sum_sq = 0.0f;
+    for (int i = 0; i < v->frame; i++) {
+        sum_sq += v->buf[i] * v->buf[i];
+        v->in[i] = v->buf[i] * v->window[i];
+    }
+    fft_power(v->plan, v->in, v->power, v->scratch);
+
+    float band[VAD_BANDS];
+    for (int b = 0; b < VAD_BANDS; b++) {
+        float e = 0.0f;
+        for (int k = v->band_lo[b]; k < v->band_hi[b]; k++) e += v->power[k];
+        band[b] = e / (v->band_hi[b] - v->band_lo[b]) + 1e-12f;
+    }
+
+    double log_sum = 0.0, lin_sum = 0.0;
+    for (int k = v->flat_lo; k < v->flat_hi; k++) {
+        float p = v->power[k] + 1e-12f;
+        log_sum += logf(p);
+        lin_sum += p;
+    }
+    int nf = v->flat_hi - v->flat_lo;
+    float flat = nf > 0 ? (float)(exp(log_sum / nf) / (lin_sum / nf)) : 1.0f;
+
+    /* Minimum statistics over the smoothed band energies */
+    for (int b = 0; b < VAD_BANDS; b++) {
+        v->smooth[b] = v->frames ? v->smooth[b] + VAD_SMOOTH * (band[b] - v->smooth[b])
+                                 : band[b];
+        if (v->sub_frames == 0 || v->smooth[b] < v->sub_min[b])
+            v->sub_min[b] = v->smooth[b];
+        float m = v->sub_min[b];
+        for (int w = 0; w < v->n_wins; w++)
+            if (v->win_min[w][b] < m) m = v->win_min[w][b];
+        v->noise[b] = m;
+    }
+    if (++v->sub_frames == VAD_MIN_SUB) {
+        if (v->n_wins == VAD_MIN_WINS) {
+            memmove(v->win_min[0], v->win_min[1],
+                    (VAD_MIN_WINS - 1) * sizeof(v->win_min[0]));
+            v->n_wins--;
+        }
+        memcpy(v->win_min[v->n_wins++], v->sub_min, sizeof(v->sub_min));
+        v->sub_frames = 0;
+    }
+
+    int raw = 0;
+    float snr = 0.0f;
+    float rms = sqrtf(sum_sq / v->frame);
+    if (v->frames >= VAD_INIT_FRAMES) {
+        for (int b = 0; b < VAD_BANDS; b++) {
+            float d = 10.0f * log10f(band[b] / v->noise[b]);
+            snr += d > 0.0f ? d : 0.0f;
+        }
+        snr /= VAD_BANDS;
+        raw = snr >= VAD_SNR_DB && rms >= VAD_MIN_RMS &&
+              flat < VAD_FLAT_MAX;
+    }
+    v->frames++;
+
+    if (raw) {
+        v->run++;
+        if (v->run >= VAD_ONSET_FRAMES) {
+            v->active = 1;
+            v->hang = VAD_HANG_FRAMES;
+        }
+    } else {
+        v->run = 0;
+        if (v->active && --v->hang <= 0) v->active = 0;
+    }
+
+    v->info.snr_db = snr;
+    v->info.flatness = flat;
+    v->info.rms = rms;
+    v->info.raw = raw;
+    return v->active;
+}
+
+int vad_feed_f32(vad_t *v, const float *pcm, int n, int *speech_frames) {
+    if (!v || !pcm) return 0;
+    int done = 0, speech = 0;
+    while (n > 0) {
+        int take = v->frame - v->fill;
+        if (take > n) take = n;
+        memcpy(v->buf + v->fill, pcm, take * sizeof(float));
+        v->fill += take;
+        pcm += take;
+        n -= take;
+        if (v->fill < v->frame) break;
+
+        speech += process_frame(v);
+        done++;
+        int keep = v->frame - v->hop;
+        memmove(v->buf, v->buf + v->hop, keep * sizeof(float));
+        v->fill = keep;
+    }
+    if (speech_frames) *speech_frames += speech;
+    return done;
+}
+
+int vad_feed_s16(vad_t *v, const int16_t *pcm, int n, int *speech_frames) {
+    float tmp[512];
+    int done = 0;
+    while (n > 0) {
+        int c = n < 512 ? n : 512;
+        for (int i = 0; i < c; i++) tmp[i] = pcm[i] / 32768.0f;
+        done += vad_feed_f32(v, tmp, c, speech_frames);
+        pcm += c;
+        n -= c;
+    }
+    return done;
+}
+
+int vad_active(const vad_t *v) {
+    return v ? v->active : 0;
+}
+
+void vad_info(const vad_t *v, vad_info_t *out) {
+    if (!v || !out) return;
+    *out = v->info;
+}
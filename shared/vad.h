@@ -0,0 +1,46 @@
+/*
+ * vad.h - Spectral voice activity detector
+ *
+ * Classifies audio in overlapping frames (VAD_FRAME_MS window every
+ * VAD_HOP_MS) from band energies against an adaptive per-band noise floor
+ * and the spectral flatness of the speech band, so steady broadband noise
+ * (fans, hum) is learned and ignored while quiet voiced speech still
+ * registers. Raw frame decisions are smoothed with an onset count and a
+ * hangover. One instance per stream; not thread-safe.
+ */
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdint.h>
+
+#define VAD_FRAME_MS 20
+#define VAD_HOP_MS   10
+
+typedef struct vad vad_t;
+
+/* Last frame's features, for display and tuning */
+typedef struct {
+    float snr_db;       /* mean band SNR over the noise floor (bands clamped at 0) */
+    float flatness;     /* 0 = tonal .. 1 = white, over 300-3400 Hz */
+    float rms;          /* frame RMS, full scale 1.0 */
+    int raw;            /* frame decision before smoothing */
+} vad_info_t;
+
+/* Returns NULL on failure. */
+vad_t *vad_create(int sample_rate);
+void vad_destroy(vad_t *v);
+
+/* Forget buffered audio, the noise floor and the smoothing state. */
+void vad_reset(vad_t *v);
+
+/* Feed samples. Returns the number of frames completed by this call and
+ * adds the number of those that were (smoothed) speech to *speech_frames
+ * if non-NULL. */
+int vad_feed_f32(vad_t *v, const float *pcm, int n, int *speech_frames);
+int vad_feed_s16(vad_t *v, const int16_t *pcm, int n, int *speech_frames);
+
+/* Smoothed state after the last completed frame. */
+int vad_active(const vad_t *v);
+void vad_info(const vad_t *v, vad_info_t *out);
+
+#endif /* VAD_H */
@@ -0,0 +1,198 @@
+/*
+ * wav_writer.c - Incremental crash-safe WAV writer
+ *
+ * The UI thread appends spans to a pending view under a critical section;
+ * the writer thread swaps it out, packs the spans into a staging buffer and
+ * writes whatever has built up once a second (or per megabyte). Every write
+ * is positioned explicitly with a 64-bit offset, so rewriting the header
+ * sizes never disturbs where the data goes. Past 4 GB the header sizes
+ * stay at their maximum and readers take the data to end of file.
+ */
+#define _CRT_SECURE_NO_WARNINGS
+#include "wav_writer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+
+#define WAV_HEADER_BYTES  44
+#define WAV_STAGE_BYTES   (1 << 20)
+#define WAV_PATCH_MS      1000
+
+struct wav_writer {
+    HANDLE file;
+    HANDLE thread;
+    HANDLE wake_event;
+    volatile LONG stop;
+    volatile LONG failed;
+    CRITICAL_SECTION lock;
+    audio_view_t pending;       /* guarded by lock */
+    unsigned char *stage;
+    DWORD stage_len;
+    LONGLONG data_bytes;        /* writer thread only */
+    LONGLONG patched_bytes;
+    DWORD last_patch_ms;
+};
+
+static void fill_header(unsigned char *h, int sample_rate, DWORD data_bytes) {
+    memcpy(h, "RIFF", 4);
+    *(DWORD *)(h + 4) = 36 + data_bytes;
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    *(DWORD *)(h + 16) = 16;
+    *(WORD *)(h + 20) = 1;                   /* PCM */
+    *(WORD *)(h + 22) = 1;                   /* mono */
+    *(DWORD *)(h + 24) = (DWORD)sample_rate;
+    *(DWORD *)(h + 28) = (DWORD)sample_rate * 2;
+    *(WORD *)(h + 32) = 2;                   /* block align */
+    *(WORD *)(h + 34) = 16;                  /* bits per sample */
+    memcpy(h + 36, "data", 4);
+    *(DWORD *)(h + 40) = data_bytes;
+}
+
+static int write_at(HANDLE f, long long offset, const void *buf, DWORD len) {
+    OVERLAPPED ov = {0};
+    ov.Offset = (DWORD)offset;
+    ov.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD written = 0;
+    return WriteFile(f, buf, len, &written, &ov) && written == len ? 0 : -1;
+}
+
+static void patch_sizes(wav_writer_t *w) {
+    if (w->data_bytes == w->patched_bytes) return;
+    DWORD data = w->data_bytes > 0xFFFFFFFFLL - 36 ? 0xFFFFFFFFu - 36 : (DWORD)w->data_bytes;
+    DWORD riff = 36 + data;
+    if (write_at(w->file, 4, &riff, 4) != 0 || write_at(w->file, 40, &data, 4) != 0)
+        InterlockedExchange(&w->failed, 1);
+    w->patched_bytes = w->data_bytes;
+    w->last_patch_ms = GetTickCount();
+}
+
+static void flush_stage(wav_writer_t *w) {
+    if (w->stage_len == 0) return;
+    if (write_at(w->file, WAV_HEADER_BYTES + w->data_bytes,
+                 w->stage, w->stage_len) != 0)
+        InterlockedExchange(&w->failed, 1);
+    else
+        w->data_bytes += w->stage_len;
+    w->stage_len = 0;
+}
+
+static void write_view(wav_writer_t *w, const audio_view_t *v) {
+    for (int i = 0; i < v->n_spans; i++) {
+        const audio_span_t *sp = &v->spans[i];
+        const unsigned char *src = (const unsigned char *)(sp->block->samples + sp->offset);
+        DWORD left = (DWORD)sp->length * sizeof(int16_t);
+        while (left > 0) {
+            DWORD take = WAV_STAGE_BYTES - w->stage_len;
+            if (take > left) take = left;
+            memcpy(w->stage + w->stage_len, src, take);
+            w->stage_len += take;
+            src += take;
+            left -= take;
+            if (w->stage_len == WAV_STAGE_BYTES) flush_stage(w);
+        }
+    }
+}
+
+static DWORD WINAPI wav_writer_thread(LPVOID param) {
+    wav_writer_t *w = (wav_writer_t *)param;
+    for (;;) {
+        WaitForSingleObject(w->wake_event, WAV_PATCH_MS);
+        int stopping = InterlockedCompareExchange(&w->stop, 0, 0) != 0;
+
+        audio_view_t batch;
+        EnterCriticalSection(&w->lock);
+        batch = w->pending;
+        memset(&w->pending, 0, sizeof(w->pending));
+        LeaveCriticalSection(&w->lock);
+
+        write_view(w, &batch);
+        audio_view_release(&batch);
+
+        /* Keep the file playable: flush and patch at least once a second */
+        if (stopping || GetTickCount() - w->last_patch_ms >= WAV_PATCH_MS) {
+            flush_stage(w);
+            patch_sizes(w);
+        }
+        if (stopping) break;
+    }
+    return 0;
+}
+
+wav_writer_t *wav_writer_open(const char *path, int sample_rate) {
+    wav_writer_t *w = (wav_writer_t *)calloc(1, sizeof(wav_writer_t));
+    if (!w) return NULL;
+    w->stage = (unsigned char *)malloc(WAV_STAGE_BYTES);
+    w->file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                          CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (!w->stage || w->file == INVALID_HANDLE_VALUE) goto fail;
+
+    unsigned char header[WAV_HEADER_BYTES];
+    fill_header(header, sample_rate, 0);
+    DWORD written = 0;
+    if (!WriteFile(w->file, header, sizeof(header), &written, NULL)
+        || written != sizeof(header))
+        goto fail;
+
+    InitializeCriticalSection(&w->lock);
+    w->wake_event = CreateEventA(NULL, FALSE, FALSE, NULL);
+    if (!w->wake_event) {
+        DeleteCriticalSection(&w->lock);
+        goto fail;
+    }
+    w->last_patch_ms = GetTickCount();
+    w->thread = CreateThread(NULL, 0, wav_writer_thread, w, 0, NULL);
+    if (!w->thread) {
+        CloseHandle(w->wake_event);
+        DeleteCriticalSection(&w->lock);
+        goto fail;
+    }
+    return w;
+
+fail:
+    if (w->file != INVALID_HANDLE_VALUE && w->file) {
+        CloseHandle(w->file);
+        DeleteFileA(path);
+    }
+    free(w->stage);
+    free(w);
+    return NULL;
+}
+
+int wav_writer_append(wav_writer_t *w, const audio_view_t *view) {
+    if (!w) return -1;
+    if (w->failed) return -1;
+    if (!view || view->n_samples <= 0) return 0;
+    int rc = 0;
+    EnterCriticalSection(&w->lock);
+    for (int i = 0; i < view->n_spans && rc == 0; i++) {
+        const audio_span_t *sp = &view->spans[i];
+        rc = audio_view_append(&w->pending, sp->block, sp->offset, sp->length);
+    }
+    LeaveCriticalSection(&w->lock);
+    SetEvent(w->wake_event);
+    return rc;
+}
+
+long long wav_writer_close(wav_writer_t *w) {
+    if (!w) return -1;
+    InterlockedExchange(&w->stop, 1);
+    SetEvent(w->wake_event);
+    WaitForSingleObject(w->thread, INFINITE);
+    CloseHandle(w->thread);
+    CloseHandle(w->wake_event);
+
+    /* Anything appended after the thread's final swap */
+    write_view(w, &w->pending);
+    audio_view_release(&w->pending);
+    flush_stage(w);
+    patch_sizes(w);
+
+    long long samples = w->failed ? -1 : w->data_bytes / (long long)sizeof(int16_t);
+    CloseHandle(w->file);
+    DeleteCriticalSection(&w->lock);
+    free(w->stage);
+    free(w);
+    return samples;
+}
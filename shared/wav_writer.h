@@ -0,0 +1,28 @@
+/*
+ * wav_writer.h - Incremental crash-safe WAV writer
+ *
+ * Appends 16-bit mono PCM to a WAV file from a background thread while a
+ * recording is in progress. Submitted audio is taken as a view (no copy) and
+ * written in large batches; the RIFF and data sizes are patched about once a
+ * second and again at close, so a crash loses at most the last second.
+ */
+#ifndef WAV_WRITER_H
+#define WAV_WRITER_H
+
+#include "audio_buf.h"
+
+typedef struct wav_writer wav_writer_t;
+
+/* Create path, write a header with zero sizes and start the writer thread.
+ * Returns NULL on failure. */
+wav_writer_t *wav_writer_open(const char *path, int sample_rate);
+
+/* Queue the samples of view for writing (takes its own references; the
+ * caller keeps view). Returns 0, or -1 if the writer has hit an I/O error. */
+int wav_writer_append(wav_writer_t *w, const audio_view_t *view);
+
+/* Write everything still queued, patch the header, close the file and free
+ * w. Returns samples written, or -1 if any write failed. */
+long long wav_writer_close(wav_writer_t *w);
+
+#endif /* WAV_WRITER_H */
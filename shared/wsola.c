@@ -0,0 +1,270 @@
+/*
+ * wsola.c - Streaming pitch-preserving time-stretch (WSOLA)
+ *
+ * Frame k is written at output k*hs (hs = half a frame) and read from input
+ * p_k, searched within +-tol of the nominal k*hs*speed. The search compares
+ * the first hs samples of each candidate with the natural continuation of
+ * frame k-1 (input p_{k-1} + hs) and keeps the best energy-normalized
+ * correlation; the nominal position wins ties and silent stretches. Frame 0 is taken at 0 with its fade-in dropped, so the
+ * output starts at full level. After end of input the tail is padded with
+ * silence and the output cut to round(input / speed).
+ *
+ * The input window is kept as float from the oldest sample any later frame
+ * can still reach; p_k for recent frames is kept in a ring for
+ * wsola_source_pos.
+ */
+#include "wsola.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define WSOLA_SSE2 1
+#endif
+
+#define WSOLA_PI      3.14159265358979323846
+#define WSOLA_ANCHORS 1024      /* frames remembered for wsola_source_pos */
+#define WSOLA_SILENT  1.0f      /* mean square below 1 LSB: keep the nominal start */
+#define WSOLA_MARGIN  1e-4      /* relative score gain needed to leave it */
+
+struct wsola {
+    double speed;
+    int n;                  /* frame length */
+    int hs;                 /* synthesis hop, also the compared overlap */
+    int tol;                /* search radius */
+    float *win;             /* periodic Hann, n */
+    float *acc;             /* overlap-add of the frames not yet emitted */
+
+    float *in;              /* input from in_base */
+    int in_len, in_cap;
+    long long in_base;
+    long long in_total;     /* real samples written (not the end padding) */
+    int ended;
+
+    long long frame;        /* next frame */
+    long long p_prev;       /* input position of the last frame */
+
+    int16_t *pend;          /* emitted, not yet read */
+    int pend_pos, pend_len;
+    long long out_total;    /* samples emitted */
+    long long out_limit;
+
+    long long anchor[WSOLA_ANCHORS];
+};
+
+/* ---- Correlation ---- */
+
+static float dot(const float *a, const float *b, int n) {
+    int i = 0;
+    float s = 0.0f;
+#ifdef WSOLA_SSE2
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    s0 = _mm_add_ps(s0, s1);
+    s0 = _mm_add_ps(s0, _mm_movehl_ps(s0, s0));
+    s0 = _mm_add_ss(s0, _mm_shuffle_ps(s0, s0, 1));
+    s = _mm_cvtss_f32(s0);
+#endif
+    for (; i < n; i++) s += a[i] * b[i];
+    return s;
+}
+
+/* Start in [lo, hi] whose first hs samples best match ref. The nominal
+ * start a keeps the frame unless another start scores clearly better, and
+ * always when ref is silent (nothing to align), so at 1x every frame is
+ * read where it falls and the output equals the input. */
+static long long best_offset(const wsola_t *w, const float *ref, long long lo, long long hi,
+                             long long a) {
+    int len = w->hs;
+    if (a < lo) a = lo;
+    if (a > hi) a = hi;
+    if (dot(ref, ref, len) < WSOLA_SILENT * len) return a;
+
+    const float *xa = w->in + (a - w->in_base);
+    double ca = dot(xa, ref, len);
+    long long best = a;
+    double best_score = ca * fabs(ca) / (1e-3 + dot(xa, xa, len));
+    double margin = WSOLA_MARGIN * fabs(best_score);
+
+    const float *x = w->in + (lo - w->in_base);
+    double energy = 1e-3;
+    for (int i = 0; i < len; i++) energy += (double)x[i] * x[i];
+    for (long long p = lo; p <= hi; p++, x++) {
+        if (p != a) {
+            double c = dot(x, ref, len);
+            double score = c * fabs(c) / energy;
+            if (score > best_score + margin) {
+                best_score = score;
+                best = p;
+                margin = WSOLA_MARGIN * fabs(best_score);
+            }
+        }
+        energy += (double)x[len] * x[len] - (double)x[0] * x[0];
+        if (energy < 1e-3) energy = 1e-3;
+    }
+    return best;
+}
+
+/* ---- Input ---- */
+
+static int in_reserve(wsola_t *w, int extra) {
+    if (w->in_len + extra <= w->in_cap) return 0;
+    int cap = w->in_cap ? w->in_cap : 4 * w->n;
+    while (cap < w->in_len + extra) cap *= 2;
+    float *p = (float *)realloc(w->in, cap * sizeof(float));
+    if (!p) return -1;
+    w->in = p;
+    w->in_cap = cap;
+    return 0;
+}
+
+/* Drop input before keep (nothing later can reach it) */
+static void in_discard(wsola_t *w, long long keep) {
+    int drop = (int)(keep - w->in_base);
+    if (drop <= 0 || drop < w->in_len / 2) return;
+    memmove(w->in, w->in + drop, (w->in_len - drop) * sizeof(float));
+    w->in_len -= drop;
+    w->in_base += drop;
+}
+
+/* ---- Frames ---- */
+
+static long long nominal(const wsola_t *w, long long k) {
+    return (long long)floor((double)k * w->hs * w->speed + 0.5);
+}
+
+/* Run the next frame into pend if its input has arrived. Returns 1 if a
+ * frame was run. */
+static int run_frame(wsola_t *w) {
+    if (w->out_total >= w->out_limit) return 0;
+    long long k = w->frame;
+    long long a = nominal(w, k);
+    long long avail = w->in_base + w->in_len;
+    if (a + w->tol + w->n > avail) return 0;
+
+    long long p = 0;
+    if (k > 0) {
+        long long lo = a - w->tol, hi = a + w->tol;
+        if (lo < w->in_base) lo = w->in_base;
+        p = best_offset(w, w->in + (w->p_prev + w->hs - w->in_base), lo, hi, a);
+    }
+
+    const float *x = w->in + (p - w->in_base);
+    for (int i = 0; i < w->n; i++)
+        w->acc[i] += (k == 0 && i < w->hs ? 1.0f : w->win[i]) * x[i];
+
+    int emit = w->hs;
+    if (w->out_total + emit > w->out_limit) emit = (int)(w->out_limit - w->out_total);
+    for (int i = 0; i < emit; i++) {
+        float v = w->acc[i];
+        w->pend[i] = (int16_t)(v > 32767.0f ? 32767 : v < -32768.0f ? -32768
+                               : (int)floorf(v + 0.5f));
+    }
+    memmove(w->acc, w->acc + w->hs, w->hs * sizeof(float));
+    memset(w->acc + w->hs, 0, (w->n - w->hs) * sizeof(float));
+    w->pend_pos = 0;
+    w->pend_len = emit;
+    w->out_total += emit;
+
+    w->anchor[k % WSOLA_ANCHORS] = p;
+    w->p_prev = p;
+    w->frame = k + 1;
+    long long keep = nominal(w, k + 1) - w->tol;
+    if (keep > p + w->hs) keep = p + w->hs;
+    in_discard(w, keep);
+    return 1;
+}
+
+/* ---- Public ---- */
+
+wsola_t *wsola_create(int sample_rate, double speed) {
+    if (sample_rate < 8000) return NULL;
+    wsola_t *w = (wsola_t *)calloc(1, sizeof(wsola_t));
+    if (!w) return NULL;
+    if (speed < WSOLA_MIN_SPEED) speed = WSOLA_MIN_SPEED;
+    if (speed > WSOLA_MAX_SPEED) speed = WSOLA_MAX_SPEED;
+    w->speed = speed;
+    w->n = (sample_rate / 50) & ~1;     /* 20 ms */
+    w->hs = w->n / 2;
+    w->tol = sample_rate / 160;         /* 6.25 ms: a 100 Hz period */
+    w->win = (float *)malloc(w->n * sizeof(float));
+    w->acc = (float *)calloc(w->n, sizeof(float));
+    w->pend = (int16_t *)malloc(w->hs * sizeof(int16_t));
+    if (!w->win || !w->acc || !w->pend) {
+        wsola_destroy(w);
+        return NULL;
+    }
+    w->out_limit = 0x7FFFFFFFFFFFFFFFLL;
+    for (int i = 0; i < w->n; i++)
+        w->win[i] = (float)(0.5 - 0.5 * cos(2.0 * WSOLA_PI * i / w->n));
+    return w;
+}
+
+void wsola_destroy(wsola_t *w) {
+    if (!w) return;
+    free(w->win);
+    free(w->acc);
+    free(w->in);
+    free(w->pend);
+    free(w);
+}
+
+double wsola_speed(const wsola_t *w) {
+    return w ? w->speed : 1.0;
+}
+
+int wsola_write(wsola_t *w, const int16_t *in, int n) {
+    if (!w || w->ended) return -1;
+    if (n <= 0) return 0;
+    if (in_reserve(w, n) != 0) return -1;
+    float *dst = w->in + w->in_len;
+    for (int i = 0; i < n; i++) dst[i] = (float)in[i];
+    w->in_len += n;
+    w->in_total += n;
+    return 0;
+}
+
+void wsola_end(wsola_t *w) {
+    if (!w || w->ended) return;
+    w->ended = 1;
+    w->out_limit = (long long)floor((double)w->in_total / w->speed + 0.5);
+    /* Silence past the end, enough for every frame up to out_limit */
+    int pad = w->tol + w->n + (int)ceil(w->hs * w->speed) + 1;
+    if (in_reserve(w, pad) == 0) {
+        memset(w->in + w->in_len, 0, pad * sizeof(float));
+        w->in_len += pad;
+    }
+}
+
+int wsola_read(wsola_t *w, int16_t *out, int cap) {
+    if (!w) return 0;
+    int n = 0;
+    while (n < cap) {
+        if (w->pend_pos == w->pend_len && !run_frame(w)) break;
+        int k = w->pend_len - w->pend_pos;
+        if (k > cap - n) k = cap - n;
+        memcpy(out + n, w->pend + w->pend_pos, k * sizeof(int16_t));
+        w->pend_pos += k;
+        n += k;
+    }
+    return n;
+}
+
+long long wsola_source_pos(const wsola_t *w, long long out_pos) {
+    if (!w || out_pos <= 0) return 0;
+    long long k = out_pos / w->hs;
+    long long last = w->frame - 1;
+    long long pos;
+    if (last < 0 || k < last - (WSOLA_ANCHORS - 1)) {
+        pos = (long long)(out_pos * w->speed);
+    } else {
+        if (k > last) k = last;
+        pos = w->anchor[k % WSOLA_ANCHORS] + (out_pos - k * w->hs);
+    }
+    return pos < w->in_total ? pos : w->in_total;
+}
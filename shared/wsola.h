@@ -0,0 +1,46 @@
+/*
+ * wsola.h - Streaming pitch-preserving time-stretch (WSOLA)
+ *
+ * Plays mono int16 PCM at 0.5x-1.5x speed without changing its pitch.
+ * Output is built from 20 ms Hann-windowed frames of the input, overlapped
+ * by half; each frame is taken near its nominal input position at the
+ * offset (within +-6 ms) whose start best continues the previous frame, so
+ * periods line up instead of smearing. The cross-correlation search uses
+ * SSE2 where available.
+ *
+ * Input is written in pieces and output read as it becomes ready (about
+ * one frame behind). wsola_source_pos maps an output sample back to the
+ * input sample it came from, for position displays.
+ */
+#ifndef WSOLA_H
+#define WSOLA_H
+
+#include <stdint.h>
+
+#define WSOLA_MIN_SPEED 0.5
+#define WSOLA_MAX_SPEED 1.5
+
+typedef struct wsola wsola_t;
+
+/* speed is clamped to [WSOLA_MIN_SPEED, WSOLA_MAX_SPEED] (0.5 = half
+ * speed, twice as long). Returns NULL on failure. */
+wsola_t *wsola_create(int sample_rate, double speed);
+void wsola_destroy(wsola_t *w);
+
+double wsola_speed(const wsola_t *w);
+
+/* Queue n input samples. Returns 0, or -1 if out of memory. */
+int wsola_write(wsola_t *w, const int16_t *in, int n);
+
+/* End of input: the remaining output becomes readable, and the total
+ * comes to round(input / speed) samples. */
+void wsola_end(wsola_t *w);
+
+/* Read up to cap stretched samples. Returns the number read (0 when more
+ * input is needed, or everything was read after wsola_end). */
+int wsola_read(wsola_t *w, int16_t *out, int cap);
+
+/* Input sample that output sample out_pos was taken from */
+long long wsola_source_pos(const wsola_t *w, long long out_pos);
+
+#endif /* WSOLA_H */